@@ -11,7 +11,7 @@ void sys_tick_handler(void) {
 static void delay_ms(uint32_t ms) {
     uint32_t start = system_millis;
     while ((system_millis - start) < ms) {
-        __asm__("nop");
+        __asm__ volatile ("wfi");  /* sleep until the next SysTick */
     }
 }
 
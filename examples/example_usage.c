@@ -5,12 +5,14 @@
  */
 
 #include "system_state.h"
+#include "kin_corexy.h"
 #include <stdio.h>
 
 /* Example: Simple main loop for a CNC controller */
 int main(void) {
     /* Initialize system context */
     system_context_t sys;
+    kin_corexy_install(NULL);   /* Motion needs kinematics to compute steps */
     system_init(&sys);
     
     printf("CNC System State Manager - Example\n");
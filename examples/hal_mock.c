@@ -1,20 +1,117 @@
 /* hal_mock.c - Mock HAL implementation for examples and testing
  *
  * This provides minimal HAL function implementations for standalone
- * examples and tests that don't run on real hardware.
+ * examples and tests that don't run on real hardware. Time is virtual and
+ * only advances through hal_mock_advance() (see hal_mock.h).
  */
 
+#define _POSIX_C_SOURCE 199309L
+
 #include "hal.h"
+#include "hal_mock.h"
 #include <string.h>
+#include <time.h>
+
+/* ----------------------------- Mock state ----------------------------- */
+
+static uint64_t mock_now_us = 0;
+
+/* Step timer, 1 tick = 1 us of virtual time */
+static hal_timer_cb_t mock_on_step = NULL;
+static hal_timer_cb_t mock_on_pulse_end = NULL;
+static void *mock_timer_user = NULL;
+static bool mock_timer_armed = false;
+static uint32_t mock_timer_period = 0;   /* Interval running now */
+static uint32_t mock_timer_reload = 0;   /* Latched at the next update event */
+static uint64_t mock_timer_next_us = 0;
+
+static uint64_t mock_steps[HAL_AXIS_MAX];
+
+static uint8_t mock_rx[HAL_MOCK_RX_SIZE];
+static size_t mock_rx_head = 0;          /* Free-running */
+static size_t mock_rx_tail = 0;
+
+static hal_mock_tx_cb_t mock_tx_hook = NULL;
+static void *mock_tx_user = NULL;
+
+/* ----------------------------- Host controls ----------------------------- */
+
+void hal_mock_reset(void) {
+    mock_now_us = 0;
+    mock_timer_armed = false;
+    mock_timer_period = 0;
+    mock_timer_reload = 0;
+    mock_timer_next_us = 0;
+    memset(mock_steps, 0, sizeof(mock_steps));
+    mock_rx_head = 0;
+    mock_rx_tail = 0;
+    mock_tx_hook = NULL;
+    mock_tx_user = NULL;
+}
+
+uint64_t hal_mock_now_us(void) {
+    return mock_now_us;
+}
+
+bool hal_mock_advance(uint64_t until_us) {
+    if (!mock_timer_armed || mock_timer_next_us > until_us) {
+        if (until_us > mock_now_us) mock_now_us = until_us;
+        return false;
+    }
+
+    /* Update event: the buffered reload becomes the running period */
+    mock_now_us = mock_timer_next_us;
+    mock_timer_period = mock_timer_reload;
+    mock_timer_next_us = mock_now_us + (mock_timer_period ? mock_timer_period : 1u);
+    if (mock_on_step) mock_on_step(mock_timer_user);
+    if (mock_on_pulse_end) mock_on_pulse_end(mock_timer_user);
+    return true;
+}
+
+bool hal_mock_step_timer_armed(void) {
+    return mock_timer_armed;
+}
+
+uint32_t hal_mock_step_timer_period(void) {
+    return mock_timer_period;
+}
+
+uint64_t hal_mock_step_count(hal_axis_t axis) {
+    return (axis < HAL_AXIS_MAX) ? mock_steps[axis] : 0u;
+}
+
+size_t hal_mock_rx_push(const uint8_t *data, size_t len) {
+    size_t n = 0;
+    while (n < len && mock_rx_tail - mock_rx_head < HAL_MOCK_RX_SIZE) {
+        mock_rx[mock_rx_tail++ % HAL_MOCK_RX_SIZE] = data[n++];
+    }
+    return n;
+}
+
+void hal_mock_set_tx_hook(hal_mock_tx_cb_t fn, void *user) {
+    mock_tx_hook = fn;
+    mock_tx_user = user;
+}
+
+/* ----------------------------- Mock HAL functions ----------------------------- */
 
-/* Mock HAL functions */
 uint32_t hal_millis(void) {
-    static uint32_t mock_time = 0;
-    return mock_time++;
+    return (uint32_t)(mock_now_us / 1000u);
 }
 
 uint32_t hal_micros(void) {
-    return hal_millis() * 1000;
+    return (uint32_t)mock_now_us;
+}
+
+/* Host cycle counter: nanoseconds from the monotonic clock */
+uint32_t hal_cycles(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+
+uint32_t hal_cycles_freq_hz(void) {
+    return 1000000000u;
 }
 
 void hal_delay_ms(uint32_t ms) {
@@ -23,22 +120,38 @@ void hal_delay_ms(uint32_t ms) {
 }
 
 size_t hal_serial_read(hal_port_t port, uint8_t *dst, size_t cap) {
+    if (port != HAL_PORT_GCODE) return 0;
+    size_t n = 0;
+    while (n < cap && mock_rx_head != mock_rx_tail) {
+        dst[n++] = mock_rx[mock_rx_head++ % HAL_MOCK_RX_SIZE];
+    }
+    return n;
+}
+
+hal_status_t hal_serial_rx_dma_start(hal_port_t port, uint8_t *ring, size_t size,
+                                     hal_serial_rx_cb_t on_rx, void *user) {
     (void)port;
-    (void)dst;
-    (void)cap;
-    return 0;  /* No data available in mock */
+    (void)ring;
+    (void)size;
+    (void)on_rx;
+    (void)user;
+    return HAL_ERR;  /* No DMA in mock: callers fall back to hal_serial_read() */
 }
 
-size_t hal_serial_write(hal_port_t port, const uint8_t *src, size_t len) {
+size_t hal_serial_rx_dma_pos(hal_port_t port) {
     (void)port;
-    (void)src;
+    return 0;
+}
+
+size_t hal_serial_write(hal_port_t port, const uint8_t *src, size_t len) {
+    if (port == HAL_PORT_GCODE && mock_tx_hook && len) {
+        mock_tx_hook(src, len, mock_tx_user);
+    }
     return len;  /* Pretend all bytes were written */
 }
 
 size_t hal_serial_write_str(hal_port_t port, const char *s) {
-    (void)port;
-    (void)s;
-    return 0;
+    return s ? hal_serial_write(port, (const uint8_t *)s, strlen(s)) : 0;
 }
 
 void hal_gpio_write(uint32_t pin_id, hal_pin_state_t state) {
@@ -65,7 +178,7 @@ void hal_stepper_set_dir(hal_axis_t axis, bool dir_positive) {
 }
 
 void hal_stepper_step_pulse(hal_axis_t axis) {
-    (void)axis;
+    if (axis < HAL_AXIS_MAX) mock_steps[axis]++;
 }
 
 void hal_stepper_step_clear(hal_axis_t axis) {
@@ -73,9 +186,44 @@ void hal_stepper_step_clear(hal_axis_t axis) {
 }
 
 void hal_stepper_pulse_mask(uint32_t axis_mask) {
+    for (unsigned i = 0; i < HAL_AXIS_MAX; i++) {
+        if (axis_mask & (1u << i)) mock_steps[i]++;
+    }
+}
+
+void hal_stepper_clear_mask(uint32_t axis_mask) {
     (void)axis_mask;
 }
 
+void hal_step_timer_init(hal_timer_cb_t on_step, hal_timer_cb_t on_pulse_end, void *user) {
+    mock_on_step = on_step;
+    mock_on_pulse_end = on_pulse_end;
+    mock_timer_user = user;
+}
+
+uint32_t hal_step_timer_freq_hz(void) {
+    return 1000000u;  /* 1 MHz tick */
+}
+
+void hal_step_timer_arm(uint32_t period_ticks) {
+    mock_timer_period = period_ticks;
+    mock_timer_reload = period_ticks;
+    mock_timer_next_us = mock_now_us + (period_ticks ? period_ticks : 1u);
+    mock_timer_armed = true;
+}
+
+void hal_step_timer_reload(uint32_t period_ticks) {
+    mock_timer_reload = period_ticks;
+}
+
+void hal_step_timer_compare(uint32_t pulse_ticks) {
+    (void)pulse_ticks;
+}
+
+void hal_step_timer_stop(void) {
+    mock_timer_armed = false;
+}
+
 void hal_spindle_set(hal_spindle_dir_t dir, float pwm) {
     (void)dir;
     (void)pwm;
@@ -95,10 +243,21 @@ void hal_read_inputs(hal_inputs_t *out) {
     }
 }
 
+hal_status_t hal_inputs_irq_init(uint32_t debounce_us, hal_inputs_cb_t on_change, void *user) {
+    (void)debounce_us;
+    (void)on_change;
+    (void)user;
+    return HAL_ERR;  /* No EXTI in mock: inputs are polled */
+}
+
 void hal_tick_1khz_isr(void) {
     /* No-op in mock */
 }
 
+void hal_idle_wait(const volatile uint32_t *wake) {
+    (void)wake;  /* Host build: never sleeps */
+}
+
 hal_status_t hal_init(void) {
     return HAL_OK;
 }
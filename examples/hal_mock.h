@@ -0,0 +1,58 @@
+/* hal_mock.h - Host-side controls of the mock HAL (hal_mock.c)
+ *
+ * The mock runs on a virtual clock that only moves when the host program
+ * advances it, so a simulation is deterministic and runs as fast as the
+ * host allows:
+ *  - hal_millis() / hal_micros() read the virtual clock
+ *  - the step timer ticks at 1 MHz of virtual time; hal_mock_advance()
+ *    fires its callbacks when an update event falls due
+ *  - step pulses are counted per axis
+ *  - G-code port RX is fed with hal_mock_rx_push(), TX goes to a hook
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bytes hal_mock_rx_push() can hold ahead of hal_serial_read() */
+#define HAL_MOCK_RX_SIZE 4096u
+
+typedef void (*hal_mock_tx_cb_t)(const uint8_t *data, size_t len, void *user);
+
+/* Clock to zero, timer disarmed, counters and RX cleared, no TX hook */
+void hal_mock_reset(void);
+
+/* Virtual time in microseconds */
+uint64_t hal_mock_now_us(void);
+
+/* Move the clock towards until_us. If the step timer is armed and its next
+ * update event falls at or before until_us, the clock stops there, on_step
+ * and on_pulse_end run and true is returned; otherwise the clock reaches
+ * until_us and false is returned.
+ */
+bool hal_mock_advance(uint64_t until_us);
+
+/* Step timer state */
+bool hal_mock_step_timer_armed(void);
+uint32_t hal_mock_step_timer_period(void);
+
+/* Step pulses emitted on an axis since the last reset */
+uint64_t hal_mock_step_count(hal_axis_t axis);
+
+/* Queue bytes for hal_serial_read(). Returns the number accepted. */
+size_t hal_mock_rx_push(const uint8_t *data, size_t len);
+
+/* Receive everything written to the G-code port */
+void hal_mock_set_tx_hook(hal_mock_tx_cb_t fn, void *user);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,442 @@
+"""
+Host-side job time estimator.
+
+Runs G-code through a Python copy of the firmware planner (src/planner.c:
+junction deviation, reverse/forward look-ahead passes over a ring of
+PLANNER_BUFFER_SIZE blocks) and the arc segmentation of src/arc.c, then
+times each block's trapezoid. Use it to pick resolution / feed per job
+before committing machine time.
+
+Assumes the host keeps the ring full (character counting), so a block
+starts executing when the next one needs its slot, with whatever profile
+the look-ahead had planned by then.
+
+Usage:
+    est = estimate_job(gcode_lines)
+    print(est.summary())
+
+    python job_estimator.py job.gcode [--accel 10 --max-rate 1000 ...]
+"""
+
+import math
+import re
+from collections import deque
+from dataclasses import dataclass, field
+from typing import Deque, Iterable, List, Optional, Tuple
+
+# First byte of a binary motion frame line (see svg_parser.encode_motion_frame)
+BIN_FRAME_SOF = "\x01"
+
+
+@dataclass
+class MachineSettings:
+    """Mirrors the firmware defaults (planner.h, arc.h, grbl.h)."""
+    acceleration: float = 10.0 * 3600.0   # mm/min^2 (PLANNER_DEFAULT_ACCELERATION)
+    max_rate: float = 1000.0              # mm/min, also the G0 rate
+    junction_deviation: float = 0.01      # mm
+    buffer_size: int = 16                 # GRBL_PLANNER_BUFFER_SIZE
+    arc_tolerance: float = 0.002          # mm (ARC_TOLERANCE_MM)
+    arc_segment_len: float = 0.5          # mm, used when arc_tolerance is 0
+    arc_max_segments: int = 10000
+    steps_per_mm: Optional[float] = None  # drop moves that round to 0 steps
+    minimum_junction_speed: float = 0.0
+    minimum_speed: float = 0.0
+
+
+@dataclass
+class JobEstimate:
+    duration_s: float = 0.0
+    motion_s: float = 0.0
+    dwell_s: float = 0.0
+    rapid_s: float = 0.0
+    below_nominal_s: float = 0.0   # time spent accelerating/decelerating
+    cut_mm: float = 0.0
+    rapid_mm: float = 0.0
+    blocks: int = 0
+    short_blocks: int = 0          # look-ahead window too short to reach nominal
+    peak_blocks_per_s: float = 0.0 # over a buffer's worth of blocks
+    lines: int = 0
+    skipped_lines: List[Tuple[int, str]] = field(default_factory=list)
+
+    def summary(self) -> str:
+        def hms(t: float) -> str:
+            t = int(round(t))
+            return f"{t // 3600:d}:{t // 60 % 60:02d}:{t % 60:02d}"
+
+        pct = 100.0 * self.below_nominal_s / self.motion_s if self.motion_s > 0 else 0.0
+        short_pct = 100.0 * self.short_blocks / self.blocks if self.blocks else 0.0
+        out = [
+            f"Estimated run time: {hms(self.duration_s)} "
+            f"(motion {self.motion_s:.1f} s, rapids {self.rapid_s:.1f} s, dwell {self.dwell_s:.1f} s)",
+            f"Below nominal feed: {self.below_nominal_s:.1f} s ({pct:.0f}% of motion)",
+            f"Planner blocks: {self.blocks}, {self.short_blocks} ({short_pct:.0f}%) limited by buffer depth",
+            f"Peak block rate: {self.peak_blocks_per_s:.0f} blocks/s",
+            f"Distance: cut {self.cut_mm:.1f} mm, rapid {self.rapid_mm:.1f} mm",
+        ]
+        if self.skipped_lines:
+            out.append(f"Unsupported lines skipped: {len(self.skipped_lines)}")
+        return "\n".join(out)
+
+
+class _Block:
+    __slots__ = ("millimeters", "ux", "uy", "nominal_speed", "acceleration",
+                 "max_entry_speed", "entry_speed", "exit_speed",
+                 "nominal_length_flag", "recalculate_flag", "rapid")
+
+    def __init__(self, mm: float, ux: float, uy: float, nominal: float, accel: float, rapid: bool):
+        self.millimeters = mm
+        self.ux, self.uy = ux, uy
+        self.nominal_speed = nominal
+        self.acceleration = accel
+        self.max_entry_speed = 0.0
+        self.entry_speed = 0.0
+        self.exit_speed = 0.0
+        self.nominal_length_flag = False
+        self.recalculate_flag = False
+        self.rapid = rapid
+
+
+def _max_allowable_speed(accel: float, v_exit: float, distance: float) -> float:
+    return math.sqrt(v_exit * v_exit + 2.0 * accel * distance)
+
+
+class PlannerSim:
+    """planner_plan_block() / planner_recalculate() over a bounded window."""
+
+    JUNCTION_COS_STRAIGHT = 0.999999
+    JUNCTION_SPEED_UNLIMITED = 1.0e9
+
+    def __init__(self, settings: MachineSettings, est: JobEstimate):
+        self.s = settings
+        self.est = est
+        self.window: Deque[_Block] = deque()
+        self._recent: Deque[float] = deque()  # durations of the last buffer_size blocks
+        self._recent_sum = 0.0
+
+    # -- look-ahead (same order of operations as planner.c) --
+    def _junction_speed(self, prev: _Block, block: _Block) -> float:
+        cos_theta = -(prev.ux * block.ux + prev.uy * block.uy)
+        if cos_theta > self.JUNCTION_COS_STRAIGHT:
+            return self.s.minimum_junction_speed
+        if cos_theta < -self.JUNCTION_COS_STRAIGHT:
+            return self.JUNCTION_SPEED_UNLIMITED
+        sin_theta_d2 = math.sqrt(0.5 * (1.0 - cos_theta))
+        v = math.sqrt(block.acceleration * self.s.junction_deviation * sin_theta_d2 /
+                      (1.0 - sin_theta_d2))
+        return max(v, self.s.minimum_junction_speed)
+
+    def _reverse_pass(self) -> None:
+        w = self.window
+        if len(w) < 2:
+            return
+        nxt = w[-1]
+        v = _max_allowable_speed(nxt.acceleration, self.s.minimum_speed, nxt.millimeters)
+        entry = min(nxt.max_entry_speed, v)
+        if entry != nxt.entry_speed:
+            nxt.entry_speed = entry
+            nxt.recalculate_flag = True
+        for k in range(len(w) - 2, 0, -1):  # window[0] is the fixed first block
+            cur = w[k]
+            if cur.entry_speed == cur.max_entry_speed:
+                break
+            if not cur.nominal_length_flag and cur.max_entry_speed > nxt.entry_speed:
+                v = _max_allowable_speed(cur.acceleration, nxt.entry_speed, cur.millimeters)
+                new_entry = min(cur.max_entry_speed, v)
+            else:
+                new_entry = cur.max_entry_speed
+            if new_entry == cur.entry_speed:
+                break
+            cur.entry_speed = new_entry
+            cur.recalculate_flag = True
+            nxt = cur
+
+    def _forward_pass(self) -> None:
+        w = self.window
+        prev = w[0]
+        for k in range(1, len(w)):
+            cur = w[k]
+            if ((prev.recalculate_flag or cur.recalculate_flag) and
+                    not prev.nominal_length_flag and prev.entry_speed < cur.entry_speed):
+                v = _max_allowable_speed(prev.acceleration, prev.entry_speed, prev.millimeters)
+                if v < cur.entry_speed:
+                    cur.entry_speed = v
+                    cur.recalculate_flag = True
+            if prev.recalculate_flag or cur.recalculate_flag:
+                prev.exit_speed = cur.entry_speed
+            prev.recalculate_flag = False
+            prev = cur
+        prev.exit_speed = self.s.minimum_speed
+        prev.recalculate_flag = False
+
+    def plan(self, block: _Block) -> None:
+        if len(self.window) >= self.s.buffer_size:
+            self._execute(self.window.popleft())
+        prev = self.window[-1] if self.window else None
+        max_entry = self.s.minimum_speed
+        if prev is not None:
+            max_entry = min(self._junction_speed(prev, block), prev.nominal_speed, block.nominal_speed)
+        block.max_entry_speed = max_entry
+        v_allowable = _max_allowable_speed(block.acceleration, self.s.minimum_speed, block.millimeters)
+        block.entry_speed = min(max_entry, v_allowable)
+        block.exit_speed = self.s.minimum_speed
+        block.nominal_length_flag = block.nominal_speed <= v_allowable
+        block.recalculate_flag = True
+        self.window.append(block)
+        self._reverse_pass()
+        self._forward_pass()
+
+    def finish(self) -> None:
+        while self.window:
+            self._execute(self.window.popleft())
+
+    # -- execution: trapezoid timing --
+    def _execute(self, b: _Block) -> None:
+        est = self.est
+        a, L = b.acceleration, b.millimeters
+        vi, vf, vn = b.entry_speed, b.exit_speed, b.nominal_speed
+        d_acc = (vn * vn - vi * vi) / (2.0 * a)
+        d_dec = (vn * vn - vf * vf) / (2.0 * a)
+        if d_acc + d_dec <= L:
+            vp = vn
+            cruise = L - d_acc - d_dec
+        else:
+            vp = math.sqrt(max(0.0, (2.0 * a * L + vi * vi + vf * vf) * 0.5))
+            cruise = 0.0
+        t_ramp = (max(0.0, vp - vi) + max(0.0, vp - vf)) / a  # minutes
+        t = (t_ramp + cruise / vn) * 60.0
+        est.motion_s += t
+        est.below_nominal_s += t_ramp * 60.0
+        if b.rapid:
+            est.rapid_s += t
+            est.rapid_mm += L
+        else:
+            est.cut_mm += L
+        est.blocks += 1
+
+        # Could a deeper buffer have let this block reach nominal? The
+        # window (this block and everything queued behind it) has to be
+        # long enough to stop from nominal speed.
+        if vp < vn:
+            ahead = L + sum(x.millimeters for x in self.window)
+            if ahead < vn * vn / (2.0 * a):
+                est.short_blocks += 1
+
+        self._recent.append(t)
+        self._recent_sum += t
+        if len(self._recent) > self.s.buffer_size:
+            self._recent_sum -= self._recent.popleft()
+        if len(self._recent) == self.s.buffer_size and self._recent_sum > 0:
+            est.peak_blocks_per_s = max(est.peak_blocks_per_s, len(self._recent) / self._recent_sum)
+
+
+_WORD = re.compile(r"([A-Z])\s*([-+]?(?:\d+\.?\d*|\.\d+))")
+
+
+def _decode_frame(line: str) -> Optional[Tuple[int, int, List[Tuple[int, int]]]]:
+    """Binary motion frame -> (flags, feed, [(dx, dy), ...]) in counts, or None."""
+    raw = bytearray()
+    data = line.encode("latin-1")[1:]
+    k = 0
+    while k < len(data):
+        b = data[k]
+        if b == 0x1B:
+            k += 1
+            if k >= len(data):
+                return None
+            b = data[k] ^ 0x40
+        raw.append(b)
+        k += 1
+    if len(raw) < 5:
+        return None
+    crc = 0
+    for b in raw[:-1]:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    if crc != raw[-1] or raw[0] != 0x01:
+        return None
+    pos = 2
+
+    def varint() -> int:
+        nonlocal pos
+        v, shift = 0, 0
+        while True:
+            b = raw[pos]
+            pos += 1
+            v |= (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                return v
+
+    try:
+        feed = varint()
+        count = raw[pos]
+        pos += 1
+        pts = []
+        for _ in range(count):
+            ux, uy = varint(), varint()
+            pts.append(((ux >> 1) ^ -(ux & 1), (uy >> 1) ^ -(uy & 1)))
+    except IndexError:
+        return None
+    return raw[1], feed, pts
+
+
+class JobSimulator:
+    """Minimal mirror of src/gcode.c feeding PlannerSim."""
+
+    BIN_UNITS_PER_MM = 1000
+
+    def __init__(self, settings: Optional[MachineSettings] = None):
+        self.s = settings or MachineSettings()
+        self.est = JobEstimate()
+        self.planner = PlannerSim(self.s, self.est)
+        self.x = self.y = 0.0       # modal position (gcode.c)
+        self.px = self.py = 0.0     # planned position (planner.c)
+        self.feed = 0.0
+        self.motion = 0
+        self.absolute = True
+
+    def _segment(self, x: float, y: float, feed: float, rapid: bool) -> None:
+        if self.s.steps_per_mm:
+            spm = self.s.steps_per_mm
+            if (round(x * spm) == round(self.px * spm)) and (round(y * spm) == round(self.py * spm)):
+                return
+        dx, dy = x - self.px, y - self.py
+        mm = math.hypot(dx, dy)
+        if mm <= 0.0:
+            return
+        nominal = self.s.max_rate if rapid or feed > self.s.max_rate else feed
+        if nominal <= 0.0:
+            return
+        self.planner.plan(_Block(mm, dx / mm, dy / mm, nominal, self.s.acceleration, rapid))
+        self.px, self.py = x, y
+
+    def _arc(self, tx: float, ty: float, cx: float, cy: float, cw: bool) -> None:
+        sx, sy = self.x, self.y
+        r = 0.5 * (math.hypot(sx - cx, sy - cy) + math.hypot(tx - cx, ty - cy))
+        if r < 0.001:
+            return
+        t0 = math.atan2(sy - cy, sx - cx)
+        t1 = math.atan2(ty - cy, tx - cx)
+        sweep = (t0 - t1) if cw else (t1 - t0)
+        if sweep <= 0.0:
+            sweep += 2.0 * math.pi
+        if abs(tx - sx) < 0.001 and abs(ty - sy) < 0.001:
+            sweep = 2.0 * math.pi
+        tol = self.s.arc_tolerance
+        seg = 2.0 * math.sqrt(tol * (2.0 * r - tol)) if tol > 0 and r > tol else self.s.arc_segment_len
+        n = min(max(1, int(r * sweep / seg)), self.s.arc_max_segments)
+        step = -sweep / n if cw else sweep / n
+        rx, ry = sx - cx, sy - cy
+        for k in range(1, n):
+            c, s = math.cos(k * step), math.sin(k * step)
+            self._segment(cx + rx * c - ry * s, cy + rx * s + ry * c, self.feed, False)
+        self._segment(tx, ty, self.feed, False)
+
+    def line(self, text: str) -> bool:
+        """Feed one line; returns False if it is not understood."""
+        self.est.lines += 1
+        if text.startswith(BIN_FRAME_SOF):
+            frame = _decode_frame(text)
+            if frame is None:
+                return False
+            flags, feed, pts = frame
+            if feed > 0:
+                self.feed = float(feed)
+            ox, oy, sx, sy = self.x, self.y, 0, 0
+            for dx, dy in pts:
+                sx += dx
+                sy += dy
+                self.x = ox + sx / self.BIN_UNITS_PER_MM
+                self.y = oy + sy / self.BIN_UNITS_PER_MM
+                self._segment(self.x, self.y, self.feed, bool(flags & 0x01))
+            return True
+
+        code = text.split(";", 1)[0]
+        code = re.sub(r"\([^)]*\)", " ", code).strip().upper()
+        if not code or code.startswith("$"):
+            return True
+        words = {}
+        gs, ms = [], []
+        for letter, num in _WORD.findall(code):
+            v = float(num)
+            if letter == "G":
+                gs.append(int(v))
+            elif letter == "M":
+                ms.append(int(v))
+            else:
+                words[letter] = v
+
+        for g in gs:
+            if g in (0, 1, 2, 3):
+                self.motion = g
+            elif g == 90:
+                self.absolute = True
+            elif g == 91:
+                self.absolute = False
+            elif g == 4:
+                self.est.dwell_s += max(0.0, words.get("P", 0.0))
+        if "F" in words and words["F"] > 0:
+            self.feed = words["F"]
+        if 30 in ms:
+            self.x = self.y = self.px = self.py = 0.0
+        if 4 in gs or not ("X" in words or "Y" in words):
+            return True
+
+        tx, ty = self.x, self.y
+        if self.absolute:
+            tx, ty = words.get("X", tx), words.get("Y", ty)
+        else:
+            tx, ty = tx + words.get("X", 0.0), ty + words.get("Y", 0.0)
+
+        if self.motion in (0, 1):
+            self._segment(tx, ty, self.feed, self.motion == 0)
+        else:
+            cw = self.motion == 2
+            if "R" in words:
+                r = words["R"]
+                hx, hy = 0.5 * (tx - self.x), 0.5 * (ty - self.y)
+                half = math.hypot(hx, hy)
+                if half == 0.0 or half > abs(r):
+                    return False
+                h = math.sqrt(r * r - half * half)
+                px, py = -hy / half, hx / half
+                left = (not cw) != (r < 0)
+                mx, my = self.x + hx, self.y + hy
+                cx, cy = (mx + h * px, my + h * py) if left else (mx - h * px, my - h * py)
+            else:
+                cx, cy = self.x + words.get("I", 0.0), self.y + words.get("J", 0.0)
+            self._arc(tx, ty, cx, cy, cw)
+        self.x, self.y = tx, ty
+        return True
+
+    def finish(self) -> JobEstimate:
+        self.planner.finish()
+        self.est.duration_s = self.est.motion_s + self.est.dwell_s
+        return self.est
+
+
+def estimate_job(lines: Iterable[str], settings: Optional[MachineSettings] = None) -> JobEstimate:
+    """Estimate run time for G-code lines (str, no newline; binary frames ok)."""
+    sim = JobSimulator(settings)
+    for n, ln in enumerate(lines, 1):
+        if not sim.line(ln.rstrip("\r\n") if not ln.startswith(BIN_FRAME_SOF) else ln.rstrip("\n")):
+            sim.est.skipped_lines.append((n, ln))
+    return sim.finish()
+
+
+if __name__ == "__main__":
+    import argparse
+
+    ap = argparse.ArgumentParser(description="Estimate CNC job time with the firmware planner model.")
+    ap.add_argument("gcode")
+    ap.add_argument("--accel", type=float, default=10.0, help="mm/s^2")
+    ap.add_argument("--max-rate", type=float, default=1000.0, help="mm/min")
+    ap.add_argument("--junction-deviation", type=float, default=0.01, help="mm")
+    ap.add_argument("--buffer", type=int, default=16, help="planner blocks")
+    args = ap.parse_args()
+
+    cfg = MachineSettings(acceleration=args.accel * 3600.0, max_rate=args.max_rate,
+                          junction_deviation=args.junction_deviation, buffer_size=args.buffer)
+    with open(args.gcode, "r", encoding="latin-1", newline="\n") as fh:
+        print(estimate_job(fh, cfg).summary())
@@ -0,0 +1,583 @@
+"""
+Fleet job manager: convert each SVG once, stream it to many controllers.
+
+- ConversionCache converts an SVG with svg_parser once per (file content,
+  resolution, G-code options) and keeps the cleaned lines in memory and,
+  optionally, as files in a cache directory. Re-running a job costs one
+  hash of the SVG, even across sessions.
+- FleetStreamer drives any number of controllers from a single I/O thread:
+  one selector loop over the serial ports (polled where the OS cannot
+  select on serial handles, e.g. Windows COM ports), with the same
+  character-counting flow control as GrblStreamer. Each controller has its
+  own state, progress and error reporting; an error on one machine stops
+  only that machine.
+
+Usage:
+    cache = ConversionCache(cache_dir=Path.home() / ".cache" / "engraver")
+    job = cache.get("art.svg", resolution=0.5, travel_feed=1200.0)
+
+    fleet = FleetStreamer(progress_callback=lambda name, done, total: ...)
+    fleet.add("COM11", 115200, job)
+    fleet.add("COM12", 115200, job)
+    fleet.start()
+    fleet.join()
+"""
+
+import hashlib
+import json
+import os
+import selectors
+import threading
+import time
+from collections import OrderedDict, deque
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Callable, Deque, Dict, Iterable, List, Optional, Sequence, Tuple, Union
+
+import serial  # pip install pyserial
+
+import svg_parser
+from streaming import (BIN_FRAME_SOF, DEFAULT_RX_BUFFER_SIZE, RT_OVR_FIRST, RT_OVR_LAST, GrblStreamer,
+                       StreamError, StreamState, parse_rx_free)
+
+
+def default_logger(msg: str) -> None:
+    print(msg)
+
+
+# -----------------------------
+# Conversion cache
+# -----------------------------
+@dataclass(frozen=True)
+class Job:
+    """Converted G-code, cleaned and ready to send (see GrblStreamer._preprocess_line)."""
+    key: str
+    lines: Tuple[str, ...]
+    total_bytes: int  # len(line) + 1 summed, what character counting sends
+
+
+def file_hash(path: Union[str, Path]) -> str:
+    """SHA-256 of a file's content, read in chunks."""
+    h = hashlib.sha256()
+    with open(path, "rb") as fh:
+        for chunk in iter(lambda: fh.read(1 << 20), b""):
+            h.update(chunk)
+    return h.hexdigest()
+
+
+class ConversionCache:
+    """
+    Converted jobs keyed by SVG content plus conversion parameters.
+
+    The key hashes the file content (not its name or mtime), the
+    resolution and every svg_parser.iter_gcode option passed, so editing
+    the SVG or changing a feed converts again while a renamed copy does
+    not. Up to max_entries jobs stay in memory (least recently used
+    dropped first); with cache_dir set every job is also written there as
+    <key>.gcode and survives restarts.
+    """
+
+    def __init__(
+        self,
+        cache_dir: Optional[Union[str, Path]] = None,
+        max_entries: int = 16,
+        converter: Callable[..., Iterable[str]] = svg_parser.iter_svg_gcode,
+    ) -> None:
+        self.cache_dir = Path(cache_dir).expanduser() if cache_dir is not None else None
+        self.max_entries = max(1, max_entries)
+        self.converter = converter
+        self.hits = 0
+        self.misses = 0
+        self._jobs: "OrderedDict[str, Job]" = OrderedDict()
+        self._lock = threading.Lock()
+
+    @staticmethod
+    def make_key(content_hash: str, resolution: float, **gcode_options) -> str:
+        params = json.dumps({"resolution": resolution, **gcode_options}, sort_keys=True, default=str)
+        return hashlib.sha256(f"{content_hash}:{params}".encode("utf-8")).hexdigest()
+
+    def key(self, svg_path: Union[str, Path], resolution: float = 0.5, **gcode_options) -> str:
+        return self.make_key(file_hash(svg_path), resolution, **gcode_options)
+
+    def lookup(self, svg_path: Union[str, Path], resolution: float = 0.5, **gcode_options) -> Optional[Job]:
+        """Cached job for these parameters, or None. Never converts."""
+        return self._find(self.key(svg_path, resolution, **gcode_options))
+
+    def get(self, svg_path: Union[str, Path], resolution: float = 0.5, **gcode_options) -> Job:
+        """Cached job, converting (and caching) on a miss. Takes the
+        svg_parser.iter_gcode keyword options."""
+        key = self.key(svg_path, resolution, **gcode_options)
+        job = self._find(key)
+        if job is not None:
+            return job
+        lines = self.converter(str(svg_path), resolution=resolution, **gcode_options)
+        return self._store(key, lines)
+
+    def put(self, svg_path: Union[str, Path], lines: Iterable[str], resolution: float = 0.5,
+            **gcode_options) -> Job:
+        """Cache lines converted elsewhere (e.g. by the GUI's worker thread)."""
+        return self._store(self.key(svg_path, resolution, **gcode_options), lines)
+
+    def clear(self) -> None:
+        """Drop the in-memory entries; files in cache_dir are kept."""
+        with self._lock:
+            self._jobs.clear()
+
+    def _find(self, key: str) -> Optional[Job]:
+        with self._lock:
+            job = self._jobs.get(key)
+            if job is not None:
+                self._jobs.move_to_end(key)
+                self.hits += 1
+                return job
+        job = self._load(key)
+        with self._lock:
+            if job is None:
+                self.misses += 1
+                return None
+            self.hits += 1
+            self._remember(job)
+        return job
+
+    def _store(self, key: str, lines: Iterable[str]) -> Job:
+        cleaned = []
+        for ln in lines:
+            ln = GrblStreamer._preprocess_line(ln)
+            if ln is not None:
+                cleaned.append(ln)
+        job = Job(key=key, lines=tuple(cleaned), total_bytes=sum(len(ln) + 1 for ln in cleaned))
+        self._save(job)
+        with self._lock:
+            self._remember(job)
+        return job
+
+    def _remember(self, job: Job) -> None:
+        self._jobs[job.key] = job
+        self._jobs.move_to_end(job.key)
+        while len(self._jobs) > self.max_entries:
+            self._jobs.popitem(last=False)
+
+    def _path(self, key: str) -> Optional[Path]:
+        return self.cache_dir / f"{key}.gcode" if self.cache_dir is not None else None
+
+    def _load(self, key: str) -> Optional[Job]:
+        path = self._path(key)
+        if path is None or not path.exists():
+            return None
+        try:
+            # Binary frames are stored byte-for-byte and never contain '\n'
+            with open(path, "r", encoding="latin-1", newline="") as fh:
+                lines = tuple(fh.read().split("\n")[:-1])
+        except OSError:
+            return None
+        return Job(key=key, lines=lines, total_bytes=sum(len(ln) + 1 for ln in lines))
+
+    def _save(self, job: Job) -> None:
+        path = self._path(job.key)
+        if path is None:
+            return
+        try:
+            path.parent.mkdir(parents=True, exist_ok=True)
+            tmp = path.with_suffix(f".tmp{os.getpid()}")
+            svg_parser.write_gcode(job.lines, tmp)
+            os.replace(tmp, path)  # readers never see a partial file
+        except OSError:
+            pass  # memory cache still works
+
+
+# -----------------------------
+# Fleet streaming
+# -----------------------------
+@dataclass
+class ControllerSession:
+    """One controller's stream: port, flow control and progress."""
+    name: str
+    port: str
+    baudrate: int
+    lines: Sequence[str]
+    rx_buffer_size: Optional[int] = None  # None: read from the controller's status report
+    char_counting: bool = True
+    total_bytes: int = 0
+
+    state: StreamState = StreamState.IDLE
+    error: Optional[StreamError] = None
+    sent: int = 0  # lines sent (index of the next one)
+    acked: int = 0  # lines acknowledged with 'ok'
+    bytes_in_flight: int = 0
+    bytes_acked: int = 0
+    in_flight: Deque[Tuple[str, int]] = field(default_factory=deque)
+
+    _ser: Optional[serial.Serial] = None
+    _fd: Optional[int] = None  # registered with the fleet's selector
+    _rx: bytearray = field(default_factory=bytearray)
+    _send_after: float = 0.0  # end of the startup drain (then of the RX size query)
+    _started: bool = False
+    _rx_size_given: bool = False
+    _rx_query_sent: bool = False
+
+    @property
+    def total_lines(self) -> int:
+        return len(self.lines)
+
+    @property
+    def active(self) -> bool:
+        return self.state in (StreamState.SENDING, StreamState.PAUSED)
+
+
+class FleetStreamer:
+    """
+    Streams jobs to several Grbl controllers from one background thread.
+
+    Each controller opened with add() follows GrblStreamer's protocol:
+    startup text is drained for startup_drain_time, the RX buffer size is
+    read from a status report unless add() fixed it (waiting at most
+    rx_query_timeout), then lines are sent while the bytes in flight fit
+    rx_buffer_size (or one at a time with char_counting=False), every 'ok'
+    frees the oldest line and an 'error:<code>' stops that controller and
+    reports the line.
+
+    Callbacks run on the I/O thread and get the controller name first:
+        log_callback(msg)
+        state_callback(name, StreamState)
+        progress_callback(name, lines_acked, total_lines)
+        byte_progress_callback(name, bytes_acked, total_bytes)
+        error_callback(name, StreamError)
+    """
+
+    def __init__(
+        self,
+        log_callback: Callable[[str], None] = default_logger,
+        state_callback: Optional[Callable[[str, StreamState], None]] = None,
+        progress_callback: Optional[Callable[[str, int, int], None]] = None,
+        error_callback: Optional[Callable[[str, StreamError], None]] = None,
+        byte_progress_callback: Optional[Callable[[str, int, int], None]] = None,
+        startup_drain_time: float = 1.0,
+        rx_query_timeout: float = 1.0,
+        poll_interval: float = 0.002,
+        verbose: bool = False,
+    ) -> None:
+        self.log = log_callback
+        self.state_callback = state_callback
+        self.progress_callback = progress_callback
+        self.error_callback = error_callback
+        self.byte_progress_callback = byte_progress_callback
+        self.startup_drain_time = startup_drain_time
+        self.rx_query_timeout = rx_query_timeout
+        self.poll_interval = poll_interval  # used for ports the selector cannot watch
+        self.verbose = verbose  # log every line sent and received
+
+        self.sessions: Dict[str, ControllerSession] = {}
+        self._thread: Optional[threading.Thread] = None
+        self._sel: Optional[selectors.BaseSelector] = None
+        self._stop_event = threading.Event()
+        self._lock = threading.Lock()
+
+    # -----------------------------
+    # Public API
+    # -----------------------------
+    def add(
+        self,
+        port: str,
+        baudrate: int,
+        job: Union[Job, Iterable[str]],
+        name: Optional[str] = None,
+        rx_buffer_size: Optional[int] = None,
+        char_counting: bool = True,
+    ) -> ControllerSession:
+        """Queue a controller. job is a cached Job or any iterable of lines
+        (cleaned here). Must be called before start()."""
+        if self._thread is not None and self._thread.is_alive():
+            raise RuntimeError("cannot add controllers while streaming")
+        name = name or port
+        if name in self.sessions:
+            raise ValueError(f"duplicate controller name: {name}")
+        if isinstance(job, Job):
+            lines, total_bytes = job.lines, job.total_bytes
+        else:
+            lines = tuple(ln for ln in map(GrblStreamer._preprocess_line, job) if ln is not None)
+            total_bytes = sum(len(ln) + 1 for ln in lines)
+        s = ControllerSession(name=name, port=port, baudrate=baudrate, lines=lines,
+                              rx_buffer_size=rx_buffer_size, char_counting=char_counting,
+                              total_bytes=total_bytes, _rx_size_given=rx_buffer_size is not None)
+        self.sessions[name] = s
+        return s
+
+    def start(self) -> None:
+        """Open every port and start the I/O thread. A port that fails to
+        open goes to ERROR; the others still run."""
+        if self._thread is not None and self._thread.is_alive():
+            self.log("Cannot start: fleet is already streaming.")
+            return
+        self._stop_event.clear()
+        now = time.monotonic()
+        for s in self.sessions.values():
+            self._reset(s)
+            try:
+                self.log(f"[{s.name}] Opening serial port {s.port} @ {s.baudrate}...")
+                # Non-blocking: the loop only reads what is already there
+                s._ser = serial.Serial(s.port, s.baudrate, timeout=0)
+            except Exception as e:
+                self.log(f"[{s.name}] Failed to open port {s.port}: {e}")
+                self._fail(s, StreamError(line_index=-1, line_text="", error_code=f"PORT:{e}", raw_line=""))
+                continue
+            s._send_after = now + self.startup_drain_time
+            self._set_state(s, StreamState.SENDING)
+        self._thread = threading.Thread(target=self._io_loop, daemon=True)
+        self._thread.start()
+
+    def pause(self, name: Optional[str] = None) -> None:
+        """Feed hold ('!') on one controller, or all with name=None."""
+        with self._lock:
+            for s in self._select(name):
+                if s.state == StreamState.SENDING:
+                    self._send_realtime(s, b"!")
+                    self._set_state(s, StreamState.PAUSED)
+
+    def resume(self, name: Optional[str] = None) -> None:
+        """Cycle start ('~') and continue sending."""
+        with self._lock:
+            for s in self._select(name):
+                if s.state == StreamState.PAUSED:
+                    self._send_realtime(s, b"~")
+                    self._set_state(s, StreamState.SENDING)
+                    self._fill_rx_buffer(s)
+
+    def override(self, code: int, name: Optional[str] = None) -> None:
+        """Send one realtime override byte (streaming.RT_*_OVR_*)."""
+        if not RT_OVR_FIRST <= code <= RT_OVR_LAST:
+            raise ValueError(f"not an override byte: {code:#x}")
+        with self._lock:
+            for s in self._select(name):
+                self._send_realtime(s, bytes([code]))
+
+    def abort(self, name: Optional[str] = None) -> None:
+        """Ctrl-X and stop streaming to one controller, or all. The I/O
+        thread closes the port."""
+        with self._lock:
+            for s in self._select(name):
+                if s.active:
+                    self._send_realtime(s, b"\x18")
+                    self._set_state(s, StreamState.IDLE)
+            if name is None:
+                self._stop_event.set()
+
+    def join(self, timeout: Optional[float] = None) -> None:
+        """Wait for the I/O thread: every controller done, failed or aborted."""
+        t = self._thread
+        if t is not None:
+            t.join(timeout=timeout)
+
+    def states(self) -> Dict[str, StreamState]:
+        return {name: s.state for name, s in self.sessions.items()}
+
+    # -----------------------------
+    # Internal helpers
+    # -----------------------------
+    def _select(self, name: Optional[str]) -> List[ControllerSession]:
+        if name is None:
+            return list(self.sessions.values())
+        return [self.sessions[name]]
+
+    @staticmethod
+    def _reset(s: ControllerSession) -> None:
+        s.state = StreamState.IDLE
+        s.error = None
+        s.sent = s.acked = 0
+        s.bytes_in_flight = s.bytes_acked = 0
+        s.in_flight.clear()
+        s._rx.clear()
+        s._started = False
+        s._rx_query_sent = False
+        if not s._rx_size_given:
+            s.rx_buffer_size = None
+
+    def _set_state(self, s: ControllerSession, state: StreamState) -> None:
+        s.state = state
+        if self.state_callback:
+            self.state_callback(s.name, state)
+
+    def _fail(self, s: ControllerSession, err: StreamError) -> None:
+        s.error = err
+        self._set_state(s, StreamState.ERROR)
+        self._close(s)
+        if self.error_callback:
+            self.error_callback(s.name, err)
+
+    def _close(self, s: ControllerSession) -> None:
+        """I/O thread (or before it starts) only: the selector is not shared."""
+        if s._fd is not None and self._sel is not None:
+            try:
+                self._sel.unregister(s._fd)
+            except (KeyError, ValueError):
+                pass
+        s._fd = None
+        if s._ser is not None:
+            try:
+                s._ser.close()
+            except Exception:
+                pass
+        s._ser = None
+
+    def _send_realtime(self, s: ControllerSession, data: bytes) -> None:
+        if s._ser is not None:
+            s._ser.write(data)
+
+    # -----------------------------
+    # I/O loop
+    # -----------------------------
+    def _io_loop(self) -> None:
+        """Single thread for every port: wait for input on any of them,
+        handle complete lines, start senders whose drain has ended."""
+        sel = self._sel = selectors.DefaultSelector()
+        polled: List[ControllerSession] = []
+        for s in self.sessions.values():
+            if s._ser is None:
+                continue
+            try:
+                fd = s._ser.fileno()
+                sel.register(fd, selectors.EVENT_READ, s)
+                s._fd = fd
+            except (AttributeError, OSError, ValueError):
+                polled.append(s)  # no selectable handle (Windows COM port)
+
+        try:
+            while not self._stop_event.is_set():
+                with self._lock:
+                    live = [s for s in self.sessions.values() if s.active]
+                if not live:
+                    break
+                wait = self._wait_time(live, polled)
+                if sel.get_map():
+                    ready = [key.data for key, _ in sel.select(wait)]
+                else:
+                    time.sleep(wait)
+                    ready = []
+                with self._lock:
+                    for s in ready + polled:
+                        if s.active:
+                            self._read(s)
+                    now = time.monotonic()
+                    for s in live:
+                        if s.active and not s._started and now >= s._send_after:
+                            if s.rx_buffer_size is None and not s._rx_query_sent:
+                                # Drained: ask for a report while the RX ring is empty
+                                s._rx_query_sent = True
+                                s._send_after = now + self.rx_query_timeout
+                                self._send_realtime(s, b"?")
+                                continue
+                            if s.rx_buffer_size is None:
+                                self.log(f"[{s.name}] No RX size in the status report; "
+                                         f"assuming {DEFAULT_RX_BUFFER_SIZE} bytes.")
+                                s.rx_buffer_size = DEFAULT_RX_BUFFER_SIZE
+                            s._started = True
+                            self._fill_rx_buffer(s)
+                            self._check_done(s)
+                        if not s.active:
+                            self._close(s)  # done, failed or aborted
+        finally:
+            with self._lock:
+                for s in self.sessions.values():
+                    self._close(s)
+            sel.close()
+            self._sel = None
+            self.log("Fleet I/O loop terminated.")
+
+    def _wait_time(self, live: List[ControllerSession], polled: List[ControllerSession]) -> float:
+        wait = self.poll_interval if polled else 0.1
+        now = time.monotonic()
+        for s in live:
+            if not s._started:
+                wait = min(wait, max(0.0, s._send_after - now))
+        return wait
+
+    def _read(self, s: ControllerSession) -> None:
+        try:
+            data = s._ser.read(s._ser.in_waiting or 1)
+        except Exception as e:
+            self.log(f"[{s.name}] Serial read error: {e}")
+            self._fail(s, StreamError(line_index=s.acked, line_text="", error_code=f"PORT:{e}", raw_line=""))
+            return
+        if not data:
+            return
+        s._rx.extend(data)
+        while s.active:
+            nl = s._rx.find(b"\n")
+            if nl < 0:
+                break
+            raw = bytes(s._rx[:nl])
+            del s._rx[: nl + 1]
+            line = raw.decode("ascii", errors="replace").strip("\r\n")
+            if line:
+                self._handle_incoming_line(s, line)
+
+    def _handle_incoming_line(self, s: ControllerSession, line: str) -> None:
+        if not s._started:
+            rx = parse_rx_free(line) if s._rx_query_sent and s.rx_buffer_size is None else None
+            if rx:
+                self.log(f"[{s.name}] Controller RX buffer: {rx} bytes.")
+                s.rx_buffer_size = rx
+                s._send_after = time.monotonic()  # start sending now
+            else:
+                self.log(f"[{s.name}] STARTUP: {line}")
+            return
+        if self.verbose:
+            self.log(f"[{s.name}] RECV: {line}")
+        line_lc = line.lower()
+        if line_lc == "ok":
+            self._on_ok(s)
+        elif line_lc.startswith("error:"):
+            self._on_error(s, line[len("error:") :].strip(), raw_line=line)
+
+    def _on_ok(self, s: ControllerSession) -> None:
+        if not s.in_flight:
+            return  # stray 'ok' (e.g. from a manual command)
+        _, size = s.in_flight.popleft()
+        s.bytes_in_flight -= size
+        s.bytes_acked += size
+        s.acked += 1
+        if self.progress_callback:
+            self.progress_callback(s.name, s.acked, s.total_lines)
+        if self.byte_progress_callback:
+            self.byte_progress_callback(s.name, s.bytes_acked, s.total_bytes)
+        if s.state == StreamState.SENDING:
+            self._fill_rx_buffer(s)
+        self._check_done(s)
+
+    def _on_error(self, s: ControllerSession, error_code: str, raw_line: str) -> None:
+        self.log(f"[{s.name}] Controller reported error: {error_code}")
+        # Replies arrive in order: the error belongs to the oldest line in flight
+        line_text = s.in_flight[0][0] if s.in_flight else ""
+        self._fail(s, StreamError(line_index=s.acked, line_text=line_text,
+                                  error_code=error_code, raw_line=raw_line))
+
+    def _check_done(self, s: ControllerSession) -> None:
+        if s.active and s.sent == s.total_lines and not s.in_flight:
+            self.log(f"[{s.name}] All lines acknowledged. Job DONE.")
+            self._set_state(s, StreamState.DONE)
+            self._close(s)
+
+    def _fill_rx_buffer(self, s: ControllerSession) -> None:
+        """Send while the next line fits the controller's RX buffer (see
+        GrblStreamer._fill_rx_buffer)."""
+        if s._ser is None:
+            return
+        while s.sent < s.total_lines:
+            line = s.lines[s.sent]
+            size = len(line) + 1  # trailing '\n'
+            if s.in_flight:
+                if not s.char_counting:
+                    return
+                if s.bytes_in_flight + size > s.rx_buffer_size:
+                    return
+            if line.startswith(BIN_FRAME_SOF):
+                data = (line + "\n").encode("latin-1")
+                shown = f"<frame {len(line)} bytes>"
+            else:
+                data = (line + "\n").encode("ascii", errors="replace")
+                shown = line
+            if self.verbose:
+                self.log(f"[{s.name}] SEND[{s.sent + 1}/{s.total_lines}]: {shown}")
+            s._ser.write(data)
+            s.in_flight.append((line, size))
+            s.bytes_in_flight += size
+            s.sent += 1
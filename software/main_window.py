@@ -1,12 +1,14 @@
 import main
 import json
+import job_estimator
+import job_manager
 from main import ProcessorWorker
 from main import PreviewCanvas
 from pathlib import Path
 from typing import Any, Optional, List
 
 
-from PySide6.QtCore import  QThread
+from PySide6.QtCore import  QThread, QObject, Signal
 
 from PySide6.QtWidgets import (
     QApplication,
@@ -17,6 +19,7 @@ from PySide6.QtWidgets import (
     QPushButton,
     QLabel,
     QFileDialog,
+    QInputDialog,
     QMessageBox,
     QTextEdit,
     QGroupBox,
@@ -24,6 +27,20 @@ from PySide6.QtWidgets import (
     QSizePolicy,
     
 )
+
+# Converted jobs survive restarts here, keyed by SVG content + parameters
+CACHE_DIR = Path.home() / ".signature_engravers" / "gcode_cache"
+
+
+class FleetEvents(QObject):
+    """FleetStreamer callbacks run on its I/O thread; re-emit them as
+    signals so the slots run on the GUI thread."""
+    log = Signal(str)
+    state = Signal(str, str)
+    progress = Signal(str, int, int)
+    error = Signal(str, str)
+
+
 class MainWindow(QMainWindow):
     def __init__(self):
         super().__init__()
@@ -56,9 +73,14 @@ class MainWindow(QMainWindow):
         self.btn_save = QPushButton("Save G-code...")
         self.btn_save.setEnabled(False)
         self.btn_save.clicked.connect(self.save_gcode_dialog)
+        # Stream the current job to one or more controllers at once
+        self.btn_stream = QPushButton("Stream to machines...")
+        self.btn_stream.setEnabled(False)
+        self.btn_stream.clicked.connect(self.stream_dialog)
         fg_layout.addWidget(self.lbl_file)
         fg_layout.addWidget(self.btn_open)
         fg_layout.addWidget(self.btn_save)
+        fg_layout.addWidget(self.btn_stream)
         right_col.addWidget(file_group)
 
         # Console / log
@@ -84,6 +106,17 @@ class MainWindow(QMainWindow):
         self._thread: QThread = None
         self._last_polylines: Optional[List[List[tuple]]] = None
         self._last_gcode: Optional[List[str]] = None
+        self._resolution: float = 0.5
+        self._from_cache = False
+        self._last_job: Optional[job_manager.Job] = None
+        self.cache = job_manager.ConversionCache(cache_dir=CACHE_DIR)
+        self._fleet: Optional[job_manager.FleetStreamer] = None
+        self._fleet_progress: dict = {}
+        self._fleet_events = FleetEvents()
+        self._fleet_events.log.connect(self.console_append)
+        self._fleet_events.state.connect(self.on_fleet_state)
+        self._fleet_events.progress.connect(self.on_fleet_progress)
+        self._fleet_events.error.connect(self.on_fleet_error)
 
         # Default UI state
         self.btn_save.setEnabled(False)
@@ -139,6 +172,21 @@ class MainWindow(QMainWindow):
         self.run_processor_worker(str(path))
 
     def run_processor_worker(self, svg_path: str, resolution: float = 0.5) -> None:
+        self._resolution = resolution
+        # Same file content and parameters as an earlier run: no conversion
+        try:
+            job = self.cache.lookup(svg_path, resolution=resolution)
+        except OSError:
+            job = None
+        if job is not None:
+            self.console_append("Using cached G-code (SVG unchanged since last conversion).")
+            self._from_cache = True
+            self._last_job = job
+            self.on_processing_finished({"polylines": None, "gcode": list(job.lines)})
+            return
+        self._from_cache = False
+        self._last_job = None
+
         # Disable open while processing
         self.btn_open.setEnabled(False)
         self.status_label.setText("Processing SVG...")
@@ -174,6 +222,11 @@ class MainWindow(QMainWindow):
         # Store for later saving
         self._last_polylines = polylines
         self._last_gcode = gcode if isinstance(gcode, list) else None
+        if self._last_gcode and not self._from_cache and self.current_svg is not None:
+            try:
+                self._last_job = self.cache.put(self.current_svg, self._last_gcode, resolution=self._resolution)
+            except OSError as e:
+                self.console_append(f"G-code not cached: {e}")
 
         # Display summary and contents
         if polylines is not None:
@@ -189,8 +242,15 @@ class MainWindow(QMainWindow):
             self.console_append("Generated G-code:")
             for ln in self._last_gcode:
                 self.console_append(ln)
-            # Enable save button
+            try:
+                estimate = job_estimator.estimate_job(self._last_gcode)
+                self.console_append(estimate.summary())
+                self.status_label.setText(f"SVG processed, est. {estimate.duration_s / 60.0:.1f} min")
+            except Exception as e:
+                self.console_append(f"Job estimate unavailable: {e}")
+            # Enable save and stream buttons
             self.btn_save.setEnabled(True)
+            self.btn_stream.setEnabled(True)
             QMessageBox.information(self, "Processing finished", "SVG parsed and G-code generated. See console.")
         else:
             self.console_append("No G-code generated.")
@@ -203,6 +263,7 @@ class MainWindow(QMainWindow):
         QMessageBox.critical(self, "Processing error", message)
         self._last_gcode = None
         self.btn_save.setEnabled(False)
+        self.btn_stream.setEnabled(False)
 
     def save_gcode_dialog(self) -> None:
         if not self._last_gcode:
@@ -222,6 +283,64 @@ class MainWindow(QMainWindow):
             QMessageBox.critical(self, "Save error", f"Could not save file: {e}")
             self.console_append(f"Failed to save G-code: {e}")
 
+    def stream_dialog(self) -> None:
+        if not self._last_gcode:
+            QMessageBox.information(self, "No G-code", "No G-code available to stream.")
+            return
+        if self._fleet is not None and any(
+            s in (job_manager.StreamState.SENDING, job_manager.StreamState.PAUSED)
+            for s in self._fleet.states().values()
+        ):
+            QMessageBox.information(self, "Streaming", "A job is already streaming.")
+            return
+        text, ok = QInputDialog.getText(
+            self, "Stream to machines", "Serial ports (comma separated), e.g. COM11, COM12:"
+        )
+        ports = [p.strip() for p in text.split(",") if p.strip()] if ok else []
+        if not ports:
+            return
+
+        job = self._last_job if self._last_job is not None else self._last_gcode
+        ev = self._fleet_events
+        self._fleet = job_manager.FleetStreamer(
+            log_callback=ev.log.emit,
+            state_callback=lambda name, st: ev.state.emit(name, st.name),
+            progress_callback=ev.progress.emit,
+            error_callback=lambda name, err: ev.error.emit(
+                name, f"error:{err.error_code} at line {err.line_index + 1}: {err.line_text}"
+            ),
+        )
+        self._fleet_progress = {}
+        for port in dict.fromkeys(ports):
+            self._fleet.add(port, 115200, job)
+            self._fleet_progress[port] = "waiting"
+        self._fleet.start()
+        self._show_fleet_status()
+
+    def _show_fleet_status(self) -> None:
+        self.status_label.setText(" | ".join(f"{n}: {p}" for n, p in self._fleet_progress.items()))
+
+    def on_fleet_state(self, name: str, state: str) -> None:
+        if state != job_manager.StreamState.SENDING.name:
+            self._fleet_progress[name] = state.lower()
+            self._show_fleet_status()
+        self.console_append(f"[{name}] {state}")
+
+    def on_fleet_progress(self, name: str, acked: int, total: int) -> None:
+        pct = 100.0 * acked / total if total else 100.0
+        self._fleet_progress[name] = f"{pct:.0f}%"
+        self._show_fleet_status()
+
+    def on_fleet_error(self, name: str, message: str) -> None:
+        self.console_append(f"[{name}] {message}")
+        QMessageBox.warning(self, "Controller error", f"{name}: {message}")
+
+    def closeEvent(self, event) -> None:
+        if self._fleet is not None:
+            self._fleet.abort()
+            self._fleet.join(timeout=2.0)
+        super().closeEvent(event)
+
 if __name__ == "__main__":
     import sys
 
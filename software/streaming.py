@@ -1,11 +1,53 @@
+import queue
 import threading
 import time
+from collections import deque
 from dataclasses import dataclass
 from enum import Enum, auto
-from typing import Callable, List, Optional
+from typing import Callable, Deque, Iterable, Iterator, List, Optional, Tuple
 
 import serial  # pip install pyserial
 
+# First byte of a binary motion frame line (see svg_parser.encode_motion_frame)
+BIN_FRAME_SOF = "\x01"
+
+# Realtime override bytes (see src/protocol.h), for GrblStreamer.override()
+RT_FEED_OVR_RESET = 0x90
+RT_FEED_OVR_COARSE_PLUS = 0x91
+RT_FEED_OVR_COARSE_MINUS = 0x92
+RT_FEED_OVR_FINE_PLUS = 0x93
+RT_FEED_OVR_FINE_MINUS = 0x94
+RT_RAPID_OVR_RESET = 0x95
+RT_RAPID_OVR_MEDIUM = 0x96
+RT_RAPID_OVR_LOW = 0x97
+RT_SPINDLE_OVR_RESET = 0x99
+RT_SPINDLE_OVR_COARSE_PLUS = 0x9A
+RT_SPINDLE_OVR_COARSE_MINUS = 0x9B
+RT_SPINDLE_OVR_FINE_PLUS = 0x9C
+RT_SPINDLE_OVR_FINE_MINUS = 0x9D
+RT_OVR_FIRST, RT_OVR_LAST = RT_FEED_OVR_RESET, RT_SPINDLE_OVR_FINE_MINUS
+
+# Character counting budget when the controller does not report its RX size
+DEFAULT_RX_BUFFER_SIZE = 1024
+
+
+def parse_rx_free(line: str) -> Optional[int]:
+    """Free RX bytes from a status report's 'Bf:<blocks>,<rx_free>' field,
+    or None if the line is not a report or has no RX count."""
+    if not (line.startswith("<") and line.endswith(">")):
+        return None
+    for fld in line[1:-1].split("|"):
+        if fld.startswith("Bf:"):
+            parts = fld[3:].split(",")
+            if len(parts) == 2 and parts[1].isdigit():
+                return int(parts[1])
+    return None
+
+
+# Source-queue markers: nothing buffered yet / generator exhausted
+_WAIT = object()
+_EOF = object()
+
 
 class StreamState(Enum):
     IDLE = auto()
@@ -30,10 +72,20 @@ def default_logger(msg: str) -> None:
 class GrblStreamer:
     """
     Simple grblHAL / Grbl streaming class:
-    - Sends G-code lines one-by-one.
-    - Waits for 'ok' before sending the next line.
+    - Character-counting flow control (default): keeps sending lines while
+      the bytes in flight fit in the controller's RX buffer
+      (rx_buffer_size). Each 'ok' acknowledges the oldest line in flight and
+      frees len(line) + 1 bytes. Left as None, the size is read from the
+      'Bf:' field of a status report after the startup drain (the RX ring
+      is empty then), falling back to DEFAULT_RX_BUFFER_SIZE.
+    - With char_counting=False, sends one line and waits for its 'ok'.
     - Stops on 'error:<code>' and reports which line failed.
     - Tolerates extra info lines from the controller.
+    - lines may be a list or any iterable/generator. A generator is drained
+      by a producer thread into a bounded lookahead queue, so sending
+      starts with the first line generated and memory stays flat however
+      long the job is. Pass total_lines (exact or estimated) and/or
+      total_bytes for meaningful progress.
 
     Usage:
         streamer = GrblStreamer(
@@ -46,24 +98,43 @@ class GrblStreamer:
             progress_callback=your_progress_func,
         )
         streamer.start()
+
+        # Cut while the rest of the SVG is still being converted
+        streamer = GrblStreamer("COM11", 115200, svg_parser.iter_svg_gcode("art.svg"),
+                                total_lines=estimate)
     """
 
     def __init__(
         self,
         port: str,
         baudrate: int,
-        lines: List[str],
+        lines: Iterable[str],
         log_callback: Callable[[str], None] = default_logger,
         state_callback: Optional[Callable[[StreamState], None]] = None,
         error_callback: Optional[Callable[[StreamError], None]] = None,
         progress_callback: Optional[Callable[[int, int], None]] = None,
         timeout: float = 1.0,
         startup_drain_time: float = 1.0,
+        char_counting: bool = True,
+        rx_buffer_size: Optional[int] = None,
+        total_lines: Optional[int] = None,
+        total_bytes: Optional[int] = None,
+        lookahead: int = 512,
+        byte_progress_callback: Optional[Callable[[int, Optional[int]], None]] = None,
     ) -> None:
         self.port = port
         self.baudrate = baudrate
-        self.raw_lines = lines  # original lines
-        self.lines = self._preprocess_lines(lines)
+        self.raw_lines = lines  # original lines (or the generator)
+        # Lists are cleaned up front as before; anything else streams
+        self.lines: Optional[List[str]] = None
+        if isinstance(lines, (list, tuple)):
+            self.lines = self._preprocess_lines(lines)
+            total_lines = len(self.lines)
+            total_bytes = sum(len(ln) + 1 for ln in self.lines)
+        self.total_lines = total_lines  # exact for lists, else caller's estimate
+        self.total_bytes = total_bytes
+        self.lookahead = max(1, lookahead)
+        self.byte_progress_callback = byte_progress_callback
         self.log = log_callback
         self.state_callback = state_callback
         self.error_callback = error_callback
@@ -72,14 +143,33 @@ class GrblStreamer:
         self.timeout = timeout
         self.startup_drain_time = startup_drain_time
 
+        # Must not exceed the firmware's PROTOCOL_RX_BUFFER_SIZE; None asks it
+        self.char_counting = char_counting
+        self.rx_buffer_size = rx_buffer_size
+        self._rx_size_given = rx_buffer_size is not None
+
         self._ser: Optional[serial.Serial] = None
         self._rx_thread: Optional[threading.Thread] = None
         self._stop_event = threading.Event()
 
         self.state: StreamState = StreamState.IDLE
-        self._line_index: int = 0  # index into self.lines
+        self._line_index: int = 0  # lines sent so far (index of the next one)
+        self._acked: int = 0  # lines acknowledged with 'ok'
+        self._in_flight: Deque[Tuple[str, int]] = deque()  # (line, bytes) per unacked line
+        self._bytes_in_flight: int = 0
+        self.bytes_sent: int = 0
+        self.bytes_acked: int = 0
         self._lock = threading.Lock()
 
+        # Line source: list iterator, or producer thread + bounded queue
+        self._source: Optional[Iterator[str]] = None
+        self._queue: Optional["queue.Queue"] = None
+        self._producer: Optional[threading.Thread] = None
+        self._next_line: Optional[str] = None  # taken from the source, not yet sent
+        self._source_done = False
+        self._consumed = False
+        self._started = False  # startup drain finished, sending allowed
+
     # -----------------------------
     # Public API
     # -----------------------------
@@ -106,6 +196,18 @@ class GrblStreamer:
 
         self._stop_event.clear()
         self._line_index = 0
+        self._acked = 0
+        self._in_flight.clear()
+        self._bytes_in_flight = 0
+        self.bytes_sent = 0
+        self.bytes_acked = 0
+        self._next_line = None
+        self._source_done = False
+        self._started = False
+        if not self._open_source():
+            self._close_port()
+            self._set_state(StreamState.ERROR)
+            return
         self._set_state(StreamState.SENDING)
 
         self._rx_thread = threading.Thread(target=self._io_loop, daemon=True)
@@ -126,9 +228,16 @@ class GrblStreamer:
                 return
             self._send_realtime(b"~")
             self._set_state(StreamState.SENDING)
-            # Resume by sending the current line if not yet acked
-            if self._line_index < len(self.lines):
-                self._send_current_line()
+            # Lines already in flight are still acknowledged; just top up
+            self._fill_rx_buffer()
+
+    def override(self, code: int) -> None:
+        """Send one realtime override byte (RT_FEED_OVR_* etc.); the
+        controller rescales queued motion without flushing it."""
+        if not RT_OVR_FIRST <= code <= RT_OVR_LAST:
+            raise ValueError(f"not an override byte: {code:#x}")
+        with self._lock:
+            self._send_realtime(bytes([code]))
 
     def abort(self) -> None:
         """Send Ctrl-X, stop streaming, close port."""
@@ -144,6 +253,82 @@ class GrblStreamer:
         if t is not None:
             t.join(timeout=timeout)
 
+    # -----------------------------
+    # Line source
+    # -----------------------------
+    def _open_source(self) -> bool:
+        if self.lines is not None:
+            self._source = iter(self.lines)
+            self._queue = None
+            return True
+        if self._consumed:
+            self.log("Cannot restart: the line generator was already consumed.")
+            return False
+        self._consumed = True
+        self._queue = queue.Queue(maxsize=self.lookahead)
+        self._producer = threading.Thread(target=self._produce, daemon=True)
+        self._producer.start()
+        return True
+
+    def _produce(self) -> None:
+        """Producer thread: clean generator lines into the lookahead queue."""
+        try:
+            for raw in self.raw_lines:
+                ln = self._preprocess_line(raw)
+                if ln is None:
+                    continue
+                if not self._put(ln):
+                    return
+                # Sending may have been waiting on us
+                with self._lock:
+                    if self.state == StreamState.SENDING and self._started:
+                        self._fill_rx_buffer()
+        except Exception as e:
+            self.log(f"Line generator failed: {e}")
+        self._put(_EOF)
+        with self._lock:
+            if self.state == StreamState.SENDING and self._started:
+                self._fill_rx_buffer()
+                self._check_done()
+
+    def _put(self, item) -> bool:
+        while not self._stop_event.is_set():
+            try:
+                self._queue.put(item, timeout=0.1)
+                return True
+            except queue.Full:
+                continue
+        return False
+
+    def _take(self):
+        """Next cleaned line, _WAIT if the generator is behind, _EOF at the end."""
+        if self._next_line is not None:
+            return self._next_line
+        if self._source_done:
+            return _EOF
+        if self._queue is None:
+            item = next(self._source, _EOF)
+        else:
+            try:
+                item = self._queue.get_nowait()
+            except queue.Empty:
+                return _WAIT
+        if item is _EOF:
+            self._source_done = True
+            if self.lines is None:
+                # Now known exactly
+                self.total_lines = self._line_index
+                self.total_bytes = self.bytes_sent
+            return _EOF
+        self._next_line = item
+        return item
+
+    def _check_done(self) -> None:
+        if self._source_done and self._next_line is None and not self._in_flight:
+            self.log("All lines acknowledged. Job DONE.")
+            self._set_state(StreamState.DONE)
+            self._stop_event.set()
+
     # -----------------------------
     # Internal helpers
     # -----------------------------
@@ -174,8 +359,15 @@ class GrblStreamer:
         if not self._ser or not self._ser.is_open:
             self.log("Port not open, cannot send line.")
             return
-        data = (line + "\n").encode("ascii", errors="replace")
-        self.log(f"SEND[{self._line_index + 1}/{len(self.lines)}]: {line}")
+        if line.startswith(BIN_FRAME_SOF):
+            # Binary motion frame: one char per byte, already stuffed
+            data = (line + "\n").encode("latin-1")
+            shown = f"<frame {len(line)} bytes>"
+        else:
+            data = (line + "\n").encode("ascii", errors="replace")
+            shown = line
+        total = self.total_lines if self.total_lines is not None else "?"
+        self.log(f"SEND[{self._line_index + 1}/{total}]: {shown}")
         self._ser.write(data)
 
     def _send_realtime(self, data: bytes) -> None:
@@ -183,39 +375,48 @@ class GrblStreamer:
             return
         self._ser.write(data)
 
-    def _preprocess_lines(self, lines: List[str]) -> List[str]:
+    def _preprocess_lines(self, lines: Iterable[str]) -> List[str]:
+        """Clean every line up front (list input), see _preprocess_line."""
+        cleaned: List[str] = []
+        for ln in lines:
+            ln = self._preprocess_line(ln)
+            if ln is not None:
+                cleaned.append(ln)
+        return cleaned
+
+    @staticmethod
+    def _preprocess_line(ln: str) -> Optional[str]:
         """
         - Strip whitespace
-        - Drop empty lines
+        - Drop empty lines (returns None)
         - Remove '; comment' and '(comment)' blocks in a simple way
         """
-        cleaned: List[str] = []
-        for ln in lines:
-            ln = ln.strip()
-            if not ln:
-                continue
+        if ln.startswith(BIN_FRAME_SOF):
+            # Binary frames may contain any of ' ;()' and must go out as-is
+            return ln
+        ln = ln.strip()
+        if not ln:
+            return None
 
-            # strip ';' comments
-            if ";" in ln:
-                ln = ln.split(";", 1)[0].rstrip()
+        # strip ';' comments
+        if ";" in ln:
+            ln = ln.split(";", 1)[0].rstrip()
 
-            # strip simple '(...)' comments fully if the line is just a comment
-            if ln.startswith("(") and ln.endswith(")"):
-                continue
+        # strip simple '(...)' comments fully if the line is just a comment
+        if ln.startswith("(") and ln.endswith(")"):
+            return None
 
-            # very basic '(comment)' removal in-line
-            # this is not a full parser but good enough for many cases
-            while True:
-                start = ln.find("(")
-                end = ln.find(")", start + 1)
-                if start != -1 and end != -1 and end > start:
-                    ln = (ln[:start] + " " + ln[end + 1 :]).strip()
-                else:
-                    break
-
-            if ln:
-                cleaned.append(ln)
-        return cleaned
+        # very basic '(comment)' removal in-line
+        # this is not a full parser but good enough for many cases
+        while True:
+            start = ln.find("(")
+            end = ln.find(")", start + 1)
+            if start != -1 and end != -1 and end > start:
+                ln = (ln[:start] + " " + ln[end + 1 :]).strip()
+            else:
+                break
+
+        return ln or None
 
     # -----------------------------
     # I/O Loop and parsing
@@ -232,16 +433,22 @@ class GrblStreamer:
                     continue
                 self.log(f"STARTUP: {line}")
 
-            # 2) start sending the first line, if any
+            # 2) learn the RX buffer size, unless the caller fixed it
+            if not self._rx_size_given:
+                self.rx_buffer_size = self._query_rx_buffer_size()
+
+            # 3) start sending, if there is anything to send
             with self._lock:
-                if self.state == StreamState.SENDING and self._line_index < len(self.lines):
-                    self._send_current_line()
-                elif not self.lines:
+                if self.lines is not None and not self.lines:
                     self.log("No G-code lines to send.")
                     self._set_state(StreamState.DONE)
                     return
+                self._started = True
+                if self.state == StreamState.SENDING:
+                    self._fill_rx_buffer()
+                    self._check_done()
 
-            # 3) main loop
+            # 4) main loop
             while not self._stop_event.is_set():
                 line = self._read_line()
                 if line is None:
@@ -252,6 +459,22 @@ class GrblStreamer:
             self._close_port()
             self.log("I/O loop terminated.")
 
+    def _query_rx_buffer_size(self) -> int:
+        """Ask for a status report and take its free RX bytes as the
+        buffer size; nothing is in flight yet, so the ring is empty."""
+        self._send_realtime(b"?")
+        t_end = time.time() + self.timeout
+        while time.time() < t_end and not self._stop_event.is_set():
+            line = self._read_line()
+            if line is None:
+                continue
+            rx = parse_rx_free(line)
+            if rx:
+                self.log(f"Controller RX buffer: {rx} bytes.")
+                return rx
+        self.log(f"No RX size in the status report; assuming {DEFAULT_RX_BUFFER_SIZE} bytes.")
+        return DEFAULT_RX_BUFFER_SIZE
+
     def _read_line(self) -> Optional[str]:
         """Read one line (ASCII) from serial; return None on timeout."""
         if not self._ser or not self._ser.is_open:
@@ -294,22 +517,24 @@ class GrblStreamer:
 
     def _on_ok(self) -> None:
         with self._lock:
-            if self.state != StreamState.SENDING:
-                # ignore 'ok' if not currently sending
+            if not self._in_flight:
+                # stray 'ok' (e.g. from a manual command); nothing to ack
                 return
 
-            self._line_index += 1
+            _, size = self._in_flight.popleft()
+            self._bytes_in_flight -= size
+            self.bytes_acked += size
+            self._acked += 1
             if self.progress_callback:
-                self.progress_callback(self._line_index, len(self.lines))
+                # An estimate can be overtaken; never report past 100%
+                total = max(self.total_lines or 0, self._acked)
+                self.progress_callback(self._acked, total)
+            if self.byte_progress_callback:
+                self.byte_progress_callback(self.bytes_acked, self.total_bytes)
 
-            if self._line_index >= len(self.lines):
-                self.log("All lines acknowledged. Job DONE.")
-                self._set_state(StreamState.DONE)
-                self._stop_event.set()
-                return
-
-            # send next line
-            self._send_current_line()
+            if self.state == StreamState.SENDING:
+                self._fill_rx_buffer()
+            self._check_done()
 
     def _on_error(self, error_code: str, raw_line: str) -> None:
         with self._lock:
@@ -317,10 +542,10 @@ class GrblStreamer:
             self._set_state(StreamState.ERROR)
             self._stop_event.set()
 
-            line_index = self._line_index
-            line_text = ""
-            if 0 <= line_index < len(self.lines):
-                line_text = self.lines[line_index]
+            # Replies arrive in order, so the error belongs to the oldest
+            # line still in flight.
+            line_index = self._acked
+            line_text = self._in_flight[0][0] if self._in_flight else ""
 
             err = StreamError(
                 line_index=line_index,
@@ -331,8 +556,29 @@ class GrblStreamer:
             if self.error_callback:
                 self.error_callback(err)
 
-    def _send_current_line(self) -> None:
-        if 0 <= self._line_index < len(self.lines):
-            self._send_line(self.lines[self._line_index])
-        else:
-            self.log("send_current_line: index out of range.")
\ No newline at end of file
+    def _fill_rx_buffer(self) -> None:
+        """Send lines while they fit in the controller's RX buffer.
+
+        Character counting: the controller frees len(line) + 1 bytes per
+        'ok', so lines can be queued until the running byte count would
+        exceed rx_buffer_size. A line longer than the whole buffer is sent
+        alone once everything else has been acknowledged. Stops early when
+        a generator has not produced the next line yet; the producer
+        calls back in when it has.
+        """
+        while True:
+            line = self._take()
+            if line is _WAIT or line is _EOF:
+                return
+            size = len(line) + 1  # trailing '\n'
+            if self._in_flight:
+                if not self.char_counting:
+                    return
+                if self._bytes_in_flight + size > self.rx_buffer_size:
+                    return
+            self._send_line(line)
+            self._next_line = None
+            self._in_flight.append((line, size))
+            self._bytes_in_flight += size
+            self.bytes_sent += size
+            self._line_index += 1
@@ -1,56 +1,120 @@
 from svgpathtools import svg2paths2
 from pathlib import Path
-from typing import List, Tuple
+from typing import Iterable, Iterator, List, Optional, Tuple
+import itertools
 
+import numpy as np  # already required by svgpathtools
 
-# Sample a single SVG segment into points
-def sample_segment(segment, resolution: float = 0.5) -> List[Tuple[float, float]]:
-    length = segment.length(error=1e-5)
-    num_samples = max(2, int(length / resolution))
 
-    pts = []
-    for i in range(num_samples + 1):
-        t = i / num_samples
-        z = segment.point(t)
-        pts.append((z.real, z.imag))
-    return pts
+# ----------------------------
+# Batched sampling
+# ----------------------------
+# Segment lengths are estimated from a chord polyline through this many
+# parameter steps instead of svgpathtools' adaptive integration.
+_LENGTH_PROBES = 16
 
-# Extract polylines from a full path
-def path_to_polylines(path, resolution: float = 0.5) -> List[List[Tuple[float, float]]]:
-    polylines = []
-    current_polyline = []
+def _as_cubic(segment) -> Optional[Tuple[complex, complex, complex, complex]]:
+    """Control points of a Line/Quadratic/Cubic as a cubic; None for arcs etc."""
+    name = segment.__class__.__name__
+    if name == "CubicBezier":
+        return segment.start, segment.control1, segment.control2, segment.end
+    if name == "QuadraticBezier":
+        q0, q1, q2 = segment.start, segment.control, segment.end
+        return q0, q0 + (q1 - q0) * (2.0 / 3.0), q2 + (q1 - q2) * (2.0 / 3.0), q2
+    if name == "Line":
+        p0, p1 = segment.start, segment.end
+        return p0, p0 + (p1 - p0) / 3.0, p0 + (p1 - p0) * (2.0 / 3.0), p1
+    return None
 
-    for segment in path:
-        seg_points = sample_segment(segment, resolution)
+def _cubic_basis(t: np.ndarray) -> np.ndarray:
+    mt = 1.0 - t
+    return np.stack([mt * mt * mt, 3.0 * mt * mt * t, 3.0 * mt * t * t, t * t * t], axis=-1)
 
-        # Avoid duplicating the first point
-        if current_polyline and seg_points:
-            seg_points = seg_points[1:]
+def _sample_segments(segments, resolution: float) -> Tuple[np.ndarray, np.ndarray]:
+    """
+    Sample every segment at once. Segment k gets max(2, length/resolution)
+    steps, i.e. sizes[k] points including both ends; all points come back
+    in one flat complex array. Beziers are evaluated with NumPy; arcs fall
+    back to segment.point().
+    """
+    m = len(segments)
+    ctrl = np.zeros((m, 4), dtype=complex)
+    is_bez = np.zeros(m, dtype=bool)
+    for k, seg in enumerate(segments):  # per segment, not per point
+        c = _as_cubic(seg)
+        if c is not None:
+            ctrl[k] = c
+            is_bez[k] = True
 
-        current_polyline.extend(seg_points)
+    probes = ctrl @ _cubic_basis(np.linspace(0.0, 1.0, _LENGTH_PROBES + 1)).T
+    lengths = np.abs(np.diff(probes, axis=1)).sum(axis=1)
+    for k in np.flatnonzero(~is_bez):
+        lengths[k] = segments[k].length(error=1e-5)
+    counts = np.maximum(2, (lengths / resolution).astype(np.int64))
 
-        # If segment is a Close object, finalize polyline
-        if segment.__class__.__name__ == "Close":
-            polylines.append(current_polyline)
-            current_polyline = []
+    sizes = counts + 1
+    starts = np.cumsum(sizes) - sizes
+    seg_of = np.repeat(np.arange(m), sizes)
+    t = (np.arange(int(sizes.sum())) - starts[seg_of]) / counts[seg_of]
+    z = np.einsum("ij,ij->i", _cubic_basis(t), ctrl[seg_of])
+    for k in np.flatnonzero(~is_bez):
+        sl = slice(starts[k], starts[k] + sizes[k])
+        z[sl] = [segments[k].point(tt) for tt in t[sl]]
+    return z, sizes
 
-    if current_polyline:
-        polylines.append(current_polyline)
+def _to_points(z: np.ndarray) -> List[Tuple[float, float]]:
+    return list(zip(z.real.tolist(), z.imag.tolist()))
 
-    return polylines
+# Sample a single SVG segment into points
+def sample_segment(segment, resolution: float = 0.5) -> List[Tuple[float, float]]:
+    z, _ = _sample_segments([segment], resolution)
+    return _to_points(z)
 
-# Parse an SVG file's paths into list of polylines
-def parse_svg_to_polylines(svg_path: str, resolution: float = 0.5) -> List[List[Tuple[float, float]]]:
+# Extract polylines from a full path
+def path_to_polylines(path, resolution: float = 0.5) -> List[List[Tuple[float, float]]]:
+    segments = list(path)
+    if not segments:
+        return []
+    z, sizes = _sample_segments(segments, resolution)
+    ends = np.cumsum(sizes)
+
+    # A segment that continues a polyline drops its first point (it repeats
+    # the previous end); a Close segment finishes the polyline.
+    closes = np.array([seg.__class__.__name__ == "Close" for seg in segments])
+    cont = np.zeros(len(segments), dtype=bool)
+    cont[1:] = ~closes[:-1]
+    keep = np.ones(len(z), dtype=bool)
+    keep[(ends - sizes)[cont]] = False
+
+    cuts = np.cumsum(keep)[ends[closes] - 1]
+    return [_to_points(piece) for piece in np.split(z[keep], cuts) if len(piece)]
+
+def iter_svg_polylines(
+    svg_path: str, resolution: float = 0.5, workers: int = 0
+) -> Iterator[List[Tuple[float, float]]]:
+    """
+    Yield polylines path by path. With workers > 1 the paths are sampled
+    in a process pool (results still arrive in file order).
+    """
     paths, attributes, svg_attr = svg2paths2(svg_path)
+    jobs = [path for path, attr in zip(paths, attributes) if "d" in attr]
 
-    all_polylines = []
-    for path, attr in zip(paths, attributes):
-        if "d" not in attr:
-            continue
-        polylines = path_to_polylines(path, resolution)
-        all_polylines.extend(polylines)
+    if workers > 1 and len(jobs) > 1:
+        from concurrent.futures import ProcessPoolExecutor
+        chunk = max(1, len(jobs) // (workers * 8))
+        with ProcessPoolExecutor(max_workers=workers) as pool:
+            for polylines in pool.map(path_to_polylines, jobs, itertools.repeat(resolution),
+                                      chunksize=chunk):
+                yield from polylines
+    else:
+        for path in jobs:
+            yield from path_to_polylines(path, resolution)
 
-    return all_polylines
+# Parse an SVG file's paths into list of polylines
+def parse_svg_to_polylines(
+    svg_path: str, resolution: float = 0.5, workers: int = 0
+) -> List[List[Tuple[float, float]]]:
+    return list(iter_svg_polylines(svg_path, resolution, workers))
 
 # ----------------------------
 # Added: polylines -> G-code
@@ -61,18 +125,296 @@ def _fmt(v: float) -> str:
 
 def _dedupe_points(poly: List[Tuple[float, float]], tol: float = 1e-6) -> List[Tuple[float, float]]:
     """Remove consecutive points that are closer than tol (Euclidean)."""
-    import math
-    if not poly:
+    if len(poly) == 0:
         return []
-    out: List[Tuple[float, float]] = [poly[0]]
-    for p in poly[1:]:
-        last = out[-1]
-        if math.hypot(p[0] - last[0], p[1] - last[1]) > tol:
-            out.append(p)
-    return out
+    arr = np.asarray(poly, dtype=float)
+    keep = np.ones(len(arr), dtype=bool)
+    step = np.diff(arr, axis=0)
+    keep[1:] = np.hypot(step[:, 0], step[:, 1]) > tol
+    return list(zip(arr[keep, 0].tolist(), arr[keep, 1].tolist()))
 
-def polylines_to_gcode(
+# ----------------------------
+# Path preprocessing: simplification, arc fitting, stroke ordering
+# ----------------------------
+def simplify_polyline(poly: List[Tuple[float, float]], tol: float) -> List[Tuple[float, float]]:
+    """
+    Ramer-Douglas-Peucker: drop points closer than tol to the chord of
+    their neighbours. Endpoints are always kept. Iterative, so long
+    polylines do not hit the recursion limit.
+    """
+    import math
+    n = len(poly)
+    if n < 3 or tol <= 0:
+        return list(poly)
+    keep = [False] * n
+    keep[0] = keep[-1] = True
+    stack = [(0, n - 1)]
+    while stack:
+        a, b = stack.pop()
+        ax, ay = poly[a]
+        bx, by = poly[b]
+        dx, dy = bx - ax, by - ay
+        chord = math.hypot(dx, dy)
+        worst, worst_i = -1.0, -1
+        for i in range(a + 1, b):
+            px, py = poly[i]
+            if chord > 0:
+                d = abs(dx * (ay - py) - dy * (ax - px)) / chord
+            else:
+                d = math.hypot(px - ax, py - ay)
+            if d > worst:
+                worst, worst_i = d, i
+        if worst > tol:
+            keep[worst_i] = True
+            stack.append((a, worst_i))
+            stack.append((worst_i, b))
+    return [p for p, k in zip(poly, keep) if k]
+
+def _circle_through(p0, p1, p2):
+    """Center and radius of the circle through three points, None if collinear."""
+    import math
+    ax, ay = p0
+    bx, by = p1
+    cx, cy = p2
+    d = 2.0 * (ax * (by - cy) + bx * (cy - ay) + cx * (ay - by))
+    if abs(d) < 1e-12:
+        return None
+    a2, b2, c2 = ax * ax + ay * ay, bx * bx + by * by, cx * cx + cy * cy
+    ux = (a2 * (by - cy) + b2 * (cy - ay) + c2 * (ay - by)) / d
+    uy = (a2 * (cx - bx) + b2 * (ax - cx) + c2 * (bx - ax)) / d
+    return (ux, uy), math.hypot(ax - ux, ay - uy)
+
+def _arc_fits(poly, a: int, b: int, tol: float, max_radius: float):
+    """
+    Fit poly[a..b] with one arc (center from first, middle, last point).
+    Returns (center, clockwise) when every point lies within tol of the
+    circle, turns the same way and the sweep stays under a half turn.
+    """
+    import math
+    fit = _circle_through(poly[a], poly[(a + b) // 2], poly[b])
+    if fit is None:
+        return None
+    (ux, uy), r = fit
+    if r > max_radius:
+        return None
+    sweep = 0.0
+    prev = math.atan2(poly[a][1] - uy, poly[a][0] - ux)
+    for i in range(a + 1, b + 1):
+        px, py = poly[i]
+        if abs(math.hypot(px - ux, py - uy) - r) > tol:
+            return None
+        ang = math.atan2(py - uy, px - ux)
+        step = (ang - prev + math.pi) % (2.0 * math.pi) - math.pi
+        if sweep and step and (step > 0) != (sweep > 0):
+            return None
+        sweep += step
+        prev = ang
+    if abs(sweep) >= math.pi:
+        return None
+    return (ux, uy), sweep < 0
+
+def fit_arcs(
+    poly: List[Tuple[float, float]],
+    tol: float,
+    min_points: int = 5,
+    max_radius: float = 1000.0,
+) -> List[tuple]:
+    """
+    Split a polyline into moves: ("G1", x, y) or ("G2"/"G3", x, y, i, j)
+    with I/J relative to the move's start. Runs of at least min_points
+    lying on a circle become one arc; the firmware re-densifies it by its
+    own chord tolerance. Straight runs are RDP-simplified with the same tol.
+    """
+    moves: List[tuple] = []
+    n = len(poly)
+    line_run = [poly[0]] if poly else []
+
+    def flush_lines():
+        for x, y in simplify_polyline(line_run, tol)[1:]:
+            moves.append(("G1", x, y))
+
+    s = 0
+    while s < n - 1:
+        best = None
+        e = s + min_points - 1
+        while e < n:
+            fit = _arc_fits(poly, s, e, tol, max_radius)
+            if fit is None:
+                break
+            best = (e, fit)
+            e += 1
+        if best is None:
+            s += 1
+            line_run.append(poly[s])
+            continue
+        e, ((ux, uy), cw) = best
+        flush_lines()
+        sx, sy = poly[s]
+        ex, ey = poly[e]
+        moves.append(("G2" if cw else "G3", ex, ey, ux - sx, uy - sy))
+        line_run = [poly[e]]
+        s = e
+    flush_lines()
+    return moves
+
+def order_polylines(
     polylines: List[List[Tuple[float, float]]],
+    start: Tuple[float, float] = (0.0, 0.0),
+    two_opt_passes: int = 4,
+) -> List[List[Tuple[float, float]]]:
+    """
+    Reorder (and reverse) strokes to cut rapid travel: greedy nearest
+    neighbour from start, then 2-opt passes. Reversing a span of strokes
+    also reverses each stroke in it, so the travel inside stays the same.
+    """
+    import math
+    strokes = [list(p) for p in polylines if p]
+    if len(strokes) < 2:
+        return strokes
+
+    def dist(p, q):
+        return math.hypot(p[0] - q[0], p[1] - q[1])
+
+    # Nearest neighbour, trying both ends of every remaining stroke
+    remaining = strokes[:]
+    ordered: List[List[Tuple[float, float]]] = []
+    pos = start
+    while remaining:
+        best_k, best_rev, best_d = 0, False, float("inf")
+        for k, st in enumerate(remaining):
+            d0, d1 = dist(pos, st[0]), dist(pos, st[-1])
+            if d0 < best_d:
+                best_k, best_rev, best_d = k, False, d0
+            if d1 < best_d:
+                best_k, best_rev, best_d = k, True, d1
+        st = remaining.pop(best_k)
+        if best_rev:
+            st.reverse()
+        ordered.append(st)
+        pos = st[-1]
+
+    # 2-opt over the stroke sequence
+    n = len(ordered)
+    for _ in range(two_opt_passes):
+        improved = False
+        for i in range(n - 1):
+            before = ordered[i - 1][-1] if i > 0 else start
+            for j in range(i + 1, n):
+                after = ordered[j + 1][0] if j + 1 < n else None
+                old = dist(before, ordered[i][0]) + (dist(ordered[j][-1], after) if after else 0.0)
+                new = dist(before, ordered[j][-1]) + (dist(ordered[i][0], after) if after else 0.0)
+                if new < old - 1e-9:
+                    span = ordered[i:j + 1]
+                    span.reverse()
+                    for st in span:
+                        st.reverse()
+                    ordered[i:j + 1] = span
+                    improved = True
+        if not improved:
+            break
+    return ordered
+
+def travel_length(polylines: List[List[Tuple[float, float]]], start: Tuple[float, float] = (0.0, 0.0)) -> float:
+    """Total rapid travel between strokes (and from start), in machine units."""
+    import math
+    total, pos = 0.0, start
+    for p in polylines:
+        if p:
+            total += math.hypot(p[0][0] - pos[0], p[0][1] - pos[1])
+            pos = p[-1]
+    return total
+
+# ----------------------------
+# Binary motion frames ($BIN=1), see src/protocol.h
+# ----------------------------
+BIN_SOF = 0x01
+BIN_ESC = 0x1B
+BIN_XOR = 0x40
+BIN_TYPE_DELTA_XY = 0x01
+BIN_FLAG_RAPID = 0x01
+BIN_UNITS_PER_MM = 1000
+BIN_MAX_POINTS = 32
+BIN_MAX_FRAME = 96  # controller line length (GRBL_LINE_MAX)
+
+# Bytes that must not appear raw in a frame: NUL, LF, CR, SOF, ESC, realtime
+# (including the 0x90..0x9D override bytes)
+_BIN_STUFFED = {0x00, 0x0A, 0x0D, BIN_SOF, BIN_ESC, ord("?"), ord("!"), ord("~"), 0x18}
+_BIN_STUFFED.update(range(0x90, 0x9E))
+
+def _crc8(data: bytes) -> int:
+    crc = 0
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+def _varint(v: int) -> bytes:
+    out = bytearray()
+    while v >= 0x80:
+        out.append((v & 0x7F) | 0x80)
+        v >>= 7
+    out.append(v)
+    return bytes(out)
+
+def _zigzag(v: int) -> int:
+    return (v << 1) if v >= 0 else ((-v << 1) - 1)
+
+def encode_motion_frame(deltas: List[Tuple[int, int]], feed: float = 0.0, rapid: bool = False) -> str:
+    """
+    Encode relative XY moves (integer counts, BIN_UNITS_PER_MM per mm) as one
+    binary frame line. The result holds one char per byte (latin-1) and has
+    no trailing newline, like the G-code lines it stands in for.
+    """
+    if not 1 <= len(deltas) <= BIN_MAX_POINTS:
+        raise ValueError("a frame carries 1..%d points" % BIN_MAX_POINTS)
+    raw = bytearray([BIN_TYPE_DELTA_XY, BIN_FLAG_RAPID if rapid else 0])
+    raw += _varint(max(0, int(round(feed))))
+    raw.append(len(deltas))
+    for dx, dy in deltas:
+        raw += _varint(_zigzag(dx))
+        raw += _varint(_zigzag(dy))
+    raw.append(_crc8(bytes(raw)))
+
+    out = bytearray([BIN_SOF])
+    for b in raw:
+        if b in _BIN_STUFFED:
+            out += bytes([BIN_ESC, b ^ BIN_XOR])
+        else:
+            out.append(b)
+    return out.decode("latin-1")
+
+def polyline_to_frames(
+    poly: List[Tuple[float, float]], feed: float, max_frame: int = BIN_MAX_FRAME
+) -> List[str]:
+    """
+    Encode the moves after poly[0] as binary frames. Deltas are taken
+    between points rounded to the count grid, so they never drift.
+    """
+    def q(v: float) -> int:
+        return int(round(v * BIN_UNITS_PER_MM))
+
+    frames: List[str] = []
+    run: List[Tuple[int, int]] = []
+    px, py = q(poly[0][0]), q(poly[0][1])
+    for x, y in poly[1:]:
+        qx, qy = q(x), q(y)
+        if (qx, qy) == (px, py):
+            continue
+        d = (qx - px, qy - py)
+        px, py = qx, qy
+        # Stuffing can double any byte, so check the encoded size
+        if run and (len(run) == BIN_MAX_POINTS or
+                    len(encode_motion_frame(run + [d], feed)) > max_frame):
+            frames.append(encode_motion_frame(run, feed))
+            run = []
+        run.append(d)
+    if run:
+        frames.append(encode_motion_frame(run, feed))
+    return frames
+
+def iter_gcode(
+    polylines: Iterable[List[Tuple[float, float]]],
     safe_z: float = 5.0,
     cut_z: float = -1.0,
     plunge_feed: float = 200.0,
@@ -82,11 +424,18 @@ def polylines_to_gcode(
     dedupe_tol: float = 1e-6,
     include_header: bool = True,
     include_footer: bool = True,
-) -> List[str]:
+    binary: bool = False,
+    simplify_tol: float | None = None,
+    arc_tol: float | None = None,
+    optimize_order: bool = False,
+) -> Iterator[str]:
     """
-    Convert polylines -> list of G-code lines.
+    Convert polylines -> G-code lines, one at a time. Nothing is held
+    beyond the current polyline, so huge inputs stream straight to a file
+    (see write_gcode); optimize_order is the exception, as it needs every
+    stroke up front.
 
-    - polylines: list of polylines; each polyline is a list of (x, y) points in machine units (e.g. mm).
+    - polylines: iterable of polylines; each polyline is a list of (x, y) points in machine units (e.g. mm).
     - safe_z: Z used for rapid travel (positive above work).
     - cut_z: Z used while cutting (negative plunges).
     - plunge_feed: feed rate for plunges and cutting (units/min).
@@ -95,19 +444,28 @@ def polylines_to_gcode(
     - comment: optional top-level comment string.
     - dedupe_tol: consecutive points closer than this are removed.
     - include_header/footer: include standard header/footer lines.
-    Returns a List[str] where each element is one G-code line (no trailing newline).
+    - binary: send the cutting moves as binary motion frames ($BIN=1); only
+      for controllers built with this protocol. Frames are latin-1 strings.
+    - simplify_tol: drop points within this distance of the path (RDP).
+    - arc_tol: fit G2/G3 arcs within this tolerance (straight runs are
+      simplified with it too); takes precedence over simplify_tol.
+    - optimize_order: reorder/reverse strokes to shorten G0 travel.
+    Yields one G-code line at a time (no trailing newline).
     """
-    lines: List[str] = []
-
     if include_header:
         if comment:
-            lines.append(f"({comment})")
-        lines.append("G21")   # mm
-        lines.append("G90")   # absolute coordinates
-        lines.append(f"G0 Z{_fmt(safe_z)}")
+            yield f"({comment})"
+        yield "G21"   # mm
+        yield "G90"   # absolute coordinates
+        yield f"G0 Z{_fmt(safe_z)}"
         if spindle_s is not None:
-            lines.append(f"M3 S{int(spindle_s)}")
-            lines.append("G4 P0.1")  # brief dwell to allow spindle/laser to spin up
+            yield f"M3 S{int(spindle_s)}"
+            yield "G4 P0.1"  # brief dwell to allow spindle/laser to spin up
+    if binary:
+        yield "$BIN=1"
+
+    if optimize_order:
+        polylines = order_polylines(list(polylines))
 
     for poly in polylines:
         if not poly:
@@ -115,24 +473,92 @@ def polylines_to_gcode(
         work_poly = _dedupe_points(poly, dedupe_tol) if dedupe_tol is not None else list(poly)
         if len(work_poly) == 0:
             continue
+        if arc_tol is not None and len(work_poly) > 2:
+            moves = fit_arcs(work_poly, arc_tol)
+        elif simplify_tol is not None:
+            moves = [("G1", x, y) for (x, y) in simplify_polyline(work_poly, simplify_tol)[1:]]
+        else:
+            moves = [("G1", x, y) for (x, y) in work_poly[1:]]
         # Move rapid to first point at safe Z
         x0, y0 = work_poly[0]
-        lines.append(f"G0 X{_fmt(x0)} Y{_fmt(y0)} F{_fmt(travel_feed)}")
+        yield f"G0 X{_fmt(x0)} Y{_fmt(y0)} F{_fmt(travel_feed)}"
         # Plunge to cut depth
-        lines.append(f"G1 Z{_fmt(cut_z)} F{_fmt(plunge_feed)}")
+        yield f"G1 Z{_fmt(cut_z)} F{_fmt(plunge_feed)}"
         # Cut along polyline (skip the first point)
-        for (x, y) in work_poly[1:]:
-            lines.append(f"G1 X{_fmt(x)} Y{_fmt(y)} F{_fmt(plunge_feed)}")
+        run = [(x0, y0)]
+        for mv in moves:
+            if mv[0] == "G1" and binary:
+                run.append((mv[1], mv[2]))
+                continue
+            if len(run) > 1:
+                yield from polyline_to_frames(run, plunge_feed)
+            if mv[0] == "G1":
+                yield f"G1 X{_fmt(mv[1])} Y{_fmt(mv[2])} F{_fmt(plunge_feed)}"
+            else:
+                op, x, y, i, j = mv
+                yield f"{op} X{_fmt(x)} Y{_fmt(y)} I{_fmt(i)} J{_fmt(j)} F{_fmt(plunge_feed)}"
+            run = [(mv[1], mv[2])]
+        if len(run) > 1:
+            yield from polyline_to_frames(run, plunge_feed)
         # Retract
-        lines.append(f"G0 Z{_fmt(safe_z)} F{_fmt(travel_feed)}")
+        yield f"G0 Z{_fmt(safe_z)} F{_fmt(travel_feed)}"
 
+    if binary:
+        yield "$BIN=0"
     if include_footer:
         if spindle_s is not None:
-            lines.append("M5")
-        lines.append("G0 X0 Y0")
-        lines.append("M2")
+            yield "M5"
+        yield "G0 X0 Y0"
+        yield "M2"
+
+def polylines_to_gcode(
+    polylines: List[List[Tuple[float, float]]],
+    safe_z: float = 5.0,
+    cut_z: float = -1.0,
+    plunge_feed: float = 200.0,
+    travel_feed: float = 1000.0,
+    spindle_s: int | None = None,
+    comment: str | None = None,
+    dedupe_tol: float = 1e-6,
+    include_header: bool = True,
+    include_footer: bool = True,
+    binary: bool = False,
+    simplify_tol: float | None = None,
+    arc_tol: float | None = None,
+    optimize_order: bool = False,
+) -> List[str]:
+    """
+    Convert polylines -> list of G-code lines (see iter_gcode for the
+    parameters). Returns a List[str] where each element is one G-code
+    line (no trailing newline).
+    """
+    return list(iter_gcode(
+        polylines,
+        safe_z=safe_z,
+        cut_z=cut_z,
+        plunge_feed=plunge_feed,
+        travel_feed=travel_feed,
+        spindle_s=spindle_s,
+        comment=comment,
+        dedupe_tol=dedupe_tol,
+        include_header=include_header,
+        include_footer=include_footer,
+        binary=binary,
+        simplify_tol=simplify_tol,
+        arc_tol=arc_tol,
+        optimize_order=optimize_order,
+    ))
 
-    return lines
+def write_gcode(lines: Iterable[str], out_path) -> int:
+    """Stream lines to out_path; returns the number written. Binary frames
+    are written byte-for-byte (latin-1)."""
+    count = 0
+    with open(out_path, "w", encoding="latin-1", newline="\n") as fh:
+        for ln in lines:
+            fh.write(ln)
+            fh.write("\n")
+            count += 1
+    return count
 
 def svg_to_gcode(
     svg_path: str,
@@ -146,12 +572,17 @@ def svg_to_gcode(
     dedupe_tol: float = 1e-6,
     include_header: bool = True,
     include_footer: bool = True,
+    binary: bool = False,
+    simplify_tol: float | None = None,
+    arc_tol: float | None = None,
+    optimize_order: bool = False,
+    workers: int = 0,
 ) -> List[str]:
     """
     Convenience wrapper: parse svg_path into polylines (using existing parse_svg_to_polylines)
     and convert them to G-code using polylines_to_gcode.
     """
-    polys = parse_svg_to_polylines(svg_path, resolution=resolution)
+    polys = parse_svg_to_polylines(svg_path, resolution=resolution, workers=workers)
     return polylines_to_gcode(
         polys,
         safe_z=safe_z,
@@ -163,8 +594,34 @@ def svg_to_gcode(
         dedupe_tol=dedupe_tol,
         include_header=include_header,
         include_footer=include_footer,
+        binary=binary,
+        simplify_tol=simplify_tol,
+        arc_tol=arc_tol,
+        optimize_order=optimize_order,
     )
 
+def iter_svg_gcode(
+    svg_path: str, resolution: float = 0.5, workers: int = 0, **gcode_options
+) -> Iterator[str]:
+    """
+    G-code for svg_path as a generator: each path is converted only when
+    its lines are needed. Hand it straight to GrblStreamer to start
+    cutting before the conversion has finished. Takes the iter_gcode
+    keyword options.
+    """
+    polys = iter_svg_polylines(svg_path, resolution=resolution, workers=workers)
+    return iter_gcode(polys, **gcode_options)
+
+def svg_to_gcode_file(
+    svg_path: str, out_path, resolution: float = 0.5, workers: int = 0, **gcode_options
+) -> int:
+    """
+    Streaming conversion for large files: polylines are sampled path by
+    path and written out as G-code without building either list. Takes the
+    iter_gcode keyword options; returns the number of lines written.
+    """
+    return write_gcode(iter_svg_gcode(svg_path, resolution, workers, **gcode_options), out_path)
+
 if __name__ == "__main__":
    
 
@@ -1,11 +1,15 @@
 /* arc.c - Arc interpolation implementation for 2D CNC engraver
  *
  * Converts G02/G03 circular arcs into a series of short linear segments.
- * Uses angular stepping to produce uniform segment lengths along the arc.
+ * Uses angular stepping to produce uniform segment lengths along the arc;
+ * the radius vector is advanced by a rotation recurrence so only one
+ * sinf/cosf pair is evaluated every ARC_N_CORRECTION segments.
  */
 
 #include "arc.h"
+#include "profile.h"
 #include <math.h>
+#include <string.h>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -18,13 +22,13 @@
 
 /* ----------------------------- I/J center-offset arc ----------------------------- */
 
-bool arc_generate_ij(float start_x, float start_y,
-                     float end_x, float end_y,
-                     float i_offset, float j_offset,
-                     bool clockwise,
-                     arc_segment_cb_t cb, void *user)
+bool arc_iter_init_ij(arc_iter_t *it,
+                      float start_x, float start_y,
+                      float end_x, float end_y,
+                      float i_offset, float j_offset,
+                      bool clockwise)
 {
-    if (!cb) return false;
+    if (!it) return false;
 
     /* Arc center in absolute coordinates */
     float cx = start_x + i_offset;
@@ -40,7 +44,7 @@ bool arc_generate_ij(float start_x, float start_y,
     float radius = 0.5f * (r_start + r_end);
     if (radius < ARC_RADIUS_MIN_MM) return false;
 
-    /* Start and end angles */
+    /* Start and end angles (only needed to measure the sweep) */
     float theta_start = atan2f(start_y - cy, start_x - cx);
     float theta_end   = atan2f(end_y   - cy, end_x   - cx);
 
@@ -63,9 +67,15 @@ bool arc_generate_ij(float start_x, float start_y,
         angular_travel = (float)(2.0 * M_PI);
     }
 
-    /* Number of segments based on arc length and desired segment length */
+    /* Number of segments: longest chord whose sagitta stays within
+     * ARC_TOLERANCE_MM, or fixed-length chords when tolerance is disabled.
+     */
     float arc_length = radius * angular_travel;
-    int num_segments = (int)(arc_length / ARC_SEGMENT_LEN_MM);
+    float seg_len = ARC_SEGMENT_LEN_MM;
+    if (ARC_TOLERANCE_MM > 0.0f && radius > ARC_TOLERANCE_MM) {
+        seg_len = 2.0f * sqrtf(ARC_TOLERANCE_MM * (2.0f * radius - ARC_TOLERANCE_MM));
+    }
+    int num_segments = (int)(arc_length / seg_len);
     if (num_segments < 1) num_segments = 1;
     if (num_segments > ARC_MAX_SEGMENTS) num_segments = ARC_MAX_SEGMENTS;
 
@@ -73,36 +83,37 @@ bool arc_generate_ij(float start_x, float start_y,
     float theta_step = angular_travel / (float)num_segments;
     if (clockwise) theta_step = -theta_step;
 
-    /* Generate segment endpoints */
-    float theta = theta_start;
-    for (int i = 1; i <= num_segments; i++) {
-        float seg_x, seg_y;
-
-        if (i == num_segments) {
-            /* Last segment snaps to exact endpoint */
-            seg_x = end_x;
-            seg_y = end_y;
-        } else {
-            theta += theta_step;
-            seg_x = cx + radius * cosf(theta);
-            seg_y = cy + radius * sinf(theta);
-        }
-
-        if (!cb(seg_x, seg_y, user)) return false;
-    }
+    /* Second-order small-angle rotation matrix for theta_step:
+     * cos ~ 1 - t^2/2, sin ~ t - t^3/6 (error O(t^4) per step).
+     */
+    float cos_t = 2.0f - theta_step * theta_step;
+    it->sin_t = theta_step * 0.16666667f * (cos_t + 4.0f);
+    it->cos_t = cos_t * 0.5f;
+    it->theta_step = theta_step;
+
+    /* Radius vector from the center, seeded from the start point */
+    it->cx = cx;
+    it->cy = cy;
+    it->rx = it->r0x = start_x - cx;
+    it->ry = it->r0y = start_y - cy;
+    it->end_x = end_x;
+    it->end_y = end_y;
+    it->num_segments = (uint16_t)num_segments;
+    it->index = 0;
+    it->since_correction = 0;
 
     return true;
 }
 
 /* ----------------------------- R (radius) arc ----------------------------- */
 
-bool arc_generate_r(float start_x, float start_y,
-                    float end_x, float end_y,
-                    float radius,
-                    bool clockwise,
-                    arc_segment_cb_t cb, void *user)
+bool arc_iter_init_r(arc_iter_t *it,
+                     float start_x, float start_y,
+                     float end_x, float end_y,
+                     float radius,
+                     bool clockwise)
 {
-    if (!cb) return false;
+    if (!it) return false;
 
     float abs_r = fabsf(radius);
     if (abs_r < ARC_RADIUS_MIN_MM) return false;
@@ -149,6 +160,94 @@ bool arc_generate_r(float start_x, float start_y,
     float i_offset = cx - start_x;
     float j_offset = cy - start_y;
 
-    return arc_generate_ij(start_x, start_y, end_x, end_y,
-                           i_offset, j_offset, clockwise, cb, user);
+    return arc_iter_init_ij(it, start_x, start_y, end_x, end_y,
+                            i_offset, j_offset, clockwise);
+}
+
+/* ----------------------------- Segment emission ----------------------------- */
+
+size_t arc_iter_fill(arc_iter_t *it, kin_cart_t *out, size_t cap)
+{
+    if (!it || !out) return 0;
+
+    size_t n = 0;
+    while (n < cap && it->index < it->num_segments) {
+        kin_cart_t *p = &out[n++];
+        memset(p, 0, sizeof(*p));
+        it->index++;
+
+        if (it->index == it->num_segments) {
+            /* Last segment snaps to exact endpoint */
+            p->v[0] = it->end_x;
+            p->v[1] = it->end_y;
+            break;
+        }
+
+        if (++it->since_correction < ARC_N_CORRECTION) {
+            /* Rotate the radius vector by theta_step */
+            float r_tmp = it->rx * it->sin_t + it->ry * it->cos_t;
+            it->rx = it->rx * it->cos_t - it->ry * it->sin_t;
+            it->ry = r_tmp;
+        } else {
+            /* Exact correction against the start vector */
+            float a = (float)it->index * it->theta_step;
+            float cos_a = cosf(a);
+            float sin_a = sinf(a);
+            it->rx = it->r0x * cos_a - it->r0y * sin_a;
+            it->ry = it->r0x * sin_a + it->r0y * cos_a;
+            it->since_correction = 0;
+        }
+        p->v[0] = it->cx + it->rx;
+        p->v[1] = it->cy + it->ry;
+    }
+
+    return n;
+}
+
+/* ----------------------------- Callback wrappers ----------------------------- */
+
+/* Drain an iterator through a per-point callback in small batches */
+static bool arc_drain(arc_iter_t *it, arc_segment_cb_t cb, void *user)
+{
+    kin_cart_t chunk[ARC_CHUNK_SEGMENTS];
+    size_t n;
+
+    while ((n = arc_iter_fill(it, chunk, ARC_CHUNK_SEGMENTS)) > 0) {
+        for (size_t k = 0; k < n; k++) {
+            if (!cb(chunk[k].v[0], chunk[k].v[1], user)) return false;
+        }
+    }
+    return true;
+}
+
+bool arc_generate_ij(float start_x, float start_y,
+                     float end_x, float end_y,
+                     float i_offset, float j_offset,
+                     bool clockwise,
+                     arc_segment_cb_t cb, void *user)
+{
+    if (!cb) return false;
+
+    arc_iter_t it;
+    PROFILE_ZONE_BEGIN(PROFILE_ZONE_ARC);
+    bool ok = arc_iter_init_ij(&it, start_x, start_y, end_x, end_y,
+                               i_offset, j_offset, clockwise) &&
+              arc_drain(&it, cb, user);
+    PROFILE_ZONE_END(PROFILE_ZONE_ARC);
+    return ok;
+}
+
+bool arc_generate_r(float start_x, float start_y,
+                    float end_x, float end_y,
+                    float radius,
+                    bool clockwise,
+                    arc_segment_cb_t cb, void *user)
+{
+    if (!cb) return false;
+
+    arc_iter_t it;
+    if (!arc_iter_init_r(&it, start_x, start_y, end_x, end_y, radius, clockwise)) {
+        return false;
+    }
+    return arc_drain(&it, cb, user);
 }
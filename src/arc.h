@@ -3,7 +3,7 @@
  * Purpose:
  *  - Convert circular arc moves into sequences of short linear segments
  *  - Support I/J (center offset) and R (radius) arc specification
- *  - Integrate with the kinematics segment_move interface
+ *  - Emit segments in caller-sized batches (same shape as kinematics segment_fill)
  *
  * Arc parameters:
  *  G02 Xn Yn In Jn Fn   - Clockwise arc with center offset I,J
@@ -15,22 +15,82 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include "kinematics.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-/* Maximum arc segment length in mm (smaller = smoother curves) */
+/* Maximum chord deviation from the true arc in mm. Segment length follows
+ * 2*sqrt(tol*(2r - tol)), so segment count grows with sqrt(radius) instead
+ * of arc length. Set to 0 to fall back to fixed ARC_SEGMENT_LEN_MM chords.
+ */
+#ifndef ARC_TOLERANCE_MM
+#define ARC_TOLERANCE_MM 0.002f
+#endif
+
+/* Fixed segment length in mm, used only when ARC_TOLERANCE_MM is 0 */
 #ifndef ARC_SEGMENT_LEN_MM
 #define ARC_SEGMENT_LEN_MM 0.5f
 #endif
 
+/* Segments are produced by a small-angle rotation recurrence; every
+ * ARC_N_CORRECTION segments the point is recomputed exactly with sinf/cosf
+ * to cancel accumulated drift (1 = exact trig for every segment).
+ */
+#ifndef ARC_N_CORRECTION
+#define ARC_N_CORRECTION 12u
+#endif
+
 /* Minimum arc radius to avoid degenerate arcs */
 #ifndef ARC_RADIUS_MIN_MM
 #define ARC_RADIUS_MIN_MM 0.001f
 #endif
 
+/* Batch size used by the callback wrappers below */
+#ifndef ARC_CHUNK_SEGMENTS
+#define ARC_CHUNK_SEGMENTS 8u
+#endif
+
+/* Arc generator state. Caller-owned, so arcs are reentrant and can be
+ * chained with other generators without globals.
+ */
+typedef struct {
+    float cx, cy;             /* arc center */
+    float rx, ry;             /* current radius vector */
+    float r0x, r0y;           /* start radius vector (exact correction base) */
+    float cos_t, sin_t;       /* per-segment rotation */
+    float theta_step;         /* signed angle per segment (rad) */
+    float end_x, end_y;       /* exact final endpoint */
+    uint16_t num_segments;
+    uint16_t index;           /* segments emitted so far */
+    uint16_t since_correction;
+} arc_iter_t;
+
+/* Prepare an iterator from I/J center-offset form (arguments as for
+ * arc_generate_ij). Returns false for degenerate arcs.
+ */
+bool arc_iter_init_ij(arc_iter_t *it,
+                      float start_x, float start_y,
+                      float end_x, float end_y,
+                      float i_offset, float j_offset,
+                      bool clockwise);
+
+/* Prepare an iterator from R form (arguments as for arc_generate_r). */
+bool arc_iter_init_r(arc_iter_t *it,
+                     float start_x, float start_y,
+                     float end_x, float end_y,
+                     float radius,
+                     bool clockwise);
+
+/* Write up to cap segment endpoints (X/Y, other axes zero) into out.
+ * Returns the count; 0 once the arc is complete. The final endpoint is
+ * exactly the arc target.
+ */
+size_t arc_iter_fill(arc_iter_t *it, kin_cart_t *out, size_t cap);
+
 /* Arc segment callback: called for each linear segment of the arc.
  * Return false from callback to abort arc generation.
  */
@@ -0,0 +1,171 @@
+/* config.h - build-time configuration: limits, feature flags, module selection
+ *
+ * Included by grbl.h and by every module header whose layout depends on a
+ * limit (planner.h, protocol.h), so each translation unit sees the same
+ * sizes whatever it includes first. Depends on nothing but the standard
+ * headers and the optional grbl_config.h.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/* ----------------------------- User overrides ----------------------------- */
+/* Create a grbl_config.h next to this file to override defaults per-project. */
+#if defined(__has_include)
+  #if __has_include("grbl_config.h")
+    #include "grbl_config.h"
+  #endif
+#endif
+
+/* ----------------------------- Platform selection ----------------------------- */
+/* Your build system should define ONE of these (or none for a generic build). */
+/* Examples:
+ *   -DGRBL_PLATFORM_STM32
+ *   -DGRBL_PLATFORM_LINUX_SIM
+ */
+#if !defined(GRBL_PLATFORM_STM32) && !defined(GRBL_PLATFORM_LINUX_SIM)
+  #define GRBL_PLATFORM_GENERIC 1
+#endif
+
+/* ----------------------------- Core limits ----------------------------- */
+
+#ifndef GRBL_CART_AXES
+  #define GRBL_CART_AXES 3u
+#endif
+
+#ifndef GRBL_JOINT_AXES
+  #define GRBL_JOINT_AXES 3u
+#endif
+
+#ifndef GRBL_LINE_MAX
+  #define GRBL_LINE_MAX 96u   /* protocol line length */
+#endif
+
+#ifndef GRBL_LINE_QUEUE_DEPTH
+  #define GRBL_LINE_QUEUE_DEPTH 8u
+#endif
+
+#ifndef GRBL_PLANNER_BUFFER_SIZE
+  #define GRBL_PLANNER_BUFFER_SIZE 16u   /* planner ring slots (power of two) */
+#endif
+
+#ifndef GRBL_RX_BUFFER_SIZE
+  #define GRBL_RX_BUFFER_SIZE 1024u  /* serial receive ring (power of two) */
+#endif
+
+#ifndef GRBL_RX_CHUNK
+  #define GRBL_RX_CHUNK 64u   /* how many bytes to read from HAL per poll */
+#endif
+
+/* ----------------------------- Feature flags ----------------------------- */
+/* 0/1 toggles. Keep defaults minimal; enable more as you need them. */
+
+#ifndef GRBL_FEATURE_STATUS_REPORTS
+  #define GRBL_FEATURE_STATUS_REPORTS 1
+#endif
+
+#ifndef GRBL_FEATURE_REALTIME_CMDS
+  #define GRBL_FEATURE_REALTIME_CMDS 1
+#endif
+
+#ifndef GRBL_FEATURE_HOMING
+  #define GRBL_FEATURE_HOMING 1
+#endif
+
+#ifndef GRBL_FEATURE_LIMITS
+  #define GRBL_FEATURE_LIMITS 1
+#endif
+
+#ifndef GRBL_FEATURE_PROBE
+  #define GRBL_FEATURE_PROBE 0
+#endif
+
+#ifndef GRBL_FEATURE_COOLANT
+  #define GRBL_FEATURE_COOLANT 0
+#endif
+
+#ifndef GRBL_FEATURE_SPINDLE_PWM
+  #define GRBL_FEATURE_SPINDLE_PWM 1
+#endif
+
+#ifndef GRBL_FEATURE_CHECK_MODE
+  #define GRBL_FEATURE_CHECK_MODE 0
+#endif
+
+#ifndef GRBL_FEATURE_JOG
+  #define GRBL_FEATURE_JOG 0
+#endif
+
+#ifndef GRBL_FEATURE_SD_STREAM
+  #define GRBL_FEATURE_SD_STREAM 0
+#endif
+
+/* Cycle counts of the hot paths, step ISR jitter and buffer high-water
+ * marks (profile.h). Costs a hal_cycles() read per zone entry and exit.
+ */
+#ifndef GRBL_FEATURE_PROFILE
+  #define GRBL_FEATURE_PROFILE 0
+#endif
+
+/* ----------------------------- Module selection ----------------------------- */
+/* Choose which kinematics implementation to compile in (one active at runtime). */
+
+#ifndef GRBL_KINEMATICS_COREXY
+  #define GRBL_KINEMATICS_COREXY 1
+#endif
+
+#ifndef GRBL_KINEMATICS_CARTESIAN
+  #define GRBL_KINEMATICS_CARTESIAN 0
+#endif
+
+/* Call the CoreXY conversions directly from the planner and stepper instead
+ * of through g_kin. Only valid when kin_corexy_install() is the kinematics
+ * installed at runtime.
+ */
+#ifndef GRBL_KINEMATICS_COREXY_INLINE
+  #define GRBL_KINEMATICS_COREXY_INLINE 0
+#endif
+
+/* ----------------------------- Sanity checks ----------------------------- */
+
+#if (GRBL_CART_AXES == 0u) || (GRBL_CART_AXES > 6u)
+  #error "GRBL_CART_AXES must be 1..6"
+#endif
+
+#if (GRBL_LINE_MAX < 32u) || (GRBL_LINE_MAX > 255u)
+  #error "GRBL_LINE_MAX must be 32..255"
+#endif
+
+#if GRBL_KINEMATICS_COREXY_INLINE && !GRBL_KINEMATICS_COREXY
+  #error "GRBL_KINEMATICS_COREXY_INLINE requires GRBL_KINEMATICS_COREXY"
+#endif
+
+#if (GRBL_LINE_QUEUE_DEPTH < 1u) || (GRBL_LINE_QUEUE_DEPTH > 32u)
+  #error "GRBL_LINE_QUEUE_DEPTH must be 1..32"
+#endif
+
+#if (GRBL_PLANNER_BUFFER_SIZE < 2u) || (GRBL_PLANNER_BUFFER_SIZE > 128u) || \
+    ((GRBL_PLANNER_BUFFER_SIZE & (GRBL_PLANNER_BUFFER_SIZE - 1u)) != 0u)
+  #error "GRBL_PLANNER_BUFFER_SIZE must be a power of two in 2..128"
+#endif
+
+/* Module-facing limits. planner.h and protocol.h include this header and take
+ * their sizes only from here, so every translation unit agrees on them. */
+#ifndef PROTOCOL_LINE_MAX
+  #define PROTOCOL_LINE_MAX GRBL_LINE_MAX
+#endif
+
+#ifndef PROTOCOL_LINE_QUEUE_DEPTH
+  #define PROTOCOL_LINE_QUEUE_DEPTH GRBL_LINE_QUEUE_DEPTH
+#endif
+
+#ifndef PROTOCOL_RX_BUFFER_SIZE
+  #define PROTOCOL_RX_BUFFER_SIZE GRBL_RX_BUFFER_SIZE
+#endif
+
+#ifndef PLANNER_BUFFER_SIZE
+  #define PLANNER_BUFFER_SIZE GRBL_PLANNER_BUFFER_SIZE
+#endif
@@ -3,9 +3,9 @@
 #include "gcode.h"
 #include "arc.h"
 #include "kinematics.h"
+#include "profile.h"
 #include <string.h>
-#include <stdlib.h>
-#include <ctype.h>
+#include <stddef.h>
 #include <math.h>
 
 /* NAN helper for optional parameters */
@@ -17,6 +17,11 @@
 #define isnan(x) ((x) != (x))
 #endif
 
+/* Segment endpoints pulled from a generator per batch (stack buffer) */
+#ifndef GCODE_SEGMENT_CHUNK
+#define GCODE_SEGMENT_CHUNK 8u
+#endif
+
 /* ----------------------------- Initialization ----------------------------- */
 
 void gcode_init(gcode_state_t *gc) {
@@ -33,6 +38,8 @@ void gcode_init(gcode_state_t *gc) {
     gc->feedrate = 100.0f;  /* default feedrate mm/min */
     gc->feedrate_set = false;
     gc->spindle_speed = 0.0f;
+    gc->spindle_override = GCODE_SPINDLE_OVERRIDE_DEFAULT;
+    gc->spindle_spinup_ms = GCODE_SPINDLE_SPINUP_MS;
     gc->program_complete = false;
     
     gc->position_x = 0.0f;
@@ -40,40 +47,200 @@ void gcode_init(gcode_state_t *gc) {
 }
 
 void gcode_reset(gcode_state_t *gc) {
+    if (!gc) return;
+    planner_queue_t *planner = gc->planner;
+    bool laser_mode = gc->laser_mode;  /* settings, not modal state */
+    uint32_t spinup_ms = gc->spindle_spinup_ms;
     gcode_init(gc);
+    gc->planner = planner;
+    gc->laser_mode = laser_mode;
+    gc->spindle_spinup_ms = spinup_ms;
+    gcode_set_spindle_override(gc, GCODE_SPINDLE_OVERRIDE_DEFAULT);  /* the planner's copy too */
+}
+
+void gcode_attach_planner(gcode_state_t *gc, planner_queue_t *planner) {
+    if (!gc) return;
+    gc->planner = planner;
+    gc->resume_skip = 0;
+    if (planner) planner->spindle_override = gc->spindle_override;
+}
+
+void gcode_cancel_pending(gcode_state_t *gc) {
+    if (!gc) return;
+    gc->resume_skip = 0;
+}
+
+void gcode_set_check_mode(gcode_state_t *gc, bool enable) {
+    if (!gc) return;
+    bool leaving = gc->check_mode && !enable;
+    gc->check_mode = enable;
+    gc->resume_skip = 0;
+    
+    /* Drop the modal state the checked lines left behind; the planner was
+     * never touched, so it still knows where the machine is.
+     */
+    if (leaving) {
+        gcode_reset(gc);
+        if (gc->planner) {
+            gc->position_x = gc->planner->position.v[0];
+            gc->position_y = gc->planner->position.v[1];
+        }
+    }
+}
+
+bool gcode_get_check_mode(const gcode_state_t *gc) {
+    return gc ? gc->check_mode : false;
+}
+
+/* Lines only update the modal state (no planner, or check mode) */
+static inline bool track_only(const gcode_state_t *gc) {
+    return !gc->planner || gc->check_mode;
 }
 
 /* ----------------------------- Parsing helpers ----------------------------- */
 
+/* Locale-independent whitespace test (isspace() consults the C locale) */
+static inline bool is_ws(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f';
+}
+
+static inline bool is_digit(char c) {
+    return (unsigned char)(c - '0') < 10u;
+}
+
 /* Skip whitespace */
 static const char *skip_ws(const char *s) {
-    while (*s && isspace((unsigned char)*s)) s++;
+    while (is_ws(*s)) s++;
     return s;
 }
 
-/* Parse a floating point number after a letter code */
+/* Powers of ten for the final scale of a scanned number */
+static const float pow10_table[] = {
+    1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+};
+#define POW10_MAX ((int)(sizeof(pow10_table) / sizeof(pow10_table[0])) - 1)
+
+/* Significant digits kept in the integer accumulator (fits uint32_t) */
+#define SCAN_MAX_DIGITS 9
+
+/* Parse a decimal number after a letter code: [ws][+-]digits[.digits].
+ * Digits accumulate in an integer and are scaled by one power of ten at
+ * the end, so the result is within float rounding of strtof() for every
+ * value G-code can express (no exponents, hex, inf or nan).
+ */
 static bool parse_float(const char **ptr, float *out) {
-    char *end;
-    float val = strtof(*ptr, &end);
-    if (end == *ptr) return false;  /* no conversion */
-    *out = val;
-    *ptr = end;
+    const char *p = skip_ws(*ptr);
+    bool negative = false;
+    if (*p == '-' || *p == '+') {
+        negative = (*p == '-');
+        p++;
+    }
+    
+    uint32_t mantissa = 0;
+    int digits = 0;       /* significant digits accumulated */
+    int exponent = 0;     /* power of ten applied to mantissa */
+    bool any = false;
+    
+    while (is_digit(*p)) {
+        if (digits < SCAN_MAX_DIGITS) {
+            mantissa = mantissa * 10u + (uint32_t)(*p - '0');
+            if (mantissa) digits++;
+        } else {
+            exponent++;   /* integer digit past precision: scale up */
+        }
+        any = true;
+        p++;
+    }
+    if (*p == '.') {
+        p++;
+        while (is_digit(*p)) {
+            if (digits < SCAN_MAX_DIGITS) {
+                mantissa = mantissa * 10u + (uint32_t)(*p - '0');
+                if (mantissa) digits++;
+                exponent--;
+            }
+            any = true;
+            p++;
+        }
+    }
+    if (!any) return false;  /* no conversion */
+    
+    float val = (float)mantissa;
+    if (exponent < 0) {
+        int e = -exponent;
+        while (e > POW10_MAX) { val /= pow10_table[POW10_MAX]; e -= POW10_MAX; }
+        val /= pow10_table[e];
+    } else {
+        int e = exponent;
+        while (e > POW10_MAX) { val *= pow10_table[POW10_MAX]; e -= POW10_MAX; }
+        val *= pow10_table[e];
+    }
+    
+    *out = negative ? -val : val;
+    *ptr = p;
     return true;
 }
 
 /* Parse an integer number after a letter code */
 static bool parse_int(const char **ptr, int *out) {
-    char *end;
-    long val = strtol(*ptr, &end, 10);
-    if (end == *ptr) return false;  /* no conversion */
-    *out = (int)val;
-    *ptr = end;
+    const char *p = skip_ws(*ptr);
+    bool negative = false;
+    if (*p == '-' || *p == '+') {
+        negative = (*p == '-');
+        p++;
+    }
+    if (!is_digit(*p)) return false;  /* no conversion */
+    
+    int val = 0;
+    while (is_digit(*p)) {
+        if (val < 100000) val = val * 10 + (*p - '0');
+        p++;
+    }
+    
+    *out = negative ? -val : val;
+    *ptr = p;
     return true;
 }
 
+/* Word letter lookup: kind plus where the value and its flag live */
+typedef enum {
+    WORD_IGNORE = 0,   /* unsupported letter: skip to next whitespace */
+    WORD_G,
+    WORD_M,
+    WORD_FLOAT,
+} word_kind_t;
+
+typedef struct {
+    uint8_t kind;
+    uint8_t value_offset;  /* offsetof(gcode_block_t, <float>) */
+    uint8_t flag_offset;   /* offsetof(gcode_block_t, has_<letter>) */
+} word_entry_t;
+
+#define WORD_F(field) { WORD_FLOAT, (uint8_t)offsetof(gcode_block_t, field), \
+                        (uint8_t)offsetof(gcode_block_t, has_##field) }
+
+static const word_entry_t word_table[26] = {
+    ['F' - 'A'] = WORD_F(f),
+    ['G' - 'A'] = { WORD_G, 0, 0 },
+    ['I' - 'A'] = WORD_F(i),
+    ['J' - 'A'] = WORD_F(j),
+    ['M' - 'A'] = { WORD_M, 0, 0 },
+    ['P' - 'A'] = WORD_F(p),
+    ['R' - 'A'] = WORD_F(r),
+    ['S' - 'A'] = WORD_F(s),
+    ['X' - 'A'] = WORD_F(x),
+    ['Y' - 'A'] = WORD_F(y),
+};
+
+/* Letter index 0..25 for A-Z / a-z, or -1 */
+static inline int letter_index(char c) {
+    unsigned idx = (unsigned)((unsigned char)c | 0x20u) - (unsigned)'a';
+    return (idx < 26u) ? (int)idx : -1;
+}
+
 /* ----------------------------- Line parsing ----------------------------- */
 
-gcode_status_t gcode_parse_line(const char *line, gcode_block_t *block) {
+static gcode_status_t parse_line(const char *line, gcode_block_t *block) {
     if (!line || !block) return GCODE_ERR_INVALID_PARAM;
     
     /* Initialize block */
@@ -91,11 +258,12 @@ gcode_status_t gcode_parse_line(const char *line, gcode_block_t *block) {
         ptr = skip_ws(ptr);
         if (*ptr == '\0') break;
         
-        char letter = toupper((unsigned char)*ptr);
+        int idx = letter_index(*ptr);
         ptr++;
         
-        switch (letter) {
-            case 'G': {
+        const word_entry_t *w = (idx >= 0) ? &word_table[idx] : NULL;
+        switch (w ? w->kind : WORD_IGNORE) {
+            case WORD_G: {
                 int gnum;
                 if (!parse_int(&ptr, &gnum)) return GCODE_ERR_INVALID_PARAM;
                 block->g_code = gnum;
@@ -103,7 +271,7 @@ gcode_status_t gcode_parse_line(const char *line, gcode_block_t *block) {
                 break;
             }
             
-            case 'M': {
+            case WORD_M: {
                 int mnum;
                 if (!parse_int(&ptr, &mnum)) return GCODE_ERR_INVALID_PARAM;
                 block->m_code = mnum;
@@ -111,58 +279,17 @@ gcode_status_t gcode_parse_line(const char *line, gcode_block_t *block) {
                 break;
             }
             
-            case 'X': {
-                if (!parse_float(&ptr, &block->x)) return GCODE_ERR_INVALID_PARAM;
-                block->has_x = true;
-                break;
-            }
-            
-            case 'Y': {
-                if (!parse_float(&ptr, &block->y)) return GCODE_ERR_INVALID_PARAM;
-                block->has_y = true;
-                break;
-            }
-            
-            case 'F': {
-                if (!parse_float(&ptr, &block->f)) return GCODE_ERR_INVALID_PARAM;
-                block->has_f = true;
-                break;
-            }
-            
-            case 'S': {
-                if (!parse_float(&ptr, &block->s)) return GCODE_ERR_INVALID_PARAM;
-                block->has_s = true;
-                break;
-            }
-            
-            case 'P': {
-                if (!parse_float(&ptr, &block->p)) return GCODE_ERR_INVALID_PARAM;
-                block->has_p = true;
-                break;
-            }
-            
-            case 'I': {
-                if (!parse_float(&ptr, &block->i)) return GCODE_ERR_INVALID_PARAM;
-                block->has_i = true;
-                break;
-            }
-            
-            case 'J': {
-                if (!parse_float(&ptr, &block->j)) return GCODE_ERR_INVALID_PARAM;
-                block->has_j = true;
-                break;
-            }
-            
-            case 'R': {
-                if (!parse_float(&ptr, &block->r)) return GCODE_ERR_INVALID_PARAM;
-                block->has_r = true;
+            case WORD_FLOAT: {
+                float *value = (float *)((char *)block + w->value_offset);
+                if (!parse_float(&ptr, value)) return GCODE_ERR_INVALID_PARAM;
+                *(bool *)((char *)block + w->flag_offset) = true;
                 break;
             }
             
             /* Ignore other letters for now */
             default:
                 /* Skip to next space or end */
-                while (*ptr && !isspace((unsigned char)*ptr)) ptr++;
+                while (*ptr && !is_ws(*ptr)) ptr++;
                 break;
         }
     }
@@ -170,8 +297,101 @@ gcode_status_t gcode_parse_line(const char *line, gcode_block_t *block) {
     return GCODE_OK;
 }
 
+gcode_status_t gcode_parse_line(const char *line, gcode_block_t *block) {
+    PROFILE_ZONE_BEGIN(PROFILE_ZONE_GCODE_PARSE);
+    gcode_status_t st = parse_line(line, block);
+    PROFILE_ZONE_END(PROFILE_ZONE_GCODE_PARSE);
+    return st;
+}
+
 /* ----------------------------- Execution ----------------------------- */
 
+/* Queue one straight segment ending at (x, y). Segments are numbered per
+ * line so a retry after GCODE_BUSY skips the ones already in the ring.
+ */
+static gcode_status_t buffer_segment(gcode_state_t *gc, float x, float y,
+                                     float feed, uint8_t flags) {
+    uint16_t index = gc->segment_index++;
+    if (track_only(gc) || index < gc->resume_skip) return GCODE_OK;
+    
+    kin_cart_t target = {{ x, y, 0.0f }};
+    switch (planner_buffer_line(gc->planner, &target, feed, flags)) {
+        case PLANNER_LINE_OK:
+        case PLANNER_LINE_EMPTY:
+            return GCODE_OK;
+        case PLANNER_LINE_FULL:
+            gc->resume_skip = index;
+            return GCODE_BUSY;
+        default:
+            gc->resume_skip = 0;
+            return GCODE_ERR_INVALID_TARGET;
+    }
+}
+
+/* Queue a sync block (dwell and/or spindle change). Numbered like motion
+ * segments, so a GCODE_BUSY retry of the line does not queue it twice.
+ */
+static gcode_status_t buffer_sync(gcode_state_t *gc, uint32_t dwell_ms, uint8_t flags) {
+    uint16_t index = gc->segment_index++;
+    if (track_only(gc) || index < gc->resume_skip) return GCODE_OK;
+    
+    switch (planner_buffer_sync(gc->planner, dwell_ms, flags)) {
+        case PLANNER_LINE_OK:
+            return GCODE_OK;
+        case PLANNER_LINE_FULL:
+            gc->resume_skip = index;
+            return GCODE_BUSY;
+        default:
+            gc->resume_skip = 0;
+            return GCODE_ERR_INVALID_TARGET;
+    }
+}
+
+/* Outside laser mode a spindle change takes effect in step with the motion:
+ * the stepper sets the output when it reaches the sync block, then waits
+ * out the spin-up if the spindle was started or reversed. Laser blocks
+ * carry the spindle state themselves. Both carry the programmed S; the
+ * stepper applies the override.
+ */
+static gcode_status_t buffer_spindle_sync(gcode_state_t *gc, gcode_spindle_state_t before) {
+    if (gc->laser_mode || track_only(gc)) return GCODE_OK;
+    
+    uint8_t flags = PLANNER_LINE_SPINDLE_SYNC;
+    if (gc->spindle_state == GCODE_SPINDLE_CW) flags |= PLANNER_LINE_SPINDLE_CW;
+    if (gc->spindle_state == GCODE_SPINDLE_CCW) flags |= PLANNER_LINE_SPINDLE_CCW;
+    uint32_t wait_ms = (gc->spindle_state != GCODE_SPINDLE_OFF && gc->spindle_state != before) ?
+                       gc->spindle_spinup_ms : 0u;
+    gc->planner->spindle_speed = gc->spindle_speed;
+    return buffer_sync(gc, wait_ms, flags);
+}
+
+/* planner_buffer_line() flags for a move; laser mode stamps the spindle
+ * state into the blocks about to be queued.
+ */
+static uint8_t motion_flags(gcode_state_t *gc, bool rapid) {
+    uint8_t flags = rapid ? PLANNER_LINE_RAPID : 0u;
+    if (!gc->laser_mode) return flags;
+    
+    flags |= PLANNER_LINE_LASER;
+    if (!rapid) {
+        if (gc->spindle_state == GCODE_SPINDLE_CW) flags |= PLANNER_LINE_SPINDLE_CW;
+        if (gc->spindle_state == GCODE_SPINDLE_CCW) flags |= PLANNER_LINE_SPINDLE_CCW;
+    }
+    if (!track_only(gc)) gc->planner->spindle_speed = gc->spindle_speed;
+    return flags;
+}
+
+/* Queue a batch of segment endpoints produced by a generator */
+static gcode_status_t buffer_chunk(gcode_state_t *gc, const kin_cart_t *pts, size_t n,
+                                   uint8_t flags) {
+    for (size_t k = 0; k < n; k++) {
+        gcode_status_t status = buffer_segment(gc, pts[k].v[0], pts[k].v[1],
+                                               gc->feedrate, flags);
+        if (status != GCODE_OK) return status;
+    }
+    return GCODE_OK;
+}
+
 /* Execute motion command - integrates with kinematics for segmentation */
 static gcode_status_t execute_motion(gcode_state_t *gc, const gcode_block_t *block) {
     float target_x = gc->position_x;
@@ -200,32 +420,47 @@ static gcode_status_t execute_motion(gcode_state_t *gc, const gcode_block_t *blo
         return GCODE_ERR_MISSING_PARAM;
     }
     
-    /* Use kinematics segment_move for path segmentation when available.
-     * This subdivides long moves into shorter segments as needed by the
-     * machine geometry (e.g., CoreXY with max_segment_len set).
+    if (track_only(gc)) {
+        gc->position_x = target_x;
+        gc->position_y = target_y;
+        return GCODE_OK;
+    }
+    
+    /* Use kinematics segmentation when available. This subdivides long
+     * moves into shorter segments as needed by the machine geometry
+     * (e.g., CoreXY with max_segment_len set), a chunk at a time.
      */
-    if (g_kin.segment_move) {
-        kin_cart_t cart_current = {{ gc->position_x, gc->position_y, 0.0f }};
-        kin_cart_t cart_target  = {{ target_x, target_y, 0.0f }};
-        kin_motion_hint_t hint = {
-            .feed_mm_min = (gc->motion_mode == GCODE_MOTION_RAPID) ? 0.0f : gc->feedrate,
-            .accel_mm_s2 = 0.0f,
-            .junction_dev_mm = 0.0f
-        };
-        kin_cart_t cart_next;
-        bool init = true;
+    bool rapid = (gc->motion_mode == GCODE_MOTION_RAPID);
+    uint8_t flags = motion_flags(gc, rapid);
+    gcode_status_t status = GCODE_OK;
+    
+    kin_cart_t cart_current = {{ gc->position_x, gc->position_y, 0.0f }};
+    kin_cart_t cart_target  = {{ target_x, target_y, 0.0f }};
+    kin_motion_hint_t hint = {
+        .feed_mm_min = rapid ? 0.0f : gc->feedrate,
+        .accel_mm_s2 = 0.0f,
+        .junction_dev_mm = 0.0f
+    };
+    kin_segment_iter_t seg;
+    
+    if (g_kin.segment_init && g_kin.segment_fill &&
+        g_kin.segment_init(&seg, &cart_target, &cart_current, &hint)) {
+        kin_cart_t chunk[GCODE_SEGMENT_CHUNK];
+        size_t n;
         
-        while (g_kin.segment_move(&cart_target, &cart_current, &hint, init, &cart_next)) {
-            init = false;
-            /* Each segment endpoint could be converted to joint space and queued:
-             *   kin_joint_t joint;
-             *   g_kin.cart_to_joint(&cart_next, &joint);
-             *   planner_enqueue_joint(&joint, feedrate);
-             */
-            cart_current = cart_next;
+        while ((n = g_kin.segment_fill(&seg, chunk, GCODE_SEGMENT_CHUNK)) > 0) {
+            status = buffer_chunk(gc, chunk, n, flags);
+            if (status != GCODE_OK) return status;
+            cart_current = chunk[n - 1];
         }
     }
     
+    /* Close the move on the exact target unless the last segment did */
+    if (cart_current.v[0] != target_x || cart_current.v[1] != target_y) {
+        status = buffer_segment(gc, target_x, target_y, gc->feedrate, flags);
+        if (status != GCODE_OK) return status;
+    }
+    
     /* Update position */
     gc->position_x = target_x;
     gc->position_y = target_y;
@@ -233,37 +468,15 @@ static gcode_status_t execute_motion(gcode_state_t *gc, const gcode_block_t *blo
     return GCODE_OK;
 }
 
-/* Execute dwell command */
+/* Execute dwell command (P in seconds). Queued as a sync block: the
+ * stepper waits once the motion before it is done, and parsing, realtime
+ * commands and status reports carry on meanwhile.
+ */
 static gcode_status_t execute_dwell(gcode_state_t *gc, const gcode_block_t *block) {
-    (void)gc;  /* unused in this simple implementation */
-    
     if (!block->has_p) return GCODE_ERR_MISSING_PARAM;
     if (block->p < 0.0f) return GCODE_ERR_INVALID_PARAM;
     
-    /* In a real system, this would schedule a dwell/delay */
-    /* Example: hal_delay_ms((uint32_t)(block->p * 1000.0f)); */
-    
-    return GCODE_OK;
-}
-
-/* Arc segment callback context */
-typedef struct {
-    gcode_state_t *gc;
-    gcode_status_t status;
-} arc_cb_ctx_t;
-
-/* Callback for each arc segment - updates position */
-static bool arc_segment_handler(float x, float y, void *user) {
-    arc_cb_ctx_t *ctx = (arc_cb_ctx_t *)user;
-    
-    /* Update position for each segment endpoint.
-     * In a real system, each segment would be queued to the planner:
-     *   planner_line_to(x, y, ctx->gc->feedrate);
-     */
-    ctx->gc->position_x = x;
-    ctx->gc->position_y = y;
-    
-    return true;
+    return buffer_sync(gc, (uint32_t)lroundf(block->p * 1000.0f), 0u);
 }
 
 /* Execute arc command (G02/G03) */
@@ -291,25 +504,25 @@ static gcode_status_t execute_arc(gcode_state_t *gc, const gcode_block_t *block,
         if (block->has_y) target_y += block->y;
     }
     
-    /* Set up callback context */
-    arc_cb_ctx_t ctx = { .gc = gc, .status = GCODE_OK };
-    
+    /* Arc endpoints are queued a chunk at a time. The modal position only
+     * moves once the whole arc is queued, so a GCODE_BUSY retry regenerates
+     * the same segments.
+     */
+    arc_iter_t arc;
     bool ok;
     if (block->has_r) {
         /* R-form arc */
-        ok = arc_generate_r(gc->position_x, gc->position_y,
-                            target_x, target_y,
-                            block->r, clockwise,
-                            arc_segment_handler, &ctx);
+        ok = arc_iter_init_r(&arc, gc->position_x, gc->position_y,
+                             target_x, target_y,
+                             block->r, clockwise);
     } else if (block->has_i || block->has_j) {
         /* I/J center-offset form */
         float i_off = block->has_i ? block->i : 0.0f;
         float j_off = block->has_j ? block->j : 0.0f;
         
-        ok = arc_generate_ij(gc->position_x, gc->position_y,
-                             target_x, target_y,
-                             i_off, j_off, clockwise,
-                             arc_segment_handler, &ctx);
+        ok = arc_iter_init_ij(&arc, gc->position_x, gc->position_y,
+                              target_x, target_y,
+                              i_off, j_off, clockwise);
     } else {
         /* No arc center specified */
         return GCODE_ERR_MISSING_PARAM;
@@ -317,14 +530,33 @@ static gcode_status_t execute_arc(gcode_state_t *gc, const gcode_block_t *block,
     
     if (!ok) return GCODE_ERR_INVALID_TARGET;
     
-    return ctx.status;
+    /* Geometry is validated by the init; segments are only needed to queue */
+    if (!track_only(gc)) {
+        kin_cart_t chunk[GCODE_SEGMENT_CHUNK];
+        size_t n;
+        uint8_t flags = motion_flags(gc, false);
+        while ((n = arc_iter_fill(&arc, chunk, GCODE_SEGMENT_CHUNK)) > 0) {
+            gcode_status_t status = buffer_chunk(gc, chunk, n, flags);
+            if (status != GCODE_OK) return status;
+        }
+    }
+    
+    gc->position_x = target_x;
+    gc->position_y = target_y;
+    
+    return GCODE_OK;
 }
 
 /* Execute program end command (M02/M30) */
 static gcode_status_t execute_program_end(gcode_state_t *gc, int m_code) {
-    /* Turn off spindle for safety */
+    /* Turn off spindle for safety, once the motion before it has run */
+    gcode_spindle_state_t before = gc->spindle_state;
     gc->spindle_state = GCODE_SPINDLE_OFF;
-    /* Interface with HAL: hal_spindle_set(HAL_SPINDLE_OFF, 0.0f); */
+    gcode_status_t status = buffer_spindle_sync(gc, before);
+    if (status != GCODE_OK) {
+        gc->spindle_state = before;  /* retried with the same line */
+        return status;
+    }
     
     /* Mark program as complete */
     gc->program_complete = true;
@@ -333,6 +565,10 @@ static gcode_status_t execute_program_end(gcode_state_t *gc, int m_code) {
         /* M30 additionally resets position to origin (program rewind) */
         gc->position_x = 0.0f;
         gc->position_y = 0.0f;
+        if (!track_only(gc)) {
+            kin_cart_t origin = {{ 0.0f, 0.0f, 0.0f }};
+            planner_sync_position(gc->planner, &origin);
+        }
     }
     
     return GCODE_OK;
@@ -340,13 +576,13 @@ static gcode_status_t execute_program_end(gcode_state_t *gc, int m_code) {
 
 /* Execute spindle control command */
 static gcode_status_t execute_spindle(gcode_state_t *gc, int m_code, const gcode_block_t *block) {
+    gcode_spindle_state_t before = gc->spindle_state;
     switch (m_code) {
         case 3:  /* M03 - spindle on, CW */
             gc->spindle_state = GCODE_SPINDLE_CW;
             if (block->has_s) {
                 gc->spindle_speed = block->s;
             }
-            /* Interface with HAL: hal_spindle_set(HAL_SPINDLE_CW, speed_to_pwm(gc->spindle_speed)); */
             break;
             
         case 4:  /* M04 - spindle on, CCW */
@@ -354,25 +590,47 @@ static gcode_status_t execute_spindle(gcode_state_t *gc, int m_code, const gcode
             if (block->has_s) {
                 gc->spindle_speed = block->s;
             }
-            /* Interface with HAL: hal_spindle_set(HAL_SPINDLE_CCW, speed_to_pwm(gc->spindle_speed)); */
             break;
             
         case 5:  /* M05 - spindle off */
             gc->spindle_state = GCODE_SPINDLE_OFF;
-            /* Interface with HAL: hal_spindle_set(HAL_SPINDLE_OFF, 0.0f); */
             break;
             
         default:
             return GCODE_ERR_UNKNOWN_CMD;
     }
     
-    return GCODE_OK;
+    gcode_status_t status = buffer_spindle_sync(gc, before);
+    if (status != GCODE_OK) {
+        gc->spindle_state = before;  /* the retry must see the change again */
+    }
+    return status;
 }
 
 gcode_status_t gcode_execute_block(gcode_state_t *gc, const gcode_block_t *block) {
     if (!gc || !block) return GCODE_ERR_INVALID_PARAM;
     
     gcode_status_t status = GCODE_OK;
+    gc->segment_index = 0;  /* planner blocks queued by this line */
+    
+    /* Spindle speed and spindle control come before motion (grbl order of
+     * execution), so "G1 X10 S500" in laser mode burns that stroke at S500.
+     */
+    bool program_end = block->has_m && (block->m_code == 2 || block->m_code == 30);
+    if (block->has_m && !program_end) {
+        status = execute_spindle(gc, block->m_code, block);
+        if (status != GCODE_OK) return status;
+    }
+    
+    /* Process standalone S word (spindle speed change without M code) */
+    if (block->has_s && !block->has_m) {
+        gc->spindle_speed = block->s;
+        /* Update spindle if it's already running */
+        if (gc->spindle_state != GCODE_SPINDLE_OFF) {
+            status = buffer_spindle_sync(gc, gc->spindle_state);
+            if (status != GCODE_OK) return status;
+        }
+    }
     
     /* Process G-code commands */
     if (block->has_g) {
@@ -426,28 +684,47 @@ gcode_status_t gcode_execute_block(gcode_state_t *gc, const gcode_block_t *block
         if (status != GCODE_OK) return status;
     }
     
-    /* Process M-code commands */
-    if (block->has_m) {
-        switch (block->m_code) {
-            case 2:  /* M02 - program end */
-            case 30: /* M30 - program end and rewind */
-                status = execute_program_end(gc, block->m_code);
-                break;
-            default:
-                status = execute_spindle(gc, block->m_code, block);
-                break;
-        }
+    /* Program end runs after the motion on its line */
+    if (program_end) {
+        status = execute_program_end(gc, block->m_code);
         if (status != GCODE_OK) return status;
     }
     
-    /* Process standalone S word (spindle speed change without M code) */
-    if (block->has_s && !block->has_m) {
-        gc->spindle_speed = block->s;
-        /* Update spindle if it's already running */
-        if (gc->spindle_state != GCODE_SPINDLE_OFF) {
-            /* Interface with HAL to update speed */
-        }
+    /* Everything this line queues is in the ring */
+    gc->resume_skip = 0;
+    return GCODE_OK;
+}
+
+gcode_status_t gcode_execute_deltas(gcode_state_t *gc, const int32_t *dx, const int32_t *dy,
+                                    size_t n, float scale, float feed, bool rapid) {
+    if (!gc || !dx || !dy || n == 0) return GCODE_ERR_INVALID_PARAM;
+    
+    if (feed > 0.0f) {
+        gc->feedrate = feed;
+        gc->feedrate_set = true;
     }
+    if (!rapid && !gc->feedrate_set) return GCODE_ERR_MISSING_PARAM;
+    
+    /* Deltas are already short segments; no kinematic subdivision */
+    uint8_t flags = motion_flags(gc, rapid);
+    int32_t sum_x = 0;
+    int32_t sum_y = 0;
+    float x = gc->position_x;
+    float y = gc->position_y;
+    gc->segment_index = 0;
+    
+    for (size_t k = 0; k < n; k++) {
+        sum_x += dx[k];
+        sum_y += dy[k];
+        x = gc->position_x + (float)sum_x * scale;
+        y = gc->position_y + (float)sum_y * scale;
+        gcode_status_t status = buffer_segment(gc, x, y, gc->feedrate, flags);
+        if (status != GCODE_OK) return status;
+    }
+    
+    gc->resume_skip = 0;
+    gc->position_x = x;
+    gc->position_y = y;
     
     return GCODE_OK;
 }
@@ -483,6 +760,32 @@ gcode_spindle_state_t gcode_get_spindle_state(const gcode_state_t *gc) {
     return gc ? gc->spindle_state : GCODE_SPINDLE_OFF;
 }
 
+void gcode_set_spindle_override(gcode_state_t *gc, uint8_t percent) {
+    if (!gc) return;
+    if (percent < GCODE_SPINDLE_OVERRIDE_MIN) percent = GCODE_SPINDLE_OVERRIDE_MIN;
+    if (percent > GCODE_SPINDLE_OVERRIDE_MAX) percent = GCODE_SPINDLE_OVERRIDE_MAX;
+    gc->spindle_override = percent;
+    if (gc->planner) gc->planner->spindle_override = percent;
+}
+
+uint8_t gcode_get_spindle_override(const gcode_state_t *gc) {
+    return gc ? gc->spindle_override : GCODE_SPINDLE_OVERRIDE_DEFAULT;
+}
+
+float gcode_get_spindle_output(const gcode_state_t *gc) {
+    if (!gc || gc->spindle_state == GCODE_SPINDLE_OFF) return 0.0f;
+    return gc->spindle_speed * (float)gc->spindle_override * 0.01f;
+}
+
+void gcode_set_laser_mode(gcode_state_t *gc, bool enable) {
+    if (!gc) return;
+    gc->laser_mode = enable;
+}
+
+bool gcode_get_laser_mode(const gcode_state_t *gc) {
+    return gc ? gc->laser_mode : false;
+}
+
 bool gcode_is_program_complete(const gcode_state_t *gc) {
     return gc ? gc->program_complete : false;
 }
@@ -496,6 +799,7 @@ const char *gcode_status_string(gcode_status_t status) {
         case GCODE_ERR_UNSUPPORTED_CMD: return "Unsupported command";
         case GCODE_ERR_INVALID_TARGET:  return "Invalid target";
         case GCODE_ERR_OVERFLOW:        return "Overflow";
+        case GCODE_BUSY:                return "Planner full";
         default:                        return "Unknown error";
     }
 }
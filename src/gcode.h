@@ -21,6 +21,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include "planner.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -62,6 +63,7 @@ typedef enum {
     GCODE_ERR_UNSUPPORTED_CMD,
     GCODE_ERR_INVALID_TARGET,
     GCODE_ERR_OVERFLOW,
+    GCODE_BUSY,                  /* planner full: re-submit the same line later */
 } gcode_status_t;
 
 /* Modal state machine */
@@ -79,12 +81,21 @@ typedef struct {
     /* Feed and speed parameters */
     float feedrate;        /* mm/min */
     float spindle_speed;   /* RPM or 0-100% depending on implementation */
+    uint8_t spindle_override; /* percent applied to spindle_speed at the output */
+    bool laser_mode;       /* $32: spindle state rides in planner blocks */
+    uint32_t spindle_spinup_ms; /* dwell queued after M3/M4 starts the spindle */
     
     /* Flags */
     bool feedrate_set;     /* true if F was ever specified */
     bool absolute_mode;    /* derived from coord_mode for convenience */
     bool program_complete; /* true after M02/M30 - program has ended */
     
+    /* Motion output (NULL = track position only) */
+    planner_queue_t *planner;
+    bool check_mode;        /* $C: validate lines, queue nothing */
+    uint16_t segment_index; /* segment counter within the current line */
+    uint16_t resume_skip;   /* segments already queued by a GCODE_BUSY attempt */
+    
 } gcode_state_t;
 
 /* Parsed G-code block */
@@ -110,6 +121,16 @@ typedef struct {
     
 } gcode_block_t;
 
+/* Spindle override limits, percent (grbl values) */
+#define GCODE_SPINDLE_OVERRIDE_DEFAULT 100u
+#define GCODE_SPINDLE_OVERRIDE_MIN      10u
+#define GCODE_SPINDLE_OVERRIDE_MAX     200u
+
+/* Wait after M3/M4 starts (or reverses) the spindle before the next move */
+#ifndef GCODE_SPINDLE_SPINUP_MS
+#define GCODE_SPINDLE_SPINUP_MS 0u
+#endif
+
 /* ----------------------------- Public API ----------------------------- */
 
 /* Initialize the G-code parser/executor state */
@@ -118,12 +139,31 @@ void gcode_init(gcode_state_t *gc);
 /* Reset to safe startup state */
 void gcode_reset(gcode_state_t *gc);
 
+/* Route motion into a planner ring (kept across gcode_reset) */
+void gcode_attach_planner(gcode_state_t *gc, planner_queue_t *planner);
+
+/* Forget a partially queued line after GCODE_BUSY (the line is dropped) */
+void gcode_cancel_pending(gcode_state_t *gc);
+
 /* Parse a single G-code line (already normalized by protocol layer) */
 gcode_status_t gcode_parse_line(const char *line, gcode_block_t *block);
 
-/* Execute a parsed G-code block (updates state, sends to planner) */
+/* Execute a parsed G-code block (updates state, sends to planner).
+ * GCODE_BUSY means the planner filled up part way through the block; the
+ * modal position is unchanged and the same line must be executed again
+ * once space frees up. Segments queued by the earlier attempt are skipped.
+ */
 gcode_status_t gcode_execute_block(gcode_state_t *gc, const gcode_block_t *block);
 
+/* Queue a run of relative XY moves without going through the parser
+ * (binary motion frames). dx/dy are integer counts, scale is mm per count;
+ * feed <= 0 keeps the modal feedrate. Points are summed in counts, so a
+ * long run does not accumulate rounding. GCODE_BUSY behaves as for
+ * gcode_execute_block(): submit the same run again later.
+ */
+gcode_status_t gcode_execute_deltas(gcode_state_t *gc, const int32_t *dx, const int32_t *dy,
+                                    size_t n, float scale, float feed, bool rapid);
+
 /* Convenience: parse + execute in one call */
 gcode_status_t gcode_process_line(gcode_state_t *gc, const char *line);
 
@@ -132,8 +172,35 @@ void gcode_get_position(const gcode_state_t *gc, float *out_x, float *out_y);
 float gcode_get_feedrate(const gcode_state_t *gc);
 float gcode_get_spindle_speed(const gcode_state_t *gc);
 gcode_spindle_state_t gcode_get_spindle_state(const gcode_state_t *gc);
+
+/* Spindle override (percent, clamped). Takes effect immediately: it is
+ * published to the attached planner, whose stepper re-sets the running
+ * spindle and scales laser power. Blocks keep the programmed S value.
+ */
+void gcode_set_spindle_override(gcode_state_t *gc, uint8_t percent);
+uint8_t gcode_get_spindle_override(const gcode_state_t *gc);
+
+/* Commanded spindle speed after the override, 0 while the spindle is off */
+float gcode_get_spindle_output(const gcode_state_t *gc);
+
+/* Laser mode (grbl $32). Motion blocks carry PLANNER_LINE_LASER plus the
+ * modal M3/M4 state and S, and the stepper sets the PWM as they execute, so
+ * S/M changes between strokes never wait for the planner to drain. G0 and
+ * M5 blocks run with the laser off.
+ */
+void gcode_set_laser_mode(gcode_state_t *gc, bool enable);
+bool gcode_get_laser_mode(const gcode_state_t *gc);
 bool gcode_is_program_complete(const gcode_state_t *gc);
 
+/* Check mode (grbl $C). Lines are parsed and validated against the modal
+ * state, and the modal state and position advance as usual, but nothing
+ * is queued: no kinematic subdivision, no arc segments, no planner blocks.
+ * A job is validated at close to parser speed. Leaving check mode resets
+ * the modal state and takes the position back from the planner.
+ */
+void gcode_set_check_mode(gcode_state_t *gc, bool enable);
+bool gcode_get_check_mode(const gcode_state_t *gc);
+
 /* Get error message for a status code */
 const char *gcode_status_string(gcode_status_t status);
 
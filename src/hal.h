@@ -69,6 +69,15 @@ uint32_t hal_millis(void);
 /* Microseconds since boot (monotonic if possible; can roll over). */
 uint32_t hal_micros(void);
 
+/* Free-running CPU cycle counter (DWT CYCCNT on Cortex-M3/M4/M7, enabled
+ * in hal_init()). Wraps; only differences are meaningful. Used by the
+ * profiler (GRBL_FEATURE_PROFILE).
+ */
+uint32_t hal_cycles(void);
+
+/* Rate of hal_cycles() in Hz (the core clock for DWT). */
+uint32_t hal_cycles_freq_hz(void);
+
 /* Busy delay. Keep short; core should prefer scheduling. */
 void hal_delay_ms(uint32_t ms);
 
@@ -88,6 +97,21 @@ size_t hal_serial_write(hal_port_t port, const uint8_t *src, size_t len);
 /* Optional convenience: write null-terminated string. */
 size_t hal_serial_write_str(hal_port_t port, const char *s);
 
+/* Optional circular DMA reception (preferred at 250 kbaud+ / USB CDC):
+ * - DMA writes continuously into ring[0..size-1] (size is a power of two)
+ * - on_rx(pos, user) is called from the idle-line, half-transfer and
+ *   transfer-complete interrupts; pos is the DMA write index (0..size-1)
+ * - no per-byte interrupt, no intermediate copy
+ * Returns HAL_ERR if the port has no DMA path; use hal_serial_read() then.
+ */
+typedef void (*hal_serial_rx_cb_t)(size_t pos, void *user);
+
+hal_status_t hal_serial_rx_dma_start(hal_port_t port, uint8_t *ring, size_t size,
+                                     hal_serial_rx_cb_t on_rx, void *user);
+
+/* Current DMA write index (0..size-1), for polling without the callback. */
+size_t hal_serial_rx_dma_pos(hal_port_t port);
+
 /* ----------------------------- Digital I/O ----------------------------- */
 
 /* Generic GPIO (for LEDs, enables, etc.). */
@@ -117,9 +141,45 @@ void hal_stepper_step_pulse(hal_axis_t axis);
 /* Set step pin(s) low for an axis. */
 void hal_stepper_step_clear(hal_axis_t axis);
 
-/* Optional: atomic multi-axis pulse for tighter timing (bitmask). */
+/* Atomic multi-axis pulse (bit n = hal_axis_t n): sets every step pin in
+ * the mask high with a single port write. Used by the step ISR.
+ */
 void hal_stepper_pulse_mask(uint32_t axis_mask);
 
+/* Counterpart of hal_stepper_pulse_mask(): set step pins in the mask low. */
+void hal_stepper_clear_mask(uint32_t axis_mask);
+
+/* ----------------------------- Step timer ----------------------------- */
+
+/* Hardware timer that paces step generation (e.g., TIM2 on STM32F446).
+ *
+ * The stepper core arms a periodic timer. On every update event the HAL
+ * calls on_step (raise step pins). A second compare channel (or a one-shot
+ * timer) fires on_pulse_end pulse_ticks later (drop step pins). No
+ * busy-waiting is required anywhere in the step path.
+ *
+ * Both callbacks run in interrupt context.
+ */
+typedef void (*hal_timer_cb_t)(void *user);
+
+/* Install ISR callbacks. Call once before arming. */
+void hal_step_timer_init(hal_timer_cb_t on_step, hal_timer_cb_t on_pulse_end, void *user);
+
+/* Timer tick rate in Hz after prescaling (e.g., 1 MHz or 84 MHz). */
+uint32_t hal_step_timer_freq_hz(void);
+
+/* Start periodic update interrupts, first one period_ticks from now. */
+void hal_step_timer_arm(uint32_t period_ticks);
+
+/* Change the period. Takes effect at the next update event (buffered reload). */
+void hal_step_timer_reload(uint32_t period_ticks);
+
+/* Set the pulse-low compare: on_pulse_end fires pulse_ticks after each update. */
+void hal_step_timer_compare(uint32_t pulse_ticks);
+
+/* Stop the timer and mask its interrupts. */
+void hal_step_timer_stop(void);
+
 /* ----------------------------- Spindle / coolant ----------------------------- */
 
 typedef enum {
@@ -147,6 +207,21 @@ typedef struct {
 
 void hal_read_inputs(hal_inputs_t *out);
 
+/* Interrupt-driven inputs (EXTI on the limit / e-stop pins):
+ * - on_change(now, user) runs in interrupt context with the debounced
+ *   input levels whenever one of them changes
+ * - the first edge is reported at once (a trip must not wait for the
+ *   contact to settle); it masks the pin's EXTI and arms a timer capture
+ *   debounce_us later, which re-enables it and reports the settled level
+ *   if it differs, so bounce never reaches the callback
+ * - an input that is already active when this is called is reported once
+ *   right away
+ * Returns HAL_ERR if the board has no such path; poll hal_read_inputs() then.
+ */
+typedef void (*hal_inputs_cb_t)(const hal_inputs_t *now, void *user);
+
+hal_status_t hal_inputs_irq_init(uint32_t debounce_us, hal_inputs_cb_t on_change, void *user);
+
 /* ----------------------------- Scheduling hook ----------------------------- */
 
 /* Called frequently from main loop; do platform polling here (USB, DMA flush, etc). */
@@ -157,6 +232,13 @@ void hal_poll(void);
  */
 void hal_tick_1khz_isr(void);
 
+/* Sleep until the next interrupt (WFI on Cortex-M) unless *wake is already
+ * nonzero. Mask interrupts around the check and the WFI so an event posted
+ * just before sleeping still wakes the core (WFI wakes on a pending IRQ
+ * even with PRIMASK set). A host build may simply return.
+ */
+void hal_idle_wait(const volatile uint32_t *wake);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
@@ -12,135 +12,113 @@
 static kin_corexy_cfg_t s_cfg;
 static kin_cart_t s_machine_pose_cart; /* current machine position in Cartesian */
 
-/* ----------------- small helpers ----------------- */
+kin_corexy_fast_t g_kin_corexy_fast;
 
-static float maybe_invert(bool inv, float x) { return inv ? -x : x; }
+/* Joint and cart signs: -1 for inverted axes */
+static float sign_of(bool inv) { return inv ? -1.0f : 1.0f; }
 
-static void apply_cart_invert(const kin_corexy_cfg_t *c, kin_cart_t *p) {
-    for (uint8_t i = 0; i < KIN_MAX_CART_AXES; i++) p->v[i] = maybe_invert(c->invert_cart[i], p->v[i]);
-}
-
-static void apply_joint_invert(const kin_corexy_cfg_t *c, kin_joint_t *p) {
-    for (uint8_t i = 0; i < KIN_MAX_JOINT_AXES; i++) p->v[i] = maybe_invert(c->invert_joint[i], p->v[i]);
-}
-
-static void apply_joint_invert_steps(const kin_corexy_cfg_t *c, kin_steps_t *p) {
-    for (uint8_t i = 0; i < KIN_MAX_JOINT_AXES; i++) {
-        if (c->invert_joint[i]) p->v[i] = -p->v[i];
-    }
+/* Fold inversion into signed per-axis constants (see kin_corexy_fast_t).
+ *   A = ja * ( sx*x + sy*y)     B = jb * (sx*x - sy*y)     Z = jz * sz*z
+ *   x = sx * (ja*A + jb*B)/2    y = sy * (ja*A - jb*B)/2   z = sz * jz*Z
+ */
+static void derive_fast(const kin_corexy_cfg_t *c)
+{
+    kin_corexy_fast_t *f = &g_kin_corexy_fast;
+    const float sx = sign_of(c->invert_cart[0]);
+    const float sy = sign_of(c->invert_cart[1]);
+    const float sz = sign_of(c->invert_cart[2]);
+    const float ja = sign_of(c->invert_joint[0]);
+    const float jb = sign_of(c->invert_joint[1]);
+    const float jz = sign_of(c->invert_joint[2]);
+    const float spm_a = c->steps_per_mm[0], spm_b = c->steps_per_mm[1], spm_z = c->steps_per_mm[2];
+    const float mm_a = (spm_a != 0.0f) ? 1.0f / spm_a : 0.0f;
+    const float mm_b = (spm_b != 0.0f) ? 1.0f / spm_b : 0.0f;
+    const float mm_z = (spm_z != 0.0f) ? 1.0f / spm_z : 0.0f;
+
+    f->a_x = ja * sx * spm_a;
+    f->a_y = ja * sy * spm_a;
+    f->b_x = jb * sx * spm_b;
+    f->b_y = -jb * sy * spm_b;
+    f->z_z = jz * sz * spm_z;
+
+    f->x_a = 0.5f * sx * ja * mm_a;
+    f->x_b = 0.5f * sx * jb * mm_b;
+    f->y_a = 0.5f * sy * ja * mm_a;
+    f->y_b = -0.5f * sy * jb * mm_b;
+    f->z_per_step = sz * jz * mm_z;
 }
 
 /* ----------------- interface functions ----------------- */
 
 static void corexy_steps_to_cart(const kin_steps_t *steps, kin_cart_t *out_cart)
 {
-    /* steps -> joint mm -> cart mm */
-    kin_steps_t st = *steps;
-    apply_joint_invert_steps(&s_cfg, &st);
-
-    /* Convert steps to "joint mm-equivalent" */
-    float a = 0.0f, b = 0.0f, z = 0.0f;
-
-    if (s_cfg.steps_per_mm[0] != 0.0f) a = (float)st.v[0] / s_cfg.steps_per_mm[0];
-    if (s_cfg.steps_per_mm[1] != 0.0f) b = (float)st.v[1] / s_cfg.steps_per_mm[1];
-    if (s_cfg.steps_per_mm[2] != 0.0f) z = (float)st.v[2] / s_cfg.steps_per_mm[2];
-
-    /* Inverse CoreXY */
-    out_cart->v[0] = 0.5f * (a + b); /* X */
-    out_cart->v[1] = 0.5f * (a - b); /* Y */
-    out_cart->v[2] = z;              /* Z passes through */
-
-    apply_cart_invert(&s_cfg, out_cart);
+    kin_corexy_steps_to_cart(steps->v, out_cart);
 }
 
-static bool corexy_cart_to_joint(const kin_cart_t *cart_in, kin_joint_t *out_joint)
+static bool corexy_cart_to_joint(const kin_cart_t *cart, kin_joint_t *out_joint)
 {
-    kin_cart_t cart = *cart_in;
-    apply_cart_invert(&s_cfg, &cart); /* bring into "mechanism space" */
-
-    const float x = cart.v[0];
-    const float y = cart.v[1];
-    const float z = cart.v[2];
-
-    /* Forward CoreXY */
-    out_joint->v[0] = x + y; /* A */
-    out_joint->v[1] = x - y; /* B */
-    out_joint->v[2] = z;     /* Z */
+    /* Forward CoreXY with inversion folded in (joint mm = steps / spm) */
+    const float sx = sign_of(s_cfg.invert_cart[0]);
+    const float sy = sign_of(s_cfg.invert_cart[1]);
+    const float x = sx * cart->v[0];
+    const float y = sy * cart->v[1];
+
+    out_joint->v[0] = sign_of(s_cfg.invert_joint[0]) * (x + y); /* A */
+    out_joint->v[1] = sign_of(s_cfg.invert_joint[1]) * (x - y); /* B */
+    out_joint->v[2] = sign_of(s_cfg.invert_joint[2]) * sign_of(s_cfg.invert_cart[2]) * cart->v[2];
     out_joint->v[3] = 0.0f;  /* AUX unused by default */
-
-    apply_joint_invert(&s_cfg, out_joint);
     return true;
 }
 
-static bool corexy_joint_to_cart(const kin_joint_t *joint_in, kin_cart_t *out_cart)
+static bool corexy_joint_to_cart(const kin_joint_t *j, kin_cart_t *out_cart)
 {
-    kin_joint_t j = *joint_in;
-    apply_joint_invert(&s_cfg, &j); /* back to mechanism direction */
-
-    const float a = j.v[0];
-    const float b = j.v[1];
-    const float z = j.v[2];
+    const float a = sign_of(s_cfg.invert_joint[0]) * j->v[0];
+    const float b = sign_of(s_cfg.invert_joint[1]) * j->v[1];
 
-    out_cart->v[0] = 0.5f * (a + b);
-    out_cart->v[1] = 0.5f * (a - b);
-    out_cart->v[2] = z;
+    out_cart->v[0] = sign_of(s_cfg.invert_cart[0]) * 0.5f * (a + b);
+    out_cart->v[1] = sign_of(s_cfg.invert_cart[1]) * 0.5f * (a - b);
+    out_cart->v[2] = sign_of(s_cfg.invert_cart[2]) * sign_of(s_cfg.invert_joint[2]) * j->v[2];
+    return true;
+}
 
-    apply_cart_invert(&s_cfg, out_cart);
+static bool corexy_joint_to_steps(const kin_joint_t *joint, kin_steps_t *out_steps)
+{
+    /* Joint inversion is already folded into the joint coordinates */
+    for (uint8_t i = 0; i < KIN_MAX_JOINT_AXES; i++) {
+        out_steps->v[i] = (int32_t)lroundf(joint->v[i] * s_cfg.steps_per_mm[i]);
+    }
     return true;
 }
 
-static bool corexy_segment_move(const kin_cart_t *cart_target,
+static bool corexy_segment_init(kin_segment_iter_t *it,
+                                const kin_cart_t *cart_target,
                                 const kin_cart_t *cart_current,
-                                const kin_motion_hint_t *hint,
-                                bool init,
-                                kin_cart_t *out_cart_next)
+                                const kin_motion_hint_t *hint)
 {
     (void)hint;
 
     /* CoreXY is linear in joint space, so segmentation is not required.
        We support optional segmentation by max segment length in Cartesian space. */
 
-    static kin_cart_t s_tgt;
-    static kin_cart_t s_cur;
-    static uint16_t   s_n;
-    static uint16_t   s_i;
+    if (!it || !cart_target || !cart_current) return false;
 
-    if (!cart_target || !cart_current || !out_cart_next) return false;
-
-    if (s_cfg.max_segment_len_mm <= 0.0f) {
-        if (init) { *out_cart_next = *cart_target; return true; }
-        return false;
-    }
-
-    if (init) {
-        s_tgt = *cart_target;
-        s_cur = *cart_current;
-        s_i = 0;
-
-        const float dx = s_tgt.v[0] - s_cur.v[0];
-        const float dy = s_tgt.v[1] - s_cur.v[1];
-        const float dz = s_tgt.v[2] - s_cur.v[2];
+    uint16_t n = 1;
+    if (s_cfg.max_segment_len_mm > 0.0f) {
+        const float dx = cart_target->v[0] - cart_current->v[0];
+        const float dy = cart_target->v[1] - cart_current->v[1];
+        const float dz = cart_target->v[2] - cart_current->v[2];
 
         /* cheap L-infinity segment length (max axis delta) to avoid sqrt */
         float maxd = dx; if (maxd < 0) maxd = -maxd;
         float ay = dy; if (ay < 0) ay = -ay; if (ay > maxd) maxd = ay;
         float az = dz; if (az < 0) az = -az; if (az > maxd) maxd = az;
 
-        s_n = (uint16_t)(maxd / s_cfg.max_segment_len_mm);
-        if (s_n == 0) s_n = 1;
-        if (s_n > 10000u) s_n = 10000u; /* sanity clamp */
+        const float segs = maxd / s_cfg.max_segment_len_mm;
+        n = (segs > 10000.0f) ? 10000u : (uint16_t)segs; /* sanity clamp */
+        if (n == 0) n = 1;
     }
 
-    if (s_i >= s_n) return false;
-
-    /* produce next point (including final target at i=s_n-1) */
-    s_i++;
-    const float t = (float)s_i / (float)s_n;
-
-    out_cart_next->v[0] = s_cur.v[0] + (s_tgt.v[0] - s_cur.v[0]) * t;
-    out_cart_next->v[1] = s_cur.v[1] + (s_tgt.v[1] - s_cur.v[1]) * t;
-    out_cart_next->v[2] = s_cur.v[2] + (s_tgt.v[2] - s_cur.v[2]) * t;
-
+    kinematics_segment_linear_init(it, cart_target, cart_current, n);
     return true;
 }
 
@@ -193,6 +171,7 @@ void kin_corexy_set_cfg(const kin_corexy_cfg_t *cfg)
 {
     if (!cfg) return;
     s_cfg = *cfg;
+    derive_fast(&s_cfg);
 }
 
 void kin_corexy_get_cfg(kin_corexy_cfg_t *out)
@@ -214,6 +193,7 @@ void kin_corexy_install(const kin_corexy_cfg_t *cfg)
     s_cfg.home_slow_mm_min = 200.0f;
 
     if (cfg) s_cfg = *cfg;
+    derive_fast(&s_cfg);
 
     /* Build interface */
     kin_iface_t impl = {
@@ -223,7 +203,9 @@ void kin_corexy_install(const kin_corexy_cfg_t *cfg)
         .steps_to_cart = corexy_steps_to_cart,
         .cart_to_joint = corexy_cart_to_joint,
         .joint_to_cart = corexy_joint_to_cart,
-        .segment_move = corexy_segment_move,
+        .joint_to_steps = corexy_joint_to_steps,
+        .segment_init = corexy_segment_init,
+        .segment_fill = kinematics_segment_linear_fill,
 
         .limit_index_to_axes = corexy_limit_index_to_axes,
         .on_limit_trigger = corexy_on_limit_trigger,
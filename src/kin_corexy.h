@@ -19,6 +19,7 @@
 
 #include <stdbool.h>
 #include <stdint.h>
+#include <math.h>
 #include "kinematics.h"
 
 #ifdef __cplusplus
@@ -47,6 +48,45 @@ typedef struct {
     float home_slow_mm_min;
 } kin_corexy_cfg_t;
 
+/* Conversion constants derived from the config by kin_corexy_install() /
+ * kin_corexy_set_cfg(): cart and joint inversion are folded into the signs,
+ * and mm-per-step is precomputed (0 for a joint with no steps_per_mm).
+ * Read-only for everyone else.
+ */
+typedef struct {
+    float a_x, a_y;     /* A steps per mm of X, Y */
+    float b_x, b_y;     /* B steps per mm of X, Y */
+    float z_z;          /* Z steps per mm of Z */
+    float x_a, x_b;     /* mm of X per A, B step */
+    float y_a, y_b;     /* mm of Y per A, B step */
+    float z_per_step;   /* mm of Z per Z step */
+} kin_corexy_fast_t;
+
+extern kin_corexy_fast_t g_kin_corexy_fast;
+
+/* Hot-path conversions, inlined into callers built with
+ * GRBL_KINEMATICS_COREXY_INLINE (grbl.h). Same results as going through
+ * g_kin, without the vtable or the per-axis inversion branches.
+ */
+static inline void kin_corexy_cart_to_steps(const kin_cart_t *cart, int32_t out_steps[KIN_MAX_JOINT_AXES])
+{
+    const kin_corexy_fast_t *f = &g_kin_corexy_fast;
+    const float x = cart->v[0], y = cart->v[1];
+    out_steps[0] = (int32_t)lroundf(f->a_x * x + f->a_y * y);
+    out_steps[1] = (int32_t)lroundf(f->b_x * x + f->b_y * y);
+    out_steps[2] = (int32_t)lroundf(f->z_z * cart->v[2]);
+    for (uint8_t i = 3; i < KIN_MAX_JOINT_AXES; i++) out_steps[i] = 0;
+}
+
+static inline void kin_corexy_steps_to_cart(const int32_t steps[KIN_MAX_JOINT_AXES], kin_cart_t *out_cart)
+{
+    const kin_corexy_fast_t *f = &g_kin_corexy_fast;
+    const float a = (float)steps[0], b = (float)steps[1];
+    out_cart->v[0] = f->x_a * a + f->x_b * b;
+    out_cart->v[1] = f->y_a * a + f->y_b * b;
+    out_cart->v[2] = f->z_per_step * (float)steps[2];
+}
+
 /* Install CoreXY implementation into global g_kin and keep config internally. */
 void kin_corexy_install(const kin_corexy_cfg_t *cfg);
 
@@ -26,19 +26,23 @@ static bool joint_to_cart_stub(const kin_joint_t *joint, kin_cart_t *out_cart) {
     return false;
 }
 
-static bool segment_move_stub(const kin_cart_t *t, const kin_cart_t *c,
-                              const kin_motion_hint_t *h, bool init,
-                              kin_cart_t *out_next)
+static bool joint_to_steps_stub(const kin_joint_t *joint, kin_steps_t *out_steps) {
+    (void)joint;
+    if (out_steps) {
+        for (uint8_t i = 0; i < KIN_MAX_JOINT_AXES; i++) out_steps->v[i] = 0;
+    }
+    return false;
+}
+
+static bool segment_init_stub(kin_segment_iter_t *it, const kin_cart_t *t,
+                              const kin_cart_t *c, const kin_motion_hint_t *h)
 {
     (void)h;
-    if (!t || !c || !out_next) return false;
+    if (!it || !t || !c) return false;
 
-    /* Default behavior: no segmentation; return target once on init. */
-    if (init) {
-        *out_next = *t;
-        return true;
-    }
-    return false;
+    /* Default behavior: no segmentation; the target is the only endpoint. */
+    kinematics_segment_linear_init(it, t, c, 1u);
+    return true;
 }
 
 static kin_axis_mask_t limit_index_to_axes_stub(uint8_t idx) {
@@ -73,7 +77,9 @@ kin_iface_t g_kin = {
     .steps_to_cart = steps_to_cart_stub,
     .cart_to_joint = cart_to_joint_stub,
     .joint_to_cart = joint_to_cart_stub,
-    .segment_move = segment_move_stub,
+    .joint_to_steps = joint_to_steps_stub,
+    .segment_init = segment_init_stub,
+    .segment_fill = kinematics_segment_linear_fill,
 
     .limit_index_to_axes = limit_index_to_axes_stub,
     .on_limit_trigger = on_limit_trigger_stub,
@@ -92,7 +98,9 @@ void kinematics_install(const kin_iface_t *impl) {
     if (!g_kin.steps_to_cart)        g_kin.steps_to_cart = steps_to_cart_stub;
     if (!g_kin.cart_to_joint)        g_kin.cart_to_joint = cart_to_joint_stub;
     if (!g_kin.joint_to_cart)        g_kin.joint_to_cart = joint_to_cart_stub;
-    if (!g_kin.segment_move)         g_kin.segment_move = segment_move_stub;
+    if (!g_kin.joint_to_steps)       g_kin.joint_to_steps = joint_to_steps_stub;
+    if (!g_kin.segment_init)         g_kin.segment_init = segment_init_stub;
+    if (!g_kin.segment_fill)         g_kin.segment_fill = kinematics_segment_linear_fill;
     if (!g_kin.limit_index_to_axes)  g_kin.limit_index_to_axes = limit_index_to_axes_stub;
     if (!g_kin.on_limit_trigger)     g_kin.on_limit_trigger = on_limit_trigger_stub;
     if (!g_kin.set_machine_pose)     g_kin.set_machine_pose = set_machine_pose_stub;
@@ -105,4 +113,35 @@ void kinematics_install(const kin_iface_t *impl) {
 
     if (g_kin.joint_axes == 0 || g_kin.joint_axes > KIN_MAX_JOINT_AXES)
         g_kin.joint_axes = (uint8_t)KIN_MAX_JOINT_AXES;
-}
\ No newline at end of file
+}
+void kinematics_segment_linear_init(kin_segment_iter_t *it,
+                                    const kin_cart_t *cart_target,
+                                    const kin_cart_t *cart_current,
+                                    uint16_t count)
+{
+    it->origin = *cart_current;
+    it->target = *cart_target;
+    it->count = count ? count : 1u;
+    it->index = 0;
+}
+
+size_t kinematics_segment_linear_fill(kin_segment_iter_t *it, kin_cart_t *out, size_t cap)
+{
+    if (!it || !out) return 0;
+
+    const float inv_n = 1.0f / (float)it->count;
+    size_t n = 0;
+    while (n < cap && it->index < it->count) {
+        it->index++;
+        if (it->index == it->count) {
+            out[n++] = it->target;  /* exact endpoint, no rounding */
+            break;
+        }
+        const float t = (float)it->index * inv_n;
+        for (uint8_t a = 0; a < KIN_MAX_CART_AXES; a++) {
+            out[n].v[a] = it->origin.v[a] + (it->target.v[a] - it->origin.v[a]) * t;
+        }
+        n++;
+    }
+    return n;
+}
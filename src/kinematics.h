@@ -32,6 +32,16 @@ typedef struct { float v[KIN_MAX_CART_AXES]; } kin_cart_t;   /* mm or user units
 typedef struct { float v[KIN_MAX_JOINT_AXES]; } kin_joint_t; /* joint-space mm-equivalent */
 typedef struct { int32_t v[KIN_MAX_JOINT_AXES]; } kin_steps_t;
 
+/* Segmentation cursor for one straight move. Owned by the caller so several
+ * generators can run side by side; kinematics may use it as they see fit.
+ */
+typedef struct {
+    kin_cart_t origin;   /* start of the move */
+    kin_cart_t target;   /* end of the move */
+    uint16_t count;      /* total segments */
+    uint16_t index;      /* segments emitted so far */
+} kin_segment_iter_t;
+
 typedef struct {
     /* optional: feed/accel/junction limits you want the kinematics to know about */
     float feed_mm_min;
@@ -68,20 +78,30 @@ typedef struct kin_iface {
     /* Convert joint coordinates -> Cartesian (optional but handy for reporting/debug). */
     bool (*joint_to_cart)(const kin_joint_t *joint, kin_cart_t *out_cart);
 
-    /* Segmenting hook:
+    /* Convert joint coordinates -> absolute motor steps (rounded to nearest).
+     * Used by the planner to build per-joint step counts for a block.
+     */
+    bool (*joint_to_steps)(const kin_joint_t *joint, kin_steps_t *out_steps);
+
+    /* Segmenting hooks:
      * - Some kinematics (delta, SCARA, CoreXY with constraints) may need to subdivide
      *   a straight Cartesian move into smaller segments in joint space.
-     * - Return true when a segment was produced in out_cart_next.
-     * - Return false when segmentation is finished (no more segments).
+     * - segment_init() prepares a caller-owned iterator for one move; return false
+     *   to reject the move.
+     * - segment_fill() writes up to cap segment endpoints into out and returns the
+     *   count; 0 means the move is finished. The last endpoint is the target.
      *
      * Typical usage:
-     *   init=true on first call for a move; subsequent calls init=false until false returned.
+     *   kin_segment_iter_t it;
+     *   kin_cart_t chunk[8];
+     *   if (g_kin.segment_init(&it, &target, &current, &hint))
+     *       while ((n = g_kin.segment_fill(&it, chunk, 8)) > 0) queue(chunk, n);
      */
-    bool (*segment_move)(const kin_cart_t *cart_target,
+    bool (*segment_init)(kin_segment_iter_t *it,
+                         const kin_cart_t *cart_target,
                          const kin_cart_t *cart_current,
-                         const kin_motion_hint_t *hint,
-                         bool init,
-                         kin_cart_t *out_cart_next);
+                         const kin_motion_hint_t *hint);
+    size_t (*segment_fill)(kin_segment_iter_t *it, kin_cart_t *out, size_t cap);
 
     /* Limits / homing support:
      * Given a limit switch index (platform-specific), return which Cartesian axis it maps to.
@@ -108,6 +128,15 @@ extern kin_iface_t g_kin;
 /* Install/replace the active kinematics implementation. */
 void kinematics_install(const kin_iface_t *impl);
 
+/* Shared segmentation for kinematics that interpolate linearly in Cartesian
+ * space: split current->target into count equal segments (count >= 1).
+ */
+void kinematics_segment_linear_init(kin_segment_iter_t *it,
+                                    const kin_cart_t *cart_target,
+                                    const kin_cart_t *cart_current,
+                                    uint16_t count);
+size_t kinematics_segment_linear_fill(kin_segment_iter_t *it, kin_cart_t *out, size_t cap);
+
 /* Convenience helpers to avoid NULL checks all over your core. */
 static inline uint8_t kinematics_cart_axes(void)  { return g_kin.cart_axes; }
 static inline uint8_t kinematics_joint_axes(void) { return g_kin.joint_axes; }
@@ -0,0 +1,302 @@
+/* pipeline.c - Event-driven main loop implementation */
+
+#include "pipeline.h"
+#include <string.h>
+
+#define RT_QUEUE_MASK (PIPELINE_RT_QUEUE_SIZE - 1u)
+
+/* ----------------------------- ISR-side callbacks ----------------------------- */
+
+/* Realtime byte seen by the protocol layer (RX ISR or DMA ISR): queue it */
+static void on_rt(proto_rt_cmd_t cmd, void *user) {
+    pipeline_t *pl = (pipeline_t *)user;
+    uint8_t tail = pl->rt_tail;
+    if ((uint8_t)(tail - pl->rt_head) >= PIPELINE_RT_QUEUE_SIZE) {
+        pl->rt_dropped++;
+    } else {
+        pl->rt_queue[tail & RT_QUEUE_MASK] = (uint8_t)cmd;
+        PLANNER_MEMORY_BARRIER();  /* entry visible before the index */
+        pl->rt_tail = (uint8_t)(tail + 1u);
+    }
+    sched_signal(&pl->sched, PIPE_EV_REALTIME);
+}
+
+static void on_rx_dma(size_t pos, void *user) {
+    pipeline_t *pl = (pipeline_t *)user;
+    protocol_rx_dma_isr(pos, &pl->proto);
+    sched_signal(&pl->sched, PIPE_EV_RX);
+}
+
+/* Debounced limit / e-stop change: halt motion here, alarm in task context */
+static void on_inputs(const hal_inputs_t *now, void *user) {
+    pipeline_t *pl = (pipeline_t *)user;
+    if (system_inputs_isr(&pl->sys, now)) {
+        stepper_emergency_stop(&pl->stepper);
+    }
+    sched_signal(&pl->sched, PIPE_EV_LIMIT);
+}
+
+static void on_step_low(void *user) {
+    pipeline_t *pl = (pipeline_t *)user;
+    sched_signal(&pl->sched, PIPE_EV_STEP);
+}
+
+/* ----------------------------- Private helpers ----------------------------- */
+
+/* Bring the stepper in line with the machine state after a realtime
+ * command or an alarm.
+ */
+static void sync_stepper(pipeline_t *pl) {
+    switch (pl->sys.state) {
+        case SYS_STATE_ALARM:
+            stepper_reset(&pl->stepper);
+            break;
+        case SYS_STATE_HOLD:
+            stepper_hold(&pl->stepper);
+            break;
+        case SYS_STATE_RUNNING:
+            stepper_resume(&pl->stepper);
+            break;
+        default:
+            break;
+    }
+    sched_signal(&pl->sched, PIPE_EV_STEP);
+}
+
+static void send_str(const char *s) {
+    hal_serial_write_str(HAL_PORT_GCODE, s);
+}
+
+/* "error:<code>", code a gcode_status_t or system_error_t */
+static void send_error(uint8_t code) {
+    char buf[sizeof("error:255\r\n")] = "error:";
+    size_t n = 6;
+    if (code >= 100u) buf[n++] = (char)('0' + code / 100u);
+    if (code >= 10u)  buf[n++] = (char)('0' + code / 10u % 10u);
+    buf[n++] = (char)('0' + code % 10u);
+    buf[n++] = '\r';
+    buf[n++] = '\n';
+    hal_serial_write(HAL_PORT_GCODE, (const uint8_t *)buf, n);
+}
+
+/* Send the owed reply once the line has left the parser */
+static void finish_line(pipeline_t *pl) {
+    pl->line_owed = false;
+#if GRBL_FEATURE_PROFILE
+    if (pl->sys.profile_report_len) {
+        send_str(pl->sys.profile_report);
+        pl->sys.profile_report_len = 0;
+    }
+#endif
+    if (pl->sys.total_errors == pl->line_errors) {
+        send_str("ok\r\n");
+    } else {
+        send_error(pl->sys.last_error);
+    }
+    system_sync_position(&pl->sys);
+}
+
+/* Execute one line; the reply waits if the planner is full */
+static void take_line(pipeline_t *pl, const char *line, proto_line_status_t st) {
+    if (st == PROTO_LINE_EMPTY) {
+        send_str("ok\r\n");
+        return;
+    }
+    if (st == PROTO_LINE_OVERFLOW || st == PROTO_LINE_BAD_CHAR) {
+        pl->sys.total_errors++;
+        pl->sys.last_error = (st == PROTO_LINE_OVERFLOW) ? SYS_ERR_LINE_OVERFLOW : SYS_ERR_BAD_CHAR;
+        send_error(pl->sys.last_error);
+        return;
+    }
+
+    pl->line_owed = true;
+    pl->line_errors = pl->sys.total_errors;
+    system_process_line(&pl->sys, line);
+    sched_signal(&pl->sched, PIPE_EV_STEP);  /* new blocks for the stepper */
+    if (!system_line_pending(&pl->sys)) {
+        finish_line(pl);
+    }
+}
+
+/* ----------------------------- Tasks ----------------------------- */
+
+static bool task_limits(void *user) {
+    pipeline_t *pl = (pipeline_t *)user;
+    system_check_inputs(&pl->sys);
+    if (system_is_alarmed(&pl->sys)) {
+        sync_stepper(pl);
+    }
+    return false;
+}
+
+static bool task_stepper(void *user) {
+    pipeline_t *pl = (pipeline_t *)user;
+
+    /* A hold between blocks must not start the next one */
+    if (pl->sys.state == SYS_STATE_HOLD && stepper_is_idle(&pl->stepper)) {
+        return false;
+    }
+    stepper_update(&pl->stepper);
+
+    /* Motion drained: back to idle */
+    if (pl->sys.state == SYS_STATE_RUNNING && stepper_is_idle(&pl->stepper) &&
+        planner_is_empty(&pl->sys.planner) && !system_line_pending(&pl->sys)) {
+        system_set_state(&pl->sys, SYS_STATE_IDLE);
+    }
+    return false;
+}
+
+static bool task_realtime(void *user) {
+    pipeline_t *pl = (pipeline_t *)user;
+
+    while (pl->rt_head != pl->rt_tail) {
+        uint8_t head = pl->rt_head;
+        proto_rt_cmd_t cmd = (proto_rt_cmd_t)pl->rt_queue[head & RT_QUEUE_MASK];
+        pl->rt_head = (uint8_t)(head + 1u);
+
+        if (cmd == PROTO_RT_RESET) {
+            /* Stepper first: the system reset clears the planner it reads */
+            stepper_reset(&pl->stepper);
+            pl->line_owed = false;
+        }
+        system_realtime_command(&pl->sys, cmd);
+
+        if (cmd == PROTO_RT_STATUS_QUERY) {
+            hal_serial_write(HAL_PORT_GCODE, (const uint8_t *)pl->sys.report, pl->sys.report_len);
+            send_str("\r\n");
+        } else {
+            sync_stepper(pl);
+        }
+    }
+    return false;
+}
+
+static bool task_rx(void *user) {
+    pipeline_t *pl = (pipeline_t *)user;
+    if (pl->rx_dma) {
+        return false;  /* lines are scanned in place by the line task */
+    }
+
+    /* Polled ports (no RX interrupt wired to pipeline_rx_isr) */
+    uint8_t chunk[PIPELINE_RX_CHUNK];
+    size_t cap = protocol_rx_free(&pl->proto);
+    if (cap > sizeof(chunk)) cap = sizeof(chunk);
+    size_t n = cap ? hal_serial_read(HAL_PORT_GCODE, chunk, cap) : 0u;
+    if (n > 0u) {
+        protocol_rx_write(&pl->proto, chunk, n);
+    }
+
+    protocol_service(&pl->proto);
+    if (n > 0u) {
+        sched_signal(&pl->sched, PIPE_EV_RX);  /* wake the line task; read on while bytes come */
+    }
+    return false;
+}
+
+static bool task_line(void *user) {
+    pipeline_t *pl = (pipeline_t *)user;
+
+    /* Lines stay buffered through a hold; cycle start posts PIPE_EV_STEP */
+    if (pl->sys.state == SYS_STATE_HOLD) {
+        return false;
+    }
+
+    /* The previous line is still waiting for planner space */
+    if (pl->line_owed) {
+        if (system_retry_pending(&pl->sys)) {
+            return false;  /* retried when the stepper retires a block */
+        }
+        sched_signal(&pl->sched, PIPE_EV_STEP);
+        finish_line(pl);
+        return true;
+    }
+
+    if (pl->rx_dma) {
+        proto_line_view_t view;
+        if (!protocol_peek_line(&pl->proto, &view)) {
+            return false;
+        }
+        take_line(pl, view.text, view.st);  /* held lines are copied */
+        protocol_release_line(&pl->proto);
+        return true;
+    }
+
+    proto_line_status_t st;
+    if (!protocol_pop_line(&pl->proto, pl->line, sizeof(pl->line), &st)) {
+        return false;
+    }
+    take_line(pl, pl->line, st);
+    sched_signal(&pl->sched, PIPE_EV_RX);  /* queue space freed: keep assembling */
+    return true;
+}
+
+static bool task_housekeeping(void *user) {
+    pipeline_t *pl = (pipeline_t *)user;
+    pl->sys.uptime_ms = hal_millis();
+    hal_poll();
+    return false;
+}
+
+/* ----------------------------- Public API ----------------------------- */
+
+void pipeline_init(pipeline_t *pl, const stepper_config_t *stepper_cfg) {
+    if (!pl) return;
+
+    memset(pl, 0, sizeof(*pl));
+    sched_init(&pl->sched);
+
+    /* Lines are pulled by the line task, realtime bytes go to on_rt */
+    const proto_config_t cfg = {
+        .strip_semicolon_comments = true,
+        .strip_paren_comments = true,
+        .allow_dollar_commands = true,
+        .to_uppercase = true,
+    };
+    protocol_init(&pl->proto, &cfg, NULL, on_rt, pl);
+
+    system_init(&pl->sys);
+    system_attach_protocol(&pl->sys, &pl->proto);
+    stepper_init(&pl->stepper, stepper_cfg);
+    stepper_attach_planner(&pl->stepper, &pl->sys.planner);
+    stepper_set_notify(&pl->stepper, on_step_low, pl);
+
+    /* Registration order is priority order */
+    sched_add_task(&pl->sched, task_limits, pl, PIPE_EV_LIMIT);
+    sched_add_task(&pl->sched, task_stepper, pl, PIPE_EV_STEP | PIPE_EV_TICK);
+    sched_add_task(&pl->sched, task_realtime, pl, PIPE_EV_REALTIME);
+    sched_add_task(&pl->sched, task_rx, pl, PIPE_EV_RX | PIPE_EV_TICK);
+    sched_add_task(&pl->sched, task_line, pl, PIPE_EV_RX | PIPE_EV_STEP);
+    sched_add_task(&pl->sched, task_housekeeping, pl, PIPE_EV_TICK);
+
+    pl->sys.inputs_irq = hal_inputs_irq_init(PIPELINE_INPUT_DEBOUNCE_US, on_inputs, pl) == HAL_OK;
+    pl->rx_dma = hal_serial_rx_dma_start(HAL_PORT_GCODE, protocol_rx_dma_buffer(&pl->proto),
+                                         PROTOCOL_RX_BUFFER_SIZE, on_rx_dma, pl) == HAL_OK;
+}
+
+bool pipeline_poll(pipeline_t *pl) {
+    if (!pl) return false;
+    return sched_run_once(&pl->sched);
+}
+
+void pipeline_run(pipeline_t *pl) {
+    if (!pl) return;
+    sched_run(&pl->sched);
+}
+
+/* ----------------------------- ISR entry points ----------------------------- */
+
+void pipeline_rx_isr(pipeline_t *pl, const uint8_t *data, size_t len) {
+    if (!pl || !data) return;
+    protocol_rx_write(&pl->proto, data, len);
+    sched_signal(&pl->sched, PIPE_EV_RX);
+}
+
+void pipeline_limit_isr(pipeline_t *pl) {
+    if (!pl) return;
+    sched_signal(&pl->sched, PIPE_EV_LIMIT);
+}
+
+void pipeline_tick_isr(pipeline_t *pl) {
+    if (!pl) return;
+    sched_signal(&pl->sched, PIPE_EV_TICK);
+}
@@ -0,0 +1,130 @@
+/* pipeline.h - Event-driven main loop: protocol -> gcode -> planner -> stepper
+ *
+ * Purpose:
+ *  - Own one instance of each core subsystem and wire them into a dataflow
+ *    pipeline run by the cooperative scheduler (scheduler.h)
+ *  - Give every ISR a single entry point that only records what happened
+ *    and posts an event; all real work runs in prioritized main-loop tasks
+ *
+ * Tasks, highest priority first:
+ *  1. limits    (PIPE_EV_LIMIT)           raise a latched alarm, halt the stepper
+ *  2. stepper   (PIPE_EV_STEP, TICK)      refill segments, retire blocks
+ *  3. realtime  (PIPE_EV_REALTIME)        status / hold / resume / overrides
+ *  4. rx        (PIPE_EV_RX, TICK)        RX ring -> line assembly
+ *  5. line      (PIPE_EV_RX, STEP)        one line per slice -> gcode/planner
+ *  6. housekeep (PIPE_EV_TICK)            uptime, hal_poll()
+ *
+ * A limit or e-stop reported through hal_inputs_irq_init() stops the step
+ * timer inside the input interrupt, so stop distance does not depend on
+ * what the main loop is doing; the limits task only raises the alarm.
+ *
+ * The scheduler re-checks events between slices, so a segment-low request
+ * from the step ISR is served after at most one line parse, and a '?'
+ * after at most one slice of any task below it. Realtime commands are
+ * queued by the RX ISR and applied here, so overrides never replan from
+ * interrupt context.
+ *
+ * Platform glue (e.g. hal_stm32.c):
+ *  - UART RX interrupt:      pipeline_rx_isr() (unless the DMA path is used)
+ *  - limit / e-stop EXTI:    hal_inputs_irq_init() is called here; boards
+ *                            without it call pipeline_limit_isr() on an
+ *                            edge and the limits task polls the inputs
+ *  - 1 kHz SysTick:          pipeline_tick_isr()
+ *  - main():                 hal_init(); pipeline_init(); hal_start(); pipeline_run();
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "scheduler.h"
+#include "protocol.h"
+#include "system_state.h"
+#include "stepper.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ----------------------------- Events ----------------------------- */
+
+#define PIPE_EV_RX        (1u << 0)   /* Serial bytes arrived */
+#define PIPE_EV_LIMIT     (1u << 1)   /* Limit / e-stop input edge */
+#define PIPE_EV_STEP      (1u << 2)   /* Segments low, block done, or block queued */
+#define PIPE_EV_REALTIME  (1u << 3)   /* Realtime command queued */
+#define PIPE_EV_TICK      (1u << 4)   /* 1 kHz housekeeping tick */
+
+/* Realtime commands buffered between the RX ISR and the realtime task
+ * (power of two, <= 128).
+ */
+#ifndef PIPELINE_RT_QUEUE_SIZE
+#define PIPELINE_RT_QUEUE_SIZE 16u
+#endif
+
+#if (PIPELINE_RT_QUEUE_SIZE & (PIPELINE_RT_QUEUE_SIZE - 1u)) != 0u || \
+    (PIPELINE_RT_QUEUE_SIZE > 128u)
+  #error "PIPELINE_RT_QUEUE_SIZE must be a power of two <= 128"
+#endif
+
+/* Limit / e-stop debounce hold-off passed to hal_inputs_irq_init() */
+#ifndef PIPELINE_INPUT_DEBOUNCE_US
+#define PIPELINE_INPUT_DEBOUNCE_US 2000u
+#endif
+
+/* Bytes read per hal_serial_read() when the port has no DMA path */
+#ifndef PIPELINE_RX_CHUNK
+#define PIPELINE_RX_CHUNK 64u
+#endif
+
+/* ----------------------------- Pipeline ----------------------------- */
+
+typedef struct {
+    scheduler_t sched;
+    protocol_t proto;
+    system_context_t sys;
+    stepper_context_t stepper;
+
+    /* Receive path */
+    bool rx_dma;                  /* UART DMA writes straight into proto.rx */
+    char line[PROTOCOL_LINE_MAX + 1]; /* Pop buffer for the interrupt path */
+
+    /* Reply owed for the line being executed (held while the planner is full) */
+    bool line_owed;
+    uint32_t line_errors;         /* sys.total_errors when the line was taken */
+
+    /* Realtime commands from the RX ISR, in arrival order */
+    uint8_t rt_queue[PIPELINE_RT_QUEUE_SIZE];
+    volatile uint8_t rt_head;     /* Consumer (realtime task), free-running */
+    volatile uint8_t rt_tail;     /* Producer (ISR), free-running */
+    volatile uint16_t rt_dropped; /* Commands lost to a full queue */
+} pipeline_t;
+
+/* ----------------------------- Public API ----------------------------- */
+
+/* Initialize every subsystem, register the tasks and start UART DMA if the
+ * HAL has it. stepper_cfg may be NULL for defaults.
+ */
+void pipeline_init(pipeline_t *pl, const stepper_config_t *stepper_cfg);
+
+/* Run one scheduler slice. Returns false if nothing was ready. */
+bool pipeline_poll(pipeline_t *pl);
+
+/* Main loop; sleeps in hal_idle_wait() between events. Never returns. */
+void pipeline_run(pipeline_t *pl);
+
+/* ----------------------------- ISR entry points ----------------------------- */
+
+/* UART RX interrupt: bytes from the G-code port (interrupt path only) */
+void pipeline_rx_isr(pipeline_t *pl, const uint8_t *data, size_t len);
+
+/* Limit / e-stop EXTI edge (boards without hal_inputs_irq_init()) */
+void pipeline_limit_isr(pipeline_t *pl);
+
+/* 1 kHz tick (dwells, idle motor timeout, uptime, hal_poll) */
+void pipeline_tick_isr(pipeline_t *pl);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,6 +1,22 @@
 #include "planner.h"
 #include "protocol.h"
+#include "grbl.h"
+#include "profile.h"
+#if GRBL_KINEMATICS_COREXY_INLINE
+#include "kin_corexy.h"
+#endif
 #include <string.h>
+#include <math.h>
+
+// Junction cosines beyond these are treated as straight-through / full reversal
+#define JUNCTION_COS_STRAIGHT 0.999999f
+#define JUNCTION_SPEED_SQR_UNLIMITED 1.0e18f
+
+// Fastest squared speed reachable from v_sqr over the whole block, in either
+// direction: v_entry^2 = v_exit^2 + 2*a*d, with 2*a*d precomputed
+static inline float max_allowable_speed_sqr(const planner_block_t *block, float v_sqr) {
+    return v_sqr + block->max_delta_speed_sqr;
+}
 
 // Initialize a planner block with default values
 void planner_block_init(planner_block_t *block) {
@@ -20,7 +36,7 @@ int planner_block_validate(const planner_block_t *block) {
     }
     
     // Check that speeds are non-negative
-    if (block->entry_speed < 0.0f) {
+    if (block->entry_speed_sqr < 0.0f) {
         return 0; // Invalid: negative entry speed
     }
     
@@ -28,7 +44,7 @@ int planner_block_validate(const planner_block_t *block) {
         return 0; // Invalid: negative nominal speed
     }
     
-    if (block->exit_speed < 0.0f) {
+    if (block->exit_speed_sqr < 0.0f) {
         return 0; // Invalid: negative exit speed
     }
     
@@ -37,8 +53,8 @@ int planner_block_validate(const planner_block_t *block) {
         return 0; // Invalid: negative acceleration
     }
     
-    // Check that max_entry_speed is non-negative
-    if (block->max_entry_speed < 0.0f) {
+    // Check that max_entry_speed_sqr is non-negative
+    if (block->max_entry_speed_sqr < 0.0f) {
         return 0; // Invalid: negative max entry speed
     }
     
@@ -47,17 +63,18 @@ int planner_block_validate(const planner_block_t *block) {
         return 0; // Invalid: negative distance
     }
     
-    // Check that entry_speed does not exceed max_entry_speed (if max is set)
-    if (block->max_entry_speed > 0.0f && block->entry_speed > block->max_entry_speed) {
+    // Check that entry speed does not exceed max entry speed (if max is set)
+    if (block->max_entry_speed_sqr > 0.0f && block->entry_speed_sqr > block->max_entry_speed_sqr) {
         return 0; // Invalid: entry speed exceeds maximum
     }
     
-    // Check that entry_speed and exit_speed do not exceed nominal_speed
+    // Check that entry and exit speeds do not exceed nominal_speed
     if (block->nominal_speed > 0.0f) {
-        if (block->entry_speed > block->nominal_speed) {
+        float nominal_sqr = block->nominal_speed * block->nominal_speed;
+        if (block->entry_speed_sqr > nominal_sqr) {
             return 0; // Invalid: entry speed exceeds nominal speed
         }
-        if (block->exit_speed > block->nominal_speed) {
+        if (block->exit_speed_sqr > nominal_sqr) {
             return 0; // Invalid: exit speed exceeds nominal speed
         }
     }
@@ -65,85 +82,158 @@ int planner_block_validate(const planner_block_t *block) {
     return 1; // Valid block
 }
 
-// Initialize a planner queue with given capacity
-void planner_queue_init(planner_queue_t *queue, uint32_t capacity) {
+// Slot for a free-running ring index
+static planner_block_t *slot_at(planner_queue_t *queue, uint8_t index) {
+    return &queue->blocks[index & PLANNER_BUFFER_MASK];
+}
+
+// Free-running index of a block that lives in the ring
+static uint8_t index_of(const planner_queue_t *queue, const planner_block_t *block) {
+    uint8_t offset = (uint8_t)((block - queue->blocks) - (queue->head & PLANNER_BUFFER_MASK)) &
+                     PLANNER_BUFFER_MASK;
+    return (uint8_t)(queue->head + offset);
+}
+
+// Initialize an empty planner queue
+void planner_queue_init(planner_queue_t *queue) {
     if (queue == NULL) {
         return;
     }
     
-    queue->head = NULL;
-    queue->tail = NULL;
-    queue->size = 0;
-    queue->capacity = capacity;
+    memset(queue, 0, sizeof(*queue));
+    queue->settings.acceleration = PLANNER_DEFAULT_ACCELERATION;
+    queue->settings.max_rate = PLANNER_DEFAULT_MAX_RATE;
+    queue->settings.junction_deviation = PLANNER_DEFAULT_JUNCTION_DEVIATION;
+    queue->feed_override = PLANNER_FEED_OVERRIDE_DEFAULT;
+    queue->rapid_override = PLANNER_RAPID_OVERRIDE_DEFAULT;
+    queue->spindle_override = PLANNER_SPINDLE_OVERRIDE_DEFAULT;
 }
 
-// Add a new block to the end of the queue
+// Return the next free slot without adding it to the queue
+// Returns pointer to the slot, NULL if queue is full
+planner_block_t* planner_get_next_free_block(planner_queue_t *queue) {
+    if (queue == NULL || planner_is_full(queue)) {
+        return NULL;
+    }
+    
+    return slot_at(queue, queue->tail);
+}
+
+// Append the slot returned by planner_get_next_free_block()
+// Returns 1 on success, 0 on failure (queue full or NULL queue)
+int planner_commit_block(planner_queue_t *queue) {
+    if (queue == NULL || planner_is_full(queue)) {
+        return 0;
+    }
+    
+    // Publish only after the slot is fully written
+    PLANNER_MEMORY_BARRIER();
+    queue->tail = (uint8_t)(queue->tail + 1u);
+    PROFILE_HWM(PROFILE_HWM_PLANNER, planner_block_count(queue));
+    return 1;
+}
+
+// Copy a block to the end of the queue
 // Returns 1 on success, 0 on failure (queue full or NULL parameters)
-int planner_enqueue(planner_queue_t *queue, planner_block_t *block) {
-    if (queue == NULL || block == NULL) {
+int planner_enqueue(planner_queue_t *queue, const planner_block_t *block) {
+    if (block == NULL) {
         return 0;
     }
     
-    // Check if queue is full
-    if (queue->capacity > 0 && queue->size >= queue->capacity) {
+    planner_block_t *slot = planner_get_next_free_block(queue);
+    if (slot == NULL) {
         return 0; // Queue is full
     }
     
-    // Clear the next pointer of the new block
-    block->next = NULL;
-    
-    if (queue->tail == NULL) {
-        // Queue is empty, set both head and tail to the new block
-        queue->head = block;
-        queue->tail = block;
-    } else {
-        // Add block to the end of the queue
-        queue->tail->next = block;
-        queue->tail = block;
+    if (slot != block) {
+        *slot = *block;
     }
-    
-    queue->size++;
-    return 1;
+    return planner_commit_block(queue);
 }
 
-// Remove and return the block at the front of the queue
-// Returns pointer to the block on success, NULL if queue is empty
+// Remove the block at the front of the queue
+// Returns pointer to its slot on success, NULL if queue is empty. The slot is
+// free again once this returns, so copy anything needed before the producer
+// can wrap around to it; execute in place via planner_get_current_block().
 planner_block_t* planner_dequeue(planner_queue_t *queue) {
-    if (queue == NULL || queue->head == NULL) {
+    if (queue == NULL || planner_is_empty(queue)) {
         return NULL;
     }
     
-    planner_block_t *block = queue->head;
-    queue->head = queue->head->next;
+    // Read the slot before handing it back to the producer
+    planner_block_t *block = slot_at(queue, queue->head);
+    PLANNER_MEMORY_BARRIER();
+    queue->head = (uint8_t)(queue->head + 1u);
+    return block;
+}
+
+// Consumer side: return the front block and mark it as executing so the
+// planner stops replanning it. Returns NULL if the queue is empty.
+planner_block_t* planner_get_current_block(planner_queue_t *queue) {
+    if (queue == NULL || planner_is_empty(queue)) {
+        return NULL;
+    }
     
-    if (queue->head == NULL) {
-        // Queue is now empty, update tail
-        queue->tail = NULL;
+    queue->current_in_use = 1;
+    PLANNER_MEMORY_BARRIER();
+    return slot_at(queue, queue->head);
+}
+
+// Consumer side: the executing block is finished; release its slot
+void planner_discard_current_block(planner_queue_t *queue) {
+    if (queue == NULL || planner_is_empty(queue)) {
+        return;
     }
     
-    queue->size--;
-    block->next = NULL; // Clear the next pointer
-    return block;
+    PLANNER_MEMORY_BARRIER();
+    queue->head = (uint8_t)(queue->head + 1u);
+    queue->current_in_use = 0;
 }
 
 // Peek at the block at the front of the queue without removing it
 // Returns pointer to the front block, NULL if queue is empty
-planner_block_t* planner_peek_front(const planner_queue_t *queue) {
-    if (queue == NULL) {
+planner_block_t* planner_peek_front(planner_queue_t *queue) {
+    if (queue == NULL || planner_is_empty(queue)) {
         return NULL;
     }
     
-    return queue->head;
+    return slot_at(queue, queue->head);
 }
 
 // Peek at the block at the back of the queue without removing it
 // Returns pointer to the back block, NULL if queue is empty
-planner_block_t* planner_peek_back(const planner_queue_t *queue) {
-    if (queue == NULL) {
+planner_block_t* planner_peek_back(planner_queue_t *queue) {
+    if (queue == NULL || planner_is_empty(queue)) {
         return NULL;
     }
     
-    return queue->tail;
+    return slot_at(queue, (uint8_t)(queue->tail - 1u));
+}
+
+// Block after the given one, NULL if it is the newest
+planner_block_t* planner_next_block(planner_queue_t *queue, const planner_block_t *block) {
+    if (queue == NULL || block == NULL) {
+        return NULL;
+    }
+    
+    uint8_t next = (uint8_t)(index_of(queue, block) + 1u);
+    if ((uint8_t)(next - queue->head) >= planner_block_count(queue)) {
+        return NULL;
+    }
+    return slot_at(queue, next);
+}
+
+// Block before the given one, NULL if it is the oldest
+planner_block_t* planner_prev_block(planner_queue_t *queue, const planner_block_t *block) {
+    if (queue == NULL || block == NULL) {
+        return NULL;
+    }
+    
+    uint8_t index = index_of(queue, block);
+    if (index == queue->head) {
+        return NULL;
+    }
+    return slot_at(queue, (uint8_t)(index - 1u));
 }
 
 // Check if the queue is empty
@@ -153,17 +243,467 @@ int planner_is_empty(const planner_queue_t *queue) {
         return 1;
     }
     
-    return queue->size == 0;
+    return queue->head == queue->tail;
 }
 
-// Clear the queue, removing all blocks
-// Note: This does not free the blocks themselves, only removes them from the queue
+// Check if the queue is full
+// Returns 1 if full or NULL queue, 0 otherwise
+int planner_is_full(const planner_queue_t *queue) {
+    if (queue == NULL) {
+        return 1;
+    }
+    
+    return planner_block_count(queue) >= PLANNER_BUFFER_SIZE;
+}
+
+// Number of blocks currently queued
+uint32_t planner_block_count(const planner_queue_t *queue) {
+    if (queue == NULL) {
+        return 0;
+    }
+    
+    return (uint8_t)(queue->tail - queue->head);
+}
+
+// Clear the queue, discarding all blocks
+// Writes both indices: only call with the consumer stopped (reset / alarm).
 void planner_queue_clear(planner_queue_t *queue) {
     if (queue == NULL) {
         return;
     }
     
-    queue->head = NULL;
-    queue->tail = NULL;
-    queue->size = 0;
+    queue->head = 0;
+    queue->tail = 0;
+    queue->current_in_use = 0;
+    queue->planned = 0;
+}
+
+
+// ----------------------------- Look-ahead planning -----------------------------
+
+// Junction deviation: treat the corner as a circle of radius R tangent to both
+// moves, deviating junction_dev_mm from the corner point. The speed limit is
+// the one that keeps centripetal acceleration within the block acceleration:
+//   v^2 = a * junction_dev * sin(theta/2) / (1 - sin(theta/2))
+float planner_junction_speed_sqr(const planner_block_t *prev, const planner_block_t *block,
+                                 float junction_dev_mm) {
+    if (prev == NULL || block == NULL) {
+        return PLANNER_MINIMUM_JUNCTION_SPEED_SQR;
+    }
+    
+    // cos(theta) where theta is the angle between the incoming and outgoing paths
+    float cos_theta = 0.0f;
+    for (uint8_t i = 0; i < KIN_MAX_CART_AXES; i++) {
+        cos_theta -= prev->unit_vec[i] * block->unit_vec[i];
+    }
+    
+    if (cos_theta > JUNCTION_COS_STRAIGHT) {
+        // Full reversal: come to a stop
+        return PLANNER_MINIMUM_JUNCTION_SPEED_SQR;
+    }
+    if (cos_theta < -JUNCTION_COS_STRAIGHT) {
+        // Straight through: only the nominal speeds limit the junction
+        return JUNCTION_SPEED_SQR_UNLIMITED;
+    }
+    
+    float sin_theta_d2 = sqrtf(0.5f * (1.0f - cos_theta));
+    float v_sqr = block->acceleration * junction_dev_mm * sin_theta_d2 / (1.0f - sin_theta_d2);
+    if (v_sqr < PLANNER_MINIMUM_JUNCTION_SPEED_SQR) {
+        v_sqr = PLANNER_MINIMUM_JUNCTION_SPEED_SQR;
+    }
+    return v_sqr;
+}
+
+// Reverse pass: walk from the newest block back towards the planned pointer,
+// raising entry speeds to what the following block allows decelerating
+// into. The planned block and everything before it are final and never
+// modified. Stops early at the first block that is already at its maximum
+// or did not change, since nothing before it can change either - unless
+// full is set, after every block's limits were rebuilt.
+static void planner_reverse_pass(planner_queue_t *queue, uint8_t planned, uint8_t tail, bool full) {
+    uint8_t index = (uint8_t)(tail - 1u);
+    if (index == planned) {
+        return;
+    }
+    
+    // Newest block must be able to stop at its end
+    planner_block_t *next = slot_at(queue, index);
+    float v_sqr = max_allowable_speed_sqr(next, PLANNER_MINIMUM_SPEED_SQR);
+    float entry_sqr = (next->max_entry_speed_sqr < v_sqr) ? next->max_entry_speed_sqr : v_sqr;
+    if (entry_sqr != next->entry_speed_sqr) {
+        next->entry_speed_sqr = entry_sqr;
+        next->recalculate_flag = 1;
+    }
+    
+    for (index--; index != planned; index--) {
+        planner_block_t *current = slot_at(queue, index);
+        if (!full && current->entry_speed_sqr == current->max_entry_speed_sqr) {
+            break; // Already maxed out
+        }
+        
+        float new_entry_sqr;
+        if (!current->nominal_length_flag && current->max_entry_speed_sqr > next->entry_speed_sqr) {
+            v_sqr = max_allowable_speed_sqr(current, next->entry_speed_sqr);
+            new_entry_sqr = (current->max_entry_speed_sqr < v_sqr) ? current->max_entry_speed_sqr : v_sqr;
+        } else {
+            new_entry_sqr = current->max_entry_speed_sqr;
+        }
+        
+        if (new_entry_sqr == current->entry_speed_sqr && !full) {
+            break; // Unchanged
+        }
+        current->entry_speed_sqr = new_entry_sqr;
+        current->recalculate_flag = 1;
+        
+        next = current;
+    }
+}
+
+// Forward pass: walk from the planned pointer, capping entry speeds by what
+// the previous block can reach accelerating over its length. Only pairs
+// where either block was touched by the reverse pass are evaluated. Exit
+// speeds are then tied to the following block's entry and the flags cleared.
+//
+// The planned pointer moves up to the newest block whose entry no later
+// block can change: one capped by acceleration from a final block, or one
+// already at its maximum entry. Appending blocks only ever raises reverse
+// pass limits, so replanning never needs to look behind it again.
+static void planner_forward_pass(planner_queue_t *queue, uint8_t tail) {
+    uint8_t planned = queue->planned;
+    planner_block_t *prev = slot_at(queue, planned);
+    
+    for (uint8_t index = (uint8_t)(planned + 1u); index != tail; index++) {
+        planner_block_t *current = slot_at(queue, index);
+        if ((prev->recalculate_flag || current->recalculate_flag) &&
+            !prev->nominal_length_flag && prev->entry_speed_sqr < current->entry_speed_sqr) {
+            float v_sqr = max_allowable_speed_sqr(prev, prev->entry_speed_sqr);
+            if (v_sqr < current->entry_speed_sqr) {
+                current->entry_speed_sqr = v_sqr;
+                current->recalculate_flag = 1;
+                planned = index;
+            }
+        }
+        if (current->entry_speed_sqr == current->max_entry_speed_sqr) {
+            planned = index;
+        }
+        
+        if (prev->recalculate_flag || current->recalculate_flag) {
+            prev->exit_speed_sqr = current->entry_speed_sqr;
+        }
+        prev->recalculate_flag = 0;
+        
+        prev = current;
+    }
+    
+    // Newest block plans to stop
+    prev->exit_speed_sqr = PLANNER_MINIMUM_SPEED_SQR;
+    prev->recalculate_flag = 0;
+    queue->planned = planned;
+}
+
+// Nominal speed of a block under the current overrides
+static float override_nominal(const planner_queue_t *queue, float programmed_rate, uint8_t flags) {
+    float max_rate = queue->settings.max_rate;
+    if (flags & PLANNER_LINE_RAPID) {
+        return max_rate * (float)queue->rapid_override * 0.01f;
+    }
+    float v = programmed_rate * (float)queue->feed_override * 0.01f;
+    return (v > max_rate) ? max_rate : v;
+}
+
+// Producer side. The consumer may advance head or claim the front block at
+// any time, so both are sampled once up front. A claimed block carries the
+// profile the stepper is running: it is skipped entirely, and the block after
+// it keeps the claimed block's exit speed as its fixed entry. A planned
+// pointer the stepper has moved past restarts at the first plannable block.
+static void planner_replan(planner_queue_t *queue, uint8_t claimed, uint8_t head, uint8_t tail,
+                           bool full) {
+    uint8_t first = (uint8_t)(head + (claimed ? 1u : 0u));
+    if ((uint8_t)(tail - head) <= (uint8_t)(first - head)) {
+        return; // Nothing plannable
+    }
+    
+    if (full || (uint8_t)(queue->planned - first) >= (uint8_t)(tail - first)) {
+        queue->planned = first;
+    }
+    
+    if (claimed) {
+        planner_block_t *running = slot_at(queue, head);
+        planner_block_t *fixed = slot_at(queue, first);
+        if (fixed->entry_speed_sqr > running->exit_speed_sqr) {
+            fixed->entry_speed_sqr = running->exit_speed_sqr;
+            fixed->recalculate_flag = 1;
+            queue->planned = first;
+        }
+    }
+    
+    planner_reverse_pass(queue, queue->planned, tail, full);
+    planner_forward_pass(queue, tail);
+}
+
+void planner_recalculate(planner_queue_t *queue) {
+    if (queue == NULL) {
+        return;
+    }
+    
+    PROFILE_ZONE_BEGIN(PROFILE_ZONE_PLANNER);
+    uint8_t claimed = queue->current_in_use;
+    PLANNER_MEMORY_BARRIER();
+    planner_replan(queue, claimed, queue->head, queue->tail, false);
+    PROFILE_ZONE_END(PROFILE_ZONE_PLANNER);
+}
+
+// Rebuild nominal and max entry speeds of every queued block, then replan
+// from scratch. Entries restart from "stop at the end of this block" so the
+// full reverse pass can only raise them to what the new limits allow.
+int planner_set_overrides(planner_queue_t *queue, uint8_t feed_percent, uint8_t rapid_percent) {
+    if (queue == NULL) {
+        return 0;
+    }
+    
+    if (feed_percent < PLANNER_FEED_OVERRIDE_MIN) feed_percent = PLANNER_FEED_OVERRIDE_MIN;
+    if (feed_percent > PLANNER_FEED_OVERRIDE_MAX) feed_percent = PLANNER_FEED_OVERRIDE_MAX;
+    if (rapid_percent > PLANNER_RAPID_OVERRIDE_DEFAULT) rapid_percent = PLANNER_RAPID_OVERRIDE_DEFAULT;
+    if (rapid_percent < PLANNER_RAPID_OVERRIDE_LOW) rapid_percent = PLANNER_RAPID_OVERRIDE_LOW;
+    if (feed_percent == queue->feed_override && rapid_percent == queue->rapid_override) {
+        return 0;
+    }
+    queue->feed_override = feed_percent;
+    queue->rapid_override = rapid_percent;
+    
+    uint8_t claimed = queue->current_in_use;
+    PLANNER_MEMORY_BARRIER();
+    uint8_t head = queue->head;
+    uint8_t tail = queue->tail;
+    
+    uint8_t first = (uint8_t)(head + (claimed ? 1u : 0u));
+    planner_block_t *prev = NULL;
+    float prev_nominal_sqr = 0.0f;
+    for (uint8_t index = head; index != tail; index++) {
+        planner_block_t *block = slot_at(queue, index);
+        if (block->programmed_rate > 0.0f || (block->line_flags & PLANNER_LINE_RAPID)) {
+            block->nominal_speed = override_nominal(queue, block->programmed_rate, block->line_flags);
+        }
+        float nominal_sqr = block->nominal_speed * block->nominal_speed;
+        
+        if (!(claimed && index == head)) {
+            float max_entry_sqr = block->max_entry_speed_sqr;
+            if (prev != NULL) {
+                max_entry_sqr = block->max_junction_speed_sqr;
+                if (max_entry_sqr > prev_nominal_sqr) max_entry_sqr = prev_nominal_sqr;
+            }
+            if (max_entry_sqr > nominal_sqr) max_entry_sqr = nominal_sqr;
+            block->max_entry_speed_sqr = max_entry_sqr;
+            
+            float v_allowable_sqr = max_allowable_speed_sqr(block, PLANNER_MINIMUM_SPEED_SQR);
+            block->nominal_length_flag = (nominal_sqr <= v_allowable_sqr) ? 1 : 0;
+            if (index != first) {
+                block->entry_speed_sqr = (max_entry_sqr < v_allowable_sqr) ? max_entry_sqr : v_allowable_sqr;
+            } else if (block->entry_speed_sqr > max_entry_sqr) {
+                // The fixed entry can only drop; a running block ahead of
+                // it then decelerates to the new entry instead
+                block->entry_speed_sqr = max_entry_sqr;
+                if (prev != NULL && prev->exit_speed_sqr > max_entry_sqr) {
+                    prev->exit_speed_sqr = max_entry_sqr;
+                }
+            }
+            block->recalculate_flag = 1;
+        }
+        prev = block;
+        prev_nominal_sqr = nominal_sqr;
+    }
+    
+    planner_replan(queue, claimed, head, tail, true);
+    return 1;
+}
+
+int planner_plan_block(planner_queue_t *queue, planner_block_t *block,
+                       const kin_motion_hint_t *hint) {
+    if (queue == NULL || block == NULL || block->millimeters <= 0.0f) {
+        return 0;
+    }
+    
+    planner_block_t *slot = planner_get_next_free_block(queue);
+    if (slot == NULL) {
+        return 0; // Queue is full
+    }
+    if (slot != block) {
+        *slot = *block;
+        block = slot;
+    }
+    
+    // The only divisions a block ever needs are taken here, once
+    block->inv_millimeters = 1.0f / block->millimeters;
+    block->max_delta_speed_sqr = 2.0f * block->acceleration * block->millimeters;
+    
+    float junction_dev = (hint != NULL) ? hint->junction_dev_mm : 0.0f;
+    planner_block_t *prev = planner_peek_back(queue);
+    float nominal_sqr = block->nominal_speed * block->nominal_speed;
+    
+    // Entry is limited by the corner, and by both blocks' nominal speeds.
+    // Starting from an empty queue means starting from rest.
+    float max_entry_sqr = PLANNER_MINIMUM_SPEED_SQR;
+    block->max_junction_speed_sqr = PLANNER_MINIMUM_SPEED_SQR;
+    if (prev != NULL) {
+        max_entry_sqr = planner_junction_speed_sqr(prev, block, junction_dev);
+        block->max_junction_speed_sqr = max_entry_sqr;
+        float prev_nominal_sqr = prev->nominal_speed * prev->nominal_speed;
+        if (max_entry_sqr > prev_nominal_sqr) max_entry_sqr = prev_nominal_sqr;
+        if (max_entry_sqr > nominal_sqr) max_entry_sqr = nominal_sqr;
+    }
+    block->max_entry_speed_sqr = max_entry_sqr;
+    
+    // Can this block always reach its max entry from a stop at its end?
+    float v_allowable_sqr = max_allowable_speed_sqr(block, PLANNER_MINIMUM_SPEED_SQR);
+    block->entry_speed_sqr = (max_entry_sqr < v_allowable_sqr) ? max_entry_sqr : v_allowable_sqr;
+    block->exit_speed_sqr = PLANNER_MINIMUM_SPEED_SQR;
+    block->nominal_length_flag = (nominal_sqr <= v_allowable_sqr) ? 1 : 0;
+    block->recalculate_flag = 1;
+    
+    planner_commit_block(queue);
+    planner_recalculate(queue);
+    return 1;
+}
+
+// ----------------------------- Block building -----------------------------
+
+// Cartesian target -> absolute joint steps through the active kinematics
+static int target_to_steps(const kin_cart_t *target, int32_t *out_steps) {
+#if GRBL_KINEMATICS_COREXY_INLINE
+    kin_corexy_cart_to_steps(target, out_steps);
+    return 1;
+#else
+    if (g_kin.cart_to_joint == NULL || g_kin.joint_to_steps == NULL) {
+        return 0;
+    }
+    
+    kin_joint_t joint;
+    kin_steps_t steps;
+    if (!g_kin.cart_to_joint(target, &joint) || !g_kin.joint_to_steps(&joint, &steps)) {
+        return 0;
+    }
+    
+    for (uint8_t i = 0; i < KIN_MAX_JOINT_AXES; i++) {
+        out_steps[i] = steps.v[i];
+    }
+    return 1;
+#endif
+}
+
+planner_line_status_t planner_buffer_line(planner_queue_t *queue, const kin_cart_t *target,
+                                          float feed_mm_min, uint8_t flags) {
+    if (queue == NULL || target == NULL) {
+        return PLANNER_LINE_ERROR;
+    }
+    
+    // Build straight into the ring slot; it only becomes visible on commit
+    planner_block_t *block = planner_get_next_free_block(queue);
+    if (block == NULL) {
+        return PLANNER_LINE_FULL;
+    }
+    
+    int32_t target_steps[KIN_MAX_JOINT_AXES];
+    if (!target_to_steps(target, target_steps)) {
+        return PLANNER_LINE_ERROR;
+    }
+    
+    planner_block_init(block);
+    for (uint8_t i = 0; i < KIN_MAX_JOINT_AXES; i++) {
+        int32_t delta = target_steps[i] - queue->position_steps[i];
+        if (delta > 0) {
+            block->direction_bits |= (uint8_t)(1u << i);
+            block->steps[i] = (uint32_t)delta;
+        } else {
+            block->steps[i] = (uint32_t)(-delta);
+        }
+        if (block->steps[i] > block->step_event_count) {
+            block->step_event_count = block->steps[i];
+        }
+    }
+    
+    float length_sq = 0.0f;
+    for (uint8_t i = 0; i < KIN_MAX_CART_AXES; i++) {
+        float delta = target->v[i] - queue->position.v[i];
+        block->unit_vec[i] = delta;
+        length_sq += delta * delta;
+    }
+    if (block->step_event_count == 0 || length_sq <= 0.0f) {
+        return PLANNER_LINE_EMPTY; // Move rounds to nothing
+    }
+    
+    block->millimeters = sqrtf(length_sq);
+    float inv_mm = 1.0f / block->millimeters;
+    for (uint8_t i = 0; i < KIN_MAX_CART_AXES; i++) {
+        block->unit_vec[i] *= inv_mm;
+    }
+    
+    float nominal = override_nominal(queue, feed_mm_min, flags);
+    if (nominal <= 0.0f) {
+        return PLANNER_LINE_ERROR;
+    }
+    block->programmed_rate = (flags & PLANNER_LINE_RAPID) ? queue->settings.max_rate : feed_mm_min;
+    block->line_flags = flags;
+    if (flags & PLANNER_LINE_LASER) {
+        block->spindle_speed = queue->spindle_speed;
+    }
+    block->nominal_speed = nominal;
+    block->acceleration = queue->settings.acceleration;
+    
+    kin_motion_hint_t hint = {0};
+    hint.feed_mm_min = nominal;
+    hint.accel_mm_s2 = queue->settings.acceleration / 3600.0f;
+    hint.junction_dev_mm = queue->settings.junction_deviation;
+    if (!planner_plan_block(queue, block, &hint)) {
+        return PLANNER_LINE_ERROR;
+    }
+    
+    queue->position = *target;
+    for (uint8_t i = 0; i < KIN_MAX_JOINT_AXES; i++) {
+        queue->position_steps[i] = target_steps[i];
+    }
+    return PLANNER_LINE_OK;
+}
+
+// A zero-length block with zero nominal speed: its max entry is 0, so the
+// look-ahead plans the block before it to stop, and the block after it to
+// start from rest (its entry is capped by this block's nominal speed).
+planner_line_status_t planner_buffer_sync(planner_queue_t *queue, uint32_t dwell_ms, uint8_t flags) {
+    if (queue == NULL) {
+        return PLANNER_LINE_ERROR;
+    }
+    
+    planner_block_t *block = planner_get_next_free_block(queue);
+    if (block == NULL) {
+        return PLANNER_LINE_FULL;
+    }
+    
+    planner_block_init(block);
+    block->line_flags = (uint8_t)((flags & ~PLANNER_LINE_RAPID) | PLANNER_LINE_DWELL);
+    block->dwell_ms = dwell_ms;
+    if (flags & (PLANNER_LINE_SPINDLE_SYNC | PLANNER_LINE_LASER)) {
+        block->spindle_speed = queue->spindle_speed;
+    }
+    block->nominal_length_flag = 1;
+    block->recalculate_flag = 1;
+    
+    planner_commit_block(queue);
+    planner_recalculate(queue);
+    return PLANNER_LINE_OK;
+}
+
+int planner_sync_position(planner_queue_t *queue, const kin_cart_t *position) {
+    if (queue == NULL || position == NULL) {
+        return 0;
+    }
+    
+    int32_t steps[KIN_MAX_JOINT_AXES];
+    if (!target_to_steps(position, steps)) {
+        return 0;
+    }
+    
+    queue->position = *position;
+    for (uint8_t i = 0; i < KIN_MAX_JOINT_AXES; i++) {
+        queue->position_steps[i] = steps[i];
+    }
+    return 1;
 }
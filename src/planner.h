@@ -2,54 +2,236 @@
 #define PLANNER_H
 
 #include <stdint.h>
+#include "config.h"
+#include "kinematics.h"
 
 // Planner block structure
 // This structure contains all the information needed for motion planning
 typedef struct {
-    // Speed parameters
-    float entry_speed;        // Entry speed for this block (mm/min)
+    // Speed parameters. Look-ahead works on squared speeds so the passes are
+    // multiplies and compares only: v_entry^2 = v_exit^2 + 2*a*d.
+    float entry_speed_sqr;    // Entry speed for this block ((mm/min)^2)
     float nominal_speed;      // Maximum speed this block can achieve (mm/min)
-    float exit_speed;         // Exit speed for this block (mm/min)
+    float exit_speed_sqr;     // Exit speed for this block ((mm/min)^2)
     
     // Acceleration parameters
     float acceleration;       // Maximum acceleration for this block (mm/min^2)
-    float max_entry_speed;    // Maximum allowable entry speed (mm/min)
+    float max_entry_speed_sqr;    // Maximum allowable entry speed ((mm/min)^2)
+    float max_junction_speed_sqr; // Corner limit alone, before nominal speeds ((mm/min)^2)
+    
+    // Override source: nominal_speed is rebuilt from these when overrides
+    // change. programmed_rate 0 means the block is not overridable.
+    float programmed_rate;    // Feed as programmed, before overrides (mm/min)
+    uint8_t line_flags;       // PLANNER_LINE_* the block was built with
+    
+    // Laser mode: spindle output travels with the motion instead of being
+    // set (and synced) by the parser. Only read for PLANNER_LINE_LASER.
+    float spindle_speed;      // S for this block, spindle override applied
+    
+    // PLANNER_LINE_DWELL blocks: no motion, the stepper waits this long
+    uint32_t dwell_ms;
     
     // Distance and time
     float millimeters;        // Total distance to travel in this block (mm)
+    float inv_millimeters;    // 1 / millimeters, 0 for blocks without motion
+    float max_delta_speed_sqr; // 2 * acceleration * millimeters: most v^2 can change over the block
+    float unit_vec[KIN_MAX_CART_AXES]; // Cartesian direction of travel (unit length)
     
     // Direction and step counts
-    uint8_t direction_bits;   // Direction bits for each axis
-    uint32_t step_event_count; // Number of step events for this block
+    uint8_t direction_bits;   // Direction bits for each joint axis (bit set = positive)
+    uint32_t steps[KIN_MAX_JOINT_AXES]; // Absolute step count per joint axis
+    uint32_t step_event_count; // Number of step events for this block (max of steps[])
     
     // Status flags
     uint8_t recalculate_flag; // Flag to indicate block needs recalculation
     uint8_t nominal_length_flag; // Flag to indicate block is running at nominal speed
     
-    // Pointer to next block (for linked list)
-    void *next;               // Pointer to next planner block
-    
 } planner_block_t;
 
-// Queue structure for managing planner blocks
+// Ring capacity. Must be a power of two so indices wrap with a mask; set via
+// GRBL_PLANNER_BUFFER_SIZE (config.h).
+
+#if (PLANNER_BUFFER_SIZE < 2u) || (PLANNER_BUFFER_SIZE > 128u) || \
+    ((PLANNER_BUFFER_SIZE & (PLANNER_BUFFER_SIZE - 1u)) != 0u)
+#error "PLANNER_BUFFER_SIZE must be a power of two in 2..128"
+#endif
+
+#define PLANNER_BUFFER_MASK (PLANNER_BUFFER_SIZE - 1u)
+
+// Memory barrier for the producer/consumer handoff. Index updates are single
+// byte stores (atomic on Cortex-M without LDREX/STREX); the barrier keeps slot
+// contents ordered against them.
+#if defined(__arm__) && defined(__GNUC__)
+#define PLANNER_MEMORY_BARRIER() __asm__ volatile ("dmb" ::: "memory")
+#elif defined(__GNUC__)
+#define PLANNER_MEMORY_BARRIER() __sync_synchronize()
+#else
+#define PLANNER_MEMORY_BARRIER() ((void)0)
+#endif
+
+// Machine limits applied when building blocks from Cartesian targets
+#ifndef PLANNER_DEFAULT_ACCELERATION
+#define PLANNER_DEFAULT_ACCELERATION (10.0f * 3600.0f) // 10 mm/s^2, in mm/min^2
+#endif
+
+#ifndef PLANNER_DEFAULT_MAX_RATE
+#define PLANNER_DEFAULT_MAX_RATE 1000.0f               // mm/min, also the G0 rate
+#endif
+
+#ifndef PLANNER_DEFAULT_JUNCTION_DEVIATION
+#define PLANNER_DEFAULT_JUNCTION_DEVIATION 0.01f       // mm
+#endif
+
+typedef struct {
+    float acceleration;       // Path acceleration (mm/min^2)
+    float max_rate;           // Feed clamp and rapid rate (mm/min)
+    float junction_deviation; // Cornering tolerance (mm)
+} planner_settings_t;
+
+// planner_buffer_line() flags
+#define PLANNER_LINE_RAPID        0x01u  // G0: run at settings.max_rate, feed ignored
+#define PLANNER_LINE_LASER        0x02u  // Stepper drives spindle PWM from this block
+#define PLANNER_LINE_SPINDLE_CW   0x04u  // M3: constant power while the block runs
+#define PLANNER_LINE_SPINDLE_CCW  0x08u  // M4: power scaled by speed / nominal speed
+#define PLANNER_LINE_DWELL        0x10u  // Sync block: timed wait, no motion
+#define PLANNER_LINE_SPINDLE_SYNC 0x20u  // Sync block sets the spindle (CW/CCW bits, S) first
+
+// Realtime overrides, in percent of programmed feed / max_rate / S (grbl values)
+#define PLANNER_FEED_OVERRIDE_DEFAULT   100u
+#define PLANNER_FEED_OVERRIDE_MIN        10u
+#define PLANNER_FEED_OVERRIDE_MAX       200u
+#define PLANNER_RAPID_OVERRIDE_DEFAULT  100u
+#define PLANNER_RAPID_OVERRIDE_MEDIUM    50u
+#define PLANNER_RAPID_OVERRIDE_LOW       25u
+#define PLANNER_SPINDLE_OVERRIDE_DEFAULT 100u
+
+// planner_buffer_line() results
+typedef enum {
+    PLANNER_LINE_OK = 0,      // Block queued
+    PLANNER_LINE_EMPTY,       // Target equals planned position, nothing queued
+    PLANNER_LINE_FULL,        // Ring full: retry once the stepper frees a slot
+    PLANNER_LINE_ERROR        // Kinematics rejected the target or bad feed
+} planner_line_status_t;
+
+// Ring of planner blocks. The queue owns block storage; callers either fill
+// the slot from planner_get_next_free_block() and commit it, or copy a block
+// in with planner_enqueue(). head and tail are free-running; the slot of an
+// index is (index & PLANNER_BUFFER_MASK) and the fill level is tail - head.
+//
+// Single producer / single consumer, no interrupt masking: the planner (main
+// loop) is the only writer of tail, the stepper (which may run from an ISR)
+// the only writer of head and current_in_use. There is no shared counter.
 typedef struct {
-    planner_block_t *head;    // Pointer to the front of the queue
-    planner_block_t *tail;    // Pointer to the back of the queue
-    uint32_t size;            // Current number of blocks in the queue
-    uint32_t capacity;        // Maximum number of blocks allowed in the queue
+    planner_block_t blocks[PLANNER_BUFFER_SIZE];
+    volatile uint8_t head;           // Index of the oldest block (front of the queue)
+    volatile uint8_t tail;           // Index one past the newest block (next free slot)
+    volatile uint8_t current_in_use; // Front block is being executed by the stepper
+    volatile uint8_t spindle_override; // Percent of spindle_speed, applied by the stepper
+    
+    // Look-ahead: blocks from the first plannable one up to and including
+    // this index are optimally planned and no new block can change them, so
+    // replanning starts here. Producer-only.
+    uint8_t planned;
+    
+    // Producer-only state for planner_buffer_line()
+    planner_settings_t settings;
+    uint8_t feed_override;                       // Percent, applied to programmed_rate
+    uint8_t rapid_override;                      // Percent of max_rate for rapids
+    float spindle_speed;                         // Stamped into laser blocks as queued
+    kin_cart_t position;                         // End of the last queued block (mm)
+    int32_t position_steps[KIN_MAX_JOINT_AXES];  // Same, in absolute joint steps
 } planner_queue_t;
 
+// Look-ahead tuning
+#ifndef PLANNER_MINIMUM_JUNCTION_SPEED
+#define PLANNER_MINIMUM_JUNCTION_SPEED 0.0f  // Junction speed floor for sharp corners (mm/min)
+#endif
+
+#ifndef PLANNER_MINIMUM_SPEED
+#define PLANNER_MINIMUM_SPEED 0.0f           // Speed the planner assumes at a full stop (mm/min)
+#endif
+
+#define PLANNER_MINIMUM_JUNCTION_SPEED_SQR (PLANNER_MINIMUM_JUNCTION_SPEED * PLANNER_MINIMUM_JUNCTION_SPEED)
+#define PLANNER_MINIMUM_SPEED_SQR (PLANNER_MINIMUM_SPEED * PLANNER_MINIMUM_SPEED)
+
 // Function declarations - Block operations
 void planner_block_init(planner_block_t *block);
 int planner_block_validate(const planner_block_t *block);
 
 // Function declarations - Queue operations
-void planner_queue_init(planner_queue_t *queue, uint32_t capacity);
-int planner_enqueue(planner_queue_t *queue, planner_block_t *block);
+// Producer: enqueue, get_next_free_block, commit_block, plan_block, recalculate.
+// Consumer: dequeue, get_current_block, discard_current_block.
+// planner_queue_init() and planner_queue_clear() need the consumer stopped.
+void planner_queue_init(planner_queue_t *queue);
+int planner_enqueue(planner_queue_t *queue, const planner_block_t *block);
 planner_block_t* planner_dequeue(planner_queue_t *queue);
-planner_block_t* planner_peek_front(const planner_queue_t *queue);
-planner_block_t* planner_peek_back(const planner_queue_t *queue);
+planner_block_t* planner_peek_front(planner_queue_t *queue);
+planner_block_t* planner_peek_back(planner_queue_t *queue);
 int planner_is_empty(const planner_queue_t *queue);
+int planner_is_full(const planner_queue_t *queue);
+uint32_t planner_block_count(const planner_queue_t *queue);
 void planner_queue_clear(planner_queue_t *queue);
 
+// Zero-copy producer path: fill the returned slot in place, then commit it.
+// Returns NULL when the ring is full. The slot is not part of the queue (and
+// is not seen by the look-ahead passes) until committed.
+planner_block_t* planner_get_next_free_block(planner_queue_t *queue);
+int planner_commit_block(planner_queue_t *queue);
+
+// Consumer-side execution: planner_get_current_block() returns the front block
+// and marks it in use, so replanning leaves it (and the entry speed of the
+// block after it) alone. planner_discard_current_block() releases it. The
+// slot is not reused until discarded.
+planner_block_t* planner_get_current_block(planner_queue_t *queue);
+void planner_discard_current_block(planner_queue_t *queue);
+
+// O(1) neighbour lookup within the queue; NULL past either end
+planner_block_t* planner_next_block(planner_queue_t *queue, const planner_block_t *block);
+planner_block_t* planner_prev_block(planner_queue_t *queue, const planner_block_t *block);
+
+// Function declarations - Look-ahead planning
+// Enqueue a block and replan the queue. The caller fills millimeters,
+// unit_vec, nominal_speed and acceleration; entry/exit speeds and the
+// precomputed inverse quantities are filled in here. block is normally
+// the slot from planner_get_next_free_block(); any other block is copied
+// into that slot. hint->junction_dev_mm limits cornering speed (grbl
+// junction deviation).
+// Returns 1 on success, 0 on failure (queue full, NULL or zero-length block).
+int planner_plan_block(planner_queue_t *queue, planner_block_t *block,
+                       const kin_motion_hint_t *hint);
+
+// Build a block in the next ring slot for a straight move from the planned
+// position to target (machine mm) and queue it. Per-joint steps come from
+// g_kin.cart_to_joint() and g_kin.joint_to_steps(); nominal speed is feed
+// (mm/min) clamped to settings.max_rate, or max_rate for PLANNER_LINE_RAPID.
+// PLANNER_LINE_LASER blocks take their spindle_speed from queue->spindle_speed.
+planner_line_status_t planner_buffer_line(planner_queue_t *queue, const kin_cart_t *target,
+                                          float feed_mm_min, uint8_t flags);
+
+// Queue a sync block: motion before it comes to a stop, then the stepper
+// waits dwell_ms (G4, spindle spin-up) without blocking the main loop. With
+// PLANNER_LINE_SPINDLE_SYNC in flags the stepper first sets the spindle from
+// the CW/CCW bits and queue->spindle_speed (neither bit = off). Blocks carry
+// the programmed speed; the stepper scales it by queue->spindle_override and
+// re-sets a running spindle whenever that changes.
+// Returns PLANNER_LINE_OK, PLANNER_LINE_FULL or PLANNER_LINE_ERROR.
+planner_line_status_t planner_buffer_sync(planner_queue_t *queue, uint32_t dwell_ms, uint8_t flags);
+
+// Set the planned position without motion (after homing, reset, G92...)
+int planner_sync_position(planner_queue_t *queue, const kin_cart_t *position);
+
+// Compute the maximum junction entry speed between two consecutive blocks ((mm/min)^2)
+float planner_junction_speed_sqr(const planner_block_t *prev, const planner_block_t *block,
+                                 float junction_dev_mm);
+
+// Re-run the reverse and forward passes over the blocks after queue->planned
+void planner_recalculate(planner_queue_t *queue);
+
+// Change the feed and rapid overrides (percent, clamped to the limits above).
+// Every queued block's nominal speed is rebuilt from its programmed rate and
+// the whole queue is replanned; nothing is flushed. The block the stepper is
+// running keeps its exit speed, and the stepper picks up its new nominal
+// speed at the next segment. Returns 1 if anything changed.
+int planner_set_overrides(planner_queue_t *queue, uint8_t feed_percent, uint8_t rapid_percent);
+
 #endif // PLANNER_H
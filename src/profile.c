@@ -0,0 +1,144 @@
+/* profile.c - Hot-path cycle profiling implementation */
+
+#include "profile.h"
+
+#if GRBL_FEATURE_PROFILE
+
+#include <string.h>
+
+profile_t g_profile;
+
+static const char *const zone_names[PROFILE_ZONE_COUNT] = {
+    "PARSE", "ARC", "PLAN", "STUPD", "STISR"
+};
+
+/* ----------------------------- Recording ----------------------------- */
+
+void profile_reset(void) {
+    uint32_t cpt = g_profile.cycles_per_tick;
+    memset(&g_profile, 0, sizeof(g_profile));
+    g_profile.cycles_per_tick = cpt;
+}
+
+void profile_record(profile_zone_t zone, uint32_t cycles) {
+    profile_zone_stats_t *z = &g_profile.zones[zone];
+    if (z->count == 0u || cycles < z->min) z->min = cycles;
+    if (cycles > z->max) z->max = cycles;
+    z->total += cycles;
+    z->count++;
+}
+
+uint32_t profile_zone_avg(profile_zone_t zone) {
+    const profile_zone_stats_t *z = &g_profile.zones[zone];
+    return z->count ? (uint32_t)(z->total / z->count) : 0u;
+}
+
+void profile_step_isr(uint32_t period_ticks) {
+    uint32_t now = hal_cycles();
+    if (g_profile.isr_valid) {
+        uint32_t dt = now - g_profile.isr_last;
+        uint32_t j = (dt > g_profile.isr_expected) ? dt - g_profile.isr_expected
+                                                   : g_profile.isr_expected - dt;
+        uint32_t b = 0;
+        while (b < PROFILE_JITTER_BUCKETS - 1u && j >= (PROFILE_JITTER_BUCKET0_CYCLES << b)) {
+            b++;
+        }
+        g_profile.jitter_hist[b]++;
+        if (j > g_profile.jitter_max) g_profile.jitter_max = j;
+    }
+    g_profile.isr_last = now;
+    g_profile.isr_expected = period_ticks * g_profile.cycles_per_tick;
+    g_profile.isr_valid = true;
+}
+
+void profile_step_isr_restart(void) {
+    if (g_profile.cycles_per_tick == 0u) {
+        uint32_t timer_hz = hal_step_timer_freq_hz();
+        uint32_t cpt = timer_hz ? hal_cycles_freq_hz() / timer_hz : 0u;
+        g_profile.cycles_per_tick = cpt ? cpt : 1u;
+    }
+    g_profile.isr_valid = false;
+}
+
+/* ----------------------------- Report ----------------------------- */
+
+typedef struct {
+    char *buf;
+    size_t cap;
+    size_t len;
+    bool ok;
+} prf_writer_t;
+
+static void put_str(prf_writer_t *w, const char *s) {
+    size_t n = strlen(s);
+    if (!w->ok || w->len + n >= w->cap) {
+        w->ok = false;
+        return;
+    }
+    memcpy(w->buf + w->len, s, n);
+    w->len += n;
+}
+
+static void put_u32(prf_writer_t *w, uint32_t v) {
+    char tmp[11];
+    size_t n = sizeof(tmp) - 1u;
+    tmp[n] = '\0';
+    do {
+        tmp[--n] = (char)('0' + v % 10u);
+        v /= 10u;
+    } while (v);
+    put_str(w, &tmp[n]);
+}
+
+size_t profile_format_report(char *buf, size_t cap) {
+    if (!buf || cap == 0u) return 0;
+    prf_writer_t w = { buf, cap, 0, true };
+
+    put_str(&w, "[PRF:HZ,");
+    put_u32(&w, hal_cycles_freq_hz());
+    put_str(&w, "]\r\n");
+
+    for (unsigned i = 0; i < PROFILE_ZONE_COUNT; i++) {
+        const profile_zone_stats_t *z = &g_profile.zones[i];
+        put_str(&w, "[PRF:");
+        put_str(&w, zone_names[i]);
+        put_str(&w, ",");
+        put_u32(&w, z->count);
+        put_str(&w, ",");
+        put_u32(&w, z->min);
+        put_str(&w, ",");
+        put_u32(&w, profile_zone_avg((profile_zone_t)i));
+        put_str(&w, ",");
+        put_u32(&w, z->max);
+        put_str(&w, "]\r\n");
+    }
+
+    put_str(&w, "[PRF:JIT");
+    for (unsigned b = 0; b < PROFILE_JITTER_BUCKETS; b++) {
+        put_str(&w, ",");
+        put_u32(&w, g_profile.jitter_hist[b]);
+    }
+    put_str(&w, ",");
+    put_u32(&w, g_profile.jitter_max);
+    put_str(&w, "]\r\n");
+
+    put_str(&w, "[PRF:HWM,");
+    put_u32(&w, g_profile.hwm[PROFILE_HWM_PLANNER]);
+    put_str(&w, ",");
+    put_u32(&w, g_profile.hwm[PROFILE_HWM_RX]);
+    put_str(&w, "]\r\n");
+
+    if (!w.ok) {
+        buf[0] = '\0';
+        return 0;
+    }
+    buf[w.len] = '\0';
+    return w.len;
+}
+
+#else
+
+/* ISO C needs at least one declaration per translation unit */
+typedef int profile_disabled_t;
+
+#endif /* GRBL_FEATURE_PROFILE */
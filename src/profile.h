@@ -0,0 +1,131 @@
+/* profile.h - Hot-path cycle profiling (GRBL_FEATURE_PROFILE)
+ *
+ * Purpose:
+ *  - Measure how many CPU cycles the hot paths take on the real target
+ *    (gcode_parse_line, arc_generate_ij, planner_recalculate,
+ *    stepper_update, the step ISR) as count / min / avg / max per zone
+ *  - Histogram step ISR jitter: how far each step event lands from the
+ *    timer period programmed for it
+ *  - Track planner ring and RX ring high-water marks
+ *
+ * Cycles come from hal_cycles() (DWT CYCCNT on Cortex-M). With the feature
+ * off the macros below expand to nothing and no code or RAM is spent.
+ * Results are read with "$P" ("$P=0" clears them) and, when selected in
+ * $10, as a Pf: status report field.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "grbl.h"
+#include "hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Instrumented zones */
+typedef enum {
+    PROFILE_ZONE_GCODE_PARSE = 0, /* gcode_parse_line() */
+    PROFILE_ZONE_ARC,             /* arc_generate_ij() */
+    PROFILE_ZONE_PLANNER,         /* planner_recalculate() */
+    PROFILE_ZONE_STEPPER_UPDATE,  /* stepper_update() */
+    PROFILE_ZONE_STEP_ISR,        /* stepper_step_isr() */
+    PROFILE_ZONE_COUNT
+} profile_zone_t;
+
+/* Buffers with a high-water mark */
+typedef enum {
+    PROFILE_HWM_PLANNER = 0,      /* Planner blocks queued */
+    PROFILE_HWM_RX,               /* RX ring bytes in use */
+    PROFILE_HWM_COUNT
+} profile_hwm_t;
+
+/* Jitter histogram: bucket n counts |jitter| < BUCKET0 << n cycles, the
+ * last bucket everything above.
+ */
+#ifndef PROFILE_JITTER_BUCKETS
+#define PROFILE_JITTER_BUCKETS 8u
+#endif
+
+#ifndef PROFILE_JITTER_BUCKET0_CYCLES
+#define PROFILE_JITTER_BUCKET0_CYCLES 16u
+#endif
+
+/* Longest "$P" report */
+#define PROFILE_REPORT_MAX 384u
+
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+} profile_zone_stats_t;
+
+typedef struct {
+    profile_zone_stats_t zones[PROFILE_ZONE_COUNT];
+    uint32_t jitter_hist[PROFILE_JITTER_BUCKETS];
+    uint32_t jitter_max;          /* Worst |jitter| seen (cycles) */
+    uint16_t hwm[PROFILE_HWM_COUNT];
+
+    /* Step ISR period tracking */
+    uint32_t isr_last;            /* hal_cycles() at the previous step event */
+    uint32_t isr_expected;        /* Cycles the timer was set to for this interval */
+    bool isr_valid;               /* isr_last belongs to the running timer */
+    uint32_t cycles_per_tick;     /* CPU cycles per step timer tick */
+} profile_t;
+
+#if GRBL_FEATURE_PROFILE
+
+extern profile_t g_profile;
+
+/* Clear all statistics */
+void profile_reset(void);
+
+/* Add one measurement to a zone */
+void profile_record(profile_zone_t zone, uint32_t cycles);
+
+/* Average cycles of a zone (0 if never entered) */
+uint32_t profile_zone_avg(profile_zone_t zone);
+
+/* Step ISR entry: period_ticks is the timer period for the interval that
+ * starts now. Bins the previous interval's deviation from its period.
+ */
+void profile_step_isr(uint32_t period_ticks);
+
+/* The step timer was (re)armed: the next interval has no reference */
+void profile_step_isr_restart(void);
+
+static inline void profile_hwm(profile_hwm_t which, uint32_t level) {
+    if (level > g_profile.hwm[which]) {
+        g_profile.hwm[which] = (uint16_t)(level > UINT16_MAX ? UINT16_MAX : level);
+    }
+}
+
+/* Format the "$P" report, one "[PRF:...]" line per item, CRLF-terminated.
+ * Returns the length written, or 0 if it does not fit.
+ */
+size_t profile_format_report(char *buf, size_t cap);
+
+#define PROFILE_ZONE_BEGIN(z)        const uint32_t profile_t0_##z = hal_cycles()
+#define PROFILE_ZONE_END(z)          profile_record((z), hal_cycles() - profile_t0_##z)
+#define PROFILE_STEP_ISR(period)     profile_step_isr(period)
+#define PROFILE_STEP_ISR_RESTART()   profile_step_isr_restart()
+#define PROFILE_HWM(which, level)    profile_hwm((which), (level))
+
+#else
+
+#define PROFILE_ZONE_BEGIN(z)        ((void)0)
+#define PROFILE_ZONE_END(z)          ((void)0)
+#define PROFILE_STEP_ISR(period)     ((void)0)
+#define PROFILE_STEP_ISR_RESTART()   ((void)0)
+#define PROFILE_HWM(which, level)    ((void)0)
+
+#endif /* GRBL_FEATURE_PROFILE */
+
+#ifdef __cplusplus
+}
+#endif
@@ -4,31 +4,9 @@
 #include "kinematics.h"
 #include "hal.h"
 #include "grbl.h"
+#include "profile.h"
 #include <string.h>
 
-/* ---- internal types ---- */
-
-struct protocol {
-    proto_config_t cfg;
-
-    proto_line_cb_t on_line;
-    proto_rt_cb_t   on_rt;
-    void           *user;
-
-    /* Current assembling line */
-    char     cur[PROTOCOL_LINE_MAX + 1];
-    uint16_t cur_len;
-    bool     cur_overflow;
-    bool     in_paren_comment;
-
-    /* Completed line queue */
-    char     q[PROTOCOL_LINE_QUEUE_DEPTH][PROTOCOL_LINE_MAX + 1];
-    proto_line_status_t qst[PROTOCOL_LINE_QUEUE_DEPTH];
-    uint8_t  q_head;
-    uint8_t  q_tail;
-    uint8_t  q_count;
-};
-
 /* ---- helpers ---- */
 
 static bool is_printable_ascii(uint8_t c) {
@@ -40,46 +18,89 @@ static char to_upper(char c) {
     return c;
 }
 
-static void queue_push(protocol_t *p, const char *line, proto_line_status_t st) {
-    if (p->q_count >= PROTOCOL_LINE_QUEUE_DEPTH) {
-        /* Drop oldest (or newest). Here: drop newest by ignoring push. */
-        return;
-    }
-    strncpy(p->q[p->q_tail], line, PROTOCOL_LINE_MAX);
-    p->q[p->q_tail][PROTOCOL_LINE_MAX] = '\0';
-    p->qst[p->q_tail] = st;
+/* Line arena: each entry is [len][status][len bytes], wrapping at the
+ * end of p->q. Short lines take only what they need.
+ */
+#define ARENA_HDR 2u
+
+static uint16_t arena_free(const protocol_t *p) {
+    return (uint16_t)(PROTOCOL_LINE_ARENA_SIZE - p->q_used);
+}
 
-    p->q_tail = (uint8_t)((p->q_tail + 1u) % PROTOCOL_LINE_QUEUE_DEPTH);
+static bool queue_full(const protocol_t *p) {
+    /* Room for the line being assembled (trim can only shrink it) */
+    return p->on_line == NULL &&
+           arena_free(p) < (uint16_t)(p->cur_len + ARENA_HDR);
+}
+
+static void arena_put(protocol_t *p, uint8_t b) {
+    p->q[p->q_tail] = b;
+    if (++p->q_tail == PROTOCOL_LINE_ARENA_SIZE) p->q_tail = 0;
+}
+
+static uint8_t arena_get(protocol_t *p) {
+    uint8_t b = p->q[p->q_head];
+    if (++p->q_head == PROTOCOL_LINE_ARENA_SIZE) p->q_head = 0;
+    return b;
+}
+
+static void queue_push(protocol_t *p, const char *line, uint16_t len, proto_line_status_t st) {
+    /* Callers check queue_full() before terminating a line, so a full
+     * arena here means a caller bug; never overwrite a queued line.
+     */
+    if (arena_free(p) < (uint16_t)(len + ARENA_HDR)) return;
+
+    arena_put(p, (uint8_t)len);
+    arena_put(p, (uint8_t)st);
+    for (uint16_t k = 0; k < len; k++) arena_put(p, (uint8_t)line[k]);
+
+    p->q_used = (uint16_t)(p->q_used + len + ARENA_HDR);
     p->q_count++;
 }
 
 static bool queue_pop(protocol_t *p, char *out, size_t out_cap, proto_line_status_t *st) {
     if (p->q_count == 0u) return false;
 
-    if (out && out_cap) {
-        strncpy(out, p->q[p->q_head], out_cap - 1u);
-        out[out_cap - 1u] = '\0';
+    uint16_t len = arena_get(p);
+    proto_line_status_t line_st = (proto_line_status_t)arena_get(p);
+    size_t n = 0;
+    for (uint16_t k = 0; k < len; k++) {
+        uint8_t b = arena_get(p);
+        if (out && n + 1u < out_cap) out[n++] = (char)b;
     }
-    if (st) *st = p->qst[p->q_head];
+    if (out && out_cap) out[n] = '\0';
+    if (st) *st = line_st;
 
-    p->q_head = (uint8_t)((p->q_head + 1u) % PROTOCOL_LINE_QUEUE_DEPTH);
+    p->q_used = (uint16_t)(p->q_used - len - ARENA_HDR);
     p->q_count--;
     return true;
 }
 
-/* Trim leading/trailing whitespace in-place. Returns new length. */
-static size_t trim_ws(char *s) {
-    size_t n = strlen(s);
-    size_t start = 0;
-    while (start < n && (s[start] == ' ' || s[start] == '\t')) start++;
-    if (start > 0) memmove(s, s + start, n - start + 1);
+/* Trim leading/trailing whitespace by moving offsets, not bytes.
+ * Returns the first kept character; *len is updated.
+ */
+static char *trim_ws(char *s, uint16_t *len) {
+    uint16_t start = 0;
+    uint16_t end = *len;
+    while (start < end && (s[start] == ' ' || s[start] == '\t')) start++;
+    while (end > start && (s[end - 1] == ' ' || s[end - 1] == '\t')) end--;
+    s[end] = '\0';
+    *len = (uint16_t)(end - start);
+    return s + start;
+}
 
-    n = strlen(s);
-    while (n > 0 && (s[n - 1] == ' ' || s[n - 1] == '\t')) {
-        s[n - 1] = '\0';
-        n--;
+/* "$BIN=0" / "$BIN=1" switch frame acceptance here, at the line they
+ * end, so the bytes that follow are read in the new mode. The line is
+ * still delivered so the executor acknowledges it.
+ */
+static void check_mode_command(protocol_t *p, const char *line, uint16_t len) {
+    static const char cmd[] = "$BIN=";
+    if (!p->cfg.allow_dollar_commands || len != sizeof(cmd)) return;
+    for (uint16_t k = 0; k + 1u < sizeof(cmd); k++) {
+        if (line[k] != cmd[k]) return;
     }
-    return n;
+    if (line[len - 1] == '0') p->binary_mode = false;
+    if (line[len - 1] == '1') p->binary_mode = true;
 }
 
 static void emit_line(protocol_t *p) {
@@ -87,20 +108,25 @@ static void emit_line(protocol_t *p) {
     p->cur[p->cur_len] = '\0';
 
     proto_line_status_t st = PROTO_LINE_OK;
+    char *line = p->cur;
+    uint16_t len = p->cur_len;
 
     if (p->cur_overflow) {
         st = PROTO_LINE_OVERFLOW;
+    } else if (p->in_binary_frame) {
+        st = PROTO_LINE_BINARY;  /* raw bytes, no trimming */
     } else {
         /* Trim */
-        trim_ws(p->cur);
+        line = trim_ws(p->cur, &len);
 
         /* Empty after trim? */
-        if (p->cur[0] == '\0') {
+        if (len == 0) {
             st = PROTO_LINE_EMPTY;
-        } else if (!p->cfg.allow_dollar_commands && p->cur[0] == '$') {
+        } else if (!p->cfg.allow_dollar_commands && line[0] == '$') {
             /* Treat as "empty/ignored" at protocol layer */
             st = PROTO_LINE_EMPTY;
-            p->cur[0] = '\0';
+        } else {
+            check_mode_command(p, line, len);
         }
     }
 
@@ -108,6 +134,8 @@ static void emit_line(protocol_t *p) {
     p->cur_len = 0;
     p->cur_overflow = false;
     p->in_paren_comment = false;
+    p->in_semicolon_comment = false;
+    p->in_binary_frame = false;
 
     if (st == PROTO_LINE_EMPTY) {
         return; /* don't enqueue empty/ignored lines */
@@ -115,9 +143,9 @@ static void emit_line(protocol_t *p) {
 
     /* Deliver line: either immediate callback or queue */
     if (p->on_line) {
-        p->on_line(p->cur, st, p->user);
+        p->on_line(line, st, p->user);
     } else {
-        queue_push(p, p->cur, st);
+        queue_push(p, line, len, st);
     }
 }
 
@@ -148,95 +176,424 @@ void protocol_reset(protocol_t *p) {
     p->cur_len = 0;
     p->cur_overflow = false;
     p->in_paren_comment = false;
+    p->in_semicolon_comment = false;
+    p->in_binary_frame = false;
+    p->binary_mode = false;
+
+    p->q_head = p->q_tail = 0;
+    p->q_used = p->q_count = 0;
+
+    p->rx_head = p->rx_tail;
+    p->view_valid = false;
+    p->rx_dropping = false;
+}
+
+/* Realtime bytes act immediately and never enter a line or the RX ring.
+ * Returns true if c was one. Ctrl-X is reported here; the caller resets
+ * (the ISR producers must leave consumer state alone).
+ */
+static bool handle_realtime(protocol_t *p, uint8_t c) {
+    switch (c) {
+        case 0x18u: emit_rt(p, PROTO_RT_RESET);                    return true;
+        case (uint8_t)'?': emit_rt(p, PROTO_RT_STATUS_QUERY); return true;
+        case (uint8_t)'!': emit_rt(p, PROTO_RT_FEED_HOLD);    return true;
+        case (uint8_t)'~': emit_rt(p, PROTO_RT_CYCLE_START);  return true;
+        case 0x90u: emit_rt(p, PROTO_RT_FEED_OVR_RESET);           return true;
+        case 0x91u: emit_rt(p, PROTO_RT_FEED_OVR_COARSE_PLUS);     return true;
+        case 0x92u: emit_rt(p, PROTO_RT_FEED_OVR_COARSE_MINUS);    return true;
+        case 0x93u: emit_rt(p, PROTO_RT_FEED_OVR_FINE_PLUS);       return true;
+        case 0x94u: emit_rt(p, PROTO_RT_FEED_OVR_FINE_MINUS);      return true;
+        case 0x95u: emit_rt(p, PROTO_RT_RAPID_OVR_RESET);          return true;
+        case 0x96u: emit_rt(p, PROTO_RT_RAPID_OVR_MEDIUM);         return true;
+        case 0x97u: emit_rt(p, PROTO_RT_RAPID_OVR_LOW);            return true;
+        case 0x99u: emit_rt(p, PROTO_RT_SPINDLE_OVR_RESET);        return true;
+        case 0x9Au: emit_rt(p, PROTO_RT_SPINDLE_OVR_COARSE_PLUS);  return true;
+        case 0x9Bu: emit_rt(p, PROTO_RT_SPINDLE_OVR_COARSE_MINUS); return true;
+        case 0x9Cu: emit_rt(p, PROTO_RT_SPINDLE_OVR_FINE_PLUS);    return true;
+        case 0x9Du: emit_rt(p, PROTO_RT_SPINDLE_OVR_FINE_MINUS);   return true;
+        default:           return false;
+    }
+}
 
-    p->q_head = p->q_tail = p->q_count = 0;
-    memset(p->q, 0, sizeof(p->q));
+/* Producer side of Ctrl-X: publish the ring up to the reset point and flag
+ * it. Bytes before rx_reset_at are dropped when the consumer applies it.
+ */
+static void request_reset(protocol_t *p, uint16_t at) {
+    p->rx_tail = at;
+    p->rx_reset_at = at;
+    p->rx_reset = true;
 }
 
-void protocol_feed_bytes(protocol_t *p, const uint8_t *data, size_t len) {
-    if (!p || !data) return;
+/* Consumer side: apply a Ctrl-X flagged by the producer. Clearing the flag
+ * before reading the mark means a newer Ctrl-X is never lost.
+ */
+static void take_reset(protocol_t *p) {
+    if (!p->rx_reset) return;
+    p->rx_reset = false;
+    const uint16_t at = p->rx_reset_at;
+    protocol_reset(p);
+    p->rx_head = at;
+}
+
+/* Line assembly for one non-realtime byte. Returns false (byte not
+ * consumed) when c would complete a line but the line queue is full.
+ */
+static bool line_byte(protocol_t *p, uint8_t c) {
+    /* ---- line termination ---- */
+    if (c == '\n') {
+        if (queue_full(p)) return false;  /* stall instead of dropping */
+        emit_line(p);
+        return true;
+    }
+
+    /* ---- binary frame: stored raw (stuffing keeps LF/CR/NUL out) ---- */
+    if (p->binary_mode && c == PROTO_BIN_SOF && p->cur_len == 0 && !p->cur_overflow &&
+        !p->in_paren_comment && !p->in_semicolon_comment) {
+        p->in_binary_frame = true;
+    }
+    if (p->in_binary_frame) {
+        if (p->cur_len < PROTOCOL_LINE_MAX) {
+            p->cur[p->cur_len++] = (char)c;
+        } else {
+            p->cur_overflow = true;
+        }
+        return true;
+    }
+
+    if (c == '\r') {
+        /* ignore CR, treat LF as terminator */
+        return true;
+    }
+
+    /* ---- ignore non-printable (except tab/space) ---- */
+    if (!(is_printable_ascii(c) || c == '\t')) {
+        return true;
+    }
+
+    char ch = (char)c;
+
+    /* ---- comment stripping ---- */
+    if (p->in_semicolon_comment) {
+        return true; /* ignore rest of line until newline */
+    }
+    if (p->cfg.strip_paren_comments) {
+        if (p->in_paren_comment) {
+            if (ch == ')') p->in_paren_comment = false;
+            return true;
+        } else if (ch == '(') {
+            p->in_paren_comment = true;
+            return true;
+        }
+    }
+    if (p->cfg.strip_semicolon_comments && ch == ';') {
+        p->in_semicolon_comment = true;
+        return true;
+    }
+
+    if (p->cfg.to_uppercase) ch = to_upper(ch);
+
+    /* ---- append to current line ---- */
+    if (p->cur_len < PROTOCOL_LINE_MAX) {
+        p->cur[p->cur_len++] = ch;
+    } else {
+        p->cur_overflow = true; /* keep consuming until newline, then report overflow */
+    }
+    return true;
+}
+
+size_t protocol_feed_bytes(protocol_t *p, const uint8_t *data, size_t len) {
+    if (!p || !data) return 0;
 
     for (size_t i = 0; i < len; i++) {
         uint8_t c = data[i];
-
-        /* ---- realtime commands (handled immediately) ---- */
-        if (c == 0x18u) { /* Ctrl-X soft reset */
-            emit_rt(p, PROTO_RT_RESET);
-            protocol_reset(p);
+        if (handle_realtime(p, c)) {
+            if (c == 0x18u) protocol_reset(p);
             continue;
         }
-        if (c == (uint8_t)'?') { emit_rt(p, PROTO_RT_STATUS_QUERY); continue; }
-        if (c == (uint8_t)'!') { emit_rt(p, PROTO_RT_FEED_HOLD);    continue; }
-        if (c == (uint8_t)'~') { emit_rt(p, PROTO_RT_CYCLE_START);  continue; }
+        if (!line_byte(p, c)) return i;
+    }
+    return len;
+}
+
+size_t protocol_rx_write(protocol_t *p, const uint8_t *data, size_t len) {
+    if (!p || !data) return 0;
 
-        /* ---- line termination ---- */
-        if (c == '\n') {
-            emit_line(p);
+    uint16_t tail = p->rx_tail;
+    for (size_t i = 0; i < len; i++) {
+        uint8_t c = data[i];
+        if (handle_realtime(p, c)) {
+            if (c == 0x18u) request_reset(p, tail);
             continue;
         }
-        if (c == '\r') {
-            /* ignore CR, treat LF as terminator */
-            continue;
+        if ((uint16_t)(tail - p->rx_head) >= PROTOCOL_RX_BUFFER_SIZE) {
+            p->rx_tail = tail;
+            return i;           /* ring full: leave the rest with the caller */
         }
+        p->rx[tail & PROTOCOL_RX_BUFFER_MASK] = c;
+        tail++;
+    }
+    p->rx_tail = tail;
+    PROFILE_HWM(PROFILE_HWM_RX, (uint16_t)(tail - p->rx_head));
+    return len;
+}
 
-        /* ---- ignore non-printable (except tab/space) ---- */
-        if (!(is_printable_ascii(c) || c == '\t')) {
-            /* Mark bad char but keep consuming until newline. */
-            if (!p->cur_overflow && p->cur_len < PROTOCOL_LINE_MAX) {
-                /* We can choose to record an error state by forcing overflow-like behavior. */
-            }
-            continue;
+size_t protocol_rx_free(const protocol_t *p) {
+    if (!p) return 0;
+    return PROTOCOL_RX_BUFFER_SIZE - (uint16_t)(p->rx_tail - p->rx_head);
+}
+
+size_t protocol_service(protocol_t *p) {
+    if (!p) return 0;
+    take_reset(p);
+
+    size_t n = 0;
+    uint16_t head = p->rx_head;
+    const uint16_t tail = p->rx_tail;
+    while (head != tail) {
+        if (!line_byte(p, p->rx[head & PROTOCOL_RX_BUFFER_MASK])) break;
+        head++;
+        n++;
+    }
+    p->rx_head = head;
+    return n;
+}
+
+bool protocol_pop_line(protocol_t *p, char *out, size_t out_cap, proto_line_status_t *st) {
+    if (!p) return false;
+    take_reset(p);
+    return queue_pop(p, out, out_cap, st);
+}
+
+bool protocol_has_line(const protocol_t *p) {
+    if (!p) return false;
+    return !p->rx_reset && (p->q_count != 0u);
+}
+/* ---- circular DMA + line views ---- */
+
+uint8_t *protocol_rx_dma_buffer(protocol_t *p) {
+    return p ? p->rx : NULL;
+}
+
+void protocol_rx_dma_isr(size_t dma_pos, void *user) {
+    protocol_t *p = (protocol_t *)user;
+    if (!p) return;
+
+    uint16_t tail = p->rx_tail;
+    uint16_t fresh = (uint16_t)((dma_pos - tail) & PROTOCOL_RX_BUFFER_MASK);
+    if (fresh > protocol_rx_free(p)) {
+        p->rx_overruns++;  /* sender ignored flow control; data already lost */
+    }
+
+    /* Realtime bytes are handled here and blanked (non-printable bytes are
+     * skipped by the line scanner). Ctrl-X discards everything before it.
+     */
+    for (uint16_t k = 0; k < fresh; k++) {
+        uint8_t *c = &p->rx[(uint16_t)(tail + k) & PROTOCOL_RX_BUFFER_MASK];
+        if (handle_realtime(p, *c)) {
+            if (*c == 0x18u) request_reset(p, (uint16_t)(tail + k + 1u));
+            *c = 0u;
         }
+    }
+    p->rx_tail = (uint16_t)(tail + fresh);
+    PROFILE_HWM(PROFILE_HWM_RX, (uint16_t)(p->rx_tail - p->rx_head));
+}
 
-        char ch = (char)c;
+/* Normalize the line at ring offset [head, head + n) (LF excluded) into
+ * dst, which may alias the ring bytes being read (dst never overtakes
+ * the read position). Returns the normalized length, or a value above
+ * PROTOCOL_LINE_MAX on overflow.
+ */
+static uint16_t normalize_span(protocol_t *p, uint16_t head, uint16_t n,
+                               char *dst, uint16_t dst_cap) {
+    bool in_paren = false;
+    uint16_t len = 0;
+
+    for (uint16_t k = 0; k < n; k++) {
+        char ch = (char)p->rx[(uint16_t)(head + k) & PROTOCOL_RX_BUFFER_MASK];
+        if (!(is_printable_ascii((uint8_t)ch) || ch == '\t')) continue;
 
-        /* ---- comment stripping ---- */
         if (p->cfg.strip_paren_comments) {
-            if (p->in_paren_comment) {
-                if (ch == ')') p->in_paren_comment = false;
+            if (in_paren) {
+                if (ch == ')') in_paren = false;
                 continue;
             } else if (ch == '(') {
-                p->in_paren_comment = true;
+                in_paren = true;
                 continue;
             }
         }
+        if (p->cfg.strip_semicolon_comments && ch == ';') break;
+        if (p->cfg.to_uppercase) ch = to_upper(ch);
+
+        if (len >= dst_cap) return (uint16_t)(PROTOCOL_LINE_MAX + 1u);
+        dst[len++] = ch;
+    }
+    return len;
+}
+
+bool protocol_peek_line(protocol_t *p, proto_line_view_t *out) {
+    if (!p || !out) return false;
+    take_reset(p);
+
+    while (!p->view_valid) {
+        const uint16_t head = p->rx_head;
+        const uint16_t avail = (uint16_t)(p->rx_tail - head);
+
+        /* Find the terminator */
+        uint16_t n = 0;
+        while (n < avail && p->rx[(uint16_t)(head + n) & PROTOCOL_RX_BUFFER_MASK] != '\n') n++;
+
+        if (n == avail) {
+            /* No complete line. A ring full of one line can never finish:
+             * drop it and report the line as an overflow when its LF arrives.
+             */
+            if (avail >= PROTOCOL_RX_BUFFER_SIZE) {
+                p->rx_head = p->rx_tail;
+                p->rx_dropping = true;
+            }
+            return false;
+        }
 
-        if (p->cfg.strip_semicolon_comments) {
-            if (ch == ';') {
-                /* ignore rest of line until newline */
-                /* easiest: set overflow-like mode and just stop appending */
-                p->cur_overflow = p->cur_overflow; /* no-op */
-                /* consume bytes until newline without appending */
-                /* We can do this by entering a paren-comment-like mode, but keep it simple:
-                   just skip appends while leaving cur_len as-is; the loop continues. */
-                for (i = i + 1; i < len; i++) {
-                    if (data[i] == '\n') { emit_line(p); }
-                    else if (data[i] == 0x18u) { emit_rt(p, PROTO_RT_RESET); protocol_reset(p); }
-                    else if (data[i] == (uint8_t)'?') { emit_rt(p, PROTO_RT_STATUS_QUERY); }
-                    else if (data[i] == (uint8_t)'!') { emit_rt(p, PROTO_RT_FEED_HOLD); }
-                    else if (data[i] == (uint8_t)'~') { emit_rt(p, PROTO_RT_CYCLE_START); }
+        /* Normalize in place when the line does not wrap the ring end */
+        uint16_t start = head & PROTOCOL_RX_BUFFER_MASK;
+        bool contiguous = (uint32_t)start + n < PROTOCOL_RX_BUFFER_SIZE;
+        char *dst = contiguous ? (char *)&p->rx[start] : p->cur;
+
+        if (p->binary_mode && n > 0 && p->rx[start] == PROTO_BIN_SOF) {
+            /* Binary frame: raw bytes, no normalization or trimming */
+            bool too_long = p->rx_dropping || n > PROTOCOL_LINE_MAX;
+            if (!contiguous && !too_long) {
+                for (uint16_t k = 0; k < n; k++) {
+                    dst[k] = (char)p->rx[(uint16_t)(head + k) & PROTOCOL_RX_BUFFER_MASK];
                 }
-                break;
             }
+            dst[too_long ? 0 : n] = '\0';
+            p->rx_dropping = false;
+
+            p->view_span = (uint16_t)(n + 1u);
+            p->view_text = dst;
+            p->view_len = too_long ? 0 : n;
+            p->view_st = too_long ? PROTO_LINE_OVERFLOW : PROTO_LINE_BINARY;
+            p->view_valid = true;
+            break;
         }
 
-        if (p->cfg.to_uppercase) ch = to_upper(ch);
+        uint16_t len = normalize_span(p, head, n, dst, PROTOCOL_LINE_MAX);
 
-        /* ---- append to current line ---- */
-        if (p->cur_len < PROTOCOL_LINE_MAX) {
-            p->cur[p->cur_len++] = ch;
-        } else {
-            p->cur_overflow = true; /* keep consuming until newline, then report overflow */
+        proto_line_status_t st = PROTO_LINE_OK;
+        if (p->rx_dropping || len > PROTOCOL_LINE_MAX) {
+            st = PROTO_LINE_OVERFLOW;
+            len = 0;
+        }
+        dst[len] = '\0';  /* lands at or before the LF */
+        p->rx_dropping = false;
+
+        /* Trim without moving bytes */
+        const char *text = dst;
+        while (len > 0 && (*text == ' ' || *text == '\t')) { text++; len--; }
+        while (len > 0 && (text[len - 1] == ' ' || text[len - 1] == '\t')) len--;
+        ((char *)text)[len] = '\0';
+
+        p->view_span = (uint16_t)(n + 1u);
+        if (st == PROTO_LINE_OK &&
+            (len == 0 || (!p->cfg.allow_dollar_commands && text[0] == '$'))) {
+            /* Empty or ignored: release and look at the next line */
+            p->rx_head = (uint16_t)(head + p->view_span);
+            continue;
         }
+
+        if (st == PROTO_LINE_OK) check_mode_command(p, text, len);
+
+        p->view_text = text;
+        p->view_len = len;
+        p->view_st = st;
+        p->view_valid = true;
     }
+
+    out->text = p->view_text;
+    out->len = p->view_len;
+    out->st = p->view_st;
+    return true;
 }
 
-bool protocol_pop_line(protocol_t *p, char *out, size_t out_cap, proto_line_status_t *st) {
-    if (!p) return false;
-    return queue_pop(p, out, out_cap, st);
+void protocol_release_line(protocol_t *p) {
+    if (!p) return;
+    take_reset(p);  /* a Ctrl-X since the peek already dropped the view */
+    if (!p->view_valid) return;
+    p->view_valid = false;
+    p->rx_head = (uint16_t)(p->rx_head + p->view_span);
 }
 
-bool protocol_has_line(const protocol_t *p) {
-    if (!p) return false;
-    return (p->q_count != 0u);
-}
\ No newline at end of file
+/* ---- binary motion frames ---- */
+
+uint8_t protocol_crc8(const uint8_t *data, size_t len) {
+    uint8_t crc = 0u;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int b = 0; b < 8; b++) {
+            crc = (uint8_t)((crc & 0x80u) ? ((unsigned)crc << 1) ^ 0x07u : (unsigned)crc << 1);
+        }
+    }
+    return crc;
+}
+
+bool protocol_binary_enabled(const protocol_t *p) {
+    return p ? p->binary_mode : false;
+}
+
+/* Unsigned LEB128-style varint, at most 5 bytes */
+static bool read_varint(const uint8_t **pp, const uint8_t *end, uint32_t *out) {
+    uint32_t v = 0;
+    for (unsigned shift = 0; shift < 35u; shift += 7u) {
+        if (*pp >= end) return false;
+        uint8_t b = *(*pp)++;
+        v |= (uint32_t)(b & 0x7Fu) << shift;
+        if (!(b & 0x80u)) {
+            *out = v;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool read_zigzag(const uint8_t **pp, const uint8_t *end, int32_t *out) {
+    uint32_t u;
+    if (!read_varint(pp, end, &u)) return false;
+    *out = (int32_t)(u >> 1) ^ -(int32_t)(u & 1u);
+    return true;
+}
+
+proto_bin_status_t protocol_decode_motion_frame(const char *line, proto_motion_frame_t *out) {
+    if (!line || !out || (uint8_t)line[0] != PROTO_BIN_SOF) return PROTO_BIN_BAD_FRAME;
+
+    /* Undo the byte stuffing */
+    uint8_t buf[PROTOCOL_LINE_MAX];
+    size_t n = 0;
+    for (const char *s = line + 1; *s; s++) {
+        uint8_t b = (uint8_t)*s;
+        if (b == PROTO_BIN_ESC) {
+            if (!*++s) return PROTO_BIN_BAD_FRAME;
+            b = (uint8_t)((uint8_t)*s ^ PROTO_BIN_XOR);
+        }
+        if (n >= sizeof(buf)) return PROTO_BIN_BAD_FRAME;
+        buf[n++] = b;
+    }
+
+    /* type, flags, feed, count and crc at the very least */
+    if (n < 5u) return PROTO_BIN_BAD_FRAME;
+    if (protocol_crc8(buf, n - 1u) != buf[n - 1u]) return PROTO_BIN_BAD_CRC;
+
+    const uint8_t *r = buf;
+    const uint8_t *end = buf + n - 1u;
+    if (*r++ != PROTO_BIN_TYPE_DELTA_XY) return PROTO_BIN_BAD_FRAME;
+    out->flags = *r++;
+    if (!read_varint(&r, end, &out->feed) || r >= end) return PROTO_BIN_BAD_FRAME;
+    out->count = *r++;
+    if (out->count == 0u || out->count > PROTO_BIN_MAX_POINTS) return PROTO_BIN_BAD_FRAME;
+
+    for (uint8_t k = 0; k < out->count; k++) {
+        if (!read_zigzag(&r, end, &out->dx[k]) || !read_zigzag(&r, end, &out->dy[k])) {
+            return PROTO_BIN_BAD_FRAME;
+        }
+    }
+    return (r == end) ? PROTO_BIN_OK : PROTO_BIN_BAD_FRAME;
+}
@@ -4,6 +4,9 @@
  *  - Feed bytes from UART/USB ISR or driver
  *  - Realtime commands are handled immediately
  *  - Full lines are normalized + queued + delivered via callback
+ *  - Flow control by back-pressure: input stalls when the line queue is
+ *    full, nothing is dropped. protocol_rx_free() gives the free RX bytes
+ *    for character-counting senders.
  *
  * Design goals: small, predictable, no malloc, portable C99.
  */
@@ -14,18 +17,40 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "config.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-#ifndef PROTOCOL_LINE_MAX
-#define PROTOCOL_LINE_MAX 96u   /* Max length of a single G-code line (excluding '\0') */
+/* PROTOCOL_LINE_MAX (longest line, excluding '\0'), PROTOCOL_LINE_QUEUE_DEPTH
+ * (worst-case full-length lines to buffer) and PROTOCOL_RX_BUFFER_SIZE
+ * (receive ring bytes, power of two) come from GRBL_LINE_MAX,
+ * GRBL_LINE_QUEUE_DEPTH and GRBL_RX_BUFFER_SIZE in config.h.
+ */
+
+/* Completed lines are stored length-prefixed in a byte arena, so the
+ * default (same RAM as DEPTH full-length lines) holds many more short lines.
+ */
+#ifndef PROTOCOL_LINE_ARENA_SIZE
+#define PROTOCOL_LINE_ARENA_SIZE (PROTOCOL_LINE_QUEUE_DEPTH * (PROTOCOL_LINE_MAX + 1u))
+#endif
+
+#if (PROTOCOL_LINE_MAX > 255u)
+#error "PROTOCOL_LINE_MAX must fit the arena's 8-bit length prefix"
 #endif
 
-#ifndef PROTOCOL_LINE_QUEUE_DEPTH
-#define PROTOCOL_LINE_QUEUE_DEPTH 8u  /* Number of complete lines to buffer */
+#if (PROTOCOL_LINE_ARENA_SIZE < PROTOCOL_LINE_MAX + 2u) || (PROTOCOL_LINE_ARENA_SIZE > 65535u)
+#error "PROTOCOL_LINE_ARENA_SIZE must hold one full line and fit 16-bit offsets"
 #endif
 
+#if (PROTOCOL_RX_BUFFER_SIZE < 64u) || (PROTOCOL_RX_BUFFER_SIZE > 32768u) || \
+    ((PROTOCOL_RX_BUFFER_SIZE & (PROTOCOL_RX_BUFFER_SIZE - 1u)) != 0u)
+#error "PROTOCOL_RX_BUFFER_SIZE must be a power of two in 64..32768"
+#endif
+
+#define PROTOCOL_RX_BUFFER_MASK (PROTOCOL_RX_BUFFER_SIZE - 1u)
+
 /* Realtime commands (modeled after common CNC controllers like Grbl). */
 typedef enum {
     PROTO_RT_NONE = 0,
@@ -34,14 +59,37 @@ typedef enum {
     PROTO_RT_CYCLE_START,      /* '~' */
     PROTO_RT_RESET,            /* Ctrl-X (0x18) */
     PROTO_RT_ESTOP,            /* Optional: user-defined emergency stop */
+    PROTO_RT_FEED_OVR_RESET,   /* 0x90: feed override 100% */
+    PROTO_RT_FEED_OVR_COARSE_PLUS,   /* 0x91: +10% */
+    PROTO_RT_FEED_OVR_COARSE_MINUS,  /* 0x92: -10% */
+    PROTO_RT_FEED_OVR_FINE_PLUS,     /* 0x93: +1% */
+    PROTO_RT_FEED_OVR_FINE_MINUS,    /* 0x94: -1% */
+    PROTO_RT_RAPID_OVR_RESET,  /* 0x95: rapids 100% */
+    PROTO_RT_RAPID_OVR_MEDIUM, /* 0x96: rapids 50% */
+    PROTO_RT_RAPID_OVR_LOW,    /* 0x97: rapids 25% */
+    PROTO_RT_SPINDLE_OVR_RESET,        /* 0x99: spindle 100% */
+    PROTO_RT_SPINDLE_OVR_COARSE_PLUS,  /* 0x9A: +10% */
+    PROTO_RT_SPINDLE_OVR_COARSE_MINUS, /* 0x9B: -10% */
+    PROTO_RT_SPINDLE_OVR_FINE_PLUS,    /* 0x9C: +1% */
+    PROTO_RT_SPINDLE_OVR_FINE_MINUS,   /* 0x9D: -1% */
 } proto_rt_cmd_t;
 
+/* Override bytes (grbl 1.1 values). Like '?', they are acted on as soon as
+ * they arrive, even in the middle of a line, and never reach the line.
+ */
+#define PROTO_RT_BYTE_FEED_OVR_RESET          0x90u
+#define PROTO_RT_BYTE_RAPID_OVR_RESET         0x95u
+#define PROTO_RT_BYTE_SPINDLE_OVR_RESET       0x99u
+#define PROTO_RT_BYTE_OVR_FIRST               0x90u
+#define PROTO_RT_BYTE_OVR_LAST                0x9Du
+
 /* Line-level errors (not motion errors). */
 typedef enum {
     PROTO_LINE_OK = 0,
     PROTO_LINE_EMPTY,          /* blank/only whitespace/comments */
     PROTO_LINE_OVERFLOW,       /* line exceeded PROTOCOL_LINE_MAX */
     PROTO_LINE_BAD_CHAR,       /* non-printable / unsupported characters */
+    PROTO_LINE_BINARY,         /* binary motion frame (see below), not G-code */
 } proto_line_status_t;
 
 /* Callback when a complete (normalized) line is ready. */
@@ -58,7 +106,50 @@ typedef struct {
     bool to_uppercase;            /* optional: normalize to uppercase */
 } proto_config_t;
 
-typedef struct protocol protocol_t;
+/* Protocol instance. Defined here so it can be allocated statically;
+ * treat the fields as private to protocol.c.
+ */
+typedef struct protocol {
+    proto_config_t cfg;
+
+    proto_line_cb_t on_line;
+    proto_rt_cb_t   on_rt;
+    void           *user;
+
+    /* Current assembling line */
+    char     cur[PROTOCOL_LINE_MAX + 1];
+    uint16_t cur_len;
+    bool     cur_overflow;
+    bool     in_paren_comment;
+    bool     in_semicolon_comment;
+    bool     in_binary_frame;  /* current line started with PROTO_BIN_SOF */
+    bool     binary_mode;      /* "$BIN=1" seen: accept binary frames */
+
+    /* Receive ring: written by protocol_rx_write() (ISR), drained by
+     * protocol_service() (main loop). Free-running indices.
+     */
+    uint8_t           rx[PROTOCOL_RX_BUFFER_SIZE];
+    volatile uint16_t rx_head;   /* consumer */
+    volatile uint16_t rx_tail;   /* producer */
+    volatile uint16_t rx_overruns; /* DMA wrote more than the ring had free */
+    volatile uint16_t rx_reset_at; /* ring offset just past the latest Ctrl-X */
+    volatile bool     rx_reset;    /* Ctrl-X seen by the producer, not yet applied */
+
+    /* Outstanding line view (protocol_peek_line / protocol_release_line) */
+    const char         *view_text;
+    uint16_t            view_len;
+    uint16_t            view_span; /* ring bytes covered, including the LF */
+    proto_line_status_t view_st;
+    bool                view_valid;
+    bool                rx_dropping; /* discarding an oversize line to its LF */
+
+    /* Completed line arena: [len][status][bytes...] entries, wrapping */
+    uint8_t  q[PROTOCOL_LINE_ARENA_SIZE];
+    uint16_t q_head;   /* offset of the oldest entry */
+    uint16_t q_tail;   /* offset for the next entry */
+    uint16_t q_used;   /* bytes in use, headers included */
+    uint16_t q_count;  /* lines queued */
+} protocol_t;
 
 /* Initialize protocol instance (zero dynamic allocation). */
 void protocol_init(protocol_t *p,
@@ -67,11 +158,58 @@ void protocol_init(protocol_t *p,
                    proto_rt_cb_t on_rt,
                    void *user);
 
-/* Reset internal state: clears current line + queued lines. */
+/* Reset internal state: clears current line, queued lines and the RX ring. */
 void protocol_reset(protocol_t *p);
 
-/* Feed bytes into the protocol (call from ISR or driver). */
-void protocol_feed_bytes(protocol_t *p, const uint8_t *data, size_t len);
+/* Feed bytes straight into line assembly (call from the main loop).
+ * Returns bytes consumed; less than len means the line queue is full and
+ * the caller must hold the remainder and feed it again after popping.
+ */
+size_t protocol_feed_bytes(protocol_t *p, const uint8_t *data, size_t len);
+
+/* ---- Receive ring (ISR producer / main-loop consumer) ----
+ *
+ * protocol_rx_write() acts on realtime bytes immediately and stores the
+ * rest in the RX ring; it returns bytes accepted (stops when the ring is
+ * full). Ctrl-X only marks the ring there: the consumer calls below apply
+ * the reset, dropping the lines and bytes that came before it. protocol_service() moves ring bytes into line assembly until the
+ * ring is empty or the line queue is full. A host that keeps at most
+ * protocol_rx_free() bytes in flight (character counting: one "ok" per
+ * line frees strlen(line)+1 bytes) can never overrun the ring.
+ */
+size_t protocol_rx_write(protocol_t *p, const uint8_t *data, size_t len);
+size_t protocol_service(protocol_t *p);
+size_t protocol_rx_free(const protocol_t *p);
+
+/* ---- Circular DMA reception + zero-copy line views ----
+ *
+ * The UART DMA writes straight into the protocol RX ring:
+ *
+ *   hal_serial_rx_dma_start(HAL_PORT_GCODE, protocol_rx_dma_buffer(&proto),
+ *                           PROTOCOL_RX_BUFFER_SIZE, protocol_rx_dma_isr, &proto);
+ *
+ * protocol_rx_dma_isr() runs from the idle-line / half / full-transfer
+ * interrupts with the DMA write position. It publishes the new bytes and
+ * acts on realtime bytes there and then, blanking them in the ring so the
+ * line scanner never sees them.
+ *
+ * The main loop then takes lines with protocol_peek_line(). The line is
+ * normalized in place and returned as a NUL-terminated view into the ring.
+ * Only a line that wraps the ring end is copied, into the assembly buffer.
+ * protocol_release_line() hands the bytes back to the DMA.
+ *
+ * Use either this path or protocol_service()/protocol_pop_line(), not both.
+ */
+typedef struct {
+    const char         *text;  /* NUL-terminated, valid until release */
+    uint16_t            len;
+    proto_line_status_t st;    /* PROTO_LINE_OK or PROTO_LINE_OVERFLOW */
+} proto_line_view_t;
+
+uint8_t *protocol_rx_dma_buffer(protocol_t *p);
+void protocol_rx_dma_isr(size_t dma_pos, void *user);
+bool protocol_peek_line(protocol_t *p, proto_line_view_t *out);
+void protocol_release_line(protocol_t *p);
 
 /* Optional: poll to deliver queued lines outside ISR context.
  * If you call protocol_feed_bytes() in ISR, set callbacks to NULL and
@@ -82,6 +220,62 @@ bool protocol_pop_line(protocol_t *p, char *out, size_t out_cap, proto_line_stat
 /* Utility: returns true if there are pending completed lines buffered. */
 bool protocol_has_line(const protocol_t *p);
 
+/* ---- Binary motion frames ----
+ *
+ * Dense engraving paths cost ~20 ASCII bytes and a parse per point. With
+ * allow_dollar_commands set, the host may send "$BIN=1" to enable compact
+ * frames (and "$BIN=0", or Ctrl-X, to return to text only). A frame is a
+ * line whose first byte is PROTO_BIN_SOF, terminated by '\n' like any
+ * other line, so flow control and the line queue work unchanged:
+ *
+ *   SOF  stuffed( type | flags | feed | count | count * (dx, dy) | crc8 )  LF
+ *
+ *   type   PROTO_BIN_TYPE_DELTA_XY
+ *   flags  PROTO_BIN_FLAG_RAPID
+ *   feed   unsigned varint, mm/min (0 = keep the current feed)
+ *   count  1..PROTO_BIN_MAX_POINTS
+ *   dx,dy  zigzag varints, PROTO_BIN_UNITS_PER_MM counts per mm, relative
+ *          to the previous point
+ *   crc8   polynomial 0x07, init 0, over everything from type on
+ *
+ * Stuffing: NUL, LF, CR, SOF, ESC and the realtime bytes (override bytes
+ * 0x90..0x9D included) are sent as
+ * PROTO_BIN_ESC, byte ^ PROTO_BIN_XOR, so realtime commands still work
+ * mid-stream and the frame is a valid C string. Frames are queued and
+ * delivered raw with status PROTO_LINE_BINARY; decode them with
+ * protocol_decode_motion_frame().
+ */
+#define PROTO_BIN_SOF            0x01u
+#define PROTO_BIN_ESC            0x1Bu
+#define PROTO_BIN_XOR            0x40u
+#define PROTO_BIN_TYPE_DELTA_XY  0x01u
+#define PROTO_BIN_FLAG_RAPID     0x01u
+#define PROTO_BIN_UNITS_PER_MM   1000
+#define PROTO_BIN_MAX_POINTS     32u
+
+typedef enum {
+    PROTO_BIN_OK = 0,
+    PROTO_BIN_BAD_FRAME,       /* not a frame, truncated or malformed */
+    PROTO_BIN_BAD_CRC,
+} proto_bin_status_t;
+
+typedef struct {
+    uint8_t  flags;
+    uint32_t feed;             /* mm/min, 0 = keep current */
+    uint8_t  count;
+    int32_t  dx[PROTO_BIN_MAX_POINTS];
+    int32_t  dy[PROTO_BIN_MAX_POINTS];
+} proto_motion_frame_t;
+
+/* Decode a frame line (as delivered, starting with PROTO_BIN_SOF). */
+proto_bin_status_t protocol_decode_motion_frame(const char *line, proto_motion_frame_t *out);
+
+/* CRC-8 (poly 0x07, init 0) as used by the frame trailer. */
+uint8_t protocol_crc8(const uint8_t *data, size_t len);
+
+/* True while binary frames are accepted ("$BIN=1"). */
+bool protocol_binary_enabled(const protocol_t *p);
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,90 @@
+/* scheduler.c - Cooperative event-driven task scheduler implementation */
+
+#include "scheduler.h"
+#include <string.h>
+
+/* ----------------------------- Private helpers ----------------------------- */
+
+#if !defined(__GNUC__)
+uint32_t sched_events_take_fallback(volatile uint32_t *events) {
+    uint32_t ev = *events;
+    *events = 0u;
+    return ev;
+}
+#endif
+
+/* Fan freshly posted events out into per-task ready bits */
+static void collect_events(scheduler_t *s) {
+    uint32_t ev = SCHED_EVENTS_TAKE(&s->events);
+    if (ev == 0u) {
+        return;
+    }
+    for (uint8_t i = 0; i < s->count; i++) {
+        if (s->tasks[i].wake_mask & ev) {
+            s->ready |= 1u << i;
+        }
+    }
+}
+
+/* ----------------------------- Public API ----------------------------- */
+
+void sched_init(scheduler_t *s) {
+    if (!s) return;
+    memset(s, 0, sizeof(*s));
+}
+
+int sched_add_task(scheduler_t *s, sched_task_fn_t fn, void *user, uint32_t wake_mask) {
+    if (!s || !fn || s->count >= SCHED_MAX_TASKS) {
+        return -1;
+    }
+    sched_task_t *t = &s->tasks[s->count];
+    t->fn = fn;
+    t->user = user;
+    t->wake_mask = wake_mask;
+    t->runs = 0;
+    return (int)s->count++;
+}
+
+void sched_set_ready(scheduler_t *s, int task) {
+    if (!s || task < 0 || task >= (int)s->count) return;
+    s->ready |= 1u << task;
+}
+
+bool sched_run_once(scheduler_t *s) {
+    if (!s) return false;
+
+    collect_events(s);
+    if (s->ready == 0u) {
+        return false;
+    }
+
+    /* Lowest set bit = highest priority */
+    uint8_t i = 0;
+    while (((s->ready >> i) & 1u) == 0u) {
+        i++;
+    }
+
+    s->ready &= ~(1u << i);
+    sched_task_t *t = &s->tasks[i];
+    t->runs++;
+    if (t->fn(t->user)) {
+        s->ready |= 1u << i;
+    }
+    return true;
+}
+
+bool sched_has_work(const scheduler_t *s) {
+    if (!s) return false;
+    return s->ready != 0u || s->events != 0u;
+}
+
+void sched_run(scheduler_t *s) {
+    if (!s) return;
+
+    for (;;) {
+        if (!sched_run_once(s)) {
+            s->idle_waits++;
+            hal_idle_wait(&s->events);
+        }
+    }
+}
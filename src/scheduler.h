@@ -0,0 +1,113 @@
+/* scheduler.h - Cooperative event-driven task scheduler for the main loop
+ *
+ * Purpose:
+ *  - Run main-loop work only when something happened, instead of polling
+ *    every subsystem on a fixed schedule
+ *  - Let ISRs wake tasks by posting event bits (RX ready, limit edge,
+ *    step segments low, realtime command, 1 kHz tick)
+ *  - Sleep (WFI) when no task has work
+ *
+ * Model:
+ *  - Tasks are registered once, in priority order (first = highest).
+ *  - Each task names the events that wake it. sched_signal() ORs events
+ *    into a pending word (ISR-safe); sched_run_once() takes that word and
+ *    marks every task whose mask matches as ready.
+ *  - sched_run_once() runs exactly one slice: the highest-priority ready
+ *    task. A task returns true if it has more work, which keeps it ready.
+ *    Because pending events are collected again before every slice, a
+ *    high-priority task woken by an ISR runs before the next slice of any
+ *    lower-priority task. Tasks keep slices short (one line, one service
+ *    pass) so that bound is the latency of the longest slice.
+ *
+ * No dynamic allocation; the scheduler is a plain struct owned by the caller.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Task table size (<= 32, one ready bit per task). */
+#ifndef SCHED_MAX_TASKS
+#define SCHED_MAX_TASKS 8u
+#endif
+
+#if SCHED_MAX_TASKS > 32u
+  #error "SCHED_MAX_TASKS must be <= 32"
+#endif
+
+/* Event word updates from ISRs. On Cortex-M these are LDREX/STREX loops, so
+ * several interrupt priorities may post concurrently.
+ */
+#if defined(__GNUC__)
+#define SCHED_EVENTS_POST(p, ev) ((void)__atomic_fetch_or((p), (ev), __ATOMIC_RELEASE))
+#define SCHED_EVENTS_TAKE(p)     __atomic_exchange_n((p), 0u, __ATOMIC_ACQUIRE)
+#else
+/* Not atomic: the platform must post events with interrupts masked */
+#define SCHED_EVENTS_POST(p, ev) ((void)(*(p) |= (ev)))
+#define SCHED_EVENTS_TAKE(p)     sched_events_take_fallback(p)
+#endif
+
+/* Task body: return true if more work is left (stay ready), false to wait
+ * for the next wake event.
+ */
+typedef bool (*sched_task_fn_t)(void *user);
+
+typedef struct {
+    sched_task_fn_t fn;
+    void *user;
+    uint32_t wake_mask;           /* Events that make this task ready */
+    uint32_t runs;                /* Slices executed (diagnostics) */
+} sched_task_t;
+
+typedef struct {
+    sched_task_t tasks[SCHED_MAX_TASKS];
+    uint8_t count;
+    uint32_t ready;               /* Bit n: task n has work */
+    volatile uint32_t events;     /* Posted by sched_signal(), taken per slice */
+    uint32_t idle_waits;          /* Times the loop went to sleep */
+} scheduler_t;
+
+/* ----------------------------- Public API ----------------------------- */
+
+/* Clear the task table and pending events */
+void sched_init(scheduler_t *s);
+
+/* Register a task below all tasks added so far. Returns its index, or -1
+ * if the table is full. A task with wake_mask 0 only runs when made ready
+ * with sched_set_ready().
+ */
+int sched_add_task(scheduler_t *s, sched_task_fn_t fn, void *user, uint32_t wake_mask);
+
+/* Post events (safe from any ISR) */
+static inline void sched_signal(scheduler_t *s, uint32_t events) {
+    SCHED_EVENTS_POST(&s->events, events);
+}
+
+/* Mark a task ready from the main loop */
+void sched_set_ready(scheduler_t *s, int task);
+
+/* Run the highest-priority ready task once. Returns false if nothing was
+ * ready (the caller may sleep).
+ */
+bool sched_run_once(scheduler_t *s);
+
+/* True if any event is pending or any task is ready */
+bool sched_has_work(const scheduler_t *s);
+
+/* Main loop: run slices forever, sleeping in hal_idle_wait() when idle */
+void sched_run(scheduler_t *s);
+
+#if !defined(__GNUC__)
+uint32_t sched_events_take_fallback(volatile uint32_t *events);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
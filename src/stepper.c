@@ -2,29 +2,434 @@
 
 #include "stepper.h"
 #include "system_state.h"
+#include "grbl.h"
+#include "profile.h"
+#if GRBL_KINEMATICS_COREXY_INLINE
+#include "kin_corexy.h"
+#endif
 #include <string.h>
 #include <math.h>
 
 /* Constants */
 #define DEFAULT_STEP_INTERVAL_US 1000  /* Default step interval: 1ms */
 
+#define SEGMENT_MASK (STEPPER_SEGMENT_BUFFER_SIZE - 1u)
+
+/* Joint axes driven by the step ISR (one HAL step/dir channel each) */
+#define STEPPER_AXES KIN_MAX_JOINT_AXES
+typedef char stepper_axes_fit_hal[(KIN_MAX_JOINT_AXES <= HAL_AXIS_MAX) ? 1 : -1];
+
 /* Internal helper functions */
 
-/* Delay for a specified number of microseconds 
- * Note: This implementation uses hal_delay_ms with rounding up to 1ms minimum
- * For sub-millisecond precision, a platform-specific implementation would be needed
+/* Convert microseconds to step timer ticks (rounded up, at least 1) */
+static uint32_t us_to_ticks(uint32_t us) {
+    uint64_t ticks = ((uint64_t)us * hal_step_timer_freq_hz() + 999999u) / 1000000u;
+    if (ticks == 0) ticks = 1;
+    if (ticks > UINT32_MAX) ticks = UINT32_MAX;
+    return (uint32_t)ticks;
+}
+
+static uint8_t segments_queued(const stepper_context_t *ctx) {
+    return (uint8_t)(ctx->seg_tail - ctx->seg_head);
+}
+
+/* ISR side: ask the main loop for stepper_update() */
+static void request_refill(const stepper_context_t *ctx) {
+    if (ctx->notify) {
+        ctx->notify(ctx->notify_user);
+    }
+}
+
+/* Spindle PWM 0..1 for a programmed S value, spindle override applied */
+static float spindle_pwm_for(const stepper_context_t *ctx, float s) {
+    float s_max = ctx->config.spindle_max_speed;
+    if (s_max <= 0.0f) s_max = STEPPER_SPINDLE_MAX_DEFAULT;
+    float pwm = s * (float)ctx->spindle_override * 0.01f / s_max;
+    if (pwm < 0.0f) pwm = 0.0f;
+    if (pwm > 1.0f) pwm = 1.0f;
+    return pwm;
+}
+
+/* Laser PWM for a block running at speed (mm/min). M4 scales power with
+ * speed over nominal so corners and ramps do not over-burn; M3 is constant.
  */
-static void delay_us(uint32_t us) {
-    if (us == 0) return;
+static float laser_pwm_for(const stepper_context_t *ctx, float speed) {
+    const planner_block_t *block = ctx->current_block;
+    if (!ctx->laser_block || !block ||
+        !(block->line_flags & (PLANNER_LINE_SPINDLE_CW | PLANNER_LINE_SPINDLE_CCW))) {
+        return 0.0f;
+    }
     
-    /* Convert to milliseconds, rounding up */
-    uint32_t ms = (us + 999) / 1000;
-    if (ms == 0) ms = 1;  /* Minimum 1ms delay */
+    float pwm = spindle_pwm_for(ctx, block->spindle_speed);
+    if ((block->line_flags & PLANNER_LINE_SPINDLE_CCW) && block->nominal_speed > 0.0f) {
+        /* Segment averages round to whole steps and can read just above nominal */
+        float ratio = speed / block->nominal_speed;
+        pwm *= (ratio < 1.0f) ? ratio : 1.0f;
+    }
+    return pwm;
+}
+
+/* Write the laser output if it changed */
+static void laser_apply(stepper_context_t *ctx, float pwm) {
+    if (pwm == ctx->laser_pwm) {
+        return;
+    }
+    ctx->laser_pwm = pwm;
+    hal_spindle_set(pwm > 0.0f ? ctx->laser_dir : HAL_SPINDLE_OFF, pwm);
+}
+
+/* Slice the remaining block steps into constant-rate segments */
+static void prep_constant_segments(stepper_context_t *ctx) {
+    while (ctx->prep_steps_remaining > 0 &&
+           segments_queued(ctx) < STEPPER_SEGMENT_BUFFER_SIZE) {
+        stepper_segment_t *seg = &ctx->segments[ctx->seg_tail & SEGMENT_MASK];
+
+        uint32_t n = ctx->prep_steps_remaining;
+        if (n > STEPPER_SEGMENT_MAX_STEPS) n = STEPPER_SEGMENT_MAX_STEPS;
+
+        seg->n_step = (uint16_t)n;
+        seg->period_ticks = ctx->step_period_ticks;
+        seg->amass_level = 0;
+        seg->spindle_pwm = laser_pwm_for(ctx, ctx->current_speed);
+        ctx->prep_steps_remaining -= n;
+        seg->end_of_block = (ctx->prep_steps_remaining == 0);
+
+        /* Publish only after the slot is fully written */
+        ctx->seg_tail++;
+    }
+}
+
+/* ----------------------------- Acceleration profile ----------------------------- */
+
+/* Distance covered t seconds into a phase. Linear ramps integrate a constant
+ * acceleration; S-curve ramps follow smoothstep velocity 3u^2 - 2u^3, whose
+ * integral is u^3 - u^4/2. Both cover the same distance in the same time, so
+ * the planner's ramp boundaries and exit speeds are honoured either way; the
+ * S-curve trades zero jerk at the ramp ends for 1.5x peak acceleration.
+ */
+static float phase_position(const stepper_phase_t *ph, float t, bool s_curve) {
+    if (ph->duration <= 0.0f) {
+        return 0.0f;
+    }
     
-    hal_delay_ms(ms);
+    float dv = ph->v_end - ph->v_start;
+    if (s_curve) {
+        float u = t / ph->duration;
+        float u3 = u * u * u;
+        return ph->v_start * t + dv * ph->duration * (u3 - 0.5f * u3 * u);
+    }
+    return ph->v_start * t + dv * t * t / (2.0f * ph->duration);
 }
 
-/* Convert planner block to step counts using kinematics */
+static float phase_speed(const stepper_phase_t *ph, float t, bool s_curve) {
+    if (ph->duration <= 0.0f) {
+        return ph->v_end;
+    }
+    
+    float u = t / ph->duration;
+    if (s_curve) {
+        u = u * u * (3.0f - 2.0f * u);
+    }
+    return ph->v_start + (ph->v_end - ph->v_start) * u;
+}
+
+/* Build the accelerate/cruise/decelerate phases of a block (grbl trapezoid)
+ * over the part of the block from step start onwards, entered at v_entry
+ * (steps/s); entered above nominal, the first phase ramps down instead.
+ * Speeds are converted to dominant-axis steps/s so the whole profile lives
+ * in the same units the ISR executes.
+ */
+static void plan_profile_from(stepper_context_t *ctx, const planner_block_t *block,
+                              float v_entry, float start) {
+    float spm = ctx->steps_per_mm;
+    float accel = block->acceleration * spm / 3600.0f;   /* mm/min^2 -> steps/s^2 */
+    float v_nominal = block->nominal_speed * spm / 60.0f; /* mm/min -> steps/s */
+    float v_exit_sqr = block->exit_speed_sqr * (spm * spm / 3600.0f);
+    float length = (float)ctx->step_event_count - start;
+    if (length < 0.0f) length = 0.0f;
+    
+    float accel_dist = (v_nominal * v_nominal - v_entry * v_entry) / (2.0f * accel);
+    float decel_dist = (v_nominal * v_nominal - v_exit_sqr) / (2.0f * accel);
+    if (accel_dist < 0.0f) accel_dist = 0.0f;
+    if (decel_dist < 0.0f) decel_dist = 0.0f;
+    
+    float v_peak = v_nominal;
+    if (v_entry > v_nominal) {
+        /* Entered above nominal (the override was lowered): the first phase
+         * ramps down to nominal at the block's acceleration. If the rest of
+         * the block can't hold that, decelerate straight towards the exit.
+         */
+        accel_dist = (v_entry * v_entry - v_nominal * v_nominal) / (2.0f * accel);
+        if (accel_dist + decel_dist > length) {
+            accel_dist = 0.0f;
+            decel_dist = length;
+            v_peak = v_entry;
+        }
+    } else if (accel_dist + decel_dist > length) {
+        /* Triangle: nominal speed is never reached */
+        accel_dist = (2.0f * accel * length - v_entry * v_entry + v_exit_sqr) / (4.0f * accel);
+        if (accel_dist < 0.0f) accel_dist = 0.0f;
+        if (accel_dist > length) accel_dist = length;
+        decel_dist = length - accel_dist;
+        v_peak = sqrtf(v_entry * v_entry + 2.0f * accel * accel_dist);
+    }
+    
+    /* Exit speed actually reachable from the peak (guards bad input) */
+    float v2_end = v_peak * v_peak - 2.0f * accel * decel_dist;
+    float v_end = (v2_end > 0.0f) ? sqrtf(v2_end) : 0.0f;
+    float cruise_dist = length - accel_dist - decel_dist;
+    
+    stepper_phase_t *ph = ctx->phases;
+    ph[STEPPER_PHASE_ACCEL].v_start = v_entry;
+    ph[STEPPER_PHASE_ACCEL].v_end = v_peak;
+    ph[STEPPER_PHASE_ACCEL].start_pos = start;
+    ph[STEPPER_PHASE_ACCEL].duration = (accel_dist > 0.0f) ? 2.0f * accel_dist / (v_entry + v_peak) : 0.0f;
+    
+    ph[STEPPER_PHASE_CRUISE].v_start = v_peak;
+    ph[STEPPER_PHASE_CRUISE].v_end = v_peak;
+    ph[STEPPER_PHASE_CRUISE].start_pos = start + accel_dist;
+    ph[STEPPER_PHASE_CRUISE].duration = (cruise_dist > 0.0f) ? cruise_dist / v_peak : 0.0f;
+    
+    ph[STEPPER_PHASE_DECEL].v_start = v_peak;
+    ph[STEPPER_PHASE_DECEL].v_end = v_end;
+    ph[STEPPER_PHASE_DECEL].start_pos = start + accel_dist + cruise_dist;
+    ph[STEPPER_PHASE_DECEL].duration = (decel_dist > 0.0f && v_peak + v_end > 0.0f) ?
+                                       2.0f * decel_dist / (v_peak + v_end) : 0.0f;
+    
+    ctx->accelerate_until = (uint32_t)(start + accel_dist);
+    ctx->decelerate_after = (uint32_t)(start + accel_dist + cruise_dist);
+    ctx->prep_phase = STEPPER_PHASE_ACCEL;
+    ctx->prep_phase_time = 0.0f;
+    ctx->profile_nominal = block->nominal_speed;
+    ctx->profile_exit_sqr = block->exit_speed_sqr;
+}
+
+/* Whole block, entered at the entry speed stepper_load_block() took from
+ * entry_speed_sqr (the only square root per block)
+ */
+static void plan_profile(stepper_context_t *ctx, const planner_block_t *block) {
+    plan_profile_from(ctx, block, ctx->current_speed * ctx->steps_per_mm / 60.0f, 0.0f);
+}
+
+/* Move the prep cursor dt seconds forward through the phases */
+static void advance_prep(stepper_context_t *ctx, float dt) {
+    while (ctx->prep_phase < STEPPER_PHASE_COUNT) {
+        float left = ctx->phases[ctx->prep_phase].duration - ctx->prep_phase_time;
+        if (dt < left) {
+            ctx->prep_phase_time += dt;
+            return;
+        }
+        dt -= left;
+        ctx->prep_phase++;
+        ctx->prep_phase_time = 0.0f;
+    }
+}
+
+/* Block position of the prep cursor, in steps */
+static float prep_position(const stepper_context_t *ctx) {
+    if (ctx->prep_phase >= STEPPER_PHASE_COUNT) {
+        return ctx->hold_decel ? ctx->hold_stop_pos : (float)ctx->step_event_count;
+    }
+    
+    const stepper_phase_t *ph = &ctx->phases[ctx->prep_phase];
+    return ph->start_pos + phase_position(ph, ctx->prep_phase_time, ctx->config.s_curve);
+}
+
+/* Step rate at the prep cursor, in steps/s */
+static float prep_speed(const stepper_context_t *ctx) {
+    if (ctx->prep_phase >= STEPPER_PHASE_COUNT) {
+        return ctx->phases[STEPPER_PHASE_DECEL].v_end;
+    }
+    
+    const stepper_phase_t *ph = &ctx->phases[ctx->prep_phase];
+    return phase_speed(ph, ctx->prep_phase_time, ctx->config.s_curve);
+}
+
+/* Feed hold: replace the rest of the profile with a ramp from the prep
+ * cursor's speed down to zero at the block's acceleration. A ramp longer
+ * than the block ends at the block with the speed left over, and the next
+ * block carries it on (see stepper_update()).
+ */
+static void plan_stop_from_prep(stepper_context_t *ctx) {
+    const planner_block_t *block = ctx->current_block;
+    float spm = ctx->steps_per_mm;
+    float accel = block->acceleration * spm / 3600.0f;   /* mm/min^2 -> steps/s^2 */
+    float v_now = prep_speed(ctx);
+    float start = prep_position(ctx);
+    float length = (float)ctx->step_event_count - start;
+    if (length < 0.0f) length = 0.0f;
+    
+    float decel_dist = v_now * v_now / (2.0f * accel);
+    float v_end = 0.0f;
+    if (decel_dist > length) {
+        decel_dist = length;
+        float v2_end = v_now * v_now - 2.0f * accel * length;
+        v_end = (v2_end > 0.0f) ? sqrtf(v2_end) : 0.0f;
+    }
+    
+    stepper_phase_t *ph = ctx->phases;
+    for (uint8_t i = STEPPER_PHASE_ACCEL; i < STEPPER_PHASE_DECEL; i++) {
+        ph[i].v_start = v_now;
+        ph[i].v_end = v_now;
+        ph[i].start_pos = start;
+        ph[i].duration = 0.0f;
+    }
+    ph[STEPPER_PHASE_DECEL].v_start = v_now;
+    ph[STEPPER_PHASE_DECEL].v_end = v_end;
+    ph[STEPPER_PHASE_DECEL].start_pos = start;
+    ph[STEPPER_PHASE_DECEL].duration = (decel_dist > 0.0f && v_now + v_end > 0.0f) ?
+                                       2.0f * decel_dist / (v_now + v_end) : 0.0f;
+    
+    ctx->accelerate_until = (uint32_t)start;
+    ctx->decelerate_after = (uint32_t)start;
+    ctx->prep_phase = STEPPER_PHASE_DECEL;
+    ctx->prep_phase_time = 0.0f;
+    ctx->hold_stop_pos = start + decel_dist;
+    ctx->hold_decel = true;
+}
+
+/* Smallest AMASS level whose ISR rate keeps the dominant axis above LEVEL1 */
+static uint8_t amass_level_for(float step_rate) {
+    uint8_t level = 0;
+    float threshold = (float)STEPPER_AMASS_LEVEL1_HZ;
+    while (level < STEPPER_MAX_AMASS_LEVEL && step_rate < threshold) {
+        level++;
+        threshold *= 0.5f;
+    }
+    return level;
+}
+
+/* Slice an accelerated block into fixed-interval segments: the step rate is
+ * re-evaluated every STEPPER_SEGMENT_DT_US, and each segment runs at the
+ * average rate over its interval. Intervals with no whole step are merged
+ * into the next one.
+ */
+static void prep_timed_segments(stepper_context_t *ctx) {
+    const float dt = (float)STEPPER_SEGMENT_DT_US * 1.0e-6f;
+    uint32_t min_period = us_to_ticks(ctx->config.dir_setup_us) + ctx->pulse_ticks + 1u;
+    
+    /* An override replanned the running block: continue from the prep
+     * cursor at its current speed towards the new nominal/exit speeds.
+     * Segments already queued run out unchanged.
+     */
+    const planner_block_t *block = ctx->current_block;
+    if (block && !ctx->hold_decel && ctx->prep_phase < STEPPER_PHASE_COUNT &&
+        (block->nominal_speed != ctx->profile_nominal || block->exit_speed_sqr != ctx->profile_exit_sqr)) {
+        plan_profile_from(ctx, block, prep_speed(ctx), prep_position(ctx));
+    }
+    
+    while (ctx->prep_steps_remaining > 0 &&
+           segments_queued(ctx) < STEPPER_SEGMENT_BUFFER_SIZE) {
+        stepper_segment_t *seg = &ctx->segments[ctx->seg_tail & SEGMENT_MASK];
+        uint32_t prepped = ctx->step_event_count - ctx->prep_steps_remaining;
+        
+        float elapsed = 0.0f;
+        uint32_t n = 0;
+        while (n == 0) {
+            advance_prep(ctx, dt);
+            elapsed += dt;
+            if (ctx->prep_phase >= STEPPER_PHASE_COUNT) {
+                /* Profile done: the rest of the block, or up to the hold point */
+                uint32_t at = ctx->hold_decel ? (uint32_t)ctx->hold_stop_pos : ctx->step_event_count;
+                n = (at > prepped) ? at - prepped : 0;
+                break;
+            }
+            uint32_t at = (uint32_t)prep_position(ctx);
+            n = (at > prepped) ? at - prepped : 0;
+        }
+        if (n == 0) {
+            break;  /* ramped down to the hold point: nothing more until resume */
+        }
+        if (n > ctx->prep_steps_remaining) n = ctx->prep_steps_remaining;
+        
+        uint8_t level = amass_level_for((float)n / elapsed);
+        if (n > (uint32_t)(UINT16_MAX >> level)) n = (uint32_t)(UINT16_MAX >> level);
+        
+        uint32_t events = n << level;
+        float period = elapsed * (float)hal_step_timer_freq_hz() / (float)events;
+        uint32_t period_ticks = (period > (float)UINT32_MAX) ? UINT32_MAX : (uint32_t)period;
+        if (period_ticks < min_period) period_ticks = min_period;
+        
+        seg->n_step = (uint16_t)events;
+        seg->amass_level = level;
+        seg->period_ticks = period_ticks;
+        seg->spindle_pwm = laser_pwm_for(ctx, (float)n / elapsed * 60.0f / ctx->steps_per_mm);
+        ctx->prep_steps_remaining -= n;
+        seg->end_of_block = (ctx->prep_steps_remaining == 0);
+        
+        ctx->current_speed = prep_speed(ctx) * 60.0f / ctx->steps_per_mm;
+        
+        /* Publish only after the slot is fully written */
+        ctx->seg_tail++;
+    }
+}
+
+/* Slice the remaining block steps into segments until the ring is full */
+static void prep_segments(stepper_context_t *ctx) {
+    if (ctx->timed_profile) {
+        prep_timed_segments(ctx);
+    } else {
+        prep_constant_segments(ctx);
+    }
+}
+
+/* Arm the step timer if there is work queued and it is not already running */
+static void start_timer_if_needed(stepper_context_t *ctx) {
+    if (ctx->timer_running || ctx->block_done || ctx->halted) {
+        return;
+    }
+
+    uint32_t period;
+    if (ctx->seg_steps_left > 0) {
+        /* Resuming mid-segment (after a hold) */
+        period = ctx->step_period_ticks;
+    } else if (segments_queued(ctx) > 0) {
+        period = ctx->segments[ctx->seg_head & SEGMENT_MASK].period_ticks;
+    } else {
+        return;
+    }
+
+    ctx->timer_running = true;
+    PROFILE_STEP_ISR_RESTART();
+    hal_step_timer_compare(ctx->pulse_ticks);
+    hal_step_timer_arm(period);
+}
+
+static void stop_timer(stepper_context_t *ctx) {
+    hal_step_timer_stop();
+    ctx->timer_running = false;
+}
+
+static void finish_block(stepper_context_t *ctx) {
+    if (ctx->block_from_planner) {
+        /* Hand the slot back to the planner */
+        planner_discard_current_block(ctx->planner);
+        ctx->block_from_planner = false;
+    }
+    if (ctx->laser_block) {
+        laser_apply(ctx, 0.0f);
+        ctx->laser_block = false;
+    }
+    ctx->current_block = NULL;
+    ctx->dwell_active = false;
+    ctx->hold_decel = false;
+    ctx->state = STEPPER_IDLE;
+    ctx->current_speed = 0.0f;
+    ctx->block_done = false;
+    ctx->idle_start_time_ms = hal_millis();
+}
+
+/* Feed hold reached (or no ramp possible): stop the timer where motion is */
+static void park_hold(stepper_context_t *ctx) {
+    ctx->state = STEPPER_HOLD;
+    stop_timer(ctx);
+    if (ctx->laser_block) {
+        /* No burn while parked */
+        laser_apply(ctx, 0.0f);
+    }
+}
+
+/* Copy per-joint step counts out of the planner block */
 static bool block_to_steps(const planner_block_t *block, 
                           uint32_t *out_steps,
                           uint8_t *out_dir_bits) {
@@ -32,26 +437,16 @@ static bool block_to_steps(const planner_block_t *block,
         return false;
     }
     
-    /* For now, we'll use the step_event_count from the planner block */
-    /* In a real implementation, this would use kinematics to convert
-     * the target position to steps for each axis */
-    
     /* Initialize all step counts to zero */
     for (uint8_t i = 0; i < HAL_AXIS_MAX; i++) {
         out_steps[i] = 0;
     }
     
-    /* Use the step_event_count and direction_bits from the block */
-    /* This is simplified - real implementation would use kinematics */
-    *out_dir_bits = block->direction_bits;
-    
-    /* Distribute steps across axes based on direction bits */
-    /* This is a simplified approach */
-    if (block->step_event_count > 0) {
-        /* For simplicity, put all steps on X axis if direction bit 0 is set */
-        /* Real implementation would calculate per-axis steps properly */
-        out_steps[HAL_AXIS_X] = block->step_event_count;
+    /* The planner already converted the move into joint (motor) space */
+    for (uint8_t i = 0; i < STEPPER_AXES; i++) {
+        out_steps[i] = block->steps[i];
     }
+    *out_dir_bits = block->direction_bits;
     
     return true;
 }
@@ -66,9 +461,7 @@ static void set_directions(uint8_t dir_bits) {
 
 /* Clear step pulses for all axes */
 static void clear_step_pulses(void) {
-    for (hal_axis_t axis = HAL_AXIS_X; axis < HAL_AXIS_MAX; axis++) {
-        hal_stepper_step_clear(axis);
-    }
+    hal_stepper_clear_mask((1u << HAL_AXIS_MAX) - 1u);
 }
 
 /* ----------------------------- Public API Implementation ----------------------------- */
@@ -83,6 +476,8 @@ void stepper_init(stepper_context_t *ctx, const stepper_config_t *config) {
     
     /* Set initial state */
     ctx->state = STEPPER_IDLE;
+    ctx->spindle_dir = HAL_SPINDLE_OFF;
+    ctx->spindle_override = PLANNER_SPINDLE_OVERRIDE_DEFAULT;
     
     /* Copy configuration */
     if (config) {
@@ -100,6 +495,9 @@ void stepper_init(stepper_context_t *ctx, const stepper_config_t *config) {
     /* Initialize position to zero */
     memset(&ctx->position, 0, sizeof(kin_steps_t));
     
+    /* Hook the step timer ISRs to this context */
+    hal_step_timer_init(stepper_step_isr, stepper_pulse_end_isr, ctx);
+    
     /* Disable motors initially */
     hal_stepper_enable(false);
 }
@@ -110,8 +508,21 @@ void stepper_reset(stepper_context_t *ctx) {
     }
     
     /* Stop any current motion */
+    stop_timer(ctx);
     ctx->state = STEPPER_IDLE;
+    if (ctx->block_from_planner) {
+        planner_discard_current_block(ctx->planner);
+        ctx->block_from_planner = false;
+    }
     ctx->current_block = NULL;
+    ctx->dwell_active = false;
+    ctx->hold_decel = false;
+    
+    /* Drop queued segments */
+    ctx->seg_head = ctx->seg_tail;
+    ctx->seg_steps_left = 0;
+    ctx->prep_steps_remaining = 0;
+    ctx->block_done = false;
     
     /* Clear step counters */
     memset(ctx->step_count, 0, sizeof(ctx->step_count));
@@ -120,8 +531,20 @@ void stepper_reset(stepper_context_t *ctx) {
     /* Reset speed */
     ctx->current_speed = 0.0f;
     
+    if (ctx->laser_block) {
+        laser_apply(ctx, 0.0f);
+        ctx->laser_block = false;
+    }
+    
+    /* Stop a spindle a sync block left running */
+    if (ctx->spindle_dir != HAL_SPINDLE_OFF) {
+        hal_spindle_set(HAL_SPINDLE_OFF, 0.0f);
+        ctx->spindle_dir = HAL_SPINDLE_OFF;
+    }
+    
     /* Clear all step pulses */
     clear_step_pulses();
+    ctx->halted = false;
     
     /* Disable motors if configured */
     if (ctx->config.idle_disable) {
@@ -130,6 +553,44 @@ void stepper_reset(stepper_context_t *ctx) {
     }
 }
 
+/* Sync block: apply its spindle state, then wait in stepper_update() with
+ * the step timer idle. Motion ahead of it has already stopped.
+ */
+static void load_sync_block(stepper_context_t *ctx, planner_block_t *block) {
+    ctx->current_block = block;
+    ctx->current_speed = 0.0f;
+    ctx->laser_block = false;
+    
+    if (block->line_flags & PLANNER_LINE_SPINDLE_SYNC) {
+        hal_spindle_dir_t dir = HAL_SPINDLE_OFF;
+        if (block->line_flags & PLANNER_LINE_SPINDLE_CW) dir = HAL_SPINDLE_CW;
+        if (block->line_flags & PLANNER_LINE_SPINDLE_CCW) dir = HAL_SPINDLE_CCW;
+        float pwm = (dir == HAL_SPINDLE_OFF) ? 0.0f : spindle_pwm_for(ctx, block->spindle_speed);
+        hal_spindle_set(dir, pwm);
+        ctx->spindle_dir = dir;
+        ctx->spindle_speed = block->spindle_speed;
+    }
+    
+    ctx->dwell_active = true;
+    ctx->dwell_left_ms = block->dwell_ms;
+    ctx->dwell_mark_ms = hal_millis();
+    ctx->block_done = false;
+    ctx->state = STEPPER_RUNNING;
+}
+
+/* Count down the dwell; true once it has run out */
+static bool dwell_elapsed(stepper_context_t *ctx) {
+    uint32_t now = hal_millis();
+    uint32_t elapsed = now - ctx->dwell_mark_ms;
+    ctx->dwell_mark_ms = now;
+    if (elapsed >= ctx->dwell_left_ms) {
+        ctx->dwell_left_ms = 0;
+        return true;
+    }
+    ctx->dwell_left_ms -= elapsed;
+    return false;
+}
+
 bool stepper_load_block(stepper_context_t *ctx, planner_block_t *block) {
     if (!ctx || !block) {
         return false;
@@ -145,6 +606,11 @@ bool stepper_load_block(stepper_context_t *ctx, planner_block_t *block) {
         return false;
     }
     
+    if (block->line_flags & PLANNER_LINE_DWELL) {
+        load_sync_block(ctx, block);
+        return true;
+    }
+    
     /* Convert block to step counts */
     uint8_t dir_bits = 0;
     if (!block_to_steps(block, ctx->target_steps, &dir_bits)) {
@@ -157,27 +623,84 @@ bool stepper_load_block(stepper_context_t *ctx, planner_block_t *block) {
     /* Reset step counters */
     memset(ctx->step_count, 0, sizeof(ctx->step_count));
     
-    /* Set direction pins */
+    /* Set direction pins. The first step event fires one full period after
+     * the timer is armed, so the period is floored at dir setup + pulse
+     * width instead of busy-waiting here.
+     */
     set_directions(dir_bits);
     
-    /* Wait for direction setup time */
-    delay_us(ctx->config.dir_setup_us);
+    /* Bresenham setup: the dominant axis steps on every event */
+    uint32_t total_steps = 0;
+    for (uint8_t i = 0; i < STEPPER_AXES; i++) {
+        if (ctx->target_steps[i] > total_steps) total_steps = ctx->target_steps[i];
+    }
+    
+    /* Dominant-axis steps per mm of path; blocks without a length fall
+     * back to 1:1.
+     */
+    ctx->steps_per_mm = 1.0f;
+    if (block->inv_millimeters > 0.0f && total_steps > 0) {
+        ctx->steps_per_mm = (float)total_steps * block->inv_millimeters;
+    }
     
-    /* Calculate initial step interval from entry speed */
-    /* Convert speed from mm/min to steps/s, then to interval in us */
-    if (block->entry_speed > 0.0f) {
-        /* Simplified calculation - assumes 1:1 mm to steps */
-        float steps_per_sec = block->entry_speed / 60.0f;
+    /* Constant-rate step interval from entry speed (used when the block
+     * carries no acceleration, and as the resume period).
+     */
+    ctx->current_speed = (block->entry_speed_sqr > 0.0f) ? sqrtf(block->entry_speed_sqr) : 0.0f;
+    uint32_t step_interval_us = DEFAULT_STEP_INTERVAL_US;
+    if (ctx->current_speed > 0.0f) {
+        float steps_per_sec = ctx->current_speed * ctx->steps_per_mm / 60.0f;
         if (steps_per_sec > 0.0f) {
-            ctx->step_interval_us = (uint32_t)(1000000.0f / steps_per_sec);
+            step_interval_us = (uint32_t)(1000000.0f / steps_per_sec);
+        }
+    }
+    
+    ctx->pulse_ticks = us_to_ticks(ctx->config.step_pulse_us);
+    ctx->step_period_ticks = us_to_ticks(step_interval_us);
+    uint32_t min_period = us_to_ticks(ctx->config.dir_setup_us) + ctx->pulse_ticks + 1u;
+    if (ctx->step_period_ticks < min_period) {
+        ctx->step_period_ticks = min_period;
+    }
+    
+    ctx->laser_block = (block->line_flags & PLANNER_LINE_LASER) != 0;
+    ctx->laser_dir = (block->line_flags & PLANNER_LINE_SPINDLE_CCW) ? HAL_SPINDLE_CCW : HAL_SPINDLE_CW;
+    
+    ctx->step_event_count = total_steps;
+    ctx->amass_event_count = total_steps << STEPPER_MAX_AMASS_LEVEL;
+    ctx->dir_bits = dir_bits;
+    ctx->pulse_mask = 0;
+    for (uint8_t i = 0; i < HAL_AXIS_MAX; i++) {
+        ctx->amass_steps[i] = ctx->target_steps[i] << STEPPER_MAX_AMASS_LEVEL;
+        ctx->axis_increment[i] = ctx->amass_steps[i];
+        ctx->counter[i] = -(int32_t)(ctx->amass_event_count >> 1);
+        ctx->axis_dir[i] = (dir_bits & (1u << i)) ? 1 : -1;
+    }
+    
+    /* Accelerated blocks follow a trapezoid (or S-curve) profile */
+    ctx->timed_profile = (block->acceleration > 0.0f && block->nominal_speed > 0.0f &&
+                          block->millimeters > 0.0f && total_steps > 0);
+    if (ctx->timed_profile) {
+        plan_profile(ctx, block);
+    }
+    
+    /* A feed hold ramp carried over from the previous block goes on here;
+     * a block that cannot ramp parks before its first step
+     */
+    bool park = false;
+    if (ctx->hold_decel) {
+        if (ctx->timed_profile) {
+            plan_stop_from_prep(ctx);
         } else {
-            ctx->step_interval_us = DEFAULT_STEP_INTERVAL_US;
+            ctx->hold_decel = false;
+            park = true;
         }
-    } else {
-        ctx->step_interval_us = DEFAULT_STEP_INTERVAL_US;
     }
     
-    ctx->current_speed = block->entry_speed;
+    /* Queue the first segments for the ISR */
+    ctx->prep_steps_remaining = total_steps;
+    ctx->seg_steps_left = 0;
+    ctx->block_done = (total_steps == 0);
+    prep_segments(ctx);
     
     /* Enable motors if not already enabled */
     if (!ctx->config.motors_enabled) {
@@ -186,18 +709,64 @@ bool stepper_load_block(stepper_context_t *ctx, planner_block_t *block) {
     }
     
     /* Start executing */
-    ctx->state = STEPPER_RUNNING;
-    ctx->last_step_time_us = hal_micros();
+    ctx->state = park ? STEPPER_HOLD : STEPPER_RUNNING;
+    if (!park) {
+        start_timer_if_needed(ctx);
+    }
     
     return true;
 }
 
-void stepper_update(stepper_context_t *ctx) {
+void stepper_attach_planner(stepper_context_t *ctx, planner_queue_t *planner) {
     if (!ctx) {
         return;
     }
     
-    uint32_t now_us = hal_micros();
+    ctx->planner = planner;
+}
+
+/* Pick up a spindle override change. A spindle set by a sync block is re-set
+ * at once; laser segments take it as they are prepped, like feed overrides.
+ */
+static void sync_spindle_override(stepper_context_t *ctx) {
+    uint8_t percent = ctx->planner->spindle_override;
+    if (percent == ctx->spindle_override) {
+        return;
+    }
+    
+    ctx->spindle_override = percent;
+    if (ctx->spindle_dir != HAL_SPINDLE_OFF && !ctx->laser_block) {
+        hal_spindle_set(ctx->spindle_dir, spindle_pwm_for(ctx, ctx->spindle_speed));
+    }
+}
+
+/* Claim the next planner block, if any, and start it */
+static void load_from_planner(stepper_context_t *ctx) {
+    planner_block_t *block = planner_get_current_block(ctx->planner);
+    if (!block) {
+        return;
+    }
+    
+    if (!stepper_load_block(ctx, block)) {
+        /* Unexecutable block: drop it rather than stall the queue */
+        planner_discard_current_block(ctx->planner);
+        return;
+    }
+    ctx->block_from_planner = true;
+}
+
+void stepper_update(stepper_context_t *ctx) {
+    if (!ctx || ctx->halted) {
+        return;  /* emergency stop: wait for stepper_reset() */
+    }
+    PROFILE_ZONE_BEGIN(PROFILE_ZONE_STEPPER_UPDATE);
+    
+    if (ctx->planner) {
+        sync_spindle_override(ctx);
+    }
+    if (ctx->state == STEPPER_IDLE && ctx->planner) {
+        load_from_planner(ctx);
+    }
     
     switch (ctx->state) {
         case STEPPER_IDLE:
@@ -215,45 +784,38 @@ void stepper_update(stepper_context_t *ctx) {
             break;
             
         case STEPPER_RUNNING:
-            /* Check if it's time for the next step */
-            if (now_us - ctx->last_step_time_us >= ctx->step_interval_us) {
-                bool steps_remaining = false;
-                
-                /* Generate step pulses for axes that need them */
-                for (hal_axis_t axis = HAL_AXIS_X; axis < HAL_AXIS_MAX; axis++) {
-                    if (ctx->step_count[axis] < ctx->target_steps[axis]) {
-                        hal_stepper_step_pulse(axis);
-                        ctx->step_count[axis]++;
-                        steps_remaining = true;
-                        
-                        /* Update position */
-                        if (ctx->current_block && 
-                            (ctx->current_block->direction_bits & (1 << axis))) {
-                            ctx->position.v[axis]++;
-                        } else {
-                            ctx->position.v[axis]--;
-                        }
-                    }
+            if (ctx->dwell_active) {
+                if (dwell_elapsed(ctx)) {
+                    finish_block(ctx);
                 }
-                
-                /* Wait for pulse duration */
-                delay_us(ctx->config.step_pulse_us);
-                
-                /* Clear step pulses */
-                clear_step_pulses();
-                
-                /* Update last step time */
-                ctx->last_step_time_us = now_us;
-                
-                /* Check if block is complete */
-                if (!steps_remaining) {
-                    /* Block finished */
-                    ctx->current_block = NULL;
-                    ctx->state = STEPPER_IDLE;
-                    ctx->current_speed = 0.0f;
-                    ctx->idle_start_time_ms = hal_millis();
+                break;
+            }
+            if (ctx->block_done) {
+                /* ISR emitted the last step of the block. A hold ramp that
+                 * outran it continues into the next block at its entry speed.
+                 */
+                bool carry = ctx->hold_decel && ctx->phases[STEPPER_PHASE_DECEL].v_end > 0.0f;
+                stop_timer(ctx);
+                finish_block(ctx);
+                if (carry && ctx->planner) {
+                    ctx->hold_decel = true;
+                    load_from_planner(ctx);
+                    if (ctx->state == STEPPER_IDLE) {
+                        ctx->hold_decel = false;
+                    }
                 }
+                break;
             }
+            if (ctx->hold_decel && ctx->prep_phase >= STEPPER_PHASE_COUNT &&
+                segments_queued(ctx) == 0 && ctx->seg_steps_left == 0) {
+                /* Hold ramp has run out: park */
+                park_hold(ctx);
+                break;
+            }
+            
+            /* Keep the ISR fed; re-arm if it starved */
+            prep_segments(ctx);
+            start_timer_if_needed(ctx);
             break;
             
         case STEPPER_HOLD:
@@ -262,13 +824,105 @@ void stepper_update(stepper_context_t *ctx) {
             
         case STEPPER_STOPPING:
             /* Decelerate and stop */
-            ctx->state = STEPPER_IDLE;
-            ctx->current_block = NULL;
-            ctx->current_speed = 0.0f;
+            stop_timer(ctx);
+            ctx->seg_head = ctx->seg_tail;
+            ctx->seg_steps_left = 0;
+            ctx->prep_steps_remaining = 0;
             clear_step_pulses();
-            ctx->idle_start_time_ms = hal_millis();
+            finish_block(ctx);
             break;
     }
+    PROFILE_ZONE_END(PROFILE_ZONE_STEPPER_UPDATE);
+}
+
+void stepper_set_notify(stepper_context_t *ctx, stepper_notify_cb_t fn, void *user) {
+    if (!ctx) {
+        return;
+    }
+    
+    ctx->notify = fn;
+    ctx->notify_user = user;
+}
+
+/* ----------------------------- ISR entry points ----------------------------- */
+
+void stepper_step_isr(void *user) {
+    stepper_context_t *ctx = (stepper_context_t *)user;
+    if (!ctx) {
+        return;
+    }
+    
+    if (ctx->state != STEPPER_RUNNING || ctx->block_done || ctx->halted) {
+        stop_timer(ctx);
+        return;
+    }
+    PROFILE_ZONE_BEGIN(PROFILE_ZONE_STEP_ISR);
+    PROFILE_STEP_ISR(ctx->step_period_ticks);  /* reloads apply from the next event */
+    
+    /* Load the next segment when the current one is exhausted */
+    if (ctx->seg_steps_left == 0) {
+        if (segments_queued(ctx) == 0) {
+            /* Starved: main loop will re-arm after the next prep */
+            stop_timer(ctx);
+            request_refill(ctx);
+            PROFILE_ZONE_END(PROFILE_ZONE_STEP_ISR);
+            return;
+        }
+        const stepper_segment_t *seg = &ctx->segments[ctx->seg_head & SEGMENT_MASK];
+        ctx->seg_steps_left = seg->n_step;
+        ctx->seg_end_of_block = seg->end_of_block;
+        ctx->step_period_ticks = seg->period_ticks;
+        for (uint8_t i = 0; i < STEPPER_AXES; i++) {
+            ctx->axis_increment[i] = ctx->amass_steps[i] >> seg->amass_level;
+        }
+        hal_step_timer_reload(seg->period_ticks);
+        if (ctx->laser_block) {
+            ctx->laser_seg_pwm = seg->spindle_pwm;
+            laser_apply(ctx, ctx->laser_seg_pwm);
+        }
+        ctx->seg_head++;  /* slot copied out, hand it back to prep */
+        if (segments_queued(ctx) <= STEPPER_SEGMENT_LOW_WATER) {
+            request_refill(ctx);
+        }
+    }
+    
+    /* Distribute this step event across all axes, then raise every
+     * stepping axis with a single port write.
+     */
+    uint32_t mask = 0;
+    for (uint8_t i = 0; i < STEPPER_AXES; i++) {
+        ctx->counter[i] += (int32_t)ctx->axis_increment[i];
+        if (ctx->counter[i] > 0) {
+            ctx->counter[i] -= (int32_t)ctx->amass_event_count;
+            ctx->step_count[i]++;
+            mask |= 1u << i;
+            
+            ctx->position.v[i] += ctx->axis_dir[i];
+        }
+    }
+    if (mask) {
+        hal_stepper_pulse_mask(mask);
+    }
+    ctx->pulse_mask = mask;
+    
+    ctx->seg_steps_left--;
+    if (ctx->seg_steps_left == 0 && ctx->seg_end_of_block) {
+        ctx->block_done = true;
+        request_refill(ctx);
+    }
+    PROFILE_ZONE_END(PROFILE_ZONE_STEP_ISR);
+}
+
+void stepper_pulse_end_isr(void *user) {
+    stepper_context_t *ctx = (stepper_context_t *)user;
+    if (!ctx) {
+        return;
+    }
+    
+    if (ctx->pulse_mask) {
+        hal_stepper_clear_mask(ctx->pulse_mask);
+        ctx->pulse_mask = 0;
+    }
 }
 
 /* ----------------------------- Motion control ----------------------------- */
@@ -301,9 +955,18 @@ void stepper_hold(stepper_context_t *ctx) {
         return;
     }
     
-    if (ctx->state == STEPPER_RUNNING) {
-        ctx->state = STEPPER_HOLD;
+    if (ctx->state != STEPPER_RUNNING || ctx->hold_decel) {
+        return;
     }
+    
+    /* Ramp down when the block has an acceleration and is moving */
+    bool moving = segments_queued(ctx) > 0 || ctx->seg_steps_left > 0;
+    if (ctx->timed_profile && !ctx->dwell_active && !ctx->block_done && moving) {
+        plan_stop_from_prep(ctx);
+        request_refill(ctx);
+        return;
+    }
+    park_hold(ctx);
 }
 
 void stepper_resume(stepper_context_t *ctx) {
@@ -311,9 +974,30 @@ void stepper_resume(stepper_context_t *ctx) {
         return;
     }
     
+    if (ctx->hold_decel) {
+        /* Back up to speed from wherever the ramp got to */
+        float v = prep_speed(ctx);
+        float start = prep_position(ctx);
+        ctx->hold_decel = false;
+        plan_profile_from(ctx, ctx->current_block, v, start);
+        if (ctx->state == STEPPER_RUNNING) {
+            request_refill(ctx);
+        }
+    }
+    
     if (ctx->state == STEPPER_HOLD) {
         ctx->state = STEPPER_RUNNING;
-        ctx->last_step_time_us = hal_micros();
+        if (ctx->timed_profile) {
+            prep_segments(ctx);
+        }
+        if (ctx->dwell_active) {
+            /* Time spent in hold does not count against the dwell */
+            ctx->dwell_mark_ms = hal_millis();
+        }
+        if (ctx->laser_block && ctx->seg_steps_left > 0) {
+            laser_apply(ctx, ctx->laser_seg_pwm);
+        }
+        start_timer_if_needed(ctx);
     }
 }
 
@@ -325,6 +1009,25 @@ void stepper_stop(stepper_context_t *ctx) {
     ctx->state = STEPPER_STOPPING;
 }
 
+void stepper_emergency_stop(stepper_context_t *ctx) {
+    if (!ctx) {
+        return;
+    }
+    
+    /* Flag first: a step ISR already pending sees it and stops itself */
+    ctx->halted = true;
+    stop_timer(ctx);
+    clear_step_pulses();
+    ctx->pulse_mask = 0;
+    hal_spindle_set(HAL_SPINDLE_OFF, 0.0f);
+    ctx->laser_pwm = 0.0f;
+    ctx->spindle_dir = HAL_SPINDLE_OFF;
+}
+
+bool stepper_is_halted(const stepper_context_t *ctx) {
+    return ctx ? ctx->halted : false;
+}
+
 /* ----------------------------- Status queries ----------------------------- */
 
 stepper_state_t stepper_get_state(const stepper_context_t *ctx) {
@@ -361,12 +1064,16 @@ void stepper_get_cart_position(const stepper_context_t *ctx, kin_cart_t *out_car
     }
     
     /* Use kinematics to convert steps to Cartesian coordinates */
+#if GRBL_KINEMATICS_COREXY_INLINE
+    kin_corexy_steps_to_cart(ctx->position.v, out_cart);
+#else
     if (g_kin.steps_to_cart) {
         g_kin.steps_to_cart(&ctx->position, out_cart);
     } else {
         /* Fallback: zero position */
         memset(out_cart, 0, sizeof(kin_cart_t));
     }
+#endif
 }
 
 /* ----------------------------- Configuration ----------------------------- */
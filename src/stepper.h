@@ -11,6 +11,14 @@
  *  - Uses kinematics to convert positions to joint/step space
  *  - Uses HAL functions to control physical stepper motors
  *  - Manages step timing and direction control
+ *
+ * Execution model:
+ *  - The main loop (stepper_update) slices the active block into short
+ *    step segments and pushes them into a small ring buffer.
+ *  - A hardware step timer ISR (stepper_step_isr) pops segments and emits
+ *    one step event per timer period; the pulse is dropped by a second
+ *    compare interrupt (stepper_pulse_end_isr). Nothing in the step path
+ *    blocks, so parsing keeps running while motion executes.
  */
 
 #pragma once
@@ -35,6 +43,84 @@ typedef enum {
     STEPPER_STOPPING,       /* Decelerating to stop */
 } stepper_state_t;
 
+/* Step segment ring depth (power of two, <= 128). */
+#ifndef STEPPER_SEGMENT_BUFFER_SIZE
+#define STEPPER_SEGMENT_BUFFER_SIZE 8u
+#endif
+
+#if (STEPPER_SEGMENT_BUFFER_SIZE & (STEPPER_SEGMENT_BUFFER_SIZE - 1u)) != 0u || \
+    (STEPPER_SEGMENT_BUFFER_SIZE > 128u)
+  #error "STEPPER_SEGMENT_BUFFER_SIZE must be a power of two <= 128"
+#endif
+
+/* Queued segments at or below which the step ISR asks for a refill
+ * (see stepper_set_notify()).
+ */
+#ifndef STEPPER_SEGMENT_LOW_WATER
+#define STEPPER_SEGMENT_LOW_WATER (STEPPER_SEGMENT_BUFFER_SIZE / 2u)
+#endif
+
+/* Max step events packed into a single segment. */
+#ifndef STEPPER_SEGMENT_MAX_STEPS
+#define STEPPER_SEGMENT_MAX_STEPS 64u
+#endif
+
+/* Segment duration for accelerated blocks. The step rate is updated once
+ * per segment, so this is the acceleration update interval.
+ */
+#ifndef STEPPER_SEGMENT_DT_US
+#define STEPPER_SEGMENT_DT_US 10000u
+#endif
+
+/* Adaptive Multi-Axis Step Smoothing: below these dominant-axis step rates
+ * the ISR runs 2^level times faster and the Bresenham counters are scaled
+ * accordingly, so minor axes step at evenly spaced instants.
+ */
+#ifndef STEPPER_MAX_AMASS_LEVEL
+#define STEPPER_MAX_AMASS_LEVEL 3u
+#endif
+
+#ifndef STEPPER_AMASS_LEVEL1_HZ
+#define STEPPER_AMASS_LEVEL1_HZ 8000u  /* level n applies below LEVEL1_HZ >> (n-1) */
+#endif
+
+/* Laser blocks: S value that maps to full PWM when the config leaves
+ * spindle_max_speed at 0 (grbl $30 default).
+ */
+#ifndef STEPPER_SPINDLE_MAX_DEFAULT
+#define STEPPER_SPINDLE_MAX_DEFAULT 1000.0f
+#endif
+
+/* One precomputed slice of a block, executed at a constant step rate. */
+typedef struct {
+    uint32_t period_ticks;        /* Step timer ticks between step events */
+    uint16_t n_step;              /* Step events in this segment */
+    uint8_t  amass_level;         /* ISR events per dominant step = 2^level */
+    bool     end_of_block;        /* Last segment of the current block */
+    float    spindle_pwm;         /* Laser PWM 0..1 (PLANNER_LINE_LASER blocks) */
+} stepper_segment_t;
+
+/* One velocity ramp (or cruise) of a block profile, in steps and seconds. */
+typedef struct {
+    float v_start;                /* Step rate at phase start (steps/s) */
+    float v_end;                  /* Step rate at phase end (steps/s) */
+    float duration;               /* Phase length (s) */
+    float start_pos;              /* Block position where the phase starts (steps) */
+} stepper_phase_t;
+
+typedef enum {
+    STEPPER_PHASE_ACCEL = 0,
+    STEPPER_PHASE_CRUISE,
+    STEPPER_PHASE_DECEL,
+    STEPPER_PHASE_COUNT
+} stepper_phase_id_t;
+
+/* Refill request from the step ISR: the segment ring fell to
+ * STEPPER_SEGMENT_LOW_WATER, ran dry, or the block's last step is out.
+ * Runs in interrupt context; post an event, do not call into the stepper.
+ */
+typedef void (*stepper_notify_cb_t)(void *user);
+
 /* Stepper configuration */
 typedef struct {
     /* Timing parameters */
@@ -48,6 +134,12 @@ typedef struct {
     bool motors_enabled;          /* Motors are enabled */
     bool idle_disable;            /* Disable motors when idle */
     uint32_t idle_timeout_ms;     /* Time before disabling motors when idle */
+    
+    /* Acceleration shaping */
+    bool s_curve;                 /* Smoothstep ramps instead of linear (jerk-limited) */
+    
+    /* Laser mode */
+    float spindle_max_speed;      /* S for full PWM; 0 = STEPPER_SPINDLE_MAX_DEFAULT */
 } stepper_config_t;
 
 /* Current stepper execution context */
@@ -61,20 +153,84 @@ typedef struct {
     /* Current block being executed */
     planner_block_t *current_block;
     
+    /* Planner ring this stepper consumes from (NULL = blocks loaded manually) */
+    planner_queue_t *planner;
+    bool block_from_planner;            /* current_block is claimed in planner */
+    
     /* Step counters for current block */
     uint32_t step_count[HAL_AXIS_MAX];  /* Steps taken per axis */
     uint32_t target_steps[HAL_AXIS_MAX]; /* Target steps per axis */
     
-    /* Current position in steps */
+    /* Bresenham/DDA state: every step event advances all axes together.
+     * Counts are pre-shifted by STEPPER_MAX_AMASS_LEVEL for AMASS.
+     */
+    uint32_t step_event_count;          /* Events in block (max of target_steps) */
+    uint32_t amass_event_count;         /* step_event_count << MAX_AMASS_LEVEL */
+    uint32_t amass_steps[HAL_AXIS_MAX]; /* target_steps << MAX_AMASS_LEVEL */
+    uint32_t axis_increment[HAL_AXIS_MAX]; /* Per-event increment for the segment */
+    int32_t  counter[HAL_AXIS_MAX];     /* Per-axis error accumulators */
+    uint8_t  dir_bits;                  /* Direction bits latched at block load */
+    int8_t   axis_dir[HAL_AXIS_MAX];    /* +1/-1 per axis, from dir_bits */
+    volatile uint32_t pulse_mask;       /* Step pins raised by the last event */
+    
+    /* Current position in steps (updated by the step ISR) */
     kin_steps_t position;
     
-    /* Timing */
-    uint32_t last_step_time_us;   /* Time of last step pulse */
-    uint32_t step_interval_us;    /* Current interval between steps */
+    /* Segment ring: stepper_update() produces, stepper_step_isr() consumes */
+    stepper_segment_t segments[STEPPER_SEGMENT_BUFFER_SIZE];
+    volatile uint8_t seg_head;    /* Next segment for the ISR (free-running) */
+    volatile uint8_t seg_tail;    /* Next free slot for prep (free-running) */
+    uint32_t prep_steps_remaining; /* Block steps not yet packed into segments */
+    
+    /* Acceleration profile (accelerated blocks only) */
+    bool timed_profile;           /* Block runs through the accel/cruise/decel phases */
+    stepper_phase_t phases[STEPPER_PHASE_COUNT];
+    uint8_t prep_phase;           /* Phase the prep cursor is in */
+    float prep_phase_time;        /* Time into that phase (s) */
+    float steps_per_mm;           /* Dominant-axis steps per mm of path */
+    uint32_t accelerate_until;    /* Last step of the accel phase */
+    uint32_t decelerate_after;    /* First step of the decel phase */
+    float profile_nominal;        /* Block nominal speed (mm/min) and exit speed */
+    float profile_exit_sqr;       /* ((mm/min)^2) the phases were built from; a change replans */
+    bool hold_decel;              /* Feed hold ramp planned (set while parked, until resume) */
+    float hold_stop_pos;          /* Block position the ramp ends at (steps) */
+    
+    /* Timing (in step timer ticks) */
+    uint32_t step_period_ticks;   /* Step period for the current block */
+    uint32_t pulse_ticks;         /* Step pulse width */
+    
+    /* ISR execution state */
+    volatile uint16_t seg_steps_left; /* Steps left in the executing segment */
+    volatile bool seg_end_of_block;   /* Executing segment closes the block */
+    volatile bool block_done;         /* Set by ISR when the block's last step is out */
+    volatile bool timer_running;      /* Step timer is armed */
+    volatile bool halted;             /* stepper_emergency_stop(): no steps until reset */
     
     /* Speed tracking */
     float current_speed;          /* Current speed in mm/min */
     
+    /* Laser output (PLANNER_LINE_LASER blocks): the ISR sets the PWM as each
+     * segment starts; it drops to off whenever motion stops.
+     */
+    bool laser_block;             /* Current block drives the spindle PWM */
+    hal_spindle_dir_t laser_dir;  /* Output direction latched at block load */
+    float laser_pwm;              /* PWM last written to the HAL */
+    float laser_seg_pwm;          /* PWM of the executing segment (for resume) */
+    
+    /* Spindle set by the last sync block, re-set when the override changes */
+    hal_spindle_dir_t spindle_dir;
+    float spindle_speed;          /* Programmed S, before the override */
+    uint8_t spindle_override;     /* Percent applied to every S (planner's copy) */
+    
+    /* Sync blocks (PLANNER_LINE_DWELL): timed wait in stepper_update() */
+    bool dwell_active;            /* Current block is a dwell, not a move */
+    uint32_t dwell_left_ms;       /* Wait remaining */
+    uint32_t dwell_mark_ms;       /* hal_millis() when dwell_left_ms was updated */
+    
+    /* Refill request hook (NULL = main loop calls stepper_update() blindly) */
+    stepper_notify_cb_t notify;
+    void *notify_user;
+    
     /* Idle tracking */
     uint32_t idle_start_time_ms;  /* Time when idle state started */
 } stepper_context_t;
@@ -90,9 +246,31 @@ void stepper_reset(stepper_context_t *ctx);
 /* Start executing a new block from the planner */
 bool stepper_load_block(stepper_context_t *ctx, planner_block_t *block);
 
-/* Update stepper state - call frequently from main loop or timer ISR */
+/* Consume blocks directly from a planner ring. stepper_update() then claims
+ * the front block with planner_get_current_block() whenever idle and
+ * discards it once its last step is out. Pass NULL to detach.
+ */
+void stepper_attach_planner(stepper_context_t *ctx, planner_queue_t *planner);
+
+/* Update stepper state - call frequently from main loop.
+ * Refills the segment ring, re-arms the step timer and retires finished blocks.
+ */
 void stepper_update(stepper_context_t *ctx);
 
+/* Install the refill request hook (call after stepper_init(), which clears
+ * it). With a hook, stepper_update() only needs to run when it fires, when
+ * a block is queued, or on a millisecond tick for dwells and idle timeout.
+ */
+void stepper_set_notify(stepper_context_t *ctx, stepper_notify_cb_t fn, void *user);
+
+/* ----------------------------- ISR entry points ----------------------------- */
+
+/* Installed through hal_step_timer_init() by stepper_init(); exposed so a
+ * platform can also wire them to its timer vectors directly. user = ctx.
+ */
+void stepper_step_isr(void *user);
+void stepper_pulse_end_isr(void *user);
+
 /* ----------------------------- Motion control ----------------------------- */
 
 /* Enable/disable stepper motors */
@@ -101,15 +279,30 @@ void stepper_enable_motors(stepper_context_t *ctx, bool enable);
 /* Check if motors are enabled */
 bool stepper_motors_enabled(const stepper_context_t *ctx);
 
-/* Pause motion (feed hold) */
+/* Pause motion (feed hold). Accelerated blocks ramp down to zero at the
+ * block's acceleration, starting after the segments already queued, and
+ * carry the ramp into the next block if this one ends first; the state
+ * turns STEPPER_HOLD once the axes have stopped. Other blocks stop at
+ * once. Use stepper_emergency_stop() for a hard stop.
+ */
 void stepper_hold(stepper_context_t *ctx);
 
-/* Resume motion from hold */
+/* Resume motion from hold (or cancel a ramp still in progress) */
 void stepper_resume(stepper_context_t *ctx);
 
 /* Stop motion immediately */
 void stepper_stop(stepper_context_t *ctx);
 
+/* Hard stop from interrupt context (limit / e-stop ISR): stops the step
+ * timer, drops the step pins and the spindle output, and blocks any
+ * restart until stepper_reset(). Position stays valid (no step is lost
+ * between the ISR's count and the pins).
+ */
+void stepper_emergency_stop(stepper_context_t *ctx);
+
+/* True between stepper_emergency_stop() and stepper_reset() */
+bool stepper_is_halted(const stepper_context_t *ctx);
+
 /* ----------------------------- Status queries ----------------------------- */
 
 /* Get current stepper state */
@@ -2,7 +2,6 @@
 
 #include "system_state.h"
 #include <string.h>
-#include <stdio.h>
 
 /* Default constants if not defined */
 #ifndef GRBL_LINE_QUEUE_DEPTH
@@ -15,14 +14,103 @@
 
 /* ----------------------------- Private helpers ----------------------------- */
 
+/* Binary motion frame: decoded and queued without the G-code parser.
+ * A retry after GCODE_BUSY decodes the held frame again.
+ */
+static gcode_status_t execute_motion_frame(system_context_t *sys, const char *line) {
+    proto_motion_frame_t frame;
+    if (protocol_decode_motion_frame(line, &frame) != PROTO_BIN_OK) {
+        return GCODE_ERR_INVALID_PARAM;
+    }
+    return gcode_execute_deltas(&sys->gcode, frame.dx, frame.dy, frame.count,
+                                1.0f / (float)PROTO_BIN_UNITS_PER_MM, (float)frame.feed,
+                                (frame.flags & PROTO_BIN_FLAG_RAPID) != 0u);
+}
+
+/* Parse an unsigned decimal setting value; false on junk or overflow */
+static bool parse_setting_u8(const char *s, uint8_t *out) {
+    uint32_t v = 0;
+    if (*s == '\0') return false;
+    for (; *s; s++) {
+        if (*s < '0' || *s > '9') return false;
+        v = v * 10u + (uint32_t)(*s - '0');
+        if (v > 255u) return false;
+    }
+    *out = (uint8_t)v;
+    return true;
+}
+
+/* '$' lines. The protocol layer acts on $BIN itself; here it only needs
+ * acknowledging. $10=<mask> selects status report fields. With
+ * GRBL_FEATURE_PROFILE, $P formats the profile report into
+ * sys->profile_report and $P=0 clears the statistics. With
+ * GRBL_FEATURE_CHECK_MODE, $C toggles check mode (from idle only).
+ */
+static gcode_status_t execute_dollar_command(system_context_t *sys, const char *line) {
+    if (strncmp(line, "$BIN=", 5) == 0 && (line[5] == '0' || line[5] == '1') && line[6] == '\0') {
+        return GCODE_OK;
+    }
+    if (strncmp(line, "$10=", 4) == 0) {
+        uint8_t mask;
+        if (!parse_setting_u8(line + 4, &mask) || (mask & (uint8_t)~SYS_REPORT_ALL) != 0u) {
+            return GCODE_ERR_INVALID_PARAM;
+        }
+        system_set_report_mask(sys, mask);
+        return GCODE_OK;
+    }
+#if GRBL_FEATURE_CHECK_MODE
+    if (strcmp(line, "$C") == 0) {
+        system_state_t next = (sys->state == SYS_STATE_CHECK) ? SYS_STATE_IDLE : SYS_STATE_CHECK;
+        return system_set_state(sys, next) ? GCODE_OK : GCODE_ERR_UNSUPPORTED_CMD;
+    }
+#endif
+#if GRBL_FEATURE_PROFILE
+    if (strcmp(line, "$P") == 0) {
+        sys->profile_report_len = (uint16_t)profile_format_report(sys->profile_report,
+                                                                  sizeof(sys->profile_report));
+        return GCODE_OK;
+    }
+    if (strcmp(line, "$P=0") == 0) {
+        profile_reset();
+        return GCODE_OK;
+    }
+#endif
+    if (strncmp(line, "$32=", 4) == 0 && (line[4] == '0' || line[4] == '1') && line[5] == '\0') {
+        gcode_set_laser_mode(&sys->gcode, line[4] == '1');
+        return GCODE_OK;
+    }
+    return GCODE_ERR_UNSUPPORTED_CMD;
+}
+
 /* Protocol line callback - can be used with protocol layer */
 static void on_line_received(const char *line, void *user) {
     system_context_t *sys = (system_context_t *)user;
     
     /* Process G-code line if system is ready */
     if (sys->state == SYS_STATE_IDLE || sys->state == SYS_STATE_RUNNING) {
-        gcode_status_t gcode_st = gcode_process_line(&sys->gcode, line);
+        gcode_status_t gcode_st;
+        if ((uint8_t)line[0] == PROTO_BIN_SOF) {
+            gcode_st = execute_motion_frame(sys, line);
+        } else if (line[0] == '$') {
+            gcode_st = execute_dollar_command(sys, line);
+        } else {
+            gcode_st = gcode_process_line(&sys->gcode, line);
+        }
         
+        if (gcode_st == GCODE_BUSY) {
+            /* Planner full: hold the line (and the "ok") until a slot frees */
+            if (line != sys->pending_line) {
+                strncpy(sys->pending_line, line, PROTOCOL_LINE_MAX);
+                sys->pending_line[PROTOCOL_LINE_MAX] = '\0';
+            }
+            sys->line_pending = true;
+            if (sys->state == SYS_STATE_IDLE) {
+                sys->state = SYS_STATE_RUNNING;
+            }
+            return;
+        }
+        
+        sys->line_pending = false;
         if (gcode_st == GCODE_OK) {
             sys->total_lines_processed++;
             
@@ -36,14 +124,30 @@ static void on_line_received(const char *line, void *user) {
             }
         } else {
             sys->total_errors++;
+            sys->last_error = (uint8_t)gcode_st;
         }
     } else if (sys->state == SYS_STATE_CHECK) {
-        /* In check mode, parse but don't execute */
-        gcode_block_t block;
-        gcode_parse_line(line, &block);
-        sys->total_lines_processed++;
+        /* Same front end, validated against the modal state; gcode check
+         * mode keeps it out of the planner, so a line never waits
+         */
+        gcode_status_t gcode_st;
+        if ((uint8_t)line[0] == PROTO_BIN_SOF) {
+            gcode_st = execute_motion_frame(sys, line);
+        } else if (line[0] == '$') {
+            gcode_st = execute_dollar_command(sys, line);
+        } else {
+            gcode_st = gcode_process_line(&sys->gcode, line);
+        }
+        
+        if (gcode_st == GCODE_OK) {
+            sys->total_lines_processed++;
+        } else {
+            sys->total_errors++;
+            sys->last_error = (uint8_t)gcode_st;
+        }
     } else {
         sys->total_errors++;
+        sys->last_error = SYS_ERR_LOCKED;
     }
 }
 
@@ -53,6 +157,16 @@ void system_process_line(system_context_t *sys, const char *line) {
     on_line_received(line, sys);
 }
 
+bool system_line_pending(const system_context_t *sys) {
+    return sys ? sys->line_pending : false;
+}
+
+/* Drop a held line together with any segments it already queued */
+static void drop_pending_line(system_context_t *sys) {
+    sys->line_pending = false;
+    gcode_cancel_pending(&sys->gcode);
+}
+
 /* ----------------------------- Initialization ----------------------------- */
 
 void system_init(system_context_t *sys) {
@@ -63,8 +177,9 @@ void system_init(system_context_t *sys) {
     /* Initialize subsystems */
     gcode_init(&sys->gcode);
     
-    /* Initialize planner queue with default depth */
-    planner_queue_init(&sys->planner, GRBL_LINE_QUEUE_DEPTH);
+    /* Initialize planner ring (capacity fixed by PLANNER_BUFFER_SIZE) */
+    planner_queue_init(&sys->planner);
+    gcode_attach_planner(&sys->gcode, &sys->planner);
     
     /* Set initial state */
     sys->state = SYS_STATE_IDLE;
@@ -88,19 +203,30 @@ void system_init(system_context_t *sys) {
     /* Initialize statistics */
     sys->total_lines_processed = 0;
     sys->total_errors = 0;
+    sys->last_error = 0;
     sys->uptime_ms = 0;
+    
+    sys->report_mask = SYS_REPORT_MASK_DEFAULT;
 }
 
 void system_reset(system_context_t *sys) {
     if (!sys) return;
     
     /* Reset subsystems */
+    drop_pending_line(sys);
+    gcode_set_check_mode(&sys->gcode, false);
     gcode_reset(&sys->gcode);
     planner_queue_clear(&sys->planner);
+    planner_set_overrides(&sys->planner, PLANNER_FEED_OVERRIDE_DEFAULT, PLANNER_RAPID_OVERRIDE_DEFAULT);
+    
+    /* gcode_reset() returned to the origin; keep the planner in step */
+    kin_cart_t origin = {{ 0.0f, 0.0f, 0.0f }};
+    planner_sync_position(&sys->planner, &origin);
     
     /* Clear alarm and return to idle */
     sys->state = SYS_STATE_IDLE;
     sys->alarm = SYS_ALARM_NONE;
+    sys->alarm_latched = SYS_ALARM_NONE;
     
     /* Keep homing state and position (don't clear on soft reset) */
 }
@@ -114,7 +240,39 @@ void system_poll(system_context_t *sys) {
     /* Poll HAL */
     hal_poll();
     
+    /* Retry a line held back by a full planner */
+    system_retry_pending(sys);
+    
     /* Check for limit switches if enabled */
+    system_check_inputs(sys);
+    
+    /* Update machine position from G-code state */
+    system_sync_position(sys);
+}
+
+bool system_retry_pending(system_context_t *sys) {
+    if (!sys) return false;
+    
+    if (sys->line_pending &&
+        (sys->state == SYS_STATE_IDLE || sys->state == SYS_STATE_RUNNING)) {
+        on_line_received(sys->pending_line, sys);
+    }
+    return sys->line_pending;
+}
+
+void system_check_inputs(system_context_t *sys) {
+    if (!sys) return;
+    
+    system_alarm_t latched = (system_alarm_t)sys->alarm_latched;
+    if (latched != SYS_ALARM_NONE) {
+        sys->alarm_latched = SYS_ALARM_NONE;
+        system_trigger_alarm(sys, latched);
+        return;
+    }
+    
+    /* Edges are reported by interrupt; nothing to poll */
+    if (sys->inputs_irq) return;
+    
     if (sys->limits_enabled && sys->state == SYS_STATE_RUNNING) {
         hal_inputs_t inputs;
         hal_read_inputs(&inputs);
@@ -127,8 +285,11 @@ void system_poll(system_context_t *sys) {
             system_trigger_alarm(sys, SYS_ALARM_ESTOP);
         }
     }
+}
+
+void system_sync_position(system_context_t *sys) {
+    if (!sys) return;
     
-    /* Update machine position from G-code state */
     gcode_get_position(&sys->gcode, &sys->machine_x, &sys->machine_y);
     /* Z axis handling would go here if supported */
 }
@@ -168,11 +329,17 @@ bool system_set_state(system_context_t *sys, system_state_t new_state) {
             /* Most states can transition to idle */
             break;
             
+        case SYS_STATE_CHECK:
+            /* Check mode is entered from idle */
+            if (old_state != SYS_STATE_IDLE && old_state != SYS_STATE_CHECK) return false;
+            break;
+            
         default:
             break;
     }
     
     sys->state = new_state;
+    gcode_set_check_mode(&sys->gcode, new_state == SYS_STATE_CHECK);
     return true;
 }
 
@@ -181,6 +348,7 @@ void system_trigger_alarm(system_context_t *sys, system_alarm_t alarm) {
     
     sys->state = SYS_STATE_ALARM;
     sys->alarm = alarm;
+    gcode_set_check_mode(&sys->gcode, false);
     
     /* Disable motion immediately */
     hal_stepper_enable(false);
@@ -189,9 +357,18 @@ void system_trigger_alarm(system_context_t *sys, system_alarm_t alarm) {
     hal_spindle_set(HAL_SPINDLE_OFF, 0.0f);
     
     /* Clear planner queue */
+    drop_pending_line(sys);
     planner_queue_clear(&sys->planner);
 }
 
+void system_latch_alarm(system_context_t *sys, system_alarm_t alarm) {
+    if (!sys || alarm == SYS_ALARM_NONE) return;
+    
+    if (sys->alarm_latched == SYS_ALARM_NONE) {
+        sys->alarm_latched = (uint8_t)alarm;
+    }
+}
+
 bool system_clear_alarm(system_context_t *sys) {
     if (!sys) return false;
     
@@ -200,6 +377,7 @@ bool system_clear_alarm(system_context_t *sys) {
     }
     
     sys->alarm = SYS_ALARM_NONE;
+    sys->alarm_latched = SYS_ALARM_NONE;  /* bounce latched while in alarm */
     sys->state = SYS_STATE_IDLE;
     
     return true;
@@ -239,40 +417,207 @@ void system_soft_reset(system_context_t *sys) {
     system_reset(sys);
 }
 
+/* Step an override percentage by delta within [lo, hi] */
+static uint8_t step_override(uint8_t value, int delta, uint8_t lo, uint8_t hi) {
+    int v = (int)value + delta;
+    if (v < (int)lo) v = lo;
+    if (v > (int)hi) v = hi;
+    return (uint8_t)v;
+}
+
+void system_realtime_command(system_context_t *sys, proto_rt_cmd_t cmd) {
+    if (!sys) return;
+    
+    uint8_t feed = sys->planner.feed_override;
+    uint8_t rapid = sys->planner.rapid_override;
+    uint8_t spindle = gcode_get_spindle_override(&sys->gcode);
+    
+    switch (cmd) {
+        case PROTO_RT_STATUS_QUERY: system_build_status_report(sys, NULL); return;
+        case PROTO_RT_FEED_HOLD:    system_feed_hold(sys);                 return;
+        case PROTO_RT_CYCLE_START:  system_cycle_start(sys);               return;
+        case PROTO_RT_RESET:        system_soft_reset(sys);                return;
+        case PROTO_RT_ESTOP:        system_trigger_alarm(sys, SYS_ALARM_ESTOP); return;
+        
+        case PROTO_RT_FEED_OVR_RESET:        feed = PLANNER_FEED_OVERRIDE_DEFAULT; break;
+        case PROTO_RT_FEED_OVR_COARSE_PLUS:  feed = step_override(feed, 10, PLANNER_FEED_OVERRIDE_MIN, PLANNER_FEED_OVERRIDE_MAX); break;
+        case PROTO_RT_FEED_OVR_COARSE_MINUS: feed = step_override(feed, -10, PLANNER_FEED_OVERRIDE_MIN, PLANNER_FEED_OVERRIDE_MAX); break;
+        case PROTO_RT_FEED_OVR_FINE_PLUS:    feed = step_override(feed, 1, PLANNER_FEED_OVERRIDE_MIN, PLANNER_FEED_OVERRIDE_MAX); break;
+        case PROTO_RT_FEED_OVR_FINE_MINUS:   feed = step_override(feed, -1, PLANNER_FEED_OVERRIDE_MIN, PLANNER_FEED_OVERRIDE_MAX); break;
+        case PROTO_RT_RAPID_OVR_RESET:       rapid = PLANNER_RAPID_OVERRIDE_DEFAULT; break;
+        case PROTO_RT_RAPID_OVR_MEDIUM:      rapid = PLANNER_RAPID_OVERRIDE_MEDIUM; break;
+        case PROTO_RT_RAPID_OVR_LOW:         rapid = PLANNER_RAPID_OVERRIDE_LOW; break;
+        
+        case PROTO_RT_SPINDLE_OVR_RESET:        spindle = GCODE_SPINDLE_OVERRIDE_DEFAULT; break;
+        case PROTO_RT_SPINDLE_OVR_COARSE_PLUS:  spindle = step_override(spindle, 10, GCODE_SPINDLE_OVERRIDE_MIN, GCODE_SPINDLE_OVERRIDE_MAX); break;
+        case PROTO_RT_SPINDLE_OVR_COARSE_MINUS: spindle = step_override(spindle, -10, GCODE_SPINDLE_OVERRIDE_MIN, GCODE_SPINDLE_OVERRIDE_MAX); break;
+        case PROTO_RT_SPINDLE_OVR_FINE_PLUS:    spindle = step_override(spindle, 1, GCODE_SPINDLE_OVERRIDE_MIN, GCODE_SPINDLE_OVERRIDE_MAX); break;
+        case PROTO_RT_SPINDLE_OVR_FINE_MINUS:   spindle = step_override(spindle, -1, GCODE_SPINDLE_OVERRIDE_MIN, GCODE_SPINDLE_OVERRIDE_MAX); break;
+        
+        default: return;
+    }
+    
+    planner_set_overrides(&sys->planner, feed, rapid);
+    if (spindle != gcode_get_spindle_override(&sys->gcode)) {
+        gcode_set_spindle_override(&sys->gcode, spindle);
+    }
+}
+
 /* ----------------------------- Status reporting ----------------------------- */
 
-size_t system_get_status_report(const system_context_t *sys, char *buf, size_t buf_size) {
-    if (!sys || !buf || buf_size == 0) return 0;
+/* Report writer over a caller buffer. Once a put overflows, ok stays false
+ * and nothing more is written.
+ */
+typedef struct {
+    char *buf;
+    size_t cap;     /* bytes available, NUL included */
+    size_t len;
+    bool ok;
+} report_writer_t;
+
+static void put_bytes(report_writer_t *w, const char *s, size_t n) {
+    if (!w->ok || w->len + n >= w->cap) {
+        w->ok = false;
+        return;
+    }
+    memcpy(w->buf + w->len, s, n);
+    w->len += n;
+}
+
+static void put_str(report_writer_t *w, const char *s) {
+    put_bytes(w, s, strlen(s));
+}
+
+/* v / 10^decimals with exactly `decimals` fraction digits ("-12.345") */
+static void put_fixed(report_writer_t *w, int32_t v, uint8_t decimals) {
+    char tmp[16];
+    size_t i = sizeof(tmp);
+    uint32_t u = (v < 0) ? (uint32_t)0u - (uint32_t)v : (uint32_t)v;
+    uint8_t d = 0;
+    
+    do {
+        tmp[--i] = (char)('0' + (u % 10u));
+        u /= 10u;
+        if (++d == decimals) {
+            tmp[--i] = '.';
+        }
+    } while (u != 0u || d <= decimals);
+    if (v < 0) tmp[--i] = '-';
+    put_bytes(w, tmp + i, sizeof(tmp) - i);
+}
+
+/* Round a float to fixed point, saturating at the int32 range */
+static int32_t to_fixed(float v, float scale) {
+    float f = v * scale;
+    if (f >= 2147483647.0f) return INT32_MAX;
+    if (f <= -2147483647.0f) return -INT32_MAX;
+    return (int32_t)(f + ((f >= 0.0f) ? 0.5f : -0.5f));
+}
+
+static void put_xyz(report_writer_t *w, const char *tag, float x, float y, float z) {
+    put_str(w, tag);
+    put_fixed(w, to_fixed(x, 1000.0f), 3);
+    put_bytes(w, ",", 1);
+    put_fixed(w, to_fixed(y, 1000.0f), 3);
+    put_bytes(w, ",", 1);
+    put_fixed(w, to_fixed(z, 1000.0f), 3);
+}
+
+static size_t write_status_report(const system_context_t *sys, char *buf, size_t buf_size) {
+    report_writer_t w = { buf, buf_size, 0, true };
+    uint8_t mask = sys->report_mask;
     
-    /* Generate grbl-style status report: <state|MPos:x,y,z|WPos:x,y,z|F:feed> */
+    /* grbl-style status report: <state|MPos:x,y,z|WPos:x,y,z|F:feed|S:speed> */
+    put_bytes(&w, "<", 1);
+    put_str(&w, system_state_string(sys->state));
     
-    float wpos_x = sys->machine_x - sys->work_offset_x;
-    float wpos_y = sys->machine_y - sys->work_offset_y;
-    float wpos_z = sys->machine_z - sys->work_offset_z;
+    if (mask & SYS_REPORT_MPOS) {
+        put_xyz(&w, "|MPos:", sys->machine_x, sys->machine_y, sys->machine_z);
+    }
+    if (mask & SYS_REPORT_WPOS) {
+        put_xyz(&w, "|WPos:",
+                sys->machine_x - sys->work_offset_x,
+                sys->machine_y - sys->work_offset_y,
+                sys->machine_z - sys->work_offset_z);
+    }
+    if (mask & SYS_REPORT_FEED) {
+        put_str(&w, "|F:");
+        put_fixed(&w, to_fixed(gcode_get_feedrate(&sys->gcode), 10.0f), 1);
+    }
+    if (mask & SYS_REPORT_SPINDLE) {
+        put_str(&w, "|S:");
+        put_fixed(&w, to_fixed(gcode_get_spindle_speed(&sys->gcode), 1.0f), 0);
+    }
+    if (mask & SYS_REPORT_BUFFER) {
+        put_str(&w, "|Bf:");
+        put_fixed(&w, (int32_t)(PLANNER_BUFFER_SIZE - planner_block_count(&sys->planner)), 0);
+        if (sys->proto) {
+            put_bytes(&w, ",", 1);
+            put_fixed(&w, (int32_t)protocol_rx_free(sys->proto), 0);
+        }
+    }
+    if (mask & SYS_REPORT_LINE_NUMBER) {
+        put_str(&w, "|Ln:");
+        put_fixed(&w, (int32_t)(sys->total_lines_processed & 0x7FFFFFFFu), 0);
+    }
     
-    float feed = gcode_get_feedrate(&sys->gcode);
-    float spindle = gcode_get_spindle_speed(&sys->gcode);
+    if (mask & SYS_REPORT_OVERRIDES) {
+        put_str(&w, "|Ov:");
+        put_fixed(&w, (int32_t)sys->planner.feed_override, 0);
+        put_bytes(&w, ",", 1);
+        put_fixed(&w, (int32_t)sys->planner.rapid_override, 0);
+        put_bytes(&w, ",", 1);
+        put_fixed(&w, (int32_t)gcode_get_spindle_override(&sys->gcode), 0);
+    }
     
-    int written = snprintf(buf, buf_size,
-        "<%s|MPos:%.3f,%.3f,%.3f|WPos:%.3f,%.3f,%.3f|F:%.1f|S:%.0f",
-        system_state_string(sys->state),
-        sys->machine_x, sys->machine_y, sys->machine_z,
-        wpos_x, wpos_y, wpos_z,
-        feed, spindle);
+#if GRBL_FEATURE_PROFILE
+    if (mask & SYS_REPORT_PROFILE) {
+        put_str(&w, "|Pf:");
+        put_fixed(&w, (int32_t)g_profile.hwm[PROFILE_HWM_PLANNER], 0);
+        put_bytes(&w, ",", 1);
+        put_fixed(&w, (int32_t)g_profile.hwm[PROFILE_HWM_RX], 0);
+        put_bytes(&w, ",", 1);
+        put_fixed(&w, (int32_t)(g_profile.jitter_max & 0x7FFFFFFFu), 0);
+    }
+#endif
     
     /* Add alarm code if in alarm state */
-    if (sys->state == SYS_STATE_ALARM && written > 0 && (size_t)written < buf_size) {
-        written += snprintf(buf + written, buf_size - written,
-            "|A:%d", sys->alarm);
+    if (sys->state == SYS_STATE_ALARM) {
+        put_str(&w, "|A:");
+        put_fixed(&w, (int32_t)sys->alarm, 0);
     }
     
     /* Close status report */
-    if (written > 0 && (size_t)written < buf_size) {
-        strncat(buf, ">", buf_size - written - 1);
-        written++;
-    }
+    put_bytes(&w, ">", 1);
     
-    return (written > 0) ? (size_t)written : 0;
+    if (!w.ok) {
+        buf[0] = '\0';
+        return 0;
+    }
+    buf[w.len] = '\0';
+    return w.len;
+}
+
+size_t system_get_status_report(const system_context_t *sys, char *buf, size_t buf_size) {
+    if (!sys || !buf || buf_size == 0) return 0;
+    return write_status_report(sys, buf, buf_size);
+}
+
+const char *system_build_status_report(system_context_t *sys, size_t *len) {
+    if (!sys) return NULL;
+    sys->report_len = (uint16_t)write_status_report(sys, sys->report, sizeof(sys->report));
+    if (len) *len = sys->report_len;
+    return sys->report;
+}
+
+void system_attach_protocol(system_context_t *sys, const protocol_t *proto) {
+    if (!sys) return;
+    sys->proto = proto;
+}
+
+void system_set_report_mask(system_context_t *sys, uint8_t mask) {
+    if (!sys) return;
+    sys->report_mask = (uint8_t)(mask & SYS_REPORT_ALL);
 }
 
 const char *system_state_string(system_state_t state) {
@@ -380,6 +725,22 @@ void system_set_soft_limits_enabled(system_context_t *sys, bool enabled) {
     sys->soft_limits_enabled = enabled;
 }
 
+bool system_inputs_isr(system_context_t *sys, const hal_inputs_t *inputs) {
+    if (!sys || !inputs) return false;
+    
+    system_alarm_t alarm = SYS_ALARM_NONE;
+    if (inputs->estop) {
+        alarm = SYS_ALARM_ESTOP;
+    } else if (sys->limits_enabled && sys->state != SYS_STATE_HOMING &&
+               (inputs->limit_x || inputs->limit_y || inputs->limit_z)) {
+        alarm = SYS_ALARM_HARD_LIMIT;
+    }
+    
+    if (alarm == SYS_ALARM_NONE) return false;
+    system_latch_alarm(sys, alarm);
+    return true;
+}
+
 bool system_check_soft_limits(const system_context_t *sys, float x, float y, float z) {
     if (!sys || !sys->soft_limits_enabled) return true;
     
@@ -19,6 +19,8 @@
 #include "planner.h"
 #include "kinematics.h"
 #include "hal.h"
+#include "protocol.h"
+#include "profile.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -34,7 +36,7 @@ typedef enum {
     SYS_STATE_JOG,              /* Jogging mode */
     SYS_STATE_ALARM,            /* Alarm condition - requires reset */
     SYS_STATE_HOMING,           /* Homing cycle in progress */
-    SYS_STATE_CHECK,            /* Check mode - parse but don't execute */
+    SYS_STATE_CHECK,            /* Check mode - validate lines, queue nothing */
     SYS_STATE_SLEEP,            /* Low power state */
     SYS_STATE_DOOR,             /* Safety door open */
 } system_state_t;
@@ -51,6 +53,49 @@ typedef enum {
     SYS_ALARM_SPINDLE_STALL,    /* Spindle stall detected */
 } system_alarm_t;
 
+/* Line error codes, sent as "error:<code>". Parser failures report their
+ * gcode_status_t value; these follow on after GCODE_BUSY.
+ */
+typedef enum {
+    SYS_ERR_LINE_OVERFLOW = GCODE_BUSY + 1, /* Line longer than PROTOCOL_LINE_MAX */
+    SYS_ERR_BAD_CHAR,           /* Line rejected by the protocol layer */
+    SYS_ERR_LOCKED,             /* State does not take lines (alarm, hold, ...) */
+} system_error_t;
+
+/* ----------------------------- Status report ----------------------------- */
+
+/* Status report fields, selected by system_context_t.report_mask ($10).
+ * State (and A: in alarm) is always reported.
+ */
+#define SYS_REPORT_MPOS         0x01u   /* MPos:x,y,z */
+#define SYS_REPORT_WPOS         0x02u   /* WPos:x,y,z */
+#define SYS_REPORT_FEED         0x04u   /* F:feed */
+#define SYS_REPORT_SPINDLE      0x08u   /* S:speed */
+#define SYS_REPORT_BUFFER       0x10u   /* Bf:free planner blocks,free RX bytes */
+#define SYS_REPORT_LINE_NUMBER  0x20u   /* Ln:lines executed */
+#define SYS_REPORT_OVERRIDES    0x40u   /* Ov:feed,rapid,spindle percent */
+#if GRBL_FEATURE_PROFILE
+#define SYS_REPORT_PROFILE      0x80u   /* Pf:planner hwm,rx hwm,max step jitter */
+#define SYS_REPORT_ALL          0xFFu
+#else
+#define SYS_REPORT_ALL          0x7Fu
+#endif
+
+#ifndef SYS_REPORT_MASK_DEFAULT
+/* Bf: on by default: hosts size their character counting from it */
+#define SYS_REPORT_MASK_DEFAULT (SYS_REPORT_MPOS | SYS_REPORT_WPOS | SYS_REPORT_FEED | \
+                                 SYS_REPORT_SPINDLE | SYS_REPORT_BUFFER)
+#endif
+
+/* Longest report with every field set (int32 positions) fits in here */
+#ifndef SYS_STATUS_REPORT_MAX
+#if GRBL_FEATURE_PROFILE
+#define SYS_STATUS_REPORT_MAX 200u
+#else
+#define SYS_STATUS_REPORT_MAX 168u
+#endif
+#endif
+
 /* ----------------------------- System context structure ----------------------------- */
 
 /* Global system context - contains all subsystem states */
@@ -63,11 +108,19 @@ typedef struct {
     gcode_state_t gcode;        /* G-code parser/executor state */
     planner_queue_t planner;    /* Motion planner queue */
     
+    /* Line held back because the planner was full (GCODE_BUSY) */
+    char pending_line[PROTOCOL_LINE_MAX + 1];
+    bool line_pending;
+    
     /* System flags */
     bool homed;                 /* Machine has been homed */
     bool limits_enabled;        /* Limit switches enabled */
     bool soft_limits_enabled;   /* Software limits enabled */
     bool spindle_enabled;       /* Spindle control enabled */
+    bool inputs_irq;            /* Limit / e-stop edges arrive via system_inputs_isr() */
+    
+    /* Alarm raised in interrupt context, applied by system_check_inputs() */
+    volatile uint8_t alarm_latched;  /* system_alarm_t, SYS_ALARM_NONE if clear */
     
     /* Machine position (in mm) */
     float machine_x;
@@ -82,8 +135,23 @@ typedef struct {
     /* Statistics */
     uint32_t total_lines_processed;
     uint32_t total_errors;
+    uint8_t last_error;         /* gcode_status_t / system_error_t of the last failed line */
     uint32_t uptime_ms;         /* System uptime in milliseconds */
     
+    /* Receive side, for Bf: (NULL: planner blocks only) */
+    const protocol_t *proto;
+    
+    /* Status report: field mask and preallocated TX buffer */
+    uint8_t report_mask;        /* SYS_REPORT_* bits */
+    uint16_t report_len;
+    char report[SYS_STATUS_REPORT_MAX];
+    
+#if GRBL_FEATURE_PROFILE
+    /* "$P" output, sent by the caller ahead of the line's "ok" */
+    uint16_t profile_report_len;
+    char profile_report[PROFILE_REPORT_MAX];
+#endif
+    
 } system_context_t;
 
 /* ----------------------------- Public API ----------------------------- */
@@ -97,9 +165,30 @@ void system_reset(system_context_t *sys);
 /* Main system poll - call frequently from main loop */
 void system_poll(system_context_t *sys);
 
-/* Process a G-code line (called by protocol layer or directly) */
+/* Process a G-code line (called by protocol layer or directly).
+ * If the planner fills up the line is held and retried from system_poll();
+ * the sender's "ok" must wait until system_line_pending() is false.
+ */
 void system_process_line(system_context_t *sys, const char *line);
 
+/* True while a line is waiting for planner space */
+bool system_line_pending(const system_context_t *sys);
+
+/* The steps of system_poll(), for an event-driven loop (see pipeline.h)
+ * that runs each one only when its trigger fired.
+ */
+
+/* Retry the held line if the state allows it; true while still held */
+bool system_retry_pending(system_context_t *sys);
+
+/* Raise an alarm latched from interrupt context, then (unless inputs_irq)
+ * read limit / e-stop inputs (running, limits enabled); alarms on a trip
+ */
+void system_check_inputs(system_context_t *sys);
+
+/* Copy the G-code position into machine_x / machine_y */
+void system_sync_position(system_context_t *sys);
+
 /* ----------------------------- State management ----------------------------- */
 
 /* Get current system state */
@@ -111,6 +200,11 @@ bool system_set_state(system_context_t *sys, system_state_t new_state);
 /* Trigger an alarm condition */
 void system_trigger_alarm(system_context_t *sys, system_alarm_t alarm);
 
+/* ISR-safe: record an alarm for the main loop's system_check_inputs() to
+ * raise. The first alarm latched wins until it has been raised.
+ */
+void system_latch_alarm(system_context_t *sys, system_alarm_t alarm);
+
 /* Clear alarm and return to idle (requires user acknowledgment) */
 bool system_clear_alarm(system_context_t *sys);
 
@@ -131,11 +225,32 @@ void system_cycle_start(system_context_t *sys);
 /* Handle soft reset request (Ctrl-X) */
 void system_soft_reset(system_context_t *sys);
 
+/* Dispatch a realtime command from the protocol layer (usable as the body
+ * of its proto_rt_cb_t). Overrides replan the queued motion in place;
+ * PROTO_RT_STATUS_QUERY builds sys->report for the caller to send.
+ */
+void system_realtime_command(system_context_t *sys, proto_rt_cmd_t cmd);
+
 /* ----------------------------- Status reporting ----------------------------- */
 
-/* Generate status report string (for '?' command) */
+/* Generate status report string (for '?' command).
+ * Fixed-point formatting, no printf. Returns the length written, or 0 (and
+ * an empty string) if the report does not fit; SYS_STATUS_REPORT_MAX
+ * always fits.
+ */
 size_t system_get_status_report(const system_context_t *sys, char *buf, size_t buf_size);
 
+/* Build the status report into sys->report and return it; *len is set to
+ * sys->report_len. Cheap enough to call on every '?' at 10 Hz.
+ */
+const char *system_build_status_report(system_context_t *sys, size_t *len);
+
+/* Report the free bytes of proto's RX ring in Bf: */
+void system_attach_protocol(system_context_t *sys, const protocol_t *proto);
+
+/* Select status report fields (SYS_REPORT_* bits, like grbl's $10) */
+void system_set_report_mask(system_context_t *sys, uint8_t mask);
+
 /* Get state name as string */
 const char *system_state_string(system_state_t state);
 
@@ -169,6 +284,13 @@ void system_set_limits_enabled(system_context_t *sys, bool enabled);
 /* Enable/disable soft limits */
 void system_set_soft_limits_enabled(system_context_t *sys, bool enabled);
 
+/* Input change from the limit / e-stop interrupt (hal_inputs_irq_init()).
+ * E-stop trips in any state; hard limits whenever limits are enabled and
+ * the machine is not homing. Latches the alarm and returns true if motion
+ * must stop now; the caller then halts the step ISR.
+ */
+bool system_inputs_isr(system_context_t *sys, const hal_inputs_t *inputs);
+
 /* Check if a position is within soft limits */
 bool system_check_soft_limits(const system_context_t *sys, float x, float y, float z);
 
@@ -0,0 +1,204 @@
+/* gcode_bench.c - Parser throughput benchmark: fast scanner vs strtof path
+ *
+ * Usage: gcode_bench [file.gcode ...]
+ *
+ * Each line is parsed by gcode_parse_line() and by a reference parser that
+ * keeps the original strtof()/strtol()/toupper() implementation. Every
+ * parsed field must agree to within float rounding; the run then reports
+ * lines per second for both. Without arguments a built-in corpus in the
+ * format emitted by software/svg_parser.py is used.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+#include "../src/gcode.h"
+
+#define BENCH_MAX_LINES 20000
+#define BENCH_LINE_MAX  96
+#define BENCH_ROUNDS    20
+
+static char corpus[BENCH_MAX_LINES][BENCH_LINE_MAX];
+static int corpus_lines = 0;
+
+/* ----------------------------- Reference parser ----------------------------- */
+
+static const char *ref_skip_ws(const char *s) {
+    while (*s && isspace((unsigned char)*s)) s++;
+    return s;
+}
+
+static bool ref_parse_float(const char **ptr, float *out) {
+    char *end;
+    float val = strtof(*ptr, &end);
+    if (end == *ptr) return false;
+    *out = val;
+    *ptr = end;
+    return true;
+}
+
+static bool ref_parse_int(const char **ptr, int *out) {
+    char *end;
+    long val = strtol(*ptr, &end, 10);
+    if (end == *ptr) return false;
+    *out = (int)val;
+    *ptr = end;
+    return true;
+}
+
+static gcode_status_t ref_parse_line(const char *line, gcode_block_t *block) {
+    memset(block, 0, sizeof(*block));
+    block->x = block->y = block->f = block->s = block->p = NAN;
+    block->i = block->j = block->r = NAN;
+    
+    const char *ptr = ref_skip_ws(line);
+    while (*ptr) {
+        ptr = ref_skip_ws(ptr);
+        if (*ptr == '\0') break;
+        
+        char letter = toupper((unsigned char)*ptr);
+        ptr++;
+        
+        float *value = NULL;
+        bool *flag = NULL;
+        switch (letter) {
+            case 'G':
+                if (!ref_parse_int(&ptr, &block->g_code)) return GCODE_ERR_INVALID_PARAM;
+                block->has_g = true;
+                continue;
+            case 'M':
+                if (!ref_parse_int(&ptr, &block->m_code)) return GCODE_ERR_INVALID_PARAM;
+                block->has_m = true;
+                continue;
+            case 'X': value = &block->x; flag = &block->has_x; break;
+            case 'Y': value = &block->y; flag = &block->has_y; break;
+            case 'F': value = &block->f; flag = &block->has_f; break;
+            case 'S': value = &block->s; flag = &block->has_s; break;
+            case 'P': value = &block->p; flag = &block->has_p; break;
+            case 'I': value = &block->i; flag = &block->has_i; break;
+            case 'J': value = &block->j; flag = &block->has_j; break;
+            case 'R': value = &block->r; flag = &block->has_r; break;
+            default:
+                while (*ptr && !isspace((unsigned char)*ptr)) ptr++;
+                continue;
+        }
+        if (!ref_parse_float(&ptr, value)) return GCODE_ERR_INVALID_PARAM;
+        *flag = true;
+    }
+    return GCODE_OK;
+}
+
+/* ----------------------------- Corpus ----------------------------- */
+
+static void add_line(const char *line) {
+    if (corpus_lines >= BENCH_MAX_LINES) return;
+    strncpy(corpus[corpus_lines], line, BENCH_LINE_MAX - 1);
+    corpus[corpus_lines][BENCH_LINE_MAX - 1] = '\0';
+    corpus[corpus_lines][strcspn(corpus[corpus_lines], "\r\n")] = '\0';
+    corpus_lines++;
+}
+
+static void load_file(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "cannot open %s\n", path);
+        exit(2);
+    }
+    char buf[256];
+    while (fgets(buf, sizeof(buf), f)) add_line(buf);
+    fclose(f);
+}
+
+/* Short-segment engraving job in svg_parser.py output format */
+static void build_builtin_corpus(void) {
+    char buf[BENCH_LINE_MAX];
+    add_line("(svg_parser corpus)");
+    add_line("G90");
+    add_line("G0 Z5.000");
+    add_line("M3 S1000");
+    for (int path = 0; path < 40 && corpus_lines < BENCH_MAX_LINES - 8; path++) {
+        float cx = 20.0f + 3.0f * (float)(path % 8);
+        float cy = 20.0f + 4.0f * (float)(path / 8);
+        snprintf(buf, sizeof(buf), "G0 X%.3f Y%.3f F3000.000", cx + 5.0f, cy);
+        add_line(buf);
+        add_line("G1 Z-0.500 F300.000");
+        for (int k = 1; k <= 300; k++) {
+            float a = (float)k * 0.0314159f * (float)(1 + path % 3);
+            float r = 5.0f + 1.5f * sinf(5.0f * a);
+            snprintf(buf, sizeof(buf), "G1 X%.3f Y%.3f F300.000",
+                     cx + r * cosf(a), cy - r * sinf(a));
+            add_line(buf);
+        }
+        snprintf(buf, sizeof(buf), "G2 X%.3f Y%.3f I-2.500 J0.000 F600",
+                 cx, cy);
+        add_line(buf);
+        add_line("G0 Z5.000 F3000.000");
+    }
+    add_line("M5");
+    add_line("G0 X0 Y0");
+}
+
+/* ----------------------------- Comparison ----------------------------- */
+
+static bool same_float(float a, float b) {
+    if (isnan(a) || isnan(b)) return isnan(a) && isnan(b);
+    float tol = 2.0f * 1.1920929e-7f * fmaxf(1.0f, fabsf(b));
+    return fabsf(a - b) <= tol;
+}
+
+static bool same_block(const gcode_block_t *a, const gcode_block_t *b) {
+    return same_float(a->x, b->x) && same_float(a->y, b->y) &&
+           same_float(a->i, b->i) && same_float(a->j, b->j) &&
+           same_float(a->r, b->r) && same_float(a->f, b->f) &&
+           same_float(a->s, b->s) && same_float(a->p, b->p) &&
+           a->has_x == b->has_x && a->has_y == b->has_y &&
+           a->has_i == b->has_i && a->has_j == b->has_j && a->has_r == b->has_r &&
+           a->has_f == b->has_f && a->has_s == b->has_s && a->has_p == b->has_p &&
+           a->has_g == b->has_g && a->has_m == b->has_m &&
+           a->g_code == b->g_code && a->m_code == b->m_code;
+}
+
+static double seconds_for(gcode_status_t (*parse)(const char *, gcode_block_t *)) {
+    gcode_block_t block;
+    volatile float sink = 0.0f;
+    clock_t t0 = clock();
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+        for (int i = 0; i < corpus_lines; i++) {
+            parse(corpus[i], &block);
+            sink += block.x;
+        }
+    }
+    (void)sink;
+    return (double)(clock() - t0) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) load_file(argv[i]);
+    if (corpus_lines == 0) build_builtin_corpus();
+    
+    int mismatches = 0;
+    for (int i = 0; i < corpus_lines; i++) {
+        gcode_block_t fast, ref;
+        gcode_status_t st_fast = gcode_parse_line(corpus[i], &fast);
+        gcode_status_t st_ref = ref_parse_line(corpus[i], &ref);
+        if (st_fast != st_ref || (st_fast == GCODE_OK && !same_block(&fast, &ref))) {
+            if (mismatches < 10) fprintf(stderr, "mismatch: %s\n", corpus[i]);
+            mismatches++;
+        }
+    }
+    
+    double t_fast = seconds_for(gcode_parse_line);
+    double t_ref = seconds_for(ref_parse_line);
+    double n = (double)corpus_lines * BENCH_ROUNDS;
+    
+    printf("corpus: %d lines x %d rounds\n", corpus_lines, BENCH_ROUNDS);
+    printf("gcode_parse_line: %10.0f lines/s\n", t_fast > 0.0 ? n / t_fast : 0.0);
+    printf("strtof reference: %10.0f lines/s\n", t_ref > 0.0 ? n / t_ref : 0.0);
+    if (t_fast > 0.0) printf("speedup:          %10.2fx\n", t_ref / t_fast);
+    printf("mismatches:       %10d\n", mismatches);
+    
+    return mismatches ? 1 : 0;
+}
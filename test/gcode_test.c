@@ -1,10 +1,14 @@
 /* gcode_test.c - Unit tests for gcode parser and executor */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
 #include <string.h>
 #include <math.h>
 #include "../src/gcode.h"
+#include "../src/arc.h"
+#include "../src/kinematics.h"
+#include "../src/planner.h"
 
 /* Helper to check if two floats are approximately equal */
 static int float_equal(float a, float b) {
@@ -487,6 +491,491 @@ void test_2d_engraver_workflow() {
     printf("  [PASSED]\n");
 }
 
+void test_number_scanner() {
+    printf("Testing word number scanner against strtof...\n");
+    
+    static const char *numbers[] = {
+        "0", "-0", "1", "12.5", "-3.25", "+7", ".5", "5.", "-.125",
+        "0.001", "123.456", "-987.654", "3000.000", "0.0000001",
+        "12345678.9", "1234567890123", "3.14159265358979",
+    };
+    char line[64];
+    for (size_t k = 0; k < sizeof(numbers) / sizeof(numbers[0]); k++) {
+        gcode_block_t block;
+        snprintf(line, sizeof(line), "G1 X%s Y1", numbers[k]);
+        assert(gcode_parse_line(line, &block) == GCODE_OK);
+        assert(block.has_x && block.has_y);
+        float ref = strtof(numbers[k], NULL);
+        assert(fabsf(block.x - ref) <= 2.4e-7f * fmaxf(1.0f, fabsf(ref)));
+        assert(block.y == 1.0f);
+    }
+    
+    /* Lower-case letters, tabs and a space between letter and value */
+    gcode_block_t block;
+    assert(gcode_parse_line("g1\tx 2.5 y-1 f300", &block) == GCODE_OK);
+    assert(block.g_code == 1 && block.x == 2.5f && block.y == -1.0f && block.f == 300.0f);
+    
+    /* Malformed numbers are rejected */
+    assert(gcode_parse_line("G1 X.", &block) == GCODE_ERR_INVALID_PARAM);
+    assert(gcode_parse_line("G1 X-", &block) == GCODE_ERR_INVALID_PARAM);
+    assert(gcode_parse_line("G", &block) == GCODE_ERR_INVALID_PARAM);
+    
+    printf("  [PASSED]\n");
+}
+
+/* Records arc segment endpoints and their worst deviation from the circle */
+typedef struct {
+    float cx, cy, r;
+    int count;
+    float max_radial_err;
+    float max_chord_sagitta;
+    float last_x, last_y;
+} arc_probe_t;
+
+static bool arc_probe_cb(float x, float y, void *user) {
+    arc_probe_t *p = (arc_probe_t *)user;
+    float err = fabsf(hypotf(x - p->cx, y - p->cy) - p->r);
+    if (err > p->max_radial_err) p->max_radial_err = err;
+    
+    /* Distance from the chord midpoint to the circle */
+    float mx = 0.5f * (x + p->last_x) - p->cx;
+    float my = 0.5f * (y + p->last_y) - p->cy;
+    float sag = p->r - hypotf(mx, my);
+    if (sag > p->max_chord_sagitta) p->max_chord_sagitta = sag;
+    
+    p->last_x = x;
+    p->last_y = y;
+    p->count++;
+    return true;
+}
+
+void test_arc_chord_tolerance() {
+    printf("Testing arc segmentation follows the chord tolerance...\n");
+    
+    /* Full circles of radius 10 and 1000: 100x the length, ~10x the segments */
+    arc_probe_t small = { 0.0f, 0.0f, 10.0f, 0, 0.0f, 0.0f, 10.0f, 0.0f };
+    assert(arc_generate_ij(10.0f, 0.0f, 10.0f, 0.0f, -10.0f, 0.0f, false,
+                           arc_probe_cb, &small));
+    arc_probe_t large = { 0.0f, 0.0f, 1000.0f, 0, 0.0f, 0.0f, 1000.0f, 0.0f };
+    assert(arc_generate_ij(1000.0f, 0.0f, 1000.0f, 0.0f, -1000.0f, 0.0f, false,
+                           arc_probe_cb, &large));
+    
+    assert(large.count > 5 * small.count);
+    assert(large.count < 20 * small.count);
+    
+    /* Recurrence points stay on the circle and chords stay within tolerance */
+    assert(small.max_radial_err < 1e-4f);
+    assert(large.max_radial_err < 1e-3f * 2.0f);
+    assert(small.max_chord_sagitta < ARC_TOLERANCE_MM * 1.1f);
+    assert(large.max_chord_sagitta < ARC_TOLERANCE_MM * 1.1f + 2e-3f);
+    
+    printf("  [PASSED]\n");
+}
+
+void test_segment_iterators() {
+    printf("Testing batched arc and linear segment iterators...\n");
+    
+    /* Two independent arc iterators: one drained 3 points at a time, one 16 */
+    arc_iter_t a, b;
+    assert(arc_iter_init_ij(&a, 10.0f, 0.0f, 0.0f, 10.0f, -10.0f, 0.0f, false));
+    assert(arc_iter_init_ij(&b, 10.0f, 0.0f, 0.0f, 10.0f, -10.0f, 0.0f, false));
+    
+    kin_cart_t small[3], big[16];
+    size_t total = 0;
+    size_t nb = arc_iter_fill(&b, big, 16);
+    assert(nb == 16);
+    size_t na;
+    kin_cart_t last = {{ 0.0f }};
+    while ((na = arc_iter_fill(&a, small, 3)) > 0) {
+        for (size_t k = 0; k < na; k++, total++) {
+            if (total < nb) {
+                assert(small[k].v[0] == big[total].v[0]);
+                assert(small[k].v[1] == big[total].v[1]);
+            }
+        }
+        last = small[na - 1];
+    }
+    assert(total == a.num_segments);
+    assert(last.v[0] == 0.0f && last.v[1] == 10.0f);
+    assert(arc_iter_fill(&a, small, 3) == 0);
+    
+    /* Linear segmentation lands exactly on the target */
+    kin_segment_iter_t it;
+    kin_cart_t from = {{ 0.0f, 0.0f, 0.0f }};
+    kin_cart_t to = {{ 1.0f, 3.0f, 0.0f }};
+    kinematics_segment_linear_init(&it, &to, &from, 3);
+    kin_cart_t pts[8];
+    assert(kinematics_segment_linear_fill(&it, pts, 2) == 2);
+    assert(float_equal(pts[1].v[1], 2.0f));
+    assert(kinematics_segment_linear_fill(&it, pts, 8) == 1);
+    assert(pts[0].v[0] == 1.0f && pts[0].v[1] == 3.0f);
+    assert(kinematics_segment_linear_fill(&it, pts, 8) == 0);
+    
+    printf("  [PASSED]\n");
+}
+
+/* Cartesian kinematics at 100 steps/mm for the planner-backed tests */
+static bool mock_cart_to_joint(const kin_cart_t *cart, kin_joint_t *out_joint) {
+    memset(out_joint, 0, sizeof(*out_joint));
+    for (unsigned i = 0; i < KIN_MAX_CART_AXES && i < KIN_MAX_JOINT_AXES; i++) {
+        out_joint->v[i] = cart->v[i];
+    }
+    return true;
+}
+
+static bool mock_joint_to_steps(const kin_joint_t *joint, kin_steps_t *out_steps) {
+    for (unsigned i = 0; i < KIN_MAX_JOINT_AXES; i++) {
+        out_steps->v[i] = (int32_t)lroundf(joint->v[i] * 100.0f);
+    }
+    return true;
+}
+
+static void install_mock_kinematics(void) {
+    kin_iface_t impl;
+    memset(&impl, 0, sizeof(impl));
+    impl.cart_axes = 2;
+    impl.joint_axes = 2;
+    impl.cart_to_joint = mock_cart_to_joint;
+    impl.joint_to_steps = mock_joint_to_steps;
+    kinematics_install(&impl);
+}
+
+void test_motion_into_planner() {
+    printf("Testing motion is queued into an attached planner...\n");
+    
+    install_mock_kinematics();
+    
+    planner_queue_t planner;
+    planner_queue_init(&planner);
+    gcode_state_t gc;
+    gcode_init(&gc);
+    gcode_attach_planner(&gc, &planner);
+    
+    assert(gcode_process_line(&gc, "G01 X10 Y0 F300") == GCODE_OK);
+    assert(planner_block_count(&planner) == 1);
+    planner_block_t *block = planner_peek_back(&planner);
+    assert(block->steps[0] == 1000 && block->steps[1] == 0);
+    assert(float_equal(block->millimeters, 10.0f));
+    assert(block->nominal_speed == 300.0f);
+    
+    /* G0 ignores F and runs at the planner's max rate */
+    assert(gcode_process_line(&gc, "G00 X10 Y5") == GCODE_OK);
+    assert(planner_peek_back(&planner)->nominal_speed == planner.settings.max_rate);
+    
+    /* Zero-length moves queue nothing */
+    assert(gcode_process_line(&gc, "G01 X10 Y5") == GCODE_OK);
+    assert(planner_block_count(&planner) == 2);
+    
+    /* Reset keeps the planner attached */
+    gcode_reset(&gc);
+    assert(gc.planner == &planner);
+    
+    printf("  [PASSED]\n");
+}
+
+void test_laser_mode_blocks() {
+    printf("Testing laser mode carries spindle state in planner blocks...\n");
+    
+    install_mock_kinematics();
+    
+    planner_queue_t planner;
+    planner_queue_init(&planner);
+    gcode_state_t gc;
+    gcode_init(&gc);
+    gcode_attach_planner(&gc, &planner);
+    
+    /* Off by default: M3 is a sync block, the move carries no spindle state */
+    assert(!gcode_get_laser_mode(&gc));
+    assert(gcode_process_line(&gc, "G01 X1 F600 M3 S200") == GCODE_OK);
+    assert(planner_block_count(&planner) == 2);
+    assert(planner_peek_back(&planner)->line_flags == 0u);
+    
+    gcode_set_laser_mode(&gc, true);
+    
+    /* S and M on the motion line apply to that stroke */
+    assert(gcode_process_line(&gc, "G01 X2 M4 S300") == GCODE_OK);
+    planner_block_t *block = planner_peek_back(&planner);
+    assert(block->line_flags == (PLANNER_LINE_LASER | PLANNER_LINE_SPINDLE_CCW));
+    assert(block->spindle_speed == 300.0f);
+    
+    /* Power changes between strokes just ride in the next block */
+    assert(gcode_process_line(&gc, "G01 X3 S150") == GCODE_OK);
+    assert(planner_peek_back(&planner)->spindle_speed == 150.0f);
+    assert(planner_block_count(&planner) == 4);
+    
+    /* Rapids and M5 strokes run with the laser off */
+    assert(gcode_process_line(&gc, "G00 X5") == GCODE_OK);
+    assert(planner_peek_back(&planner)->line_flags == (PLANNER_LINE_LASER | PLANNER_LINE_RAPID));
+    assert(gcode_process_line(&gc, "M5") == GCODE_OK);
+    assert(gcode_process_line(&gc, "G01 X6") == GCODE_OK);
+    assert(planner_peek_back(&planner)->line_flags == PLANNER_LINE_LASER);
+    
+    /* Blocks keep the programmed S; the override goes to the stepper */
+    assert(gcode_process_line(&gc, "M3 S400") == GCODE_OK);
+    gcode_set_spindle_override(&gc, 50);
+    assert(planner.spindle_override == 50);
+    assert(gcode_process_line(&gc, "G01 X8") == GCODE_OK);
+    block = planner_peek_back(&planner);
+    assert(block->line_flags == (PLANNER_LINE_LASER | PLANNER_LINE_SPINDLE_CW));
+    assert(block->spindle_speed == 400.0f);
+    
+    /* A setting, not modal state: survives reset */
+    gcode_reset(&gc);
+    assert(gcode_get_laser_mode(&gc));
+    
+    printf("  [PASSED]\n");
+}
+
+void test_dwell_and_spindle_sync() {
+    printf("Testing G4 and spindle changes queue sync blocks...\n");
+    
+    install_mock_kinematics();
+    
+    planner_queue_t planner;
+    planner_queue_init(&planner);
+    gcode_state_t gc;
+    gcode_init(&gc);
+    gcode_attach_planner(&gc, &planner);
+    gc.spindle_spinup_ms = 2000u;
+    
+    /* G4 P is seconds */
+    assert(gcode_process_line(&gc, "G04 P0.25") == GCODE_OK);
+    planner_block_t *block = planner_peek_back(&planner);
+    assert(block->line_flags == PLANNER_LINE_DWELL && block->dwell_ms == 250u);
+    
+    /* Starting the spindle waits out the spin-up, then the move on the line */
+    assert(gcode_process_line(&gc, "G01 X5 F300 M3 S800") == GCODE_OK);
+    assert(planner_block_count(&planner) == 3);
+    block = planner_next_block(&planner, planner_peek_front(&planner));
+    assert(block->line_flags == (PLANNER_LINE_DWELL | PLANNER_LINE_SPINDLE_SYNC | PLANNER_LINE_SPINDLE_CW));
+    assert(block->dwell_ms == 2000u && block->spindle_speed == 800.0f);
+    assert(planner_peek_back(&planner)->steps[0] == 500);
+    
+    /* A new S on a running spindle syncs without the spin-up */
+    assert(gcode_process_line(&gc, "S400") == GCODE_OK);
+    block = planner_peek_back(&planner);
+    assert(block->dwell_ms == 0u && block->spindle_speed == 400.0f);
+    
+    /* M5 and program end switch it off in sequence */
+    assert(gcode_process_line(&gc, "M5") == GCODE_OK);
+    assert(planner_peek_back(&planner)->line_flags == (PLANNER_LINE_DWELL | PLANNER_LINE_SPINDLE_SYNC));
+    assert(gcode_process_line(&gc, "M2") == GCODE_OK);
+    assert(planner_peek_back(&planner)->line_flags == (PLANNER_LINE_DWELL | PLANNER_LINE_SPINDLE_SYNC));
+    assert(planner_block_count(&planner) == 6);
+    
+    /* Negative or missing P */
+    assert(gcode_process_line(&gc, "G04 P-1") == GCODE_ERR_INVALID_PARAM);
+    assert(gcode_process_line(&gc, "G04") == GCODE_ERR_MISSING_PARAM);
+    
+    /* BUSY retry of "M3 + move" does not queue the sync block twice */
+    planner_queue_init(&planner);
+    gcode_init(&gc);
+    gcode_attach_planner(&gc, &planner);
+    while (planner_block_count(&planner) < PLANNER_BUFFER_SIZE - 1u) {
+        assert(gcode_process_line(&gc, "G04 P0") == GCODE_OK);
+    }
+    assert(gcode_process_line(&gc, "G01 X1 F300 M3 S100") == GCODE_BUSY);
+    assert(planner_is_full(&planner));
+    planner_dequeue(&planner);
+    assert(gcode_process_line(&gc, "G01 X1 F300 M3 S100") == GCODE_OK);
+    block = planner_peek_back(&planner);
+    assert(block->steps[0] == 100);
+    block = planner_prev_block(&planner, block);
+    assert(block->line_flags & PLANNER_LINE_SPINDLE_SYNC);
+    assert(!(planner_prev_block(&planner, block)->line_flags & PLANNER_LINE_SPINDLE_SYNC));
+    
+    /* BUSY on the sync block itself leaves the spindle state untouched, so
+     * the retry still waits out the spin-up
+     */
+    planner_queue_init(&planner);
+    gcode_init(&gc);
+    gcode_attach_planner(&gc, &planner);
+    gc.spindle_spinup_ms = 2000u;
+    while (!planner_is_full(&planner)) {
+        assert(gcode_process_line(&gc, "G04 P0") == GCODE_OK);
+    }
+    assert(gcode_process_line(&gc, "M3 S100") == GCODE_BUSY);
+    assert(gc.spindle_state == GCODE_SPINDLE_OFF);
+    planner_dequeue(&planner);
+    assert(gcode_process_line(&gc, "M3 S100") == GCODE_OK);
+    block = planner_peek_back(&planner);
+    assert(block->line_flags == (PLANNER_LINE_DWELL | PLANNER_LINE_SPINDLE_SYNC | PLANNER_LINE_SPINDLE_CW));
+    assert(block->dwell_ms == 2000u);
+    
+    printf("  [PASSED]\n");
+}
+
+void test_motion_planner_busy() {
+    printf("Testing GCODE_BUSY back-pressure and retry...\n");
+    
+    install_mock_kinematics();
+    
+    planner_queue_t planner;
+    planner_queue_init(&planner);
+    gcode_state_t gc;
+    gcode_init(&gc);
+    gcode_attach_planner(&gc, &planner);
+    
+    /* Fill the ring with alternating moves */
+    for (uint32_t i = 0; i < PLANNER_BUFFER_SIZE; i++) {
+        assert(gcode_process_line(&gc, (i & 1u) ? "G01 X0 F300" : "G01 X1 F300") == GCODE_OK);
+    }
+    assert(planner_is_full(&planner));
+    
+    /* The next line is refused and leaves the modal position alone */
+    float x_before = gc.position_x;
+    assert(gcode_process_line(&gc, "G01 Y20") == GCODE_BUSY);
+    assert(float_equal(gc.position_x, x_before));
+    assert(float_equal(gc.position_y, 0.0f));
+    
+    /* Once the stepper frees a slot the same line goes through */
+    planner_dequeue(&planner);
+    assert(gcode_process_line(&gc, "G01 Y20") == GCODE_OK);
+    assert(float_equal(gc.position_y, 20.0f));
+    assert(planner_peek_back(&planner)->steps[1] == 2000);
+    
+    printf("  [PASSED]\n");
+}
+
+void test_arc_planner_resume() {
+    printf("Testing arc resumes after GCODE_BUSY without duplicating segments...\n");
+    
+    install_mock_kinematics();
+    
+    planner_queue_t planner;
+    planner_queue_init(&planner);
+    gcode_state_t gc;
+    gcode_init(&gc);
+    gcode_attach_planner(&gc, &planner);
+    assert(gcode_process_line(&gc, "G00 X10 Y0") == GCODE_OK);
+    
+    /* A quarter circle of radius 10 needs far more segments than the ring holds */
+    const char *arc = "G03 X0 Y10 I-10 J0 F300";
+    uint32_t queued = 0;
+    uint32_t attempts = 0;
+    gcode_status_t status;
+    while ((status = gcode_process_line(&gc, arc)) == GCODE_BUSY) {
+        assert(planner_is_full(&planner));
+        assert(float_equal(gc.position_x, 10.0f));
+        while (!planner_is_empty(&planner)) {
+            planner_block_t *b = planner_peek_front(&planner);
+            assert(b->step_event_count > 0);
+            planner_dequeue(&planner);
+            queued++;
+        }
+        attempts++;
+    }
+    assert(status == GCODE_OK);
+    assert(attempts > 0);
+    queued += planner_block_count(&planner);
+    
+    /* Every segment was queued exactly once and the arc ended on target */
+    assert(queued == gc.segment_index + 1u);  /* plus the G00 drained first */
+    assert(float_equal(planner.position.v[0], 0.0f));
+    assert(float_equal(planner.position.v[1], 10.0f));
+    assert(float_equal(gc.position_x, 0.0f));
+    assert(float_equal(gc.position_y, 10.0f));
+    
+    printf("  [PASSED]\n");
+}
+
+void test_delta_run_into_planner() {
+    printf("Testing binary-frame delta runs bypass the parser...\n");
+    
+    install_mock_kinematics();
+    
+    planner_queue_t planner;
+    planner_queue_init(&planner);
+    gcode_state_t gc;
+    gcode_init(&gc);
+    gcode_attach_planner(&gc, &planner);
+    
+    /* No feed yet: a cutting run is refused, a rapid one is not */
+    const int32_t dx[] = { 1000, 250, -250, 0 };
+    const int32_t dy[] = { 0, 500, 500, -1000 };
+    assert(gcode_execute_deltas(&gc, dx, dy, 4, 0.001f, 0.0f, false) == GCODE_ERR_MISSING_PARAM);
+    assert(planner_block_count(&planner) == 0);
+    
+    assert(gcode_execute_deltas(&gc, dx, dy, 4, 0.001f, 600.0f, false) == GCODE_OK);
+    assert(planner_block_count(&planner) == 4);
+    assert(float_equal(gc.feedrate, 600.0f));
+    assert(float_equal(gc.position_x, 1.0f) && float_equal(gc.position_y, 0.0f));
+    assert(planner_peek_back(&planner)->steps[1] == 100);
+    assert(planner_peek_back(&planner)->nominal_speed == 600.0f);
+    
+    /* Text G-code continues from where the run ended */
+    assert(gcode_process_line(&gc, "G91") == GCODE_OK);
+    assert(gcode_process_line(&gc, "G01 X1") == GCODE_OK);
+    assert(float_equal(gc.position_x, 2.0f));
+    
+    /* A run that fills the ring resumes without duplicating points */
+    static int32_t many_x[PLANNER_BUFFER_SIZE + 4u];
+    static int32_t many_y[PLANNER_BUFFER_SIZE + 4u];
+    const size_t n = PLANNER_BUFFER_SIZE + 4u;
+    for (size_t k = 0; k < n; k++) { many_x[k] = 10; many_y[k] = 0; }
+    assert(gcode_execute_deltas(&gc, many_x, many_y, n, 0.001f, 0.0f, false) == GCODE_BUSY);
+    assert(float_equal(gc.position_x, 2.0f));
+    while (!planner_is_empty(&planner)) planner_dequeue(&planner);
+    assert(gcode_execute_deltas(&gc, many_x, many_y, n, 0.001f, 0.0f, false) == GCODE_OK);
+    assert(float_equal(gc.position_x, 2.0f + 0.01f * (float)n));
+    assert(float_equal(planner.position.v[0], gc.position_x));
+    
+    printf("  [PASSED]\n");
+}
+
+void test_check_mode_queues_nothing() {
+    printf("Testing check mode validates lines without queueing...\n");
+    
+    install_mock_kinematics();
+    
+    planner_queue_t planner;
+    planner_queue_init(&planner);
+    gcode_state_t gc;
+    gcode_init(&gc);
+    gcode_attach_planner(&gc, &planner);
+    
+    assert(gcode_process_line(&gc, "G01 X5 Y0 F300") == GCODE_OK);
+    assert(planner_block_count(&planner) == 1);
+    
+    gcode_set_check_mode(&gc, true);
+    assert(gcode_get_check_mode(&gc));
+    
+    /* Modal state and position advance, the planner sees nothing */
+    assert(gcode_process_line(&gc, "G01 X10 Y10 F600") == GCODE_OK);
+    assert(gcode_process_line(&gc, "G02 X20 Y10 I5 J0") == GCODE_OK);
+    assert(gcode_process_line(&gc, "M03 S1000") == GCODE_OK);
+    assert(gcode_process_line(&gc, "G04 P0.5") == GCODE_OK);
+    const int32_t dx[] = { 100, 100 };
+    const int32_t dy[] = { 0, 100 };
+    assert(gcode_execute_deltas(&gc, dx, dy, 2, 0.01f, 0.0f, false) == GCODE_OK);
+    assert(float_equal(gc.position_x, 22.0f) && float_equal(gc.position_y, 11.0f));
+    assert(float_equal(gc.feedrate, 600.0f));
+    assert(planner_block_count(&planner) == 1);
+    
+    /* Errors are still reported */
+    assert(gcode_process_line(&gc, "G999") == GCODE_ERR_UNSUPPORTED_CMD);
+    assert(gcode_process_line(&gc, "G01 Xabc") == GCODE_ERR_INVALID_PARAM);
+    assert(gcode_process_line(&gc, "G04") == GCODE_ERR_MISSING_PARAM);
+    assert(gcode_process_line(&gc, "G02 X22 Y11") == GCODE_ERR_MISSING_PARAM);
+    assert(gcode_process_line(&gc, "G02 X100 Y11 R1") == GCODE_ERR_INVALID_TARGET);
+    
+    /* M30 leaves the planner position alone */
+    assert(gcode_process_line(&gc, "M30") == GCODE_OK);
+    assert(planner.position.v[0] == 5.0f);
+    
+    /* Leaving resets the modal state and resumes from the planner */
+    gcode_set_check_mode(&gc, false);
+    assert(!gcode_get_check_mode(&gc));
+    assert(!gc.program_complete && !gc.feedrate_set);
+    assert(gcode_get_spindle_state(&gc) == GCODE_SPINDLE_OFF);
+    assert(float_equal(gc.position_x, 5.0f) && float_equal(gc.position_y, 0.0f));
+    assert(gc.planner == &planner);
+    assert(gcode_process_line(&gc, "G01 X6 F300") == GCODE_OK);
+    assert(planner_block_count(&planner) == 2);
+    
+    printf("  [PASSED]\n");
+}
+
 int main() {
     printf("\n=== G-code Parser and Executor Tests ===\n\n");
     
@@ -508,6 +997,16 @@ int main() {
     test_arc_missing_params();
     test_2d_engraver_workflow();
     test_engraver_workflow_with_arcs();
+    test_number_scanner();
+    test_arc_chord_tolerance();
+    test_segment_iterators();
+    test_motion_into_planner();
+    test_laser_mode_blocks();
+    test_dwell_and_spindle_sync();
+    test_motion_planner_busy();
+    test_arc_planner_resume();
+    test_delta_run_into_planner();
+    test_check_mode_queues_nothing();
     
     printf("\n=== All G-code tests passed! ===\n\n");
     return 0;
@@ -0,0 +1,150 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "../src/kin_corexy.h"
+#include "../src/planner.h"
+
+// Reference path: cart -> joint -> steps through the installed vtable
+static void vtable_cart_to_steps(const kin_cart_t *cart, int32_t out_steps[KIN_MAX_JOINT_AXES]) {
+    kin_joint_t joint;
+    kin_steps_t steps;
+    assert(g_kin.cart_to_joint(cart, &joint));
+    assert(g_kin.joint_to_steps(&joint, &steps));
+    memcpy(out_steps, steps.v, sizeof(steps.v));
+}
+
+static const kin_cart_t test_points[] = {
+    {{ 0.0f, 0.0f, 0.0f }},
+    {{ 12.345f, -7.25f, 1.1f }},
+    {{ -150.2f, 88.8f, -3.3f }},
+    {{ 0.0125f, 0.0375f, 0.0f }},
+    {{ 299.9f, 299.9f, 49.95f }},
+};
+
+static void install_with_inversion(unsigned combo) {
+    kin_corexy_cfg_t cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.steps_per_mm[0] = 80.0f;
+    cfg.steps_per_mm[1] = 80.0f;
+    cfg.steps_per_mm[2] = 400.0f;
+    for (unsigned i = 0; i < 3; i++) {
+        cfg.invert_cart[i] = (combo >> i) & 1u;
+        cfg.invert_joint[i] = (combo >> (i + 3)) & 1u;
+    }
+    kin_corexy_install(&cfg);
+}
+
+// Inline forward conversion matches the vtable for every inversion combination
+void test_corexy_inline_matches_vtable() {
+    printf("Testing CoreXY inline cart->steps matches vtable...\n");
+
+    for (unsigned combo = 0; combo < 64; combo++) {
+        install_with_inversion(combo);
+        for (size_t p = 0; p < sizeof(test_points) / sizeof(test_points[0]); p++) {
+            int32_t fast[KIN_MAX_JOINT_AXES];
+            int32_t ref[KIN_MAX_JOINT_AXES];
+            kin_corexy_cart_to_steps(&test_points[p], fast);
+            vtable_cart_to_steps(&test_points[p], ref);
+            for (unsigned i = 0; i < KIN_MAX_JOINT_AXES; i++) {
+                assert(fast[i] == ref[i]);
+            }
+        }
+    }
+
+    printf("[passed]\n");
+}
+
+// steps -> cart inverts the forward mapping (within half a step)
+void test_corexy_steps_to_cart_roundtrip() {
+    printf("Testing CoreXY steps->cart round trip...\n");
+
+    for (unsigned combo = 0; combo < 64; combo++) {
+        install_with_inversion(combo);
+        for (size_t p = 0; p < sizeof(test_points) / sizeof(test_points[0]); p++) {
+            int32_t steps[KIN_MAX_JOINT_AXES];
+            kin_cart_t back;
+            kin_corexy_cart_to_steps(&test_points[p], steps);
+
+            kin_steps_t st;
+            memcpy(st.v, steps, sizeof(st.v));
+            g_kin.steps_to_cart(&st, &back);
+
+            assert(fabsf(back.v[0] - test_points[p].v[0]) <= 1.0f / 80.0f);
+            assert(fabsf(back.v[1] - test_points[p].v[1]) <= 1.0f / 80.0f);
+            assert(fabsf(back.v[2] - test_points[p].v[2]) <= 1.0f / 400.0f);
+        }
+    }
+
+    printf("[passed]\n");
+}
+
+// kin_corexy_set_cfg() refreshes the precomputed constants
+void test_corexy_set_cfg_refresh() {
+    printf("Testing CoreXY set_cfg refreshes fast constants...\n");
+
+    kin_corexy_install(NULL);
+    kin_cart_t p = {{ 10.0f, 5.0f, 2.0f }};
+    int32_t steps[KIN_MAX_JOINT_AXES];
+    kin_corexy_cart_to_steps(&p, steps);
+    assert(steps[0] == 1200 && steps[1] == 400 && steps[2] == 800);
+
+    kin_corexy_cfg_t cfg;
+    kin_corexy_get_cfg(&cfg);
+    cfg.steps_per_mm[0] = 160.0f;
+    cfg.steps_per_mm[2] = 0.0f;
+    cfg.invert_joint[1] = true;
+    kin_corexy_set_cfg(&cfg);
+
+    kin_corexy_cart_to_steps(&p, steps);
+    assert(steps[0] == 2400 && steps[1] == -400 && steps[2] == 0);
+
+    // A joint without steps_per_mm reads back as zero instead of dividing by it
+    kin_cart_t back;
+    kin_corexy_steps_to_cart(steps, &back);
+    assert(fabsf(back.v[0] - 10.0f) < 1e-4f);
+    assert(fabsf(back.v[1] - 5.0f) < 1e-4f);
+    assert(back.v[2] == 0.0f);
+
+    printf("[passed]\n");
+}
+
+// Planner built with GRBL_KINEMATICS_COREXY_INLINE produces the vtable's steps
+void test_corexy_planner_fast_path() {
+    printf("Testing planner step counts on the CoreXY fast path...\n");
+
+    install_with_inversion(0x05);  // invert X and Z cart axes
+
+    planner_queue_t queue;
+    planner_queue_init(&queue);
+
+    int32_t prev[KIN_MAX_JOINT_AXES] = { 0 };
+    for (size_t p = 1; p < sizeof(test_points) / sizeof(test_points[0]); p++) {
+        assert(planner_buffer_line(&queue, &test_points[p], 1200.0f, 0) == PLANNER_LINE_OK);
+        const planner_block_t *block = planner_peek_back(&queue);
+        assert(block != NULL);
+
+        int32_t ref[KIN_MAX_JOINT_AXES];
+        vtable_cart_to_steps(&test_points[p], ref);
+        for (unsigned i = 0; i < KIN_MAX_JOINT_AXES; i++) {
+            const int32_t delta = ref[i] - prev[i];
+            assert(block->steps[i] == (uint32_t)(delta < 0 ? -delta : delta));
+            assert(((block->direction_bits >> i) & 1u) == (delta > 0 ? 1u : 0u) || delta == 0);
+        }
+        memcpy(prev, ref, sizeof(prev));
+    }
+
+    printf("[passed]\n");
+}
+
+int main(void) {
+    printf("Running CoreXY kinematics tests...\n\n");
+
+    test_corexy_inline_matches_vtable();
+    test_corexy_steps_to_cart_roundtrip();
+    test_corexy_set_cfg_refresh();
+    test_corexy_planner_fast_path();
+
+    printf("\nAll CoreXY kinematics tests passed!\n");
+    return 0;
+}
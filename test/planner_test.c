@@ -1,8 +1,30 @@
 #include <assert.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 #include "../src/planner.h"
 
+// Kinematics stand-in: Cartesian == joint space, 100 steps/mm on every joint
+static bool mock_cart_to_joint(const kin_cart_t *cart, kin_joint_t *out_joint) {
+    memset(out_joint, 0, sizeof(*out_joint));
+    for (unsigned i = 0; i < KIN_MAX_CART_AXES && i < KIN_MAX_JOINT_AXES; i++) {
+        out_joint->v[i] = cart->v[i];
+    }
+    return true;
+}
+
+static bool mock_joint_to_steps(const kin_joint_t *joint, kin_steps_t *out_steps) {
+    for (unsigned i = 0; i < KIN_MAX_JOINT_AXES; i++) {
+        out_steps->v[i] = (int32_t)lroundf(joint->v[i] * 100.0f);
+    }
+    return true;
+}
+
+kin_iface_t g_kin = {
+    .cart_to_joint = mock_cart_to_joint,
+    .joint_to_steps = mock_joint_to_steps,
+};
+
 // Test initialization of planner block
 void test_planner_block_init() {
     printf("Testing planner block initialization...\n");
@@ -13,17 +35,19 @@ void test_planner_block_init() {
     planner_block_init(&block);
     
     // Verify all fields are initialized correctly
-    assert(block.entry_speed == 0.0f);
+    assert(block.entry_speed_sqr == 0.0f);
     assert(block.nominal_speed == 0.0f);
-    assert(block.exit_speed == 0.0f);
+    assert(block.exit_speed_sqr == 0.0f);
     assert(block.acceleration == 0.0f);
-    assert(block.max_entry_speed == 0.0f);
+    assert(block.max_entry_speed_sqr == 0.0f);
     assert(block.millimeters == 0.0f);
     assert(block.direction_bits == 0);
     assert(block.step_event_count == 0);
+    for (int i = 0; i < KIN_MAX_JOINT_AXES; i++) {
+        assert(block.steps[i] == 0);
+    }
     assert(block.recalculate_flag == 0);
     assert(block.nominal_length_flag == 0);
-    assert(block.next == NULL);
     
     printf("[passed]\n");
 }
@@ -46,11 +70,11 @@ void test_planner_block_validate_valid() {
     planner_block_init(&block);
     
     // Set valid values
-    block.entry_speed = 100.0f;
+    block.entry_speed_sqr = 100.0f * 100.0f;
     block.nominal_speed = 200.0f;
-    block.exit_speed = 50.0f;
+    block.exit_speed_sqr = 50.0f * 50.0f;
     block.acceleration = 500.0f;
-    block.max_entry_speed = 150.0f;
+    block.max_entry_speed_sqr = 150.0f * 150.0f;
     block.millimeters = 10.0f;
     block.step_event_count = 1000;
     
@@ -67,9 +91,9 @@ void test_planner_block_validate_negative_entry_speed() {
     planner_block_t block;
     planner_block_init(&block);
     
-    block.entry_speed = -10.0f;  // Invalid
+    block.entry_speed_sqr = -100.0f;  // Invalid
     block.nominal_speed = 200.0f;
-    block.exit_speed = 50.0f;
+    block.exit_speed_sqr = 50.0f * 50.0f;
     
     // Should fail validation
     assert(planner_block_validate(&block) == 0);
@@ -84,9 +108,9 @@ void test_planner_block_validate_negative_nominal_speed() {
     planner_block_t block;
     planner_block_init(&block);
     
-    block.entry_speed = 100.0f;
+    block.entry_speed_sqr = 100.0f * 100.0f;
     block.nominal_speed = -200.0f;  // Invalid
-    block.exit_speed = 50.0f;
+    block.exit_speed_sqr = 50.0f * 50.0f;
     
     // Should fail validation
     assert(planner_block_validate(&block) == 0);
@@ -101,9 +125,9 @@ void test_planner_block_validate_negative_exit_speed() {
     planner_block_t block;
     planner_block_init(&block);
     
-    block.entry_speed = 100.0f;
+    block.entry_speed_sqr = 100.0f * 100.0f;
     block.nominal_speed = 200.0f;
-    block.exit_speed = -50.0f;  // Invalid
+    block.exit_speed_sqr = -2500.0f;  // Invalid
     
     // Should fail validation
     assert(planner_block_validate(&block) == 0);
@@ -118,9 +142,9 @@ void test_planner_block_validate_negative_acceleration() {
     planner_block_t block;
     planner_block_init(&block);
     
-    block.entry_speed = 100.0f;
+    block.entry_speed_sqr = 100.0f * 100.0f;
     block.nominal_speed = 200.0f;
-    block.exit_speed = 50.0f;
+    block.exit_speed_sqr = 50.0f * 50.0f;
     block.acceleration = -500.0f;  // Invalid
     
     // Should fail validation
@@ -136,9 +160,9 @@ void test_planner_block_validate_negative_distance() {
     planner_block_t block;
     planner_block_init(&block);
     
-    block.entry_speed = 100.0f;
+    block.entry_speed_sqr = 100.0f * 100.0f;
     block.nominal_speed = 200.0f;
-    block.exit_speed = 50.0f;
+    block.exit_speed_sqr = 50.0f * 50.0f;
     block.millimeters = -10.0f;  // Invalid
     
     // Should fail validation
@@ -154,10 +178,10 @@ void test_planner_block_validate_entry_exceeds_max() {
     planner_block_t block;
     planner_block_init(&block);
     
-    block.entry_speed = 200.0f;  // Exceeds max
-    block.max_entry_speed = 150.0f;
+    block.entry_speed_sqr = 200.0f * 200.0f;  // Exceeds max
+    block.max_entry_speed_sqr = 150.0f * 150.0f;
     block.nominal_speed = 300.0f;
-    block.exit_speed = 50.0f;
+    block.exit_speed_sqr = 50.0f * 50.0f;
     
     // Should fail validation
     assert(planner_block_validate(&block) == 0);
@@ -172,9 +196,9 @@ void test_planner_block_validate_entry_exceeds_nominal() {
     planner_block_t block;
     planner_block_init(&block);
     
-    block.entry_speed = 250.0f;  // Exceeds nominal
+    block.entry_speed_sqr = 250.0f * 250.0f;  // Exceeds nominal
     block.nominal_speed = 200.0f;
-    block.exit_speed = 50.0f;
+    block.exit_speed_sqr = 50.0f * 50.0f;
     
     // Should fail validation
     assert(planner_block_validate(&block) == 0);
@@ -189,9 +213,9 @@ void test_planner_block_validate_exit_exceeds_nominal() {
     planner_block_t block;
     planner_block_init(&block);
     
-    block.entry_speed = 100.0f;
+    block.entry_speed_sqr = 100.0f * 100.0f;
     block.nominal_speed = 200.0f;
-    block.exit_speed = 250.0f;  // Exceeds nominal
+    block.exit_speed_sqr = 250.0f * 250.0f;  // Exceeds nominal
     
     // Should fail validation
     assert(planner_block_validate(&block) == 0);
@@ -206,30 +230,28 @@ void test_planner_block_has_required_fields() {
     planner_block_t block;
     
     // Test that we can access all required fields
-    block.entry_speed = 100.0f;
+    block.entry_speed_sqr = 100.0f * 100.0f;
     block.nominal_speed = 200.0f;
-    block.exit_speed = 50.0f;
+    block.exit_speed_sqr = 50.0f * 50.0f;
     block.acceleration = 500.0f;
-    block.max_entry_speed = 150.0f;
+    block.max_entry_speed_sqr = 150.0f * 150.0f;
     block.millimeters = 10.0f;
     block.direction_bits = 0xFF;
     block.step_event_count = 1000;
     block.recalculate_flag = 1;
     block.nominal_length_flag = 1;
-    block.next = NULL;
     
     // Verify values were set correctly
-    assert(block.entry_speed == 100.0f);
+    assert(block.entry_speed_sqr == 100.0f * 100.0f);
     assert(block.nominal_speed == 200.0f);
-    assert(block.exit_speed == 50.0f);
+    assert(block.exit_speed_sqr == 50.0f * 50.0f);
     assert(block.acceleration == 500.0f);
-    assert(block.max_entry_speed == 150.0f);
+    assert(block.max_entry_speed_sqr == 150.0f * 150.0f);
     assert(block.millimeters == 10.0f);
     assert(block.direction_bits == 0xFF);
     assert(block.step_event_count == 1000);
     assert(block.recalculate_flag == 1);
     assert(block.nominal_length_flag == 1);
-    assert(block.next == NULL);
     
     printf("[passed]\n");
 }
@@ -243,9 +265,9 @@ void test_planner_block_zero_nominal_speed() {
     
     // Zero nominal speed should be valid
     // (validation only checks if entry/exit exceed nominal when nominal > 0)
-    block.entry_speed = 0.0f;
+    block.entry_speed_sqr = 0.0f;
     block.nominal_speed = 0.0f;
-    block.exit_speed = 0.0f;
+    block.exit_speed_sqr = 0.0f;
     block.acceleration = 100.0f;
     
     assert(planner_block_validate(&block) == 1);
@@ -261,9 +283,9 @@ void test_planner_block_complete_stop() {
     planner_block_init(&block);
     
     // All speeds zero should be valid (represents a complete stop)
-    block.entry_speed = 0.0f;
+    block.entry_speed_sqr = 0.0f;
     block.nominal_speed = 0.0f;
-    block.exit_speed = 0.0f;
+    block.exit_speed_sqr = 0.0f;
     
     assert(planner_block_validate(&block) == 1);
     
@@ -277,12 +299,13 @@ void test_planner_queue_init() {
     printf("Testing planner queue initialization...\n");
     
     planner_queue_t queue;
-    planner_queue_init(&queue, 10);
+    planner_queue_init(&queue);
     
-    assert(queue.head == NULL);
-    assert(queue.tail == NULL);
-    assert(queue.size == 0);
-    assert(queue.capacity == 10);
+    assert(queue.head == 0);
+    assert(queue.tail == 0);
+    assert(planner_block_count(&queue) == 0);
+    assert(planner_is_empty(&queue) == 1);
+    assert(planner_is_full(&queue) == 0);
     
     printf("[passed]\n");
 }
@@ -292,16 +315,16 @@ void test_planner_queue_enqueue_single() {
     printf("Testing planner queue enqueue single block...\n");
     
     planner_queue_t queue;
-    planner_queue_init(&queue, 10);
+    planner_queue_init(&queue);
     
     planner_block_t block1;
     planner_block_init(&block1);
     block1.nominal_speed = 100.0f;
     
     assert(planner_enqueue(&queue, &block1) == 1);
-    assert(queue.size == 1);
-    assert(queue.head == &block1);
-    assert(queue.tail == &block1);
+    assert(planner_block_count(&queue) == 1);
+    assert(planner_peek_front(&queue) == planner_peek_back(&queue));
+    assert(planner_peek_front(&queue)->nominal_speed == 100.0f);
     
     printf("[passed]\n");
 }
@@ -311,7 +334,7 @@ void test_planner_queue_enqueue_multiple() {
     printf("Testing planner queue enqueue multiple blocks...\n");
     
     planner_queue_t queue;
-    planner_queue_init(&queue, 10);
+    planner_queue_init(&queue);
     
     planner_block_t block1, block2, block3;
     planner_block_init(&block1);
@@ -326,9 +349,9 @@ void test_planner_queue_enqueue_multiple() {
     assert(planner_enqueue(&queue, &block2) == 1);
     assert(planner_enqueue(&queue, &block3) == 1);
     
-    assert(queue.size == 3);
-    assert(queue.head == &block1);
-    assert(queue.tail == &block3);
+    assert(planner_block_count(&queue) == 3);
+    assert(planner_peek_front(&queue)->nominal_speed == 100.0f);
+    assert(planner_peek_back(&queue)->nominal_speed == 300.0f);
     
     printf("[passed]\n");
 }
@@ -338,7 +361,7 @@ void test_planner_queue_dequeue_single() {
     printf("Testing planner queue dequeue single block...\n");
     
     planner_queue_t queue;
-    planner_queue_init(&queue, 10);
+    planner_queue_init(&queue);
     
     planner_block_t block1;
     planner_block_init(&block1);
@@ -347,11 +370,11 @@ void test_planner_queue_dequeue_single() {
     planner_enqueue(&queue, &block1);
     
     planner_block_t *dequeued = planner_dequeue(&queue);
-    assert(dequeued == &block1);
+    assert(dequeued != NULL);
     assert(dequeued->nominal_speed == 100.0f);
-    assert(queue.size == 0);
-    assert(queue.head == NULL);
-    assert(queue.tail == NULL);
+    assert(planner_block_count(&queue) == 0);
+    assert(planner_peek_front(&queue) == NULL);
+    assert(planner_peek_back(&queue) == NULL);
     
     printf("[passed]\n");
 }
@@ -361,7 +384,7 @@ void test_planner_queue_dequeue_multiple() {
     printf("Testing planner queue dequeue multiple blocks (FIFO)...\n");
     
     planner_queue_t queue;
-    planner_queue_init(&queue, 10);
+    planner_queue_init(&queue);
     
     planner_block_t block1, block2, block3;
     planner_block_init(&block1);
@@ -377,21 +400,17 @@ void test_planner_queue_dequeue_multiple() {
     planner_enqueue(&queue, &block3);
     
     planner_block_t *dequeued1 = planner_dequeue(&queue);
-    assert(dequeued1 == &block1);
     assert(dequeued1->nominal_speed == 100.0f);
-    assert(queue.size == 2);
+    assert(planner_block_count(&queue) == 2);
     
     planner_block_t *dequeued2 = planner_dequeue(&queue);
-    assert(dequeued2 == &block2);
     assert(dequeued2->nominal_speed == 200.0f);
-    assert(queue.size == 1);
+    assert(planner_block_count(&queue) == 1);
     
     planner_block_t *dequeued3 = planner_dequeue(&queue);
-    assert(dequeued3 == &block3);
     assert(dequeued3->nominal_speed == 300.0f);
-    assert(queue.size == 0);
-    assert(queue.head == NULL);
-    assert(queue.tail == NULL);
+    assert(planner_block_count(&queue) == 0);
+    assert(planner_is_empty(&queue) == 1);
     
     printf("[passed]\n");
 }
@@ -401,11 +420,11 @@ void test_planner_queue_dequeue_empty() {
     printf("Testing planner queue dequeue from empty queue...\n");
     
     planner_queue_t queue;
-    planner_queue_init(&queue, 10);
+    planner_queue_init(&queue);
     
     planner_block_t *dequeued = planner_dequeue(&queue);
     assert(dequeued == NULL);
-    assert(queue.size == 0);
+    assert(planner_block_count(&queue) == 0);
     
     printf("[passed]\n");
 }
@@ -415,18 +434,83 @@ void test_planner_queue_enqueue_full() {
     printf("Testing planner queue enqueue when full...\n");
     
     planner_queue_t queue;
-    planner_queue_init(&queue, 2); // Small capacity
+    planner_queue_init(&queue);
     
-    planner_block_t block1, block2, block3;
-    planner_block_init(&block1);
-    planner_block_init(&block2);
-    planner_block_init(&block3);
+    planner_block_t block;
+    planner_block_init(&block);
     
-    assert(planner_enqueue(&queue, &block1) == 1);
-    assert(planner_enqueue(&queue, &block2) == 1);
-    assert(planner_enqueue(&queue, &block3) == 0); // Should fail
+    for (uint32_t i = 0; i < PLANNER_BUFFER_SIZE; i++) {
+        assert(planner_enqueue(&queue, &block) == 1);
+    }
+    assert(planner_is_full(&queue) == 1);
+    assert(planner_enqueue(&queue, &block) == 0); // Should fail
+    assert(planner_get_next_free_block(&queue) == NULL);
+    assert(planner_commit_block(&queue) == 0);
+    
+    assert(planner_block_count(&queue) == PLANNER_BUFFER_SIZE);
+    
+    printf("[passed]\n");
+}
+
+// Test zero-copy slot fill and commit
+void test_planner_queue_free_block_commit() {
+    printf("Testing planner queue free block and commit...\n");
+    
+    planner_queue_t queue;
+    planner_queue_init(&queue);
     
-    assert(queue.size == 2);
+    planner_block_t *slot = planner_get_next_free_block(&queue);
+    assert(slot != NULL);
+    planner_block_init(slot);
+    slot->nominal_speed = 250.0f;
+    
+    // Not visible until committed
+    assert(planner_is_empty(&queue) == 1);
+    assert(planner_get_next_free_block(&queue) == slot);
+    
+    assert(planner_commit_block(&queue) == 1);
+    assert(planner_block_count(&queue) == 1);
+    assert(planner_peek_back(&queue) == slot);
+    assert(planner_get_next_free_block(&queue) != slot);
+    
+    printf("[passed]\n");
+}
+
+// Test the ring wraps and neighbour lookup walks across the wrap point
+void test_planner_queue_wrap_and_iterate() {
+    printf("Testing planner queue wrap-around and iteration...\n");
+    
+    planner_queue_t queue;
+    planner_queue_init(&queue);
+    
+    planner_block_t block;
+    planner_block_init(&block);
+    
+    // Push the indices past the end of the storage array
+    for (uint32_t i = 0; i < PLANNER_BUFFER_SIZE + 3u; i++) {
+        assert(planner_enqueue(&queue, &block) == 1);
+        assert(planner_dequeue(&queue) != NULL);
+    }
+    
+    for (uint32_t i = 0; i < PLANNER_BUFFER_SIZE; i++) {
+        block.nominal_speed = (float)i;
+        assert(planner_enqueue(&queue, &block) == 1);
+    }
+    
+    // Forward walk
+    uint32_t n = 0;
+    for (planner_block_t *b = planner_peek_front(&queue); b != NULL; b = planner_next_block(&queue, b)) {
+        assert(b->nominal_speed == (float)n);
+        n++;
+    }
+    assert(n == PLANNER_BUFFER_SIZE);
+    
+    // Reverse walk
+    for (planner_block_t *b = planner_peek_back(&queue); b != NULL; b = planner_prev_block(&queue, b)) {
+        n--;
+        assert(b->nominal_speed == (float)n);
+    }
+    assert(n == 0);
     
     printf("[passed]\n");
 }
@@ -436,7 +520,7 @@ void test_planner_queue_peek_front() {
     printf("Testing planner queue peek front...\n");
     
     planner_queue_t queue;
-    planner_queue_init(&queue, 10);
+    planner_queue_init(&queue);
     
     planner_block_t block1, block2;
     planner_block_init(&block1);
@@ -449,9 +533,9 @@ void test_planner_queue_peek_front() {
     planner_enqueue(&queue, &block2);
     
     planner_block_t *front = planner_peek_front(&queue);
-    assert(front == &block1);
+    assert(front != NULL);
     assert(front->nominal_speed == 100.0f);
-    assert(queue.size == 2); // Size should not change
+    assert(planner_block_count(&queue) == 2); // Size should not change
     
     printf("[passed]\n");
 }
@@ -461,7 +545,7 @@ void test_planner_queue_peek_back() {
     printf("Testing planner queue peek back...\n");
     
     planner_queue_t queue;
-    planner_queue_init(&queue, 10);
+    planner_queue_init(&queue);
     
     planner_block_t block1, block2;
     planner_block_init(&block1);
@@ -474,9 +558,9 @@ void test_planner_queue_peek_back() {
     planner_enqueue(&queue, &block2);
     
     planner_block_t *back = planner_peek_back(&queue);
-    assert(back == &block2);
+    assert(back != NULL);
     assert(back->nominal_speed == 200.0f);
-    assert(queue.size == 2); // Size should not change
+    assert(planner_block_count(&queue) == 2); // Size should not change
     
     printf("[passed]\n");
 }
@@ -486,7 +570,7 @@ void test_planner_queue_peek_empty() {
     printf("Testing planner queue peek on empty queue...\n");
     
     planner_queue_t queue;
-    planner_queue_init(&queue, 10);
+    planner_queue_init(&queue);
     
     assert(planner_peek_front(&queue) == NULL);
     assert(planner_peek_back(&queue) == NULL);
@@ -499,7 +583,7 @@ void test_planner_is_empty() {
     printf("Testing planner is_empty...\n");
     
     planner_queue_t queue;
-    planner_queue_init(&queue, 10);
+    planner_queue_init(&queue);
     
     assert(planner_is_empty(&queue) == 1);
     
@@ -520,7 +604,7 @@ void test_planner_queue_clear() {
     printf("Testing planner queue clear...\n");
     
     planner_queue_t queue;
-    planner_queue_init(&queue, 10);
+    planner_queue_init(&queue);
     
     planner_block_t block1, block2, block3;
     planner_block_init(&block1);
@@ -531,13 +615,13 @@ void test_planner_queue_clear() {
     planner_enqueue(&queue, &block2);
     planner_enqueue(&queue, &block3);
     
-    assert(queue.size == 3);
+    assert(planner_block_count(&queue) == 3);
     
     planner_queue_clear(&queue);
     
-    assert(queue.size == 0);
-    assert(queue.head == NULL);
-    assert(queue.tail == NULL);
+    assert(planner_block_count(&queue) == 0);
+    assert(planner_peek_front(&queue) == NULL);
+    assert(planner_peek_back(&queue) == NULL);
     assert(planner_is_empty(&queue) == 1);
     
     printf("[passed]\n");
@@ -548,13 +632,12 @@ void test_planner_queue_clear_empty() {
     printf("Testing planner queue clear on empty queue...\n");
     
     planner_queue_t queue;
-    planner_queue_init(&queue, 10);
+    planner_queue_init(&queue);
     
     planner_queue_clear(&queue);
     
-    assert(queue.size == 0);
-    assert(queue.head == NULL);
-    assert(queue.tail == NULL);
+    assert(planner_block_count(&queue) == 0);
+    assert(planner_is_empty(&queue) == 1);
     
     printf("[passed]\n");
 }
@@ -564,19 +647,20 @@ void test_planner_queue_enqueue_after_clear() {
     printf("Testing planner queue enqueue after clear...\n");
     
     planner_queue_t queue;
-    planner_queue_init(&queue, 10);
+    planner_queue_init(&queue);
     
     planner_block_t block1, block2;
     planner_block_init(&block1);
     planner_block_init(&block2);
+    block2.nominal_speed = 200.0f;
     
     planner_enqueue(&queue, &block1);
     planner_queue_clear(&queue);
     
     assert(planner_enqueue(&queue, &block2) == 1);
-    assert(queue.size == 1);
-    assert(queue.head == &block2);
-    assert(queue.tail == &block2);
+    assert(planner_block_count(&queue) == 1);
+    assert(planner_peek_front(&queue) == planner_peek_back(&queue));
+    assert(planner_peek_front(&queue)->nominal_speed == 200.0f);
     
     printf("[passed]\n");
 }
@@ -589,21 +673,490 @@ void test_planner_queue_null_parameters() {
     planner_block_t block;
     
     // NULL queue
-    planner_queue_init(NULL, 10);
+    planner_queue_init(NULL);
     assert(planner_enqueue(NULL, &block) == 0);
     assert(planner_dequeue(NULL) == NULL);
     assert(planner_peek_front(NULL) == NULL);
     assert(planner_peek_back(NULL) == NULL);
     assert(planner_is_empty(NULL) == 1);
+    assert(planner_get_next_free_block(NULL) == NULL);
+    assert(planner_commit_block(NULL) == 0);
+    assert(planner_next_block(NULL, &block) == NULL);
+    assert(planner_prev_block(NULL, &block) == NULL);
     planner_queue_clear(NULL);
     
     // NULL block with valid queue
-    planner_queue_init(&queue, 10);
+    planner_queue_init(&queue);
     assert(planner_enqueue(&queue, NULL) == 0);
     
     printf("[passed]\n");
 }
 
+// ----------------------------- Look-ahead planning tests -----------------------------
+
+// Build a unit-direction XY move for planning tests
+static void make_line(planner_block_t *block, float ux, float uy, float mm, float nominal) {
+    planner_block_init(block);
+    block->unit_vec[0] = ux;
+    block->unit_vec[1] = uy;
+    block->millimeters = mm;
+    block->nominal_speed = nominal;
+    block->acceleration = 1000000.0f; // mm/min^2
+}
+
+// Test that collinear blocks run through their junctions at nominal speed
+void test_planner_plan_collinear() {
+    printf("Testing planner look-ahead with collinear blocks...\n");
+    
+    planner_queue_t queue;
+    planner_block_t *blocks[3];
+    kin_motion_hint_t hint = {0};
+    hint.junction_dev_mm = 0.01f;
+    planner_queue_init(&queue);
+    
+    for (int i = 0; i < 3; i++) {
+        blocks[i] = planner_get_next_free_block(&queue);
+        make_line(blocks[i], 1.0f, 0.0f, 10.0f, 600.0f);
+        assert(planner_plan_block(&queue, blocks[i], &hint) == 1);
+    }
+    
+    assert(blocks[0]->entry_speed_sqr == 0.0f);      // Starts from rest
+    assert(blocks[0]->exit_speed_sqr == 600.0f * 600.0f);
+    assert(blocks[1]->entry_speed_sqr == 600.0f * 600.0f);
+    assert(blocks[2]->entry_speed_sqr == 600.0f * 600.0f);
+    assert(blocks[2]->exit_speed_sqr == 0.0f);       // Plans to stop at the end
+    
+    printf("[passed]\n");
+}
+
+// Test that a right-angle corner is limited by junction deviation
+void test_planner_plan_corner() {
+    printf("Testing planner look-ahead with a 90 degree corner...\n");
+    
+    planner_queue_t queue;
+    planner_block_t *blocks[2];
+    kin_motion_hint_t hint = {0};
+    hint.junction_dev_mm = 0.01f;
+    planner_queue_init(&queue);
+    
+    blocks[0] = planner_get_next_free_block(&queue);
+    make_line(blocks[0], 1.0f, 0.0f, 10.0f, 600.0f);
+    assert(planner_plan_block(&queue, blocks[0], &hint) == 1);
+    blocks[1] = planner_get_next_free_block(&queue);
+    make_line(blocks[1], 0.0f, 1.0f, 10.0f, 600.0f);
+    assert(planner_plan_block(&queue, blocks[1], &hint) == 1);
+    
+    float v_junction = sqrtf(planner_junction_speed_sqr(blocks[0], blocks[1], hint.junction_dev_mm));
+    assert(v_junction > 0.0f && v_junction < 600.0f);
+    assert(fabsf(sqrtf(blocks[1]->entry_speed_sqr) - v_junction) < 0.01f);
+    assert(blocks[0]->exit_speed_sqr == blocks[1]->entry_speed_sqr);
+    
+    printf("[passed]\n");
+}
+
+// Test that a full reversal forces a stop at the junction
+void test_planner_plan_reversal() {
+    printf("Testing planner look-ahead with a direction reversal...\n");
+    
+    planner_queue_t queue;
+    planner_block_t *blocks[3];
+    kin_motion_hint_t hint = {0};
+    hint.junction_dev_mm = 0.01f;
+    planner_queue_init(&queue);
+    
+    const float dir_x[3] = {1.0f, -1.0f, -1.0f};
+    for (int i = 0; i < 3; i++) {
+        blocks[i] = planner_get_next_free_block(&queue);
+        make_line(blocks[i], dir_x[i], 0.0f, 10.0f, 600.0f);
+        assert(planner_plan_block(&queue, blocks[i], &hint) == 1);
+    }
+    
+    assert(blocks[1]->entry_speed_sqr == 0.0f);
+    assert(blocks[0]->exit_speed_sqr == 0.0f);
+    assert(blocks[2]->entry_speed_sqr == 600.0f * 600.0f);
+    
+    printf("[passed]\n");
+}
+
+// Test that short blocks ramp: entry limited by what the previous block can reach
+void test_planner_plan_short_blocks() {
+    printf("Testing planner look-ahead with short blocks...\n");
+    
+    planner_queue_t queue;
+    planner_block_t *blocks[4];
+    kin_motion_hint_t hint = {0};
+    hint.junction_dev_mm = 0.01f;
+    planner_queue_init(&queue);
+    
+    // 0.01 mm at 1e6 mm/min^2 reaches ~141 mm/min per block
+    for (int i = 0; i < 4; i++) {
+        blocks[i] = planner_get_next_free_block(&queue);
+        make_line(blocks[i], 1.0f, 0.0f, 0.01f, 6000.0f);
+        assert(planner_plan_block(&queue, blocks[i], &hint) == 1);
+    }
+    
+    for (int i = 0; i < 4; i++) {
+        planner_block_t *b = blocks[i];
+        assert(b->recalculate_flag == 0);
+        assert(planner_block_validate(b) == 1);
+        if (i < 3) {
+            assert(b->exit_speed_sqr == blocks[i + 1]->entry_speed_sqr);
+            // Never faster than accelerating / decelerating over the block allows
+            float dv2 = b->exit_speed_sqr - b->entry_speed_sqr;
+            assert(fabsf(dv2) <= 2.0f * b->acceleration * b->millimeters * 1.001f);
+        }
+    }
+    assert(blocks[1]->entry_speed_sqr > 0.0f);
+    assert(blocks[1]->entry_speed_sqr < 6000.0f * 6000.0f);
+    
+    printf("[passed]\n");
+}
+
+// Test that the block claimed by the stepper is left alone by replanning
+void test_planner_plan_claimed_block() {
+    printf("Testing planner look-ahead skips the executing block...\n");
+    
+    planner_queue_t queue;
+    planner_block_t *blocks[3];
+    kin_motion_hint_t hint = {0};
+    hint.junction_dev_mm = 0.01f;
+    planner_queue_init(&queue);
+    
+    blocks[0] = planner_get_next_free_block(&queue);
+    make_line(blocks[0], 1.0f, 0.0f, 10.0f, 600.0f);
+    assert(planner_plan_block(&queue, blocks[0], &hint) == 1);
+    
+    // Stepper takes the only block: it is planned to stop at its end
+    assert(planner_get_current_block(&queue) == blocks[0]);
+    assert(queue.current_in_use == 1);
+    planner_block_t running = *blocks[0];
+    
+    // A collinear follow-up would normally raise the junction speed
+    for (int i = 1; i < 3; i++) {
+        blocks[i] = planner_get_next_free_block(&queue);
+        make_line(blocks[i], 1.0f, 0.0f, 10.0f, 600.0f);
+        assert(planner_plan_block(&queue, blocks[i], &hint) == 1);
+    }
+    
+    assert(memcmp(blocks[0], &running, sizeof(running)) == 0);
+    assert(blocks[1]->entry_speed_sqr == blocks[0]->exit_speed_sqr);
+    assert(blocks[1]->entry_speed_sqr == 0.0f);
+    assert(blocks[2]->entry_speed_sqr == 600.0f * 600.0f);
+    
+    // Releasing the slot makes the next block the front of the queue
+    planner_discard_current_block(&queue);
+    assert(queue.current_in_use == 0);
+    assert(planner_peek_front(&queue) == blocks[1]);
+    assert(planner_block_count(&queue) == 2);
+    
+    // Claiming from an empty queue yields nothing
+    planner_queue_clear(&queue);
+    assert(planner_get_current_block(&queue) == NULL);
+    assert(queue.current_in_use == 0);
+    
+    printf("[passed]\n");
+}
+
+// Test that degenerate input is rejected
+void test_planner_plan_invalid() {
+    printf("Testing planner look-ahead rejects invalid blocks...\n");
+    
+    planner_queue_t queue;
+    planner_block_t block;
+    planner_queue_init(&queue);
+    
+    make_line(&block, 1.0f, 0.0f, 0.0f, 600.0f);
+    assert(planner_plan_block(&queue, &block, NULL) == 0);
+    assert(planner_plan_block(NULL, &block, NULL) == 0);
+    assert(planner_plan_block(&queue, NULL, NULL) == 0);
+    assert(planner_is_empty(&queue) == 1);
+    
+    printf("[passed]\n");
+}
+
+// Test that a Cartesian target is turned into a planned block in place
+void test_planner_buffer_line() {
+    printf("Testing planner_buffer_line builds blocks in the ring...\n");
+    
+    planner_queue_t queue;
+    planner_queue_init(&queue);
+    assert(queue.settings.max_rate == PLANNER_DEFAULT_MAX_RATE);
+    
+    kin_cart_t target = {{ 3.0f, -4.0f, 0.0f }};
+    planner_block_t *slot = planner_get_next_free_block(&queue);
+    assert(planner_buffer_line(&queue, &target, 600.0f, 0) == PLANNER_LINE_OK);
+    assert(planner_block_count(&queue) == 1);
+    
+    // Built directly in the slot that was free before the call
+    planner_block_t *block = planner_peek_back(&queue);
+    assert(block == slot);
+    assert(fabsf(block->millimeters - 5.0f) < 1e-5f);
+    assert(fabsf(block->unit_vec[0] - 0.6f) < 1e-6f);
+    assert(fabsf(block->unit_vec[1] + 0.8f) < 1e-6f);
+    assert(block->steps[0] == 300 && block->steps[1] == 400);
+    assert(block->direction_bits == 0x01);  // +X, -Y
+    assert(block->step_event_count == 400);
+    assert(block->nominal_speed == 600.0f);
+    assert(block->acceleration == PLANNER_DEFAULT_ACCELERATION);
+    assert(block->entry_speed_sqr == 0.0f);
+    
+    // Planned position follows the queued target
+    assert(queue.position.v[0] == 3.0f && queue.position_steps[1] == -400);
+    
+    // Rapids run at max_rate, feeds are clamped to it
+    kin_cart_t next = {{ 3.0f, 0.0f, 0.0f }};
+    assert(planner_buffer_line(&queue, &next, 0.0f, PLANNER_LINE_RAPID) == PLANNER_LINE_OK);
+    assert(planner_peek_back(&queue)->nominal_speed == queue.settings.max_rate);
+    next.v[0] = 10.0f;
+    assert(planner_buffer_line(&queue, &next, 1e6f, 0) == PLANNER_LINE_OK);
+    assert(planner_peek_back(&queue)->nominal_speed == queue.settings.max_rate);
+    
+    // Sub-step moves queue nothing; a zero feed is an error
+    next.v[0] += 0.001f;
+    assert(planner_buffer_line(&queue, &next, 600.0f, 0) == PLANNER_LINE_EMPTY);
+    next.v[0] = 20.0f;
+    assert(planner_buffer_line(&queue, &next, 0.0f, 0) == PLANNER_LINE_ERROR);
+    assert(planner_block_count(&queue) == 3);
+    assert(planner_buffer_line(NULL, &next, 600.0f, 0) == PLANNER_LINE_ERROR);
+    
+    printf("[passed]\n");
+}
+
+// Test that a full ring reports back-pressure without moving the position
+void test_planner_buffer_sync() {
+    printf("Testing planner sync blocks stop the motion around them...\n");
+    
+    planner_queue_t queue;
+    planner_queue_init(&queue);
+    
+    kin_cart_t a = {{ 10.0f, 0.0f, 0.0f }};
+    kin_cart_t b = {{ 20.0f, 0.0f, 0.0f }};
+    assert(planner_buffer_line(&queue, &a, 600.0f, 0) == PLANNER_LINE_OK);
+    queue.spindle_speed = 750.0f;
+    assert(planner_buffer_sync(&queue, 1500u, PLANNER_LINE_SPINDLE_SYNC | PLANNER_LINE_SPINDLE_CW |
+                                              PLANNER_LINE_RAPID) == PLANNER_LINE_OK);
+    assert(planner_buffer_line(&queue, &b, 600.0f, 0) == PLANNER_LINE_OK);
+    assert(planner_block_count(&queue) == 3);
+    
+    planner_block_t *move = planner_peek_front(&queue);
+    planner_block_t *sync = planner_next_block(&queue, move);
+    planner_block_t *after = planner_next_block(&queue, sync);
+    assert(sync->line_flags == (PLANNER_LINE_DWELL | PLANNER_LINE_SPINDLE_SYNC | PLANNER_LINE_SPINDLE_CW));
+    assert(sync->dwell_ms == 1500u && sync->spindle_speed == 750.0f);
+    assert(sync->step_event_count == 0 && sync->millimeters == 0.0f);
+    assert(planner_block_validate(sync));
+    
+    /* Straight line, but the move before stops and the one after starts from rest */
+    assert(move->exit_speed_sqr == 0.0f);
+    assert(sync->entry_speed_sqr == 0.0f && sync->exit_speed_sqr == 0.0f);
+    assert(after->max_entry_speed_sqr == 0.0f && after->entry_speed_sqr == 0.0f);
+    
+    /* Overrides leave the barrier in place */
+    assert(planner_set_overrides(&queue, 150, PLANNER_RAPID_OVERRIDE_DEFAULT));
+    assert(move->exit_speed_sqr == 0.0f && after->entry_speed_sqr == 0.0f);
+    assert(sync->nominal_speed == 0.0f);
+    
+    /* Full ring and NULL */
+    while (!planner_is_full(&queue)) {
+        assert(planner_buffer_sync(&queue, 0u, 0u) == PLANNER_LINE_OK);
+    }
+    assert(planner_buffer_sync(&queue, 0u, 0u) == PLANNER_LINE_FULL);
+    assert(planner_buffer_sync(NULL, 0u, 0u) == PLANNER_LINE_ERROR);
+    
+    printf("[passed]\n");
+}
+
+void test_planner_buffer_line_full() {
+    printf("Testing planner_buffer_line back-pressure when full...\n");
+    
+    planner_queue_t queue;
+    planner_queue_init(&queue);
+    
+    kin_cart_t target = {{ 0.0f, 0.0f, 0.0f }};
+    for (uint32_t i = 0; i < PLANNER_BUFFER_SIZE; i++) {
+        target.v[0] += 1.0f;
+        assert(planner_buffer_line(&queue, &target, 600.0f, 0) == PLANNER_LINE_OK);
+    }
+    
+    kin_cart_t extra = {{ 100.0f, 0.0f, 0.0f }};
+    assert(planner_buffer_line(&queue, &extra, 600.0f, 0) == PLANNER_LINE_FULL);
+    assert(queue.position.v[0] == target.v[0]);
+    
+    // Freeing a slot lets the same target through, measured from the old end
+    planner_dequeue(&queue);
+    assert(planner_buffer_line(&queue, &extra, 600.0f, 0) == PLANNER_LINE_OK);
+    assert(planner_peek_back(&queue)->steps[0] == (uint32_t)(100 - PLANNER_BUFFER_SIZE) * 100u);
+    
+    // Syncing the position moves the origin of the next block
+    kin_cart_t home = {{ 0.0f, 0.0f, 0.0f }};
+    assert(planner_sync_position(&queue, &home) == 1);
+    assert(queue.position_steps[0] == 0);
+    
+    printf("[passed]\n");
+}
+
+// Check every queued block's profile is self-consistent and reachable
+static void assert_queue_consistent(planner_queue_t *queue) {
+    planner_block_t *prev = NULL;
+    for (planner_block_t *b = planner_peek_front(queue); b; b = planner_next_block(queue, b)) {
+        float entry = sqrtf(b->entry_speed_sqr);
+        float max_entry = sqrtf(b->max_entry_speed_sqr);
+        assert(entry <= max_entry + 1e-3f || (prev == NULL && b->entry_speed_sqr == 0.0f));
+        assert(max_entry <= b->nominal_speed + 1e-3f);
+        if (prev != NULL) {
+            assert(fabsf(sqrtf(prev->exit_speed_sqr) - entry) < 1e-3f);
+            float reach = sqrtf(prev->entry_speed_sqr + 2.0f * prev->acceleration * prev->millimeters);
+            assert(entry <= reach + 1e-2f);
+        }
+        prev = b;
+    }
+}
+
+// Test that feed/rapid overrides rescale queued blocks and replan in place
+void test_planner_overrides() {
+    printf("Testing planner feed/rapid overrides replan the queue...\n");
+    
+    planner_queue_t queue;
+    planner_queue_init(&queue);
+    assert(queue.feed_override == 100 && queue.rapid_override == 100);
+    
+    kin_cart_t target = {{ 0.0f, 0.0f, 0.0f }};
+    for (int i = 0; i < 4; i++) {
+        target.v[0] += 20.0f;
+        assert(planner_buffer_line(&queue, &target, 600.0f, 0) == PLANNER_LINE_OK);
+    }
+    target.v[1] = 20.0f;
+    assert(planner_buffer_line(&queue, &target, 0.0f, PLANNER_LINE_RAPID) == PLANNER_LINE_OK);
+    
+    // Stepper is running the first block
+    planner_block_t *running = planner_get_current_block(&queue);
+    float running_exit_sqr = running->exit_speed_sqr;
+    assert(running_exit_sqr == 600.0f * 600.0f);
+    
+    assert(planner_set_overrides(&queue, 150, 50) == 1);
+    assert(planner_set_overrides(&queue, 150, 50) == 0);
+    assert(planner_block_count(&queue) == 5);
+    
+    planner_block_t *b = planner_next_block(&queue, running);
+    assert(b->nominal_speed == 900.0f);
+    assert(b->entry_speed_sqr == running_exit_sqr); // fixed entry untouched when raising
+    b = planner_next_block(&queue, b);
+    assert(b->nominal_speed == 900.0f);
+    assert(b->entry_speed_sqr > 600.0f * 600.0f); // collinear junction sped up
+    assert(planner_peek_back(&queue)->nominal_speed == 0.5f * queue.settings.max_rate);
+    assert(running->nominal_speed == 900.0f);
+    assert_queue_consistent(&queue);
+    
+    // Slowing down below the running block's exit pulls that exit down too
+    assert(planner_set_overrides(&queue, 5, 0) == 1);
+    assert(queue.feed_override == PLANNER_FEED_OVERRIDE_MIN);
+    assert(queue.rapid_override == PLANNER_RAPID_OVERRIDE_LOW);
+    b = planner_next_block(&queue, running);
+    assert(b->nominal_speed == 60.0f);
+    assert(b->entry_speed_sqr <= 60.0f * 60.0f);
+    assert(running->exit_speed_sqr == b->entry_speed_sqr);
+    assert_queue_consistent(&queue);
+    
+    // New blocks are built with the active override
+    target.v[0] = 0.0f;
+    assert(planner_buffer_line(&queue, &target, 600.0f, 0) == PLANNER_LINE_OK);
+    assert(planner_peek_back(&queue)->nominal_speed == 60.0f);
+    assert(planner_peek_back(&queue)->programmed_rate == 600.0f);
+    
+    // Clamps: feed to 200%, rapids never above 100%
+    assert(planner_set_overrides(&queue, 255, 255) == 1);
+    assert(queue.feed_override == PLANNER_FEED_OVERRIDE_MAX);
+    assert(planner_peek_back(&queue)->nominal_speed == queue.settings.max_rate);
+    assert_queue_consistent(&queue);
+    
+    // Hand-built blocks (no programmed rate) are left alone
+    planner_queue_clear(&queue);
+    planner_block_t *slot = planner_get_next_free_block(&queue);
+    make_line(slot, 1.0f, 0.0f, 10.0f, 600.0f);
+    assert(planner_plan_block(&queue, slot, NULL) == 1);
+    assert(planner_set_overrides(&queue, 100, 100) == 1);
+    assert(slot->nominal_speed == 600.0f);
+    assert(planner_set_overrides(NULL, 100, 100) == 0);
+    
+    printf("[passed]\n");
+}
+
+// Reference solution: full reverse then forward pass over the whole queue,
+// head entry fixed, no early exits and no planned pointer
+static void reference_entries(planner_queue_t *queue, float *out_sqr, uint32_t count) {
+    planner_block_t *blocks[PLANNER_BUFFER_SIZE];
+    uint32_t n = 0;
+    for (planner_block_t *b = planner_peek_front(queue); b; b = planner_next_block(queue, b)) {
+        blocks[n++] = b;
+    }
+    assert(n == count);
+    
+    out_sqr[0] = blocks[0]->entry_speed_sqr;
+    float next_sqr = 0.0f;
+    for (uint32_t i = n; i-- > 1;) {
+        float v_sqr = next_sqr + 2.0f * blocks[i]->acceleration * blocks[i]->millimeters;
+        out_sqr[i] = (blocks[i]->max_entry_speed_sqr < v_sqr) ? blocks[i]->max_entry_speed_sqr : v_sqr;
+        next_sqr = out_sqr[i];
+    }
+    for (uint32_t i = 1; i < n; i++) {
+        float v_sqr = out_sqr[i - 1] + 2.0f * blocks[i - 1]->acceleration * blocks[i - 1]->millimeters;
+        if (v_sqr < out_sqr[i]) out_sqr[i] = v_sqr;
+    }
+}
+
+// Test that replanning from the planned pointer matches a full replan, and
+// that the pointer keeps up with the newest blocks so each replan is short
+void test_planner_planned_pointer() {
+    printf("Testing planner replans only the blocks after the planned pointer...\n");
+    
+    planner_queue_t queue;
+    planner_queue_init(&queue);
+    
+    // Short zig-zag segments with long straights in between: ramps over
+    // several blocks, corners and lines that reach nominal speed
+    kin_cart_t target = {{ 0.0f, 0.0f, 0.0f }};
+    float ref[PLANNER_BUFFER_SIZE];
+    uint32_t lagging = 0;
+    for (int i = 0; i < 200; i++) {
+        if (planner_is_full(&queue)) {
+            planner_dequeue(&queue);  // Stepper finished the front block
+        }
+        if ((i / 12) % 2) {
+            target.v[0] += 5.0f;
+        } else {
+            target.v[0] += 0.05f;
+            target.v[1] += (i % 2) ? 0.02f : -0.02f;
+        }
+        assert(planner_buffer_line(&queue, &target, 3000.0f, 0) == PLANNER_LINE_OK);
+        
+        uint32_t count = planner_block_count(&queue);
+        reference_entries(&queue, ref, count);
+        uint32_t k = 0;
+        for (planner_block_t *b = planner_peek_front(&queue); b; b = planner_next_block(&queue, b), k++) {
+            assert(fabsf(b->entry_speed_sqr - ref[k]) <= 1e-3f * (ref[k] + 1.0f));
+        }
+        assert_queue_consistent(&queue);
+        
+        // The pointer stays inside the queue, and mostly right behind the tail
+        uint8_t offset = (uint8_t)(queue.planned - queue.head);
+        assert(offset < count);
+        if (count - offset > 4u) {
+            lagging++;
+        }
+    }
+    assert(lagging < 20u);
+    
+    // Clearing restarts the pointer with the queue
+    planner_queue_clear(&queue);
+    assert(queue.planned == 0);
+    assert(planner_buffer_line(&queue, &target, 600.0f, 0) == PLANNER_LINE_EMPTY);
+    target.v[0] += 10.0f;
+    assert(planner_buffer_line(&queue, &target, 600.0f, 0) == PLANNER_LINE_OK);
+    assert(queue.planned == queue.head);
+    
+    printf("[passed]\n");
+}
+
 // Main function to execute all test cases
 int main() {
     printf("=== Running Planner Block Tests ===\n\n");
@@ -636,6 +1189,8 @@ int main() {
     test_planner_queue_dequeue_multiple();
     test_planner_queue_dequeue_empty();
     test_planner_queue_enqueue_full();
+    test_planner_queue_free_block_commit();
+    test_planner_queue_wrap_and_iterate();
     test_planner_queue_peek_front();
     test_planner_queue_peek_back();
     test_planner_queue_peek_empty();
@@ -647,5 +1202,22 @@ int main() {
     
     printf("\n=== All planner queue tests passed! ===\n");
     
+    // Run look-ahead tests
+    printf("\n=== Running Planner Look-ahead Tests ===\n\n");
+    
+    test_planner_plan_collinear();
+    test_planner_plan_corner();
+    test_planner_plan_reversal();
+    test_planner_plan_short_blocks();
+    test_planner_plan_claimed_block();
+    test_planner_plan_invalid();
+    test_planner_buffer_line();
+    test_planner_buffer_line_full();
+    test_planner_buffer_sync();
+    test_planner_overrides();
+    test_planner_planned_pointer();
+    
+    printf("\n=== All planner look-ahead tests passed! ===\n");
+    
     return 0;
 }
@@ -0,0 +1,136 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "../src/profile.h"
+
+// Mock HAL: a cycle counter the test advances by hand
+static uint32_t mock_cycles = 0;
+
+uint32_t hal_cycles(void) { return mock_cycles; }
+uint32_t hal_cycles_freq_hz(void) { return 168000000u; }
+uint32_t hal_step_timer_freq_hz(void) { return 1000000u; }
+
+static void timed_zone(uint32_t cycles) {
+    PROFILE_ZONE_BEGIN(PROFILE_ZONE_PLANNER);
+    mock_cycles += cycles;
+    PROFILE_ZONE_END(PROFILE_ZONE_PLANNER);
+}
+
+// Zone count / min / avg / max, including a counter wrap inside the zone
+void test_profile_zone_stats() {
+    printf("Testing profile zone statistics...\n");
+    profile_reset();
+    mock_cycles = 1000u;
+
+    timed_zone(300u);
+    timed_zone(100u);
+    mock_cycles = 0xFFFFFF00u;
+    timed_zone(500u);   // wraps through zero
+
+    const profile_zone_stats_t *z = &g_profile.zones[PROFILE_ZONE_PLANNER];
+    assert(z->count == 3u);
+    assert(z->min == 100u);
+    assert(z->max == 500u);
+    assert(profile_zone_avg(PROFILE_ZONE_PLANNER) == 300u);
+    assert(profile_zone_avg(PROFILE_ZONE_ARC) == 0u);
+    assert(g_profile.zones[PROFILE_ZONE_ARC].count == 0u);
+
+    printf("[passed]\n");
+}
+
+// Step ISR intervals are binned by their deviation from the programmed period
+void test_profile_step_jitter() {
+    printf("Testing profile step ISR jitter histogram...\n");
+    profile_reset();
+    mock_cycles = 0u;
+
+    profile_step_isr_restart();             // 168 cycles per timer tick
+    assert(g_profile.cycles_per_tick == 168u);
+
+    profile_step_isr(100u);                 // first event: no reference yet
+    for (unsigned b = 0; b < PROFILE_JITTER_BUCKETS; b++) {
+        assert(g_profile.jitter_hist[b] == 0u);
+    }
+
+    mock_cycles += 16800u + 5u;             // 5 late -> bucket 0
+    profile_step_isr(50u);
+    mock_cycles += 8400u - 40u;             // 40 early -> bucket 2 (32..63)
+    profile_step_isr(50u);
+    mock_cycles += 8400u + 100000u;         // far off -> last bucket
+    profile_step_isr(50u);
+
+    assert(g_profile.jitter_hist[0] == 1u);
+    assert(g_profile.jitter_hist[2] == 1u);
+    assert(g_profile.jitter_hist[PROFILE_JITTER_BUCKETS - 1u] == 1u);
+    assert(g_profile.jitter_max == 100000u);
+
+    // Re-arming the timer drops the reference: the gap is not counted
+    profile_step_isr_restart();
+    mock_cycles += 5000000u;
+    profile_step_isr(50u);
+    assert(g_profile.jitter_hist[PROFILE_JITTER_BUCKETS - 1u] == 1u);
+    assert(g_profile.jitter_max == 100000u);
+
+    printf("[passed]\n");
+}
+
+// High-water marks only rise, clamp to 16 bits and clear on reset
+void test_profile_hwm_and_reset() {
+    printf("Testing profile high-water marks and reset...\n");
+    profile_reset();
+
+    PROFILE_HWM(PROFILE_HWM_PLANNER, 3u);
+    PROFILE_HWM(PROFILE_HWM_PLANNER, 7u);
+    PROFILE_HWM(PROFILE_HWM_PLANNER, 5u);
+    PROFILE_HWM(PROFILE_HWM_RX, 100000u);
+    assert(g_profile.hwm[PROFILE_HWM_PLANNER] == 7u);
+    assert(g_profile.hwm[PROFILE_HWM_RX] == UINT16_MAX);
+
+    timed_zone(10u);
+    profile_step_isr_restart();
+    profile_reset();
+    assert(g_profile.hwm[PROFILE_HWM_PLANNER] == 0u);
+    assert(g_profile.zones[PROFILE_ZONE_PLANNER].count == 0u);
+    assert(g_profile.cycles_per_tick == 168u);  // calibration survives
+
+    printf("[passed]\n");
+}
+
+// "$P" report layout
+void test_profile_report_format() {
+    printf("Testing profile report format...\n");
+    profile_reset();
+    mock_cycles = 0u;
+    timed_zone(40u);
+    timed_zone(60u);
+    PROFILE_HWM(PROFILE_HWM_PLANNER, 12u);
+    PROFILE_HWM(PROFILE_HWM_RX, 200u);
+
+    char buf[PROFILE_REPORT_MAX];
+    size_t len = profile_format_report(buf, sizeof(buf));
+    assert(len == strlen(buf));
+    assert(strncmp(buf, "[PRF:HZ,168000000]\r\n[PRF:PARSE,0,0,0,0]\r\n", 40) == 0);
+    assert(strstr(buf, "[PRF:PLAN,2,40,50,60]\r\n") != NULL);
+    assert(strstr(buf, "[PRF:JIT,0,0,0,0,0,0,0,0,0]\r\n") != NULL);
+    assert(strstr(buf, "[PRF:HWM,12,200]\r\n") != NULL);
+    assert(buf[len - 1] == '\n');
+
+    // Too small a buffer yields nothing rather than a truncated line
+    char small[32];
+    assert(profile_format_report(small, sizeof(small)) == 0u);
+    assert(small[0] == '\0');
+
+    printf("[passed]\n");
+}
+
+int main(void) {
+    printf("Running profile tests...\n\n");
+
+    test_profile_zone_stats();
+    test_profile_step_jitter();
+    test_profile_hwm_and_reset();
+    test_profile_report_format();
+
+    printf("\nAll profile tests passed!\n");
+    return 0;
+}
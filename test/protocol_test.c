@@ -0,0 +1,482 @@
+/* protocol_test.c - Unit tests for protocol line assembly and RX ring */
+
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include "../src/protocol.h"
+
+static protocol_t proto;
+
+static int rt_count[PROTO_RT_SPINDLE_OVR_FINE_MINUS + 1];
+
+static void on_rt(proto_rt_cmd_t cmd, void *user) {
+    (void)user;
+    rt_count[cmd]++;
+}
+
+static protocol_t *fresh_protocol(void) {
+    protocol_t *p = &proto;
+    proto_config_t cfg = {
+        .strip_semicolon_comments = true,
+        .strip_paren_comments = true,
+        .allow_dollar_commands = true,
+        .to_uppercase = true,
+    };
+    memset(rt_count, 0, sizeof(rt_count));
+    protocol_init(p, &cfg, NULL, on_rt, NULL);
+    return p;
+}
+
+static size_t feed_str(protocol_t *p, const char *s) {
+    return protocol_feed_bytes(p, (const uint8_t *)s, strlen(s));
+}
+
+void test_feed_and_pop() {
+    printf("Testing line assembly and normalization...\n");
+    
+    protocol_t *p = fresh_protocol();
+    const char *in = "  g1 x10 (move) y2  \r\nG0 X0 ; rapid\n\n";
+    assert(feed_str(p, in) == strlen(in));
+    
+    char line[PROTOCOL_LINE_MAX + 1];
+    proto_line_status_t st;
+    assert(protocol_pop_line(p, line, sizeof(line), &st));
+    assert(st == PROTO_LINE_OK && strcmp(line, "G1 X10  Y2") == 0);
+    assert(protocol_pop_line(p, line, sizeof(line), &st));
+    assert(strcmp(line, "G0 X0") == 0);
+    assert(!protocol_has_line(p));
+    
+    /* A ';' comment split across two feeds still runs to the newline */
+    feed_str(p, "G1 X1 ; comment ");
+    feed_str(p, "G1 X99\nG1 X2\n");
+    assert(protocol_pop_line(p, line, sizeof(line), &st) && strcmp(line, "G1 X1") == 0);
+    assert(protocol_pop_line(p, line, sizeof(line), &st) && strcmp(line, "G1 X2") == 0);
+    
+    printf("  [PASSED]\n");
+}
+
+void test_full_queue_stalls() {
+    printf("Testing a full line arena stalls input instead of dropping...\n");
+    
+    protocol_t *p = fresh_protocol();
+    /* Short lines take 7..9 arena bytes each, so this cannot all fit */
+    const unsigned total = PROTOCOL_LINE_ARENA_SIZE / 4u;
+    static char text[PROTOCOL_LINE_ARENA_SIZE * 4u];
+    text[0] = '\0';
+    for (unsigned i = 0; i < total; i++) {
+        char one[16];
+        snprintf(one, sizeof(one), "G1 X%u\n", i);
+        strcat(text, one);
+    }
+    
+    size_t used = feed_str(p, text);
+    assert(used < strlen(text));
+    assert(text[used] == '\n');  /* stopped on the terminator it could not queue */
+    
+    /* The arena holds far more short lines than DEPTH full-length ones */
+    unsigned queued = 0;
+    for (size_t k = 0; k < used; k++) queued += (text[k] == '\n');
+    assert(queued >= 4u * PROTOCOL_LINE_QUEUE_DEPTH);
+    
+    /* Pop one, resume from where it stopped: every line arrives in order */
+    char line[PROTOCOL_LINE_MAX + 1];
+    unsigned next = 0;
+    size_t off = used;
+    while (protocol_pop_line(p, line, sizeof(line), NULL)) {
+        char expect[16];
+        snprintf(expect, sizeof(expect), "G1 X%u", next++);
+        assert(strcmp(line, expect) == 0);
+        off += protocol_feed_bytes(p, (const uint8_t *)text + off, strlen(text) - off);
+    }
+    assert(next == total);
+    assert(off == strlen(text));
+    
+    printf("  [PASSED]\n");
+}
+
+void test_arena_wrap_long_lines() {
+    printf("Testing full-length lines across the arena wrap...\n");
+    
+    protocol_t *p = fresh_protocol();
+    char in[PROTOCOL_LINE_MAX + 2];
+    char line[PROTOCOL_LINE_MAX + 1];
+    proto_line_status_t st;
+    
+    /* Odd offsets so entries straddle the end of the arena */
+    for (unsigned i = 0; i < 3u * PROTOCOL_LINE_QUEUE_DEPTH; i++) {
+        size_t n = PROTOCOL_LINE_MAX - (i % 3u);
+        memset(in, 'A' + (int)(i % 26u), n);
+        in[n] = '\n';
+        in[n + 1] = '\0';
+        assert(feed_str(p, in) == n + 1u);
+        assert(feed_str(p, "G0\n") == 3u);
+        
+        assert(protocol_pop_line(p, line, sizeof(line), &st));
+        assert(st == PROTO_LINE_OK && strlen(line) == n && line[n - 1] == in[0]);
+        assert(protocol_pop_line(p, line, sizeof(line), &st) && strcmp(line, "G0") == 0);
+    }
+    
+    /* A short output buffer truncates but still consumes the whole entry */
+    feed_str(p, "G1 X123 Y456\nG1 X7\n");
+    char small[4];
+    assert(protocol_pop_line(p, small, sizeof(small), NULL) && strcmp(small, "G1 ") == 0);
+    assert(protocol_pop_line(p, line, sizeof(line), NULL) && strcmp(line, "G1 X7") == 0);
+    assert(!protocol_has_line(p));
+    
+    printf("  [PASSED]\n");
+}
+
+void test_rx_ring() {
+    printf("Testing RX ring accounting and realtime bytes...\n");
+    
+    protocol_t *p = fresh_protocol();
+    assert(protocol_rx_free(p) == PROTOCOL_RX_BUFFER_SIZE);
+    
+    /* Realtime bytes are acted on at write time and take no ring space */
+    const char *in = "G1 X1?\nG1!~ X2\n";
+    assert(protocol_rx_write(p, (const uint8_t *)in, strlen(in)) == strlen(in));
+    assert(rt_count[PROTO_RT_STATUS_QUERY] == 1);
+    assert(rt_count[PROTO_RT_FEED_HOLD] == 1);
+    assert(rt_count[PROTO_RT_CYCLE_START] == 1);
+    assert(protocol_rx_free(p) == PROTOCOL_RX_BUFFER_SIZE - (strlen(in) - 3u));
+    assert(!protocol_has_line(p));
+    
+    assert(protocol_service(p) == strlen(in) - 3u);
+    assert(protocol_rx_free(p) == PROTOCOL_RX_BUFFER_SIZE);
+    
+    char line[PROTOCOL_LINE_MAX + 1];
+    assert(protocol_pop_line(p, line, sizeof(line), NULL) && strcmp(line, "G1 X1") == 0);
+    assert(protocol_pop_line(p, line, sizeof(line), NULL) && strcmp(line, "G1 X2") == 0);
+    
+    /* Filling the ring refuses the overflow; realtime still gets through */
+    static uint8_t bulk[PROTOCOL_RX_BUFFER_SIZE + 16u];
+    memset(bulk, 'X', sizeof(bulk));
+    assert(protocol_rx_write(p, bulk, sizeof(bulk)) == PROTOCOL_RX_BUFFER_SIZE);
+    assert(protocol_rx_free(p) == 0);
+    assert(protocol_rx_write(p, (const uint8_t *)"?", 1) == 1);
+    assert(rt_count[PROTO_RT_STATUS_QUERY] == 2);
+    
+    /* Ctrl-X empties everything */
+    assert(protocol_rx_write(p, (const uint8_t *)"\x18", 1) == 1);
+    assert(rt_count[PROTO_RT_RESET] == 1);
+    assert(protocol_service(p) == 0);
+    assert(protocol_rx_free(p) == PROTOCOL_RX_BUFFER_SIZE);
+    
+    printf("  [PASSED]\n");
+}
+
+void test_rx_reset_deferred() {
+    printf("Testing Ctrl-X from the producer is applied by the consumer...\n");
+    
+    protocol_t *p = fresh_protocol();
+    const char *in = "G1 X1\nG1 X2\n";
+    assert(protocol_rx_write(p, (const uint8_t *)in, strlen(in)) == strlen(in));
+    assert(protocol_service(p) == strlen(in));
+    char line[PROTOCOL_LINE_MAX + 1];
+    assert(protocol_pop_line(p, line, sizeof(line), NULL) && strcmp(line, "G1 X1") == 0);
+    
+    /* The ISR only marks the reset: the ring head stays where it was */
+    const char *burst = "G1 X9\n\x18G1 X3\n";
+    assert(protocol_rx_write(p, (const uint8_t *)burst, strlen(burst)) == strlen(burst));
+    assert(rt_count[PROTO_RT_RESET] == 1);
+    assert(protocol_rx_free(p) == PROTOCOL_RX_BUFFER_SIZE - 12u);
+    assert(!protocol_has_line(p));
+    
+    /* The consumer drops the queued line and everything before the Ctrl-X */
+    assert(protocol_service(p) == 6u);
+    assert(protocol_pop_line(p, line, sizeof(line), NULL) && strcmp(line, "G1 X3") == 0);
+    assert(!protocol_has_line(p));
+    assert(protocol_rx_free(p) == PROTOCOL_RX_BUFFER_SIZE);
+    
+    printf("  [PASSED]\n");
+}
+
+void test_rx_ring_stalls_on_full_queue() {
+    printf("Testing protocol_service leaves bytes in the ring when lines back up...\n");
+    
+    protocol_t *p = fresh_protocol();
+    /* 6 ring bytes per line but 7 arena bytes: the arena fills first */
+    const unsigned total = PROTOCOL_LINE_ARENA_SIZE / 6u;
+    static char text[PROTOCOL_LINE_ARENA_SIZE + 8u];
+    text[0] = '\0';
+    for (unsigned i = 0; i < total; i++) strcat(text, "G1 X1\n");
+    assert(protocol_rx_write(p, (const uint8_t *)text, strlen(text)) == strlen(text));
+    
+    size_t moved = protocol_service(p);
+    assert(moved < strlen(text));
+    assert(protocol_rx_free(p) == PROTOCOL_RX_BUFFER_SIZE - (strlen(text) - moved));
+    
+    unsigned lines = 0;
+    while (protocol_pop_line(p, NULL, 0, NULL)) {
+        lines++;
+        protocol_service(p);
+    }
+    assert(lines == total);
+    assert(protocol_rx_free(p) == PROTOCOL_RX_BUFFER_SIZE);
+    
+    printf("  [PASSED]\n");
+}
+
+/* Stand-in for the UART DMA: copy bytes into the ring and fire the ISR */
+static size_t dma_pos;
+
+static void dma_receive(protocol_t *p, const char *s) {
+    uint8_t *ring = protocol_rx_dma_buffer(p);
+    for (size_t k = 0; s[k]; k++) {
+        ring[dma_pos] = (uint8_t)s[k];
+        dma_pos = (dma_pos + 1u) & PROTOCOL_RX_BUFFER_MASK;
+    }
+    protocol_rx_dma_isr(dma_pos, p);
+}
+
+void test_dma_line_views() {
+    printf("Testing DMA ring line views...\n");
+    
+    protocol_t *p = fresh_protocol();
+    dma_pos = 0;
+    const uint8_t *ring = protocol_rx_dma_buffer(p);
+    
+    /* Realtime bytes are caught in the ISR and never reach a line */
+    dma_receive(p, "g1 x1 (c) ?y2\nG0");
+    assert(rt_count[PROTO_RT_STATUS_QUERY] == 1);
+    
+    proto_line_view_t v;
+    assert(protocol_peek_line(p, &v));
+    assert(v.st == PROTO_LINE_OK && strcmp(v.text, "G1 X1  Y2") == 0 && v.len == 9);
+    assert((const uint8_t *)v.text >= ring && (const uint8_t *)v.text < ring + PROTOCOL_RX_BUFFER_SIZE);
+    
+    /* Peeking again returns the same view until it is released */
+    proto_line_view_t again;
+    assert(protocol_peek_line(p, &again) && again.text == v.text);
+    size_t free_before = protocol_rx_free(p);
+    protocol_release_line(p);
+    assert(protocol_rx_free(p) == free_before + 14u);
+    
+    /* Partial line stays pending; empty lines are skipped */
+    assert(!protocol_peek_line(p, &v));
+    dma_receive(p, " X3\n\n  ;note\nM5\n");
+    assert(protocol_peek_line(p, &v) && strcmp(v.text, "G0 X3") == 0);
+    protocol_release_line(p);
+    assert(protocol_peek_line(p, &v) && strcmp(v.text, "M5") == 0);
+    protocol_release_line(p);
+    assert(!protocol_peek_line(p, &v));
+    assert(protocol_rx_free(p) == PROTOCOL_RX_BUFFER_SIZE);
+    
+    printf("  [PASSED]\n");
+}
+
+void test_dma_wrap_and_overflow() {
+    printf("Testing DMA ring wrap-around and oversize lines...\n");
+    
+    protocol_t *p = fresh_protocol();
+    dma_pos = 0;
+    const uint8_t *ring = protocol_rx_dma_buffer(p);
+    proto_line_view_t v;
+    
+    /* Advance close to the ring end, then send a line that straddles it */
+    char pad[PROTOCOL_RX_BUFFER_SIZE];
+    memset(pad, '\n', sizeof(pad));  /* empty lines */
+    pad[PROTOCOL_RX_BUFFER_SIZE - 7u] = '\0';
+    dma_receive(p, pad);
+    assert(!protocol_peek_line(p, &v));  /* blank */
+    
+    dma_receive(p, "G1 X12.5 Y7\n");
+    assert(protocol_peek_line(p, &v) && strcmp(v.text, "G1 X12.5 Y7") == 0);
+    assert(!((const uint8_t *)v.text >= ring && (const uint8_t *)v.text < ring + PROTOCOL_RX_BUFFER_SIZE));
+    protocol_release_line(p);
+    
+    /* Lines longer than PROTOCOL_LINE_MAX come back as overflow */
+    char longline[PROTOCOL_LINE_MAX + 16u];
+    memset(longline, 'X', sizeof(longline));
+    longline[sizeof(longline) - 2u] = '\n';
+    longline[sizeof(longline) - 1u] = '\0';
+    dma_receive(p, longline);
+    assert(protocol_peek_line(p, &v) && v.st == PROTO_LINE_OVERFLOW && v.len == 0);
+    protocol_release_line(p);
+    
+    /* Ctrl-X mid-burst drops what came before it */
+    dma_receive(p, "G1 X5\x18G1 X6\n");
+    assert(rt_count[PROTO_RT_RESET] == 1);
+    assert(protocol_peek_line(p, &v) && strcmp(v.text, "G1 X6") == 0);
+    protocol_release_line(p);
+    assert(protocol_rx_free(p) == PROTOCOL_RX_BUFFER_SIZE);
+    
+    printf("  [PASSED]\n");
+}
+
+/* Test-side frame encoder (mirrors software/svg_parser.py) */
+static size_t put_varint(uint8_t *out, uint32_t v) {
+    size_t n = 0;
+    while (v >= 0x80u) { out[n++] = (uint8_t)(v | 0x80u); v >>= 7; }
+    out[n++] = (uint8_t)v;
+    return n;
+}
+
+static size_t encode_frame(char *line, uint8_t flags, uint32_t feed,
+                           const int32_t *dx, const int32_t *dy, uint8_t count) {
+    uint8_t raw[128];
+    size_t n = 0;
+    raw[n++] = PROTO_BIN_TYPE_DELTA_XY;
+    raw[n++] = flags;
+    n += put_varint(raw + n, feed);
+    raw[n++] = count;
+    for (uint8_t k = 0; k < count; k++) {
+        n += put_varint(raw + n, ((uint32_t)dx[k] << 1) ^ (uint32_t)(dx[k] >> 31));
+        n += put_varint(raw + n, ((uint32_t)dy[k] << 1) ^ (uint32_t)(dy[k] >> 31));
+    }
+    raw[n] = protocol_crc8(raw, n);
+    n++;
+    
+    size_t len = 0;
+    line[len++] = (char)PROTO_BIN_SOF;
+    for (size_t k = 0; k < n; k++) {
+        uint8_t b = raw[k];
+        if (b == 0x00u || b == '\n' || b == '\r' || b == PROTO_BIN_SOF || b == PROTO_BIN_ESC ||
+            b == '?' || b == '!' || b == '~' || b == 0x18u ||
+            (b >= PROTO_RT_BYTE_OVR_FIRST && b <= PROTO_RT_BYTE_OVR_LAST)) {
+            line[len++] = (char)PROTO_BIN_ESC;
+            b ^= PROTO_BIN_XOR;
+        }
+        line[len++] = (char)b;
+    }
+    line[len++] = '\n';
+    line[len] = '\0';
+    return len;
+}
+
+void test_binary_frames() {
+    printf("Testing binary motion frames...\n");
+    
+    protocol_t *p = fresh_protocol();
+    /* Deltas chosen so the stuffed bytes include '?', '~', LF and NUL */
+    const int32_t dx[] = { 0x3F / 2, -32, 5, 0, 123456 };
+    const int32_t dy[] = { 0, 5, -0x7E / 2 - 1, 0x0A / 2, -1 };
+    char frame[128];
+    size_t flen = encode_frame(frame, 0u, 1200u, dx, dy, 5);
+    
+    /* Text mode: the frame is just noise on a line, never BINARY */
+    feed_str(p, frame);
+    proto_line_status_t st = PROTO_LINE_OK;
+    while (protocol_pop_line(p, NULL, 0, &st)) assert(st != PROTO_LINE_BINARY);
+    
+    /* Negotiate; the $BIN line is still delivered for its "ok" */
+    assert(feed_str(p, "$BIN=1\n") == 7u);
+    assert(protocol_binary_enabled(p));
+    char line[PROTOCOL_LINE_MAX + 1];
+    assert(protocol_pop_line(p, line, sizeof(line), &st) && strcmp(line, "$BIN=1") == 0);
+    
+    /* Realtime bytes around and between frames still act */
+    assert(protocol_rx_write(p, (const uint8_t *)frame, flen) == flen);
+    assert(protocol_rx_write(p, (const uint8_t *)"?G1 X1\n", 8) == 8u);
+    assert(rt_count[PROTO_RT_STATUS_QUERY] == 1);
+    assert(protocol_service(p) == flen + 7u);
+    
+    assert(protocol_pop_line(p, line, sizeof(line), &st) && st == PROTO_LINE_BINARY);
+    assert(strlen(line) == flen - 1u);
+    proto_motion_frame_t m;
+    assert(protocol_decode_motion_frame(line, &m) == PROTO_BIN_OK);
+    assert(m.feed == 1200u && m.count == 5u && m.flags == 0u);
+    for (unsigned k = 0; k < 5u; k++) assert(m.dx[k] == dx[k] && m.dy[k] == dy[k]);
+    assert(protocol_pop_line(p, line, sizeof(line), &st) && strcmp(line, "G1 X1") == 0);
+    
+    /* Corruption is caught */
+    frame[3] ^= 0x04;
+    frame[flen - 1u] = '\0';
+    assert(protocol_decode_motion_frame(frame, &m) != PROTO_BIN_OK);
+    assert(protocol_decode_motion_frame("G1 X1", &m) == PROTO_BIN_BAD_FRAME);
+    
+    /* The DMA view path negotiates and delivers frames raw as well */
+    p = fresh_protocol();
+    dma_pos = 0;
+    flen = encode_frame(frame, PROTO_BIN_FLAG_RAPID, 0u, dx, dy, 2);
+    dma_receive(p, "$BIN=1\n");
+    dma_receive(p, frame);
+    proto_line_view_t v;
+    assert(protocol_peek_line(p, &v) && strcmp(v.text, "$BIN=1") == 0);
+    protocol_release_line(p);
+    assert(protocol_peek_line(p, &v) && v.st == PROTO_LINE_BINARY && v.len == flen - 1u);
+    assert(protocol_decode_motion_frame(v.text, &m) == PROTO_BIN_OK);
+    assert(m.count == 2u && (m.flags & PROTO_BIN_FLAG_RAPID) && m.dx[1] == -32);
+    protocol_release_line(p);
+    
+    /* Ctrl-X drops back to text mode */
+    protocol_rx_write(p, (const uint8_t *)"\x18", 1);
+    assert(!protocol_peek_line(p, &v));
+    assert(!protocol_binary_enabled(p));
+    
+    printf("  [PASSED]\n");
+}
+
+void test_override_bytes() {
+    printf("Testing realtime override bytes...\n");
+    
+    protocol_t *p = fresh_protocol();
+    
+    /* Acted on mid-line and never part of the line */
+    const char *in = "G1\x91 X1\x97\x9C\n";
+    assert(feed_str(p, in) == strlen(in));
+    assert(rt_count[PROTO_RT_FEED_OVR_COARSE_PLUS] == 1);
+    assert(rt_count[PROTO_RT_RAPID_OVR_LOW] == 1);
+    assert(rt_count[PROTO_RT_SPINDLE_OVR_FINE_PLUS] == 1);
+    char line[PROTOCOL_LINE_MAX + 1];
+    assert(protocol_pop_line(p, line, sizeof(line), NULL) && strcmp(line, "G1 X1") == 0);
+    
+    /* 0x98 and 0x9E are not commands: dropped as non-printable */
+    feed_str(p, "G1\x98\x9E X2\n");
+    assert(protocol_pop_line(p, line, sizeof(line), NULL) && strcmp(line, "G1 X2") == 0);
+    
+    /* Every byte of the range maps to its own command, on both RX paths */
+    memset(rt_count, 0, sizeof(rt_count));
+    for (unsigned b = PROTO_RT_BYTE_OVR_FIRST; b <= PROTO_RT_BYTE_OVR_LAST; b++) {
+        uint8_t c = (uint8_t)b;
+        if (b == 0x98u) continue;  /* unassigned in grbl 1.1 too */
+        assert(protocol_rx_write(p, &c, 1) == 1);
+    }
+    assert(protocol_rx_free(p) == PROTOCOL_RX_BUFFER_SIZE);
+    for (int cmd = PROTO_RT_FEED_OVR_RESET; cmd <= PROTO_RT_SPINDLE_OVR_FINE_MINUS; cmd++) {
+        assert(rt_count[cmd] == 1);
+    }
+    
+    p = fresh_protocol();
+    dma_pos = 0;
+    dma_receive(p, "G1 X\x90" "3\n");
+    proto_line_view_t v;
+    assert(protocol_peek_line(p, &v) && strcmp(v.text, "G1 X3") == 0);
+    assert(rt_count[PROTO_RT_FEED_OVR_RESET] == 1);
+    protocol_release_line(p);
+    
+    /* A frame whose varint feed is 0x91 0x01 carries it stuffed */
+    const int32_t dx[] = { 1 };
+    const int32_t dy[] = { 0 };
+    char frame[64];
+    size_t flen = encode_frame(frame, 0u, 145u, dx, dy, 1);
+    assert(memchr(frame, 0x91, flen) == NULL);
+    dma_receive(p, "$BIN=1\n");
+    dma_receive(p, frame);
+    assert(protocol_peek_line(p, &v));
+    protocol_release_line(p);
+    assert(protocol_peek_line(p, &v) && v.st == PROTO_LINE_BINARY);
+    proto_motion_frame_t m;
+    assert(protocol_decode_motion_frame(v.text, &m) == PROTO_BIN_OK && m.feed == 145u);
+    assert(rt_count[PROTO_RT_FEED_OVR_COARSE_PLUS] == 0);
+    
+    printf("  [PASSED]\n");
+}
+
+int main() {
+    printf("\n=== Protocol Tests ===\n\n");
+    
+    test_feed_and_pop();
+    test_full_queue_stalls();
+    test_arena_wrap_long_lines();
+    test_rx_ring();
+    test_rx_reset_deferred();
+    test_rx_ring_stalls_on_full_queue();
+    test_dma_line_views();
+    test_dma_wrap_and_overflow();
+    test_binary_frames();
+    test_override_bytes();
+    
+    printf("\n=== All protocol tests passed! ===\n\n");
+    return 0;
+}
@@ -0,0 +1,388 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "../src/scheduler.h"
+#include "../src/pipeline.h"
+#include "../src/kin_corexy.h"
+#include "../src/hal.h"
+
+/* ----------------------------- Mock HAL ----------------------------- */
+
+static uint32_t mock_time_ms = 0;
+static hal_inputs_t mock_inputs;
+static uint32_t mock_idle_waits = 0;
+
+/* Everything written to the G-code port */
+static char mock_tx[1024];
+static size_t mock_tx_len = 0;
+
+uint32_t hal_millis(void) { return mock_time_ms; }
+uint32_t hal_micros(void) { return mock_time_ms * 1000u; }
+void hal_delay_ms(uint32_t ms) { mock_time_ms += ms; }
+
+size_t hal_serial_read(hal_port_t port, uint8_t *dst, size_t cap) {
+    (void)port; (void)dst; (void)cap;
+    return 0;
+}
+
+hal_status_t hal_serial_rx_dma_start(hal_port_t port, uint8_t *ring, size_t size,
+                                     hal_serial_rx_cb_t on_rx, void *user) {
+    (void)port; (void)ring; (void)size; (void)on_rx; (void)user;
+    return HAL_ERR;
+}
+
+size_t hal_serial_rx_dma_pos(hal_port_t port) {
+    (void)port;
+    return 0;
+}
+
+size_t hal_serial_write(hal_port_t port, const uint8_t *src, size_t len) {
+    (void)port;
+    if (mock_tx_len + len >= sizeof(mock_tx)) len = sizeof(mock_tx) - 1 - mock_tx_len;
+    memcpy(mock_tx + mock_tx_len, src, len);
+    mock_tx_len += len;
+    mock_tx[mock_tx_len] = '\0';
+    return len;
+}
+
+size_t hal_serial_write_str(hal_port_t port, const char *s) {
+    return hal_serial_write(port, (const uint8_t *)s, strlen(s));
+}
+
+void hal_poll(void) {}
+void hal_stepper_enable(bool en) { (void)en; }
+void hal_stepper_set_dir(hal_axis_t axis, bool dir_positive) { (void)axis; (void)dir_positive; }
+void hal_stepper_pulse_mask(uint32_t axis_mask) { (void)axis_mask; }
+void hal_stepper_clear_mask(uint32_t axis_mask) { (void)axis_mask; }
+void hal_spindle_set(hal_spindle_dir_t dir, float pwm) { (void)dir; (void)pwm; }
+
+void hal_read_inputs(hal_inputs_t *out) {
+    *out = mock_inputs;
+}
+
+/* Mock input interrupt: tests fire the debounced change by hand */
+static bool mock_inputs_irq = false;
+static hal_inputs_cb_t mock_on_inputs = NULL;
+static void *mock_inputs_user = NULL;
+
+hal_status_t hal_inputs_irq_init(uint32_t debounce_us, hal_inputs_cb_t on_change, void *user) {
+    (void)debounce_us;
+    mock_on_inputs = on_change;
+    mock_inputs_user = user;
+    return mock_inputs_irq ? HAL_OK : HAL_ERR;
+}
+
+void hal_idle_wait(const volatile uint32_t *wake) {
+    (void)wake;
+    mock_idle_waits++;
+}
+
+/* Mock step timer: tests fire the ISR by hand */
+static hal_timer_cb_t mock_on_step = NULL;
+static hal_timer_cb_t mock_on_pulse_end = NULL;
+static void *mock_timer_user = NULL;
+static bool mock_timer_armed = false;
+
+void hal_step_timer_init(hal_timer_cb_t on_step, hal_timer_cb_t on_pulse_end, void *user) {
+    mock_on_step = on_step;
+    mock_on_pulse_end = on_pulse_end;
+    mock_timer_user = user;
+}
+
+uint32_t hal_step_timer_freq_hz(void) { return 1000000u; }
+void hal_step_timer_arm(uint32_t period_ticks) { (void)period_ticks; mock_timer_armed = true; }
+void hal_step_timer_reload(uint32_t period_ticks) { (void)period_ticks; }
+void hal_step_timer_compare(uint32_t pulse_ticks) { (void)pulse_ticks; }
+void hal_step_timer_stop(void) { mock_timer_armed = false; }
+
+static void reset_mocks(void) {
+    mock_time_ms = 0;
+    memset(&mock_inputs, 0, sizeof(mock_inputs));
+    mock_idle_waits = 0;
+    mock_tx_len = 0;
+    mock_tx[0] = '\0';
+    mock_timer_armed = false;
+}
+
+/* ----------------------------- Scheduler tests ----------------------------- */
+
+static char trace[32];
+static size_t trace_len = 0;
+static int task_b_more = 0;
+
+static bool task_a(void *user) {
+    (void)user;
+    trace[trace_len++] = 'a';
+    return false;
+}
+
+static bool task_b(void *user) {
+    scheduler_t *s = (scheduler_t *)user;
+    trace[trace_len++] = 'b';
+    if (task_b_more == 2) {
+        sched_signal(s, 0x01u);  /* an "ISR" wakes task a mid-slice */
+    }
+    return --task_b_more > 0;
+}
+
+static bool task_c(void *user) {
+    (void)user;
+    trace[trace_len++] = 'c';
+    return false;
+}
+
+static void trace_reset(void) {
+    memset(trace, 0, sizeof(trace));
+    trace_len = 0;
+}
+
+// Tasks run one slice at a time in registration (priority) order
+void test_sched_priority_order() {
+    printf("Testing scheduler priority order...\n");
+
+    scheduler_t s;
+    sched_init(&s);
+    assert(sched_add_task(&s, task_a, &s, 0x01u) == 0);
+    assert(sched_add_task(&s, task_c, &s, 0x01u | 0x04u) == 1);
+    assert(!sched_run_once(&s));
+    assert(!sched_has_work(&s));
+
+    trace_reset();
+    sched_signal(&s, 0x04u);
+    assert(sched_has_work(&s));
+    assert(sched_run_once(&s));
+    assert(!sched_run_once(&s));
+    assert(strcmp(trace, "c") == 0);
+
+    trace_reset();
+    sched_signal(&s, 0x01u);
+    while (sched_run_once(&s)) {}
+    assert(strcmp(trace, "ac") == 0);
+    assert(s.tasks[0].runs == 1 && s.tasks[1].runs == 2);
+
+    printf("  [PASSED]\n");
+}
+
+// A task with more work stays ready, but an event posted during its slice
+// runs the higher-priority task first
+void test_sched_preempts_between_slices() {
+    printf("Testing scheduler re-checks events between slices...\n");
+
+    scheduler_t s;
+    sched_init(&s);
+    sched_add_task(&s, task_a, &s, 0x01u);
+    int b = sched_add_task(&s, task_b, &s, 0x02u);
+
+    trace_reset();
+    task_b_more = 4;
+    sched_signal(&s, 0x02u);
+    while (sched_run_once(&s)) {}
+    assert(strcmp(trace, "bbbab") == 0);
+
+    /* sched_set_ready() runs a task without an event */
+    trace_reset();
+    task_b_more = 1;
+    sched_set_ready(&s, b);
+    assert(sched_run_once(&s));
+    assert(strcmp(trace, "b") == 0);
+
+    /* Table full */
+    for (unsigned i = 2; i < SCHED_MAX_TASKS; i++) {
+        assert(sched_add_task(&s, task_c, &s, 0u) == (int)i);
+    }
+    assert(sched_add_task(&s, task_c, &s, 0u) == -1);
+
+    printf("  [PASSED]\n");
+}
+
+/* ----------------------------- Pipeline tests ----------------------------- */
+
+static pipeline_t pl;
+
+static void send(const char *s) {
+    pipeline_rx_isr(&pl, (const uint8_t *)s, strlen(s));
+}
+
+/* Run slices until all work is done, firing the step timer like the
+ * hardware would and ticking the millisecond clock when the loop sleeps
+ */
+static void run_until_idle(unsigned max_slices) {
+    for (unsigned i = 0; i < max_slices; i++) {
+        if (mock_timer_armed) {
+            mock_on_step(mock_timer_user);
+            mock_on_pulse_end(mock_timer_user);
+        }
+        if (pipeline_poll(&pl) || mock_timer_armed) {
+            continue;
+        }
+        if (stepper_is_idle(&pl.stepper) && planner_is_empty(&pl.sys.planner) &&
+            !pl.line_owed && !protocol_has_line(&pl.proto) && pl.sys.state != SYS_STATE_RUNNING) {
+            return;
+        }
+        mock_time_ms++;
+        pipeline_tick_isr(&pl);
+    }
+    assert(!"pipeline did not drain");
+}
+
+static void pipeline_setup(void) {
+    reset_mocks();
+    kin_corexy_install(NULL);
+    pipeline_init(&pl, NULL);
+}
+
+// Lines flow RX -> gcode -> planner -> stepper; each gets an "ok"
+void test_pipeline_streams_lines() {
+    printf("Testing pipeline streams lines to the stepper...\n");
+
+    pipeline_setup();
+    send("G21 G90\nG1 X1 F600\n\nG1 Y1\n");
+    run_until_idle(200000);
+
+    assert(strcmp(mock_tx, "ok\r\nok\r\nok\r\n") == 0);  /* blank line dropped by protocol */
+    assert(pl.sys.state == SYS_STATE_IDLE);
+    assert(stepper_is_idle(&pl.stepper));
+
+    kin_cart_t pos;
+    stepper_get_cart_position(&pl.stepper, &pos);
+    assert(pos.v[0] > 0.99f && pos.v[0] < 1.01f);
+    assert(pos.v[1] > 0.99f && pos.v[1] < 1.01f);
+
+    /* Bad line: the host matches "error:<code>" */
+    mock_tx_len = 0;
+    send("G1 X\n");
+    run_until_idle(1000);
+    assert(strcmp(mock_tx, "error:2\r\n") == 0);  /* GCODE_ERR_INVALID_PARAM */
+
+    /* Overlong line, rejected by the protocol layer */
+    static char longline[PROTOCOL_LINE_MAX + 8u];
+    memset(longline, 'X', sizeof(longline));
+    longline[sizeof(longline) - 2u] = '\n';
+    longline[sizeof(longline) - 1u] = '\0';
+    mock_tx_len = 0;
+    send(longline);
+    run_until_idle(1000);
+    assert(strcmp(mock_tx, "error:8\r\n") == 0);  /* SYS_ERR_LINE_OVERFLOW */
+
+    printf("  [PASSED]\n");
+}
+
+// '?' is answered from the realtime task before queued lines execute
+void test_pipeline_realtime_first() {
+    printf("Testing pipeline serves realtime commands ahead of lines...\n");
+
+    pipeline_setup();
+    send("G1 X5 F600\n?");
+    assert(pipeline_poll(&pl));
+    assert(strncmp(mock_tx, "<Idle", 5) == 0);
+
+    run_until_idle(400000);
+    assert(strstr(mock_tx, ">\r\nok\r\n") != NULL);
+
+    /* Feed hold parks the stepper; lines wait; cycle start resumes */
+    mock_tx_len = 0;
+    send("G1 X0\n");
+    for (int i = 0; i < 50; i++) pipeline_poll(&pl);
+    assert(pl.sys.state == SYS_STATE_RUNNING);
+    send("!");
+    pipeline_poll(&pl);
+    assert(pl.sys.state == SYS_STATE_HOLD);
+
+    /* The stepper ramps down along the profile before it parks */
+    assert(stepper_get_state(&pl.stepper) == STEPPER_RUNNING);
+    for (unsigned i = 0; i < 400000u && stepper_get_state(&pl.stepper) != STEPPER_HOLD; i++) {
+        if (mock_timer_armed) {
+            mock_on_step(mock_timer_user);
+            mock_on_pulse_end(mock_timer_user);
+        }
+        pipeline_poll(&pl);
+    }
+    assert(stepper_get_state(&pl.stepper) == STEPPER_HOLD);
+    assert(!mock_timer_armed);
+    kin_cart_t held;
+    stepper_get_cart_position(&pl.stepper, &held);
+    assert(held.v[0] < 4.99f && held.v[0] > 0.01f);  /* stopped short of X0 */
+    send("G1 Y2\n");
+    for (int i = 0; i < 50; i++) pipeline_poll(&pl);
+    assert(strcmp(mock_tx, "ok\r\n") == 0);  /* G1 Y2 not taken yet */
+
+    send("~");
+    run_until_idle(400000);
+    assert(strcmp(mock_tx, "ok\r\nok\r\n") == 0);
+    assert(pl.sys.state == SYS_STATE_IDLE);
+
+    printf("  [PASSED]\n");
+}
+
+// A limit edge halts motion at the next slice
+void test_pipeline_limit_alarm() {
+    printf("Testing pipeline limit event halts motion...\n");
+
+    pipeline_setup();
+    send("G1 X50 F600\n");
+    for (int i = 0; i < 20; i++) pipeline_poll(&pl);
+    assert(stepper_get_state(&pl.stepper) == STEPPER_RUNNING);
+
+    mock_inputs.limit_x = true;
+    pipeline_limit_isr(&pl);
+    assert(pipeline_poll(&pl));
+    assert(pl.sys.state == SYS_STATE_ALARM);
+    assert(pl.sys.alarm == SYS_ALARM_HARD_LIMIT);
+    assert(stepper_is_idle(&pl.stepper));
+    assert(!mock_timer_armed);
+
+    printf("  [PASSED]\n");
+}
+
+// With input interrupts the step timer stops inside the ISR, before any
+// main-loop slice runs; the limits task then raises the alarm
+void test_pipeline_limit_irq() {
+    printf("Testing pipeline limit interrupt stops steps in the ISR...\n");
+
+    mock_inputs_irq = true;
+    pipeline_setup();
+    assert(pl.sys.inputs_irq);
+    send("G1 X50 F600\n");
+    for (int i = 0; i < 20; i++) pipeline_poll(&pl);
+    assert(mock_timer_armed);
+
+    /* A busy main loop does not delay the stop */
+    hal_inputs_t in;
+    memset(&in, 0, sizeof(in));
+    in.limit_x = true;
+    mock_on_inputs(&in, mock_inputs_user);
+    assert(!mock_timer_armed && stepper_is_halted(&pl.stepper));
+    assert(pl.sys.state == SYS_STATE_RUNNING);
+
+    mock_timer_armed = true;  /* pending step IRQ */
+    mock_on_step(mock_timer_user);
+    assert(!mock_timer_armed);
+
+    assert(pipeline_poll(&pl));
+    assert(pl.sys.state == SYS_STATE_ALARM && pl.sys.alarm == SYS_ALARM_HARD_LIMIT);
+    assert(stepper_is_idle(&pl.stepper) && !stepper_is_halted(&pl.stepper));
+
+    /* Inputs are not polled when edges come by interrupt */
+    assert(system_clear_alarm(&pl.sys));
+    mock_inputs.limit_x = true;
+    pipeline_limit_isr(&pl);
+    pipeline_poll(&pl);
+    assert(pl.sys.state == SYS_STATE_IDLE);
+    mock_inputs_irq = false;
+
+    printf("  [PASSED]\n");
+}
+
+int main(void) {
+    printf("Running scheduler tests...\n\n");
+
+    test_sched_priority_order();
+    test_sched_preempts_between_slices();
+    test_pipeline_streams_lines();
+    test_pipeline_realtime_first();
+    test_pipeline_limit_alarm();
+    test_pipeline_limit_irq();
+
+    printf("\n=== All scheduler tests passed! ===\n");
+    return 0;
+}
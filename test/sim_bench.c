@@ -0,0 +1,454 @@
+/* sim_bench.c - Host throughput benchmark and streaming simulator
+ *
+ * Usage: grbl_sim_bench [--json out.json] [--baud N] [file.gcode ...]
+ *
+ * Built by CMake against the grbl library and examples/hal_mock.c; run it
+ * with "cmake --build <dir> --target bench". Three passes over the corpus:
+ *  1. parse:   gcode_parse_line() only                      -> lines/s
+ *     check:   gcode_process_line() in check mode ($C)      -> lines/s
+ *  2. plan:    gcode_process_line() into a planner that the
+ *              bench drains one block at a time when full   -> blocks/s
+ *  3. stream:  the whole pipeline (protocol -> gcode -> planner -> stepper)
+ *              on the mock's virtual clock, fed like a host with
+ *              character-counting flow control at --baud; every step
+ *              timer event is fired
+ * Pass 3 reports simulated job time, step rates, planner starvation
+ * (look-ahead down to the executing block while the host still owes
+ * lines: count and time), segment underruns
+ * (the step ISR ran out of segments mid-block), buffer high-water marks and
+ * the static RAM of the core. Without files a built-in corpus is used.
+ * The exit status is nonzero if any line failed or the stream stalled.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+#include "pipeline.h"
+#include "kin_corexy.h"
+#include "hal_mock.h"
+
+#define BENCH_MAX_LINES  50000
+#define BENCH_LINE_MAX   96
+#define BENCH_MIN_SECONDS 0.25   /* Passes 1 and 2 repeat the corpus at least this long */
+#define BENCH_BAUD       115200u
+#define BENCH_TIMEOUT_US (4ull * 3600u * 1000000u)  /* Virtual time before a stall is declared */
+
+static char corpus[BENCH_MAX_LINES][BENCH_LINE_MAX];
+static int corpus_lines = 0;
+
+static pipeline_t pl;
+
+/* ----------------------------- Corpus ----------------------------- */
+
+/* Clean a line the way the host streamer does (software/streaming.py):
+ * comments and surrounding whitespace removed, blank lines dropped. The
+ * controller does not acknowledge lines that end up empty.
+ */
+static void add_line(const char *line) {
+    if (corpus_lines >= BENCH_MAX_LINES) return;
+    char *out = corpus[corpus_lines];
+    size_t n = 0;
+    int depth = 0;
+    for (; *line && *line != ';' && *line != '\r' && *line != '\n'; line++) {
+        if (*line == '(') depth++;
+        else if (*line == ')' && depth > 0) depth--;
+        else if (depth == 0 && n < BENCH_LINE_MAX - 1) out[n++] = *line;
+    }
+    while (n > 0 && isspace((unsigned char)out[n - 1])) n--;
+    out[n] = '\0';
+    size_t lead = strspn(out, " \t");
+    memmove(out, out + lead, n - lead + 1u);
+    if (out[0] != '\0') corpus_lines++;
+}
+
+static void load_file(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "cannot open %s\n", path);
+        exit(2);
+    }
+    char buf[256];
+    while (fgets(buf, sizeof(buf), f)) add_line(buf);
+    fclose(f);
+}
+
+/* Engraving job: short-segment outlines, arcs, plunges, dwells, rapids */
+static void build_builtin_corpus(void) {
+    char buf[BENCH_LINE_MAX];
+    add_line("(sim_bench corpus)");
+    add_line("G90");
+    add_line("G0 Z5.000");
+    add_line("M3 S1000");
+    add_line("G4 P0.2");
+    for (int path = 0; path < 24; path++) {
+        float cx = 20.0f + 12.0f * (float)(path % 6);
+        float cy = 20.0f + 12.0f * (float)(path / 6);
+        snprintf(buf, sizeof(buf), "G0 X%.3f Y%.3f", cx + 5.0f, cy);
+        add_line(buf);
+        add_line("G1 Z-0.500 F300.000");
+        for (int k = 1; k <= 240; k++) {
+            float a = (float)k * 0.0261799f;
+            float r = 5.0f + 1.0f * sinf(6.0f * a);
+            snprintf(buf, sizeof(buf), "G1 X%.3f Y%.3f F1200.000",
+                     cx + r * cosf(a), cy - r * sinf(a));
+            add_line(buf);
+        }
+        snprintf(buf, sizeof(buf), "G2 X%.3f Y%.3f I-2.500 J0.000 F900", cx, cy);
+        add_line(buf);
+        snprintf(buf, sizeof(buf), "G3 X%.3f Y%.3f I2.500 J0.000", cx + 5.0f, cy);
+        add_line(buf);
+        add_line("G0 Z5.000");
+    }
+    add_line("M5");
+    add_line("G0 X0 Y0");
+}
+
+/* ----------------------------- Helpers ----------------------------- */
+
+static double seconds_since(clock_t t0) {
+    return (double)(clock() - t0) / CLOCKS_PER_SEC;
+}
+
+static double per_second(double n, double s) {
+    return s > 0.0 ? n / s : 0.0;
+}
+
+/* ----------------------------- Pass 1: parse ----------------------------- */
+
+static double bench_parse(void) {
+    gcode_block_t block;
+    volatile float sink = 0.0f;
+    double lines = 0.0;
+    clock_t t0 = clock();
+    do {
+        for (int i = 0; i < corpus_lines; i++) {
+            gcode_parse_line(corpus[i], &block);
+            sink += block.x;
+        }
+        lines += (double)corpus_lines;
+    } while (seconds_since(t0) < BENCH_MIN_SECONDS);
+    (void)sink;
+    return per_second(lines, seconds_since(t0));
+}
+
+/* ----------------------------- Pass 2: plan ----------------------------- */
+
+static gcode_state_t plan_gc;
+static planner_queue_t plan_queue;
+
+/* Check mode validates against the modal state but queues nothing */
+static double bench_check(uint32_t *errors_out) {
+    uint32_t errors = 0;
+    double lines = 0.0;
+    clock_t t0 = clock();
+    do {
+        gcode_init(&plan_gc);
+        planner_queue_init(&plan_queue);
+        gcode_attach_planner(&plan_gc, &plan_queue);
+        gcode_set_check_mode(&plan_gc, true);
+        errors = 0;
+        for (int i = 0; i < corpus_lines; i++) {
+            if (gcode_process_line(&plan_gc, corpus[i]) != GCODE_OK) errors++;
+        }
+        lines += (double)corpus_lines;
+    } while (seconds_since(t0) < BENCH_MIN_SECONDS);
+    *errors_out = errors;
+    return per_second(lines, seconds_since(t0));
+}
+
+static double bench_plan(uint32_t *blocks_out) {
+    uint64_t blocks = 0;
+    uint32_t rounds = 0;
+    clock_t t0 = clock();
+    do {
+        gcode_init(&plan_gc);
+        planner_queue_init(&plan_queue);
+        gcode_attach_planner(&plan_gc, &plan_queue);
+        for (int i = 0; i < corpus_lines; i++) {
+            for (;;) {
+                uint8_t tail = plan_queue.tail;
+                gcode_status_t st = gcode_process_line(&plan_gc, corpus[i]);
+                blocks += (uint8_t)(plan_queue.tail - tail);
+                if (st != GCODE_BUSY) break;
+                planner_dequeue(&plan_queue);  /* keep the look-ahead ring full */
+            }
+        }
+        rounds++;
+    } while (seconds_since(t0) < BENCH_MIN_SECONDS);
+    double s = seconds_since(t0);
+    *blocks_out = (uint32_t)(blocks / rounds);
+    return per_second((double)blocks, s);
+}
+
+/* ----------------------------- Pass 3: stream ----------------------------- */
+
+typedef struct {
+    /* Host side */
+    int sent;                     /* Lines fully pushed onto the wire */
+    size_t sent_off;              /* Bytes of corpus[sent] already pushed */
+    bool sent_open;               /* corpus[sent] is counted in in_flight */
+    int acked;                    /* ok / error replies received */
+    size_t in_flight;             /* Bytes sent and not yet acknowledged */
+    double wire_budget;           /* Bytes the UART may still carry this ms */
+    uint32_t errors;
+    char rx_line[128];            /* Reply being assembled */
+    size_t rx_len;
+
+    /* Controller side */
+    uint32_t blocks;
+    uint64_t step_events;         /* Step timer update events */
+    uint32_t min_period;          /* Shortest timer period (ticks) */
+    uint64_t steps_mark;          /* Pulses at the previous ms boundary */
+    uint32_t peak_steps_ms;       /* Most pulses (all axes) in one ms */
+    uint32_t starvations;
+    uint64_t starved_us;          /* Virtual time spent starved */
+    uint32_t underruns;
+    uint32_t planner_peak;
+    uint32_t rx_peak;
+    bool stalled;
+} stream_t;
+
+static stream_t st;
+
+static size_t line_bytes(int i) {
+    return strlen(corpus[i]) + 1u;
+}
+
+static void on_reply_line(const char *line) {
+    bool ok = strncmp(line, "ok", 2) == 0;
+    bool err = strncmp(line, "error", 5) == 0;
+    if (!ok && !err) return;  /* status / report lines */
+    if (err) st.errors++;
+    if (st.acked < st.sent || (st.acked == st.sent && st.sent_open)) {
+        st.in_flight -= line_bytes(st.acked);
+        st.acked++;
+    }
+}
+
+static void on_tx(const uint8_t *data, size_t len, void *user) {
+    (void)user;
+    for (size_t i = 0; i < len; i++) {
+        char c = (char)data[i];
+        if (c == '\r') continue;
+        if (c == '\n') {
+            st.rx_line[st.rx_len] = '\0';
+            on_reply_line(st.rx_line);
+            st.rx_len = 0;
+        } else if (st.rx_len < sizeof(st.rx_line) - 1u) {
+            st.rx_line[st.rx_len++] = c;
+        }
+    }
+}
+
+/* One millisecond of UART: push as much of the stream as flow control allows */
+static void host_feed(double bytes_per_ms) {
+    st.wire_budget += bytes_per_ms;
+    while (st.sent < corpus_lines && st.wire_budget >= 1.0) {
+        size_t len = line_bytes(st.sent);
+        if (!st.sent_open) {
+            if (st.in_flight + len > PROTOCOL_RX_BUFFER_SIZE) break;
+            st.in_flight += len;
+            st.sent_open = true;
+        }
+        size_t n = len - st.sent_off;
+        if ((double)n > st.wire_budget) n = (size_t)st.wire_budget;
+
+        uint8_t wire[BENCH_LINE_MAX + 1];
+        memcpy(wire, corpus[st.sent], len - 1u);
+        wire[len - 1u] = '\n';
+        size_t pushed = hal_mock_rx_push(wire + st.sent_off, n);
+        st.wire_budget -= (double)pushed;
+        st.sent_off += pushed;
+        if (pushed < n) break;
+
+        if (st.sent_off == len) {
+            st.sent++;
+            st.sent_off = 0;
+            st.sent_open = false;
+        }
+    }
+    /* A blocked or idle wire does not bank bandwidth */
+    double cap = bytes_per_ms > 1.0 ? bytes_per_ms : 1.0;
+    if (st.wire_budget > cap) st.wire_budget = cap;
+}
+
+static uint64_t total_steps(void) {
+    uint64_t steps = 0;
+    for (unsigned a = 0; a < HAL_AXIS_MAX; a++) steps += hal_mock_step_count((hal_axis_t)a);
+    return steps;
+}
+
+static bool job_done(void) {
+    return st.acked == corpus_lines && !pl.line_owed &&
+           planner_is_empty(&pl.sys.planner) && stepper_is_idle(&pl.stepper) &&
+           !hal_mock_step_timer_armed();
+}
+
+/* Run every ready task, then sample the buffers */
+static void drain_tasks(void) {
+    uint8_t tail = pl.sys.planner.tail;
+    while (pipeline_poll(&pl)) {
+        st.blocks += (uint8_t)(pl.sys.planner.tail - tail);
+        tail = pl.sys.planner.tail;
+    }
+    uint32_t queued = planner_block_count(&pl.sys.planner);
+    uint32_t rx_used = (uint32_t)(PROTOCOL_RX_BUFFER_SIZE - protocol_rx_free(&pl.proto));
+    if (queued > st.planner_peak) st.planner_peak = queued;
+    if (rx_used > st.rx_peak) st.rx_peak = rx_used;
+}
+
+static double bench_stream(uint32_t baud, double *sim_s) {
+    memset(&st, 0, sizeof(st));
+    st.min_period = UINT32_MAX;
+    hal_mock_reset();
+    hal_mock_set_tx_hook(on_tx, NULL);
+    pipeline_init(&pl, NULL);
+
+    const double bytes_per_ms = (double)baud / 10.0 / 1000.0;  /* 8N1 */
+    bool started = false;
+    bool was_starved = false;
+    uint64_t starved_since = 0;
+    clock_t t0 = clock();
+
+    host_feed(bytes_per_ms);
+    pipeline_tick_isr(&pl);
+    while (!job_done()) {
+        drain_tasks();
+
+        /* Look-ahead ran dry: only the executing block (or nothing) is left
+         * although the host still owes lines
+         */
+        bool fed = planner_block_count(&pl.sys.planner) > 1u;
+        bool starved = !fed && started && st.acked < corpus_lines;
+        if (starved && !was_starved) {
+            st.starvations++;
+            starved_since = hal_mock_now_us();
+        } else if (!starved && was_starved) {
+            st.starved_us += hal_mock_now_us() - starved_since;
+        }
+        was_starved = starved;
+        if (!stepper_is_idle(&pl.stepper)) started = true;
+
+        uint64_t now = hal_mock_now_us();
+        if (now >= BENCH_TIMEOUT_US) {
+            st.stalled = true;
+            break;
+        }
+        if (hal_mock_advance((now / 1000u + 1u) * 1000u)) {
+            st.step_events++;
+            uint32_t period = hal_mock_step_timer_period();
+            if (period && period < st.min_period) st.min_period = period;
+            if (!hal_mock_step_timer_armed() && !pl.stepper.block_done && !pl.stepper.halted) {
+                st.underruns++;
+            }
+            continue;
+        }
+
+        /* Millisecond boundary */
+        uint64_t pulses = total_steps();
+        if (pulses - st.steps_mark > st.peak_steps_ms) st.peak_steps_ms = (uint32_t)(pulses - st.steps_mark);
+        st.steps_mark = pulses;
+        host_feed(bytes_per_ms);
+        pipeline_tick_isr(&pl);
+    }
+
+    if (was_starved) st.starved_us += hal_mock_now_us() - starved_since;
+    *sim_s = (double)hal_mock_now_us() / 1e6;
+    return seconds_since(t0);
+}
+
+/* ----------------------------- Report ----------------------------- */
+
+int main(int argc, char **argv) {
+    const char *json_path = NULL;
+    uint32_t baud = BENCH_BAUD;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (strcmp(argv[i], "--baud") == 0 && i + 1 < argc) {
+            baud = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else {
+            load_file(argv[i]);
+        }
+    }
+    if (corpus_lines == 0) build_builtin_corpus();
+    if (baud == 0u) baud = BENCH_BAUD;
+
+    kin_corexy_install(NULL);
+
+    uint32_t plan_blocks = 0;
+    double parse_lps = bench_parse();
+    uint32_t check_errors = 0;
+    double check_lps = bench_check(&check_errors);
+    double plan_bps = bench_plan(&plan_blocks);
+    double sim_s = 0.0;
+    double wall_s = bench_stream(baud, &sim_s);
+
+    uint64_t steps = total_steps();
+    double step_avg = per_second((double)steps, sim_s);
+    double step_peak = (double)st.peak_steps_ms * 1000.0;
+    double isr_peak = st.min_period != UINT32_MAX
+                    ? (double)hal_step_timer_freq_hz() / (double)st.min_period : 0.0;
+
+    printf("corpus:               %10d lines\n", corpus_lines);
+    printf("parse:                %10.0f lines/s\n", parse_lps);
+    printf("check:                %10.0f lines/s (%u errors)\n", check_lps, (unsigned)check_errors);
+    printf("plan:                 %10.0f blocks/s (%u blocks)\n", plan_bps, (unsigned)plan_blocks);
+    printf("stream @%u baud:   %10.3f s simulated, %.3f s host\n", (unsigned)baud, sim_s, wall_s);
+    printf("steps:                %10llu (avg %.0f Hz, peak %.0f Hz)\n",
+           (unsigned long long)steps, step_avg, step_peak);
+    printf("step timer events:    %10llu (peak %.0f Hz)\n",
+           (unsigned long long)st.step_events, isr_peak);
+    printf("planner starvation:   %10u (%.3f s)\n", (unsigned)st.starvations, (double)st.starved_us / 1e6);
+    printf("segment underruns:    %10u\n", (unsigned)st.underruns);
+    printf("peak planner / rx:    %10u / %u\n", (unsigned)st.planner_peak, (unsigned)st.rx_peak);
+    printf("static RAM:           %10u bytes\n", (unsigned)sizeof(pipeline_t));
+    printf("errors:               %10u%s\n", (unsigned)st.errors, st.stalled ? " (STALLED)" : "");
+
+    if (json_path) {
+        FILE *f = fopen(json_path, "w");
+        if (!f) {
+            fprintf(stderr, "cannot write %s\n", json_path);
+            return 2;
+        }
+        fprintf(f, "{\n");
+        fprintf(f, "  \"corpus_lines\": %d,\n", corpus_lines);
+        fprintf(f, "  \"parse_lines_per_s\": %.0f,\n", parse_lps);
+        fprintf(f, "  \"check_lines_per_s\": %.0f,\n", check_lps);
+        fprintf(f, "  \"check_errors\": %u,\n", (unsigned)check_errors);
+        fprintf(f, "  \"plan_blocks\": %u,\n", (unsigned)plan_blocks);
+        fprintf(f, "  \"plan_blocks_per_s\": %.0f,\n", plan_bps);
+        fprintf(f, "  \"stream\": {\n");
+        fprintf(f, "    \"baud\": %u,\n", (unsigned)baud);
+        fprintf(f, "    \"blocks\": %u,\n", (unsigned)st.blocks);
+        fprintf(f, "    \"sim_seconds\": %.6f,\n", sim_s);
+        fprintf(f, "    \"host_seconds\": %.6f,\n", wall_s);
+        fprintf(f, "    \"steps\": %llu,\n", (unsigned long long)steps);
+        fprintf(f, "    \"step_rate_avg_hz\": %.0f,\n", step_avg);
+        fprintf(f, "    \"step_rate_peak_hz\": %.0f,\n", step_peak);
+        fprintf(f, "    \"timer_events\": %llu,\n", (unsigned long long)st.step_events);
+        fprintf(f, "    \"timer_rate_peak_hz\": %.0f,\n", isr_peak);
+        fprintf(f, "    \"planner_starvation_events\": %u,\n", (unsigned)st.starvations);
+        fprintf(f, "    \"planner_starved_seconds\": %.6f,\n", (double)st.starved_us / 1e6);
+        fprintf(f, "    \"segment_underruns\": %u,\n", (unsigned)st.underruns);
+        fprintf(f, "    \"planner_peak_blocks\": %u,\n", (unsigned)st.planner_peak);
+        fprintf(f, "    \"rx_peak_bytes\": %u,\n", (unsigned)st.rx_peak);
+        fprintf(f, "    \"errors\": %u,\n", (unsigned)st.errors);
+        fprintf(f, "    \"stalled\": %s\n", st.stalled ? "true" : "false");
+        fprintf(f, "  },\n");
+        fprintf(f, "  \"ram_bytes\": {\n");
+        fprintf(f, "    \"total\": %u,\n", (unsigned)sizeof(pipeline_t));
+        fprintf(f, "    \"planner\": %u,\n", (unsigned)sizeof(planner_queue_t));
+        fprintf(f, "    \"stepper\": %u,\n", (unsigned)sizeof(stepper_context_t));
+        fprintf(f, "    \"protocol\": %u,\n", (unsigned)sizeof(protocol_t));
+        fprintf(f, "    \"system\": %u\n", (unsigned)sizeof(system_context_t));
+        fprintf(f, "  }\n");
+        fprintf(f, "}\n");
+        fclose(f);
+    }
+
+    return (st.errors || st.stalled) ? 1 : 0;
+}
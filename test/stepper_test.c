@@ -1,6 +1,7 @@
 #include <assert.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
 #include "../src/stepper.h"
 #include "../src/planner.h"
 #include "../src/hal.h"
@@ -47,8 +48,82 @@ void hal_stepper_step_clear(hal_axis_t axis) {
     }
 }
 
+static uint32_t mock_pulse_mask_calls = 0;
+
 void hal_stepper_pulse_mask(uint32_t axis_mask) {
-    (void)axis_mask;
+    mock_pulse_mask_calls++;
+    for (int i = 0; i < HAL_AXIS_MAX; i++) {
+        if (axis_mask & (1u << i)) mock_step_pulse_state[i] = true;
+    }
+}
+
+void hal_stepper_clear_mask(uint32_t axis_mask) {
+    for (int i = 0; i < HAL_AXIS_MAX; i++) {
+        if (axis_mask & (1u << i)) mock_step_pulse_state[i] = false;
+    }
+}
+
+/* Mock step timer: records arm/stop and lets tests fire the ISRs by hand */
+static hal_timer_cb_t mock_timer_on_step = NULL;
+static hal_timer_cb_t mock_timer_on_pulse_end = NULL;
+static void *mock_timer_user = NULL;
+static bool mock_timer_armed = false;
+static uint32_t mock_timer_period = 0;
+static uint32_t mock_step_pulses[HAL_AXIS_MAX];
+
+void hal_step_timer_init(hal_timer_cb_t on_step, hal_timer_cb_t on_pulse_end, void *user) {
+    mock_timer_on_step = on_step;
+    mock_timer_on_pulse_end = on_pulse_end;
+    mock_timer_user = user;
+}
+
+uint32_t hal_step_timer_freq_hz(void) {
+    return 1000000u;  /* 1 tick = 1 us */
+}
+
+void hal_step_timer_arm(uint32_t period_ticks) {
+    mock_timer_armed = true;
+    mock_timer_period = period_ticks;
+}
+
+void hal_step_timer_reload(uint32_t period_ticks) {
+    mock_timer_period = period_ticks;
+}
+
+void hal_step_timer_compare(uint32_t pulse_ticks) {
+    (void)pulse_ticks;
+}
+
+void hal_step_timer_stop(void) {
+    mock_timer_armed = false;
+}
+
+/* Fire one timer period: update event, then the pulse-low compare */
+static void mock_timer_fire(void) {
+    if (!mock_timer_armed) return;
+    mock_timer_on_step(mock_timer_user);
+    for (int i = 0; i < HAL_AXIS_MAX; i++) {
+        if (mock_step_pulse_state[i]) mock_step_pulses[i]++;
+    }
+    mock_timer_on_pulse_end(mock_timer_user);
+    mock_time_us += mock_timer_period;
+}
+
+/* Mock spindle output: last value written and the range seen */
+static hal_spindle_dir_t mock_spindle_dir = HAL_SPINDLE_OFF;
+static float mock_spindle_pwm = 0.0f;
+static float mock_spindle_pwm_min = 0.0f;
+static float mock_spindle_pwm_max = 0.0f;
+static uint32_t mock_spindle_calls = 0;
+
+void hal_spindle_set(hal_spindle_dir_t dir, float pwm_0_to_1) {
+    mock_spindle_dir = dir;
+    mock_spindle_pwm = pwm_0_to_1;
+    if (pwm_0_to_1 > 0.0f && (mock_spindle_pwm_min == 0.0f || pwm_0_to_1 < mock_spindle_pwm_min)) {
+        mock_spindle_pwm_min = pwm_0_to_1;
+    }
+    if (pwm_0_to_1 > mock_spindle_pwm_max) mock_spindle_pwm_max = pwm_0_to_1;
+    mock_spindle_calls++;
 }
 
 /* Mock kinematics */
@@ -67,6 +142,15 @@ void reset_mocks(void) {
     mock_time_ms = 0;
     memset(mock_dir_state, 0, sizeof(mock_dir_state));
     memset(mock_step_pulse_state, 0, sizeof(mock_step_pulse_state));
+    memset(mock_step_pulses, 0, sizeof(mock_step_pulses));
+    mock_pulse_mask_calls = 0;
+    mock_timer_armed = false;
+    mock_timer_period = 0;
+    mock_spindle_dir = HAL_SPINDLE_OFF;
+    mock_spindle_pwm = 0.0f;
+    mock_spindle_pwm_min = 0.0f;
+    mock_spindle_pwm_max = 0.0f;
+    mock_spindle_calls = 0;
     
     /* Set up minimal kinematics */
     g_kin.cart_axes = 3;
@@ -172,11 +256,13 @@ void test_stepper_load_block(void) {
     /* Create a valid planner block */
     planner_block_t block;
     planner_block_init(&block);
-    block.entry_speed = 100.0f;
+    block.entry_speed_sqr = 100.0f * 100.0f;
     block.nominal_speed = 200.0f;
-    block.exit_speed = 50.0f;
+    block.exit_speed_sqr = 50.0f * 50.0f;
     block.acceleration = 500.0f;
     block.millimeters = 10.0f;
+    block.inv_millimeters = 1.0f / 10.0f;
+    block.steps[HAL_AXIS_X] = 1000;
     block.step_event_count = 1000;
     block.direction_bits = 0x01;  /* X axis positive */
     
@@ -227,7 +313,7 @@ void test_stepper_queries(void) {
     /* Load a block */
     planner_block_t block;
     planner_block_init(&block);
-    block.entry_speed = 100.0f;
+    block.entry_speed_sqr = 100.0f * 100.0f;
     block.nominal_speed = 200.0f;
     block.step_event_count = 100;
     
@@ -252,7 +338,7 @@ void test_stepper_hold_resume(void) {
     /* Load a block */
     planner_block_t block;
     planner_block_init(&block);
-    block.entry_speed = 100.0f;
+    block.entry_speed_sqr = 100.0f * 100.0f;
     block.nominal_speed = 200.0f;
     block.step_event_count = 100;
     
@@ -281,7 +367,7 @@ void test_stepper_stop(void) {
     /* Load a block */
     planner_block_t block;
     planner_block_init(&block);
-    block.entry_speed = 100.0f;
+    block.entry_speed_sqr = 100.0f * 100.0f;
     block.nominal_speed = 200.0f;
     block.step_event_count = 100;
     
@@ -357,6 +443,871 @@ void test_stepper_config(void) {
     printf("[passed]\n");
 }
 
+/* Test that the step timer ISR executes a block without blocking */
+void test_stepper_isr_execution(void) {
+    printf("Testing stepper ISR-driven execution...\n");
+    reset_mocks();
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    assert(mock_timer_on_step != NULL);
+    assert(mock_timer_on_pulse_end != NULL);
+    
+    /* More steps than fit into one segment ring fill */
+    const uint32_t total = STEPPER_SEGMENT_BUFFER_SIZE * STEPPER_SEGMENT_MAX_STEPS + 10u;
+    planner_block_t block;
+    planner_block_init(&block);
+    block.entry_speed_sqr = 600.0f * 600.0f;   /* 10 steps/s at the assumed 1:1 ratio */
+    block.nominal_speed = 600.0f;
+    block.steps[HAL_AXIS_X] = total;
+    block.step_event_count = total;
+    block.direction_bits = 0x01;  /* X axis positive */
+    
+    assert(stepper_load_block(&ctx, &block));
+    assert(mock_timer_armed);
+    assert(mock_timer_period == 100000u);  /* 100 ms between steps */
+    
+    /* Loading must not busy-wait for direction setup */
+    assert(mock_time_ms == 0);
+    
+    /* Run ISR periods, letting the main loop refill segments in between */
+    for (uint32_t i = 0; i < total + 4u; i++) {
+        mock_timer_fire();
+        assert(!mock_step_pulse_state[HAL_AXIS_X]); /* pulse dropped by compare ISR */
+        stepper_update(&ctx);
+    }
+    
+    assert(mock_step_pulses[HAL_AXIS_X] == total);
+    assert(ctx.position.v[HAL_AXIS_X] == (int32_t)total);
+    assert(ctx.state == STEPPER_IDLE);
+    assert(ctx.current_block == NULL);
+    assert(!mock_timer_armed);
+    
+    /* The step path never fell back to millisecond delays */
+    assert(mock_time_ms == 0);
+    
+    printf("[passed]\n");
+}
+
+/* Test that hold stops the step timer and resume re-arms it */
+void test_stepper_isr_hold_resume(void) {
+    printf("Testing stepper ISR hold and resume...\n");
+    reset_mocks();
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    
+    planner_block_t block;
+    planner_block_init(&block);
+    block.entry_speed_sqr = 100.0f * 100.0f;
+    block.nominal_speed = 200.0f;
+    block.steps[HAL_AXIS_X] = 5;
+    block.step_event_count = 5;
+    block.direction_bits = 0x01;
+    
+    stepper_load_block(&ctx, &block);
+    mock_timer_fire();
+    mock_timer_fire();
+    assert(mock_step_pulses[HAL_AXIS_X] == 2);
+    
+    stepper_hold(&ctx);
+    assert(!mock_timer_armed);
+    mock_timer_fire();  /* timer stopped: nothing happens */
+    assert(mock_step_pulses[HAL_AXIS_X] == 2);
+    
+    stepper_resume(&ctx);
+    assert(mock_timer_armed);
+    for (int i = 0; i < 4; i++) {
+        mock_timer_fire();
+        stepper_update(&ctx);
+    }
+    assert(mock_step_pulses[HAL_AXIS_X] == 5);
+    assert(ctx.state == STEPPER_IDLE);
+    
+    printf("[passed]\n");
+}
+
+/* Test the limit/e-stop hard stop from interrupt context */
+void test_stepper_emergency_stop(void) {
+    printf("Testing stepper emergency stop from ISR...\n");
+    reset_mocks();
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    
+    planner_block_t block;
+    planner_block_init(&block);
+    block.entry_speed_sqr = 100.0f * 100.0f;
+    block.nominal_speed = 100.0f;
+    block.steps[HAL_AXIS_X] = 20;
+    block.step_event_count = 20;
+    block.direction_bits = 0x01;
+    
+    stepper_load_block(&ctx, &block);
+    for (int i = 0; i < 3; i++) {
+        mock_timer_fire();
+    }
+    
+    /* Trip lands between the step edge and the pulse-low compare */
+    mock_timer_on_step(mock_timer_user);
+    assert(mock_step_pulse_state[HAL_AXIS_X]);
+    stepper_emergency_stop(&ctx);
+    assert(stepper_is_halted(&ctx));
+    assert(!mock_timer_armed && !mock_step_pulse_state[HAL_AXIS_X]);
+    assert(mock_spindle_dir == HAL_SPINDLE_OFF);
+    
+    kin_steps_t pos;
+    stepper_get_position(&ctx, &pos);
+    assert(pos.v[HAL_AXIS_X] == 4);
+    
+    /* Nothing restarts the timer until reset */
+    stepper_update(&ctx);
+    stepper_hold(&ctx);
+    stepper_resume(&ctx);
+    assert(!mock_timer_armed);
+    mock_timer_armed = true;  /* a step IRQ already pending */
+    mock_timer_on_step(mock_timer_user);
+    assert(!mock_timer_armed && !mock_step_pulse_state[HAL_AXIS_X]);
+    stepper_get_position(&ctx, &pos);
+    assert(pos.v[HAL_AXIS_X] == 4);
+    
+    stepper_reset(&ctx);
+    assert(!stepper_is_halted(&ctx) && ctx.state == STEPPER_IDLE);
+    
+    printf("[passed]\n");
+}
+
+/* Test Bresenham distribution of a diagonal move across joints */
+void test_stepper_multi_axis_dda(void) {
+    printf("Testing stepper multi-axis Bresenham distribution...\n");
+    reset_mocks();
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    
+    /* e.g. a CoreXY move that drives A 30 steps forward and B 10 back */
+    planner_block_t block;
+    planner_block_init(&block);
+    block.entry_speed_sqr = 100.0f * 100.0f;
+    block.nominal_speed = 100.0f;
+    block.steps[HAL_AXIS_X] = 30;
+    block.steps[HAL_AXIS_Y] = 10;
+    block.step_event_count = 30;
+    block.direction_bits = 0x01;  /* X positive, Y negative */
+    
+    assert(stepper_load_block(&ctx, &block));
+    assert(mock_dir_state[HAL_AXIS_X] == true);
+    assert(mock_dir_state[HAL_AXIS_Y] == false);
+    
+    uint32_t max_y_gap = 0, gap = 0;
+    for (int i = 0; i < 30; i++) {
+        uint32_t y_before = mock_step_pulses[HAL_AXIS_Y];
+        mock_timer_fire();
+        stepper_update(&ctx);
+        if (mock_step_pulses[HAL_AXIS_Y] == y_before) {
+            gap++;
+        } else {
+            if (gap > max_y_gap) max_y_gap = gap;
+            gap = 0;
+        }
+    }
+    stepper_update(&ctx);
+    
+    assert(mock_step_pulses[HAL_AXIS_X] == 30);
+    assert(mock_step_pulses[HAL_AXIS_Y] == 10);
+    assert(mock_step_pulses[HAL_AXIS_Z] == 0);
+    assert(ctx.position.v[HAL_AXIS_X] == 30);
+    assert(ctx.position.v[HAL_AXIS_Y] == -10);
+    
+    /* Minor axis steps are evenly spread (every third event) */
+    assert(max_y_gap == 2);
+    
+    /* One GPIO write per tick, regardless of how many axes step */
+    assert(mock_pulse_mask_calls == 30);
+    assert(ctx.state == STEPPER_IDLE);
+    
+    printf("[passed]\n");
+}
+
+/* Test that an attached planner ring is consumed block by block */
+void test_stepper_planner_consumer(void) {
+    printf("Testing stepper consuming from the planner ring...\n");
+    reset_mocks();
+    
+    planner_queue_t queue;
+    planner_queue_init(&queue);
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    stepper_attach_planner(&ctx, &queue);
+    
+    planner_block_t block;
+    planner_block_init(&block);
+    block.entry_speed_sqr = 600.0f * 600.0f;
+    block.nominal_speed = 600.0f;
+    block.steps[HAL_AXIS_X] = 5;
+    block.step_event_count = 5;
+    block.direction_bits = 0x01;
+    assert(planner_enqueue(&queue, &block));
+    block.direction_bits = 0x00;
+    assert(planner_enqueue(&queue, &block));
+    
+    /* Idle stepper claims the front block in place */
+    stepper_update(&ctx);
+    assert(ctx.state == STEPPER_RUNNING);
+    assert(ctx.current_block == planner_peek_front(&queue));
+    assert(queue.current_in_use == 1);
+    assert(planner_block_count(&queue) == 2);
+    
+    for (int i = 0; i < 5; i++) {
+        mock_timer_fire();
+    }
+    assert(ctx.position.v[HAL_AXIS_X] == 5);
+    
+    /* Retiring the block hands its slot back and the next one starts */
+    stepper_update(&ctx);
+    assert(ctx.state == STEPPER_IDLE);
+    assert(planner_block_count(&queue) == 1);
+    assert(queue.current_in_use == 0);
+    
+    stepper_update(&ctx);
+    assert(ctx.state == STEPPER_RUNNING);
+    for (int i = 0; i < 5; i++) {
+        mock_timer_fire();
+    }
+    stepper_update(&ctx);
+    assert(ctx.position.v[HAL_AXIS_X] == 0);
+    assert(planner_is_empty(&queue));
+    
+    /* Nothing left to claim */
+    stepper_update(&ctx);
+    assert(ctx.state == STEPPER_IDLE);
+    assert(queue.current_in_use == 0);
+    
+    printf("[passed]\n");
+}
+
+/* Run a loaded block to completion, recording the time (us) between
+ * consecutive X steps. Returns the number of ISR events.
+ */
+static uint32_t run_block_periods(stepper_context_t *ctx, uint32_t *periods, uint32_t cap) {
+    uint32_t events = 0;
+    uint32_t n = 0;
+    uint32_t last_step_us = mock_time_us;
+    for (uint32_t guard = 0; guard < 1000000u && ctx->state != STEPPER_IDLE; guard++) {
+        uint32_t steps_before = mock_step_pulses[HAL_AXIS_X];
+        uint32_t start_us = mock_time_us;
+        if (mock_timer_armed) events++;
+        mock_timer_fire();
+        if (mock_step_pulses[HAL_AXIS_X] != steps_before) {
+            /* Pulse raised at the start of this period */
+            if (n < cap) periods[n] = start_us - last_step_us;
+            last_step_us = start_us;
+            n++;
+        }
+        stepper_update(ctx);
+    }
+    assert(ctx->state == STEPPER_IDLE);
+    return events;
+}
+
+/* 10 mm at 100 steps/mm, 0 -> 600 mm/min -> 0 at 100 mm/s^2 */
+static void make_accel_block(planner_block_t *block) {
+    planner_block_init(block);
+    block->millimeters = 10.0f;
+    block->inv_millimeters = 1.0f / 10.0f;
+    block->nominal_speed = 600.0f;
+    block->acceleration = 360000.0f;
+    block->steps[HAL_AXIS_X] = 1000;
+    block->step_event_count = 1000;
+    block->direction_bits = 0x01;
+}
+
+/* Test the trapezoid acceleration profile */
+void test_stepper_trapezoid_profile(void) {
+    printf("Testing stepper trapezoid acceleration...\n");
+    reset_mocks();
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    
+    planner_block_t block;
+    make_accel_block(&block);
+    assert(stepper_load_block(&ctx, &block));
+    assert(ctx.timed_profile);
+    
+    /* 1000 steps/s nominal, 10000 steps/s^2: 50 steps to ramp each way */
+    assert(ctx.accelerate_until == 50);
+    assert(ctx.decelerate_after == 950);
+    
+    static uint32_t periods[1000];
+    run_block_periods(&ctx, periods, 1000);
+    assert(mock_step_pulses[HAL_AXIS_X] == 1000);
+    
+    /* Slow at both ends, nominal rate (1 ms) in the middle */
+    assert(periods[1] > 3000u);
+    assert(periods[999] > 3000u);
+    assert(periods[500] >= 990u && periods[500] <= 1010u);
+    for (uint32_t i = 2; i < 40; i++) {
+        assert(periods[i] <= periods[i - 1]);        /* accelerating */
+        assert(periods[999 - i] <= periods[1000 - i]); /* decelerating */
+    }
+    
+    /* 0.1 s ramps + 0.9 s cruise */
+    assert(mock_time_us > 1080000u && mock_time_us < 1120000u);
+    
+    printf("[passed]\n");
+}
+
+/* Test a block too short to reach nominal speed */
+void test_stepper_triangle_profile(void) {
+    printf("Testing stepper triangle acceleration...\n");
+    reset_mocks();
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    
+    planner_block_t block;
+    make_accel_block(&block);
+    block.millimeters = 0.6f;
+    block.inv_millimeters = 1.0f / 0.6f;
+    block.steps[HAL_AXIS_X] = 60;
+    block.step_event_count = 60;
+    assert(stepper_load_block(&ctx, &block));
+    assert(ctx.accelerate_until == 30);
+    assert(ctx.decelerate_after == 30);
+    
+    /* Peak stays below nominal */
+    assert(ctx.phases[STEPPER_PHASE_ACCEL].v_end < 1000.0f);
+    assert(ctx.phases[STEPPER_PHASE_CRUISE].duration == 0.0f);
+    
+    static uint32_t periods[60];
+    run_block_periods(&ctx, periods, 60);
+    assert(mock_step_pulses[HAL_AXIS_X] == 60);
+    for (uint32_t i = 1; i < 60; i++) {
+        assert(periods[i] > 1000u);
+    }
+    
+    printf("[passed]\n");
+}
+
+/* Test a nominal speed change (feed override) mid-block is picked up by
+ * segment preparation without reloading the block
+ */
+void test_stepper_override_mid_block(void) {
+    printf("Testing stepper re-profiles a running block on override...\n");
+    reset_mocks();
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    
+    planner_block_t block;
+    make_accel_block(&block);
+    assert(stepper_load_block(&ctx, &block));
+    
+    /* Run into the cruise phase */
+    while (mock_step_pulses[HAL_AXIS_X] < 400) {
+        mock_timer_fire();
+        stepper_update(&ctx);
+    }
+    
+    /* Planner doubles the nominal speed (200% feed override) */
+    block.nominal_speed = 1200.0f;
+    stepper_update(&ctx);
+    assert(ctx.profile_nominal == 1200.0f);
+    assert(ctx.phases[STEPPER_PHASE_ACCEL].v_start > 990.0f);
+    assert(ctx.phases[STEPPER_PHASE_ACCEL].v_end == 2000.0f);
+    assert(ctx.phases[STEPPER_PHASE_ACCEL].start_pos > 400.0f);
+    assert(ctx.decelerate_after == 800);  /* 2000 steps/s stops in 200 steps */
+    
+    uint32_t min_period = UINT32_MAX;
+    uint32_t last_us = mock_time_us;
+    uint32_t last_steps = mock_step_pulses[HAL_AXIS_X];
+    for (uint32_t guard = 0; guard < 1000000u && ctx.state != STEPPER_IDLE; guard++) {
+        uint32_t start_us = mock_time_us;
+        mock_timer_fire();
+        if (mock_step_pulses[HAL_AXIS_X] != last_steps) {
+            if (start_us - last_us < min_period) min_period = start_us - last_us;
+            last_us = start_us;
+            last_steps = mock_step_pulses[HAL_AXIS_X];
+        }
+        stepper_update(&ctx);
+    }
+    assert(ctx.state == STEPPER_IDLE);
+    assert(mock_step_pulses[HAL_AXIS_X] == 1000);
+    assert(min_period >= 490u && min_period <= 520u);
+    
+    /* Faster than the 1.1 s the block takes at 100% */
+    assert(mock_time_us < 1000000u);
+    
+    printf("[passed]\n");
+}
+
+void test_stepper_override_lowered_mid_block(void) {
+    printf("Testing stepper ramps down when an override lowers the feed...\n");
+    reset_mocks();
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    
+    planner_block_t block;
+    make_accel_block(&block);
+    assert(stepper_load_block(&ctx, &block));
+    
+    while (mock_step_pulses[HAL_AXIS_X] < 300) {
+        mock_timer_fire();
+        stepper_update(&ctx);
+    }
+    
+    /* Planner drops the nominal speed to 10% (feed override) */
+    block.nominal_speed = 60.0f;
+    stepper_update(&ctx);
+    assert(ctx.profile_nominal == 60.0f);
+    assert(ctx.phases[STEPPER_PHASE_ACCEL].v_start > 990.0f);
+    assert(ctx.phases[STEPPER_PHASE_ACCEL].v_end == 100.0f);
+    
+    /* 10000 steps/s^2 over a 10 ms segment: at most 100 steps/s slower per
+     * segment, plus one step per segment since each carries whole steps
+     */
+    const float dt = (float)STEPPER_SEGMENT_DT_US * 1.0e-6f;
+    float max_drop = 10000.0f * dt + 1.0f / dt;
+    float last_rate = 0.0f;
+    uint32_t counted = 0;
+    uint32_t override_us = mock_time_us;
+    uint32_t ramp_us = 0;
+    uint32_t last_us = mock_time_us;
+    uint32_t last_steps = mock_step_pulses[HAL_AXIS_X];
+    for (uint32_t guard = 0; guard < 1000000u && ctx.state != STEPPER_IDLE; guard++) {
+        uint32_t start_us = mock_time_us;
+        mock_timer_fire();
+        if (mock_step_pulses[HAL_AXIS_X] != last_steps) {
+            /* The first period is partial, measured from the override */
+            if (counted++ > 0) {
+                float rate = 1e6f / (float)(start_us - last_us);
+                if (last_rate > 0.0f) {
+                    assert(last_rate - rate <= max_drop);
+                }
+                if (ramp_us == 0 && rate < 101.0f) {
+                    ramp_us = start_us - override_us;
+                }
+                last_rate = rate;
+            }
+            last_us = start_us;
+            last_steps = mock_step_pulses[HAL_AXIS_X];
+        }
+        stepper_update(&ctx);
+    }
+    assert(ctx.state == STEPPER_IDLE);
+    assert(mock_step_pulses[HAL_AXIS_X] == 1000);
+    
+    /* 1000 -> 100 steps/s at 10000 steps/s^2 takes 90 ms */
+    assert(ramp_us >= 90000u);
+    
+    printf("[passed]\n");
+}
+
+void test_stepper_override_lowered_short_remainder(void) {
+    printf("Testing stepper decelerates straight to exit on a short remainder...\n");
+    reset_mocks();
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    
+    planner_block_t block;
+    make_accel_block(&block);
+    block.exit_speed_sqr = 300.0f * 300.0f;  /* 500 steps/s */
+    assert(stepper_load_block(&ctx, &block));
+    
+    /* Prep into the 37.5-step ramp from 1000 to 500 steps/s */
+    while (ctx.prep_phase != STEPPER_PHASE_DECEL) {
+        mock_timer_fire();
+        stepper_update(&ctx);
+    }
+    
+    /* Stopping from 1000 steps/s down to 100 would take ~50 steps, more than
+     * the remainder holds, so it is one ramp from the current speed
+     */
+    block.nominal_speed = 60.0f;
+    block.exit_speed_sqr = 0.0f;
+    stepper_update(&ctx);
+    assert(ctx.profile_nominal == 60.0f);
+    assert(ctx.phases[STEPPER_PHASE_ACCEL].duration == 0.0f);
+    assert(ctx.phases[STEPPER_PHASE_CRUISE].duration == 0.0f);
+    assert(ctx.phases[STEPPER_PHASE_DECEL].v_start > 500.0f);
+    assert(ctx.phases[STEPPER_PHASE_DECEL].v_end > 490.0f);
+    
+    while (ctx.state != STEPPER_IDLE) {
+        mock_timer_fire();
+        stepper_update(&ctx);
+    }
+    assert(mock_step_pulses[HAL_AXIS_X] == 1000);
+    
+    printf("[passed]\n");
+}
+
+/* Step the ISR until the stepper parks in hold, recording the time (us)
+ * between consecutive X steps. Returns the number of steps recorded.
+ */
+static uint32_t run_until_hold(stepper_context_t *ctx, uint32_t *periods, uint32_t cap) {
+    uint32_t n = 0;
+    uint32_t last_step_us = mock_time_us;
+    for (uint32_t guard = 0; guard < 1000000u && ctx->state != STEPPER_HOLD; guard++) {
+        uint32_t steps_before = mock_step_pulses[HAL_AXIS_X];
+        uint32_t start_us = mock_time_us;
+        mock_timer_fire();
+        if (mock_step_pulses[HAL_AXIS_X] != steps_before) {
+            if (n < cap) periods[n] = start_us - last_step_us;
+            last_step_us = start_us;
+            n++;
+        }
+        stepper_update(ctx);
+    }
+    assert(ctx->state == STEPPER_HOLD);
+    return n;
+}
+
+/* Test feed hold ramps down along the block's acceleration */
+void test_stepper_hold_ramp(void) {
+    printf("Testing stepper feed hold decelerates before parking...\n");
+    reset_mocks();
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    
+    /* Hold at cruise (1000 steps/s, 10000 steps/s^2: 50 steps to stop) */
+    planner_block_t block;
+    make_accel_block(&block);
+    assert(stepper_load_block(&ctx, &block));
+    while (mock_step_pulses[HAL_AXIS_X] < 500) {
+        mock_timer_fire();
+        stepper_update(&ctx);
+    }
+    stepper_hold(&ctx);
+    assert(ctx.state == STEPPER_RUNNING && ctx.hold_decel);
+    
+    static uint32_t periods[1000];
+    uint32_t n = run_until_hold(&ctx, periods, 1000);
+    assert(!mock_timer_armed);
+    
+    /* Queued segments run out at cruise, then the ramp: 50 steps or so */
+    uint32_t parked = mock_step_pulses[HAL_AXIS_X];
+    assert(parked == 500u + n);
+    assert(parked > 550u && parked < 660u);
+    assert(periods[1] >= 990u && periods[1] <= 1010u);
+    assert(periods[n - 1] > 3000u);
+    for (uint32_t i = n - 40u; i < n; i++) {
+        assert(periods[i] >= periods[i - 1]);  /* decelerating */
+    }
+    
+    /* Parked: the timer stays off */
+    mock_timer_fire();
+    stepper_update(&ctx);
+    assert(mock_step_pulses[HAL_AXIS_X] == parked && ctx.state == STEPPER_HOLD);
+    
+    /* Resume accelerates from rest and finishes the block exactly */
+    stepper_resume(&ctx);
+    assert(ctx.state == STEPPER_RUNNING && mock_timer_armed);
+    run_block_periods(&ctx, periods, 1000);
+    assert(periods[1] > 3000u);
+    assert(mock_step_pulses[HAL_AXIS_X] == 1000);
+    
+    /* A ramp longer than the rest of the block carries into the next one */
+    reset_mocks();
+    planner_queue_t queue;
+    planner_queue_init(&queue);
+    stepper_init(&ctx, NULL);
+    stepper_attach_planner(&ctx, &queue);
+    make_accel_block(&block);
+    block.exit_speed_sqr = 600.0f * 600.0f;
+    assert(planner_enqueue(&queue, &block));
+    make_accel_block(&block);
+    block.entry_speed_sqr = 600.0f * 600.0f;
+    assert(planner_enqueue(&queue, &block));
+    
+    stepper_update(&ctx);
+    while (mock_step_pulses[HAL_AXIS_X] < 990) {
+        mock_timer_fire();
+        stepper_update(&ctx);
+    }
+    stepper_hold(&ctx);
+    n = run_until_hold(&ctx, periods, 1000);
+    parked = mock_step_pulses[HAL_AXIS_X];
+    assert(parked > 1000u && parked < 1060u);
+    assert(ctx.current_block == planner_peek_front(&queue) && planner_block_count(&queue) == 1);
+    assert(periods[n - 1] > 3000u);
+    
+    stepper_resume(&ctx);
+    for (uint32_t guard = 0; guard < 1000000u && !planner_is_empty(&queue); guard++) {
+        mock_timer_fire();
+        stepper_update(&ctx);
+    }
+    assert(mock_step_pulses[HAL_AXIS_X] == 2000);
+    
+    printf("[passed]\n");
+}
+
+/* Test laser blocks drive the spindle PWM from the segment speed */
+void test_stepper_laser_power(void) {
+    printf("Testing stepper laser power follows segment speed...\n");
+    reset_mocks();
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    
+    /* M4: power scales with speed, 500/1000 S at nominal */
+    planner_block_t block;
+    make_accel_block(&block);
+    block.line_flags = PLANNER_LINE_LASER | PLANNER_LINE_SPINDLE_CCW;
+    block.spindle_speed = 500.0f;
+    assert(stepper_load_block(&ctx, &block));
+    
+    while (mock_step_pulses[HAL_AXIS_X] < 500) {
+        mock_timer_fire();
+        stepper_update(&ctx);
+    }
+    assert(mock_spindle_dir == HAL_SPINDLE_CCW);
+    assert(fabsf(mock_spindle_pwm - 0.5f) < 1e-3f);
+    assert(mock_spindle_pwm_min > 0.0f && mock_spindle_pwm_min < 0.25f);
+    
+    /* Hold ramps down with M4 power following the speed, parks the laser
+     * off, and resume brings the power back with the speed
+     */
+    stepper_hold(&ctx);
+    mock_spindle_pwm_min = 1.0f;
+    for (uint32_t guard = 0; guard < 1000000u && ctx.state != STEPPER_HOLD; guard++) {
+        mock_timer_fire();
+        stepper_update(&ctx);
+    }
+    assert(ctx.state == STEPPER_HOLD);
+    assert(mock_spindle_pwm_min < 0.25f);
+    assert(mock_spindle_dir == HAL_SPINDLE_OFF && mock_spindle_pwm == 0.0f);
+    stepper_resume(&ctx);
+    uint32_t parked_at = mock_step_pulses[HAL_AXIS_X];
+    while (mock_step_pulses[HAL_AXIS_X] < parked_at + 5u) {
+        mock_timer_fire();
+        stepper_update(&ctx);
+    }
+    assert(mock_spindle_dir == HAL_SPINDLE_CCW);
+    assert(mock_spindle_pwm > 0.0f && mock_spindle_pwm < 0.25f);
+    
+    for (uint32_t guard = 0; guard < 1000000u && ctx.state != STEPPER_IDLE; guard++) {
+        mock_timer_fire();
+        stepper_update(&ctx);
+    }
+    assert(ctx.state == STEPPER_IDLE);
+    assert(mock_spindle_pwm_max <= 0.5f + 1e-3f);
+    assert(mock_spindle_dir == HAL_SPINDLE_OFF && mock_spindle_pwm == 0.0f);
+    
+    /* M3: constant power, one write on and one write off */
+    reset_mocks();
+    make_accel_block(&block);
+    block.line_flags = PLANNER_LINE_LASER | PLANNER_LINE_SPINDLE_CW;
+    block.spindle_speed = 250.0f;
+    assert(stepper_load_block(&ctx, &block));
+    for (uint32_t guard = 0; guard < 1000000u && ctx.state != STEPPER_IDLE; guard++) {
+        mock_timer_fire();
+        stepper_update(&ctx);
+    }
+    assert(mock_spindle_calls == 2);
+    assert(mock_spindle_pwm_min == 0.25f && mock_spindle_pwm_max == 0.25f);
+    
+    /* Blocks without PLANNER_LINE_LASER never touch the spindle */
+    reset_mocks();
+    make_accel_block(&block);
+    block.spindle_speed = 500.0f;
+    assert(stepper_load_block(&ctx, &block));
+    for (uint32_t guard = 0; guard < 1000000u && ctx.state != STEPPER_IDLE; guard++) {
+        mock_timer_fire();
+        stepper_update(&ctx);
+    }
+    assert(mock_spindle_calls == 0);
+    
+    printf("[passed]\n");
+}
+
+/* Test sync blocks: spindle set on arrival, then a timed wait with no steps */
+void test_stepper_dwell_block(void) {
+    printf("Testing stepper runs sync blocks as timed waits...\n");
+    reset_mocks();
+    
+    planner_queue_t queue;
+    planner_queue_init(&queue);
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    stepper_attach_planner(&ctx, &queue);
+    
+    queue.spindle_speed = 600.0f;
+    assert(planner_buffer_sync(&queue, 250u, PLANNER_LINE_SPINDLE_SYNC | PLANNER_LINE_SPINDLE_CW) ==
+           PLANNER_LINE_OK);
+    assert(planner_buffer_sync(&queue, 0u, PLANNER_LINE_SPINDLE_SYNC) == PLANNER_LINE_OK);
+    
+    stepper_update(&ctx);
+    assert(ctx.state == STEPPER_RUNNING && ctx.dwell_active);
+    assert(mock_spindle_dir == HAL_SPINDLE_CW && fabsf(mock_spindle_pwm - 0.6f) < 1e-6f);
+    assert(!mock_timer_armed);
+    
+    mock_time_ms += 100;
+    stepper_update(&ctx);
+    assert(ctx.state == STEPPER_RUNNING && ctx.dwell_left_ms == 150u);
+    
+    /* Time in hold does not count */
+    stepper_hold(&ctx);
+    mock_time_ms += 1000;
+    stepper_update(&ctx);
+    stepper_resume(&ctx);
+    stepper_update(&ctx);
+    assert(ctx.state == STEPPER_RUNNING && ctx.dwell_left_ms == 150u);
+    
+    mock_time_ms += 150;
+    stepper_update(&ctx);
+    assert(ctx.state == STEPPER_IDLE && !ctx.dwell_active);
+    assert(planner_block_count(&queue) == 1);
+    assert(mock_spindle_dir == HAL_SPINDLE_CW);  /* spindle stays on past the dwell */
+    
+    /* Zero-length wait: spindle off, retired on the next update */
+    stepper_update(&ctx);
+    assert(mock_spindle_dir == HAL_SPINDLE_OFF && mock_spindle_pwm == 0.0f);
+    stepper_update(&ctx);
+    assert(ctx.state == STEPPER_IDLE && planner_is_empty(&queue));
+    for (int i = 0; i < HAL_AXIS_MAX; i++) {
+        assert(mock_step_pulses[i] == 0);
+    }
+    
+    printf("[passed]\n");
+}
+
+/* Test spindle override changes reach a running spindle and laser power */
+void test_stepper_spindle_override(void) {
+    printf("Testing stepper applies spindle overrides on the fly...\n");
+    reset_mocks();
+    
+    planner_queue_t queue;
+    planner_queue_init(&queue);
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    stepper_attach_planner(&ctx, &queue);
+    
+    /* Spindle started by a sync block at 100% */
+    queue.spindle_speed = 600.0f;
+    assert(planner_buffer_sync(&queue, 0u, PLANNER_LINE_SPINDLE_SYNC | PLANNER_LINE_SPINDLE_CW) ==
+           PLANNER_LINE_OK);
+    stepper_update(&ctx);
+    stepper_update(&ctx);
+    assert(ctx.state == STEPPER_IDLE && planner_is_empty(&queue));
+    assert(mock_spindle_dir == HAL_SPINDLE_CW && fabsf(mock_spindle_pwm - 0.6f) < 1e-6f);
+    
+    /* Re-set at once, with nothing moving; later sync blocks are scaled */
+    queue.spindle_override = 50;
+    stepper_update(&ctx);
+    assert(mock_spindle_dir == HAL_SPINDLE_CW && fabsf(mock_spindle_pwm - 0.3f) < 1e-6f);
+    queue.spindle_speed = 800.0f;
+    assert(planner_buffer_sync(&queue, 0u, PLANNER_LINE_SPINDLE_SYNC | PLANNER_LINE_SPINDLE_CCW) ==
+           PLANNER_LINE_OK);
+    stepper_update(&ctx);
+    assert(mock_spindle_dir == HAL_SPINDLE_CCW && fabsf(mock_spindle_pwm - 0.4f) < 1e-6f);
+    
+    /* Stopped spindles stay off */
+    assert(planner_buffer_sync(&queue, 0u, PLANNER_LINE_SPINDLE_SYNC) == PLANNER_LINE_OK);
+    stepper_update(&ctx);
+    stepper_update(&ctx);
+    uint32_t calls = mock_spindle_calls;
+    queue.spindle_override = 80;
+    stepper_update(&ctx);
+    assert(mock_spindle_calls == calls && mock_spindle_dir == HAL_SPINDLE_OFF);
+    
+    /* M3 laser power: 500/1000 S at 80%, then 100% for segments prepped after */
+    planner_block_t block;
+    make_accel_block(&block);
+    block.line_flags = PLANNER_LINE_LASER | PLANNER_LINE_SPINDLE_CW;
+    block.spindle_speed = 500.0f;
+    assert(stepper_load_block(&ctx, &block));
+    while (mock_step_pulses[HAL_AXIS_X] < 200) {
+        mock_timer_fire();
+        stepper_update(&ctx);
+    }
+    assert(mock_spindle_dir == HAL_SPINDLE_CW && fabsf(mock_spindle_pwm - 0.4f) < 1e-6f);
+    queue.spindle_override = 100;
+    while (mock_step_pulses[HAL_AXIS_X] < 400) {
+        mock_timer_fire();
+        stepper_update(&ctx);
+    }
+    assert(mock_spindle_dir == HAL_SPINDLE_CW && fabsf(mock_spindle_pwm - 0.5f) < 1e-6f);
+    
+    printf("[passed]\n");
+}
+
+/* Test the S-curve option keeps the trapezoid's timing and boundaries */
+void test_stepper_s_curve_profile(void) {
+    printf("Testing stepper S-curve acceleration...\n");
+    reset_mocks();
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    stepper_config_t config;
+    stepper_get_config(&ctx, &config);
+    config.s_curve = true;
+    stepper_set_config(&ctx, &config);
+    
+    planner_block_t block;
+    make_accel_block(&block);
+    assert(stepper_load_block(&ctx, &block));
+    
+    static uint32_t periods[1000];
+    run_block_periods(&ctx, periods, 1000);
+    assert(mock_step_pulses[HAL_AXIS_X] == 1000);
+    assert(mock_time_us > 1080000u && mock_time_us < 1120000u);
+    uint32_t s_curve_10 = 0;
+    for (uint32_t i = 0; i < 10; i++) s_curve_10 += periods[i];
+    
+    /* Jerk-limited start takes longer to cover the first steps than the
+     * linear ramp, while the block as a whole takes the same time.
+     */
+    reset_mocks();
+    stepper_init(&ctx, NULL);
+    make_accel_block(&block);
+    assert(stepper_load_block(&ctx, &block));
+    run_block_periods(&ctx, periods, 1000);
+    uint32_t linear_10 = 0;
+    for (uint32_t i = 0; i < 10; i++) linear_10 += periods[i];
+    assert(s_curve_10 > linear_10);
+    
+    printf("[passed]\n");
+}
+
+/* Test AMASS: slow multi-axis moves tick the ISR faster but step exactly */
+void test_stepper_amass(void) {
+    printf("Testing stepper AMASS at low step rates...\n");
+    reset_mocks();
+    
+    stepper_context_t ctx;
+    stepper_init(&ctx, NULL);
+    
+    planner_block_t block;
+    make_accel_block(&block);
+    block.nominal_speed = 60.0f;   /* 100 steps/s: below every AMASS level */
+    block.steps[HAL_AXIS_X] = 200;
+    block.steps[HAL_AXIS_Y] = 70;
+    block.step_event_count = 200;
+    block.millimeters = 2.0f;
+    block.inv_millimeters = 1.0f / 2.0f;
+    block.direction_bits = 0x03;
+    assert(stepper_load_block(&ctx, &block));
+    assert(ctx.segments[ctx.seg_head & (STEPPER_SEGMENT_BUFFER_SIZE - 1u)].amass_level ==
+           STEPPER_MAX_AMASS_LEVEL);
+    
+    static uint32_t periods[4096];
+    uint32_t events = run_block_periods(&ctx, periods, 4096);
+    assert(events == (200u << STEPPER_MAX_AMASS_LEVEL));
+    assert(mock_step_pulses[HAL_AXIS_X] == 200);
+    assert(mock_step_pulses[HAL_AXIS_Y] == 70);
+    assert(ctx.position.v[HAL_AXIS_X] == 200);
+    assert(ctx.position.v[HAL_AXIS_Y] == 70);
+    
+    printf("[passed]\n");
+}
+
 int main(void) {
     printf("Running stepper tests...\n\n");
     
@@ -371,6 +1322,22 @@ int main(void) {
     test_stepper_stop();
     test_stepper_get_position();
     test_stepper_config();
+    test_stepper_isr_execution();
+    test_stepper_isr_hold_resume();
+    test_stepper_emergency_stop();
+    test_stepper_multi_axis_dda();
+    test_stepper_planner_consumer();
+    test_stepper_trapezoid_profile();
+    test_stepper_triangle_profile();
+    test_stepper_override_mid_block();
+    test_stepper_override_lowered_mid_block();
+    test_stepper_override_lowered_short_remainder();
+    test_stepper_hold_ramp();
+    test_stepper_laser_power();
+    test_stepper_dwell_block();
+    test_stepper_spindle_override();
+    test_stepper_s_curve_profile();
+    test_stepper_amass();
     
     printf("\nAll stepper tests passed!\n");
     return 0;
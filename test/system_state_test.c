@@ -3,7 +3,9 @@
 #include <stdio.h>
 #include <assert.h>
 #include <string.h>
+#include <math.h>
 #include "../src/system_state.h"
+#include "../src/stepper.h"
 
 /* Mock HAL functions for testing */
 uint32_t hal_millis(void) {
@@ -40,9 +42,52 @@ void hal_stepper_enable(bool en) {
     (void)en;
 }
 
+void hal_stepper_set_dir(hal_axis_t axis, bool dir_positive) {
+    (void)axis;
+    (void)dir_positive;
+}
+
+void hal_stepper_pulse_mask(uint32_t axis_mask) {
+    (void)axis_mask;
+}
+
+void hal_stepper_clear_mask(uint32_t axis_mask) {
+    (void)axis_mask;
+}
+
+/* Step timer: never fires, the tests only run sync blocks */
+void hal_step_timer_init(hal_timer_cb_t on_step, hal_timer_cb_t on_pulse_end, void *user) {
+    (void)on_step;
+    (void)on_pulse_end;
+    (void)user;
+}
+
+uint32_t hal_step_timer_freq_hz(void) {
+    return 1000000u;
+}
+
+void hal_step_timer_arm(uint32_t period_ticks) {
+    (void)period_ticks;
+}
+
+void hal_step_timer_reload(uint32_t period_ticks) {
+    (void)period_ticks;
+}
+
+void hal_step_timer_compare(uint32_t pulse_ticks) {
+    (void)pulse_ticks;
+}
+
+void hal_step_timer_stop(void) {
+}
+
+/* Mock spindle output: last value written */
+static hal_spindle_dir_t mock_spindle_dir = HAL_SPINDLE_OFF;
+static float mock_spindle_pwm = 0.0f;
+
 void hal_spindle_set(hal_spindle_dir_t dir, float pwm) {
-    (void)dir;
-    (void)pwm;
+    mock_spindle_dir = dir;
+    mock_spindle_pwm = pwm;
 }
 
 void hal_read_inputs(hal_inputs_t *out) {
@@ -216,6 +261,200 @@ void test_status_report() {
     printf("  [PASSED]\n");
 }
 
+void test_status_report_format() {
+    printf("Testing status report fixed-point format...\n");
+    
+    system_context_t sys;
+    system_init(&sys);
+    
+    sys.machine_x = 10.5f;
+    sys.machine_y = -0.0625f;
+    sys.machine_z = 1234.0009f;
+    system_set_work_offset(&sys, 0.5f, 0.0f, 0.0f);
+    
+    char buf[SYS_STATUS_REPORT_MAX];
+    char expect[SYS_STATUS_REPORT_MAX];
+    size_t len = system_get_status_report(&sys, buf, sizeof(buf));
+    snprintf(expect, sizeof(expect),
+             "<Idle|MPos:10.500,-0.063,1234.001|WPos:10.000,-0.063,1234.001|F:100.0|S:0|Bf:%u>",
+             (unsigned)PLANNER_BUFFER_SIZE);
+    assert(strcmp(buf, expect) == 0);
+    assert(len == strlen(buf));
+    
+    /* Alarm code is always appended */
+    system_trigger_alarm(&sys, SYS_ALARM_HARD_LIMIT);
+    system_set_report_mask(&sys, 0);
+    len = system_get_status_report(&sys, buf, sizeof(buf));
+    assert(strcmp(buf, "<Alarm|A:1>") == 0);
+    
+    /* Too small: nothing half-written */
+    len = system_get_status_report(&sys, buf, 8);
+    assert(len == 0 && buf[0] == '\0');
+    
+    /* Worst case fits the preallocated buffer */
+    static protocol_t proto;
+    protocol_init(&proto, NULL, NULL, NULL, NULL);
+    system_attach_protocol(&sys, &proto);
+    system_clear_alarm(&sys);
+    sys.state = SYS_STATE_ALARM;
+    sys.alarm = SYS_ALARM_SPINDLE_STALL;
+    sys.machine_x = sys.machine_y = sys.machine_z = -3.0e9f;
+    sys.work_offset_x = sys.work_offset_y = sys.work_offset_z = 3.0e9f;
+    sys.total_lines_processed = 0xFFFFFFFFu;
+    system_set_report_mask(&sys, SYS_REPORT_ALL);
+    size_t n;
+    const char *r = system_build_status_report(&sys, &n);
+    assert(n > 0 && n == strlen(r) && r == sys.report);
+    assert(strstr(r, "MPos:-2147483.647,") != NULL);
+    assert(r[n - 1] == '>');
+    
+    printf("  Status: %s\n", r);
+    printf("  [PASSED]\n");
+}
+
+void test_status_report_mask() {
+    printf("Testing status report field mask ($10)...\n");
+    
+    system_context_t sys;
+    system_init(&sys);
+    
+    system_process_line(&sys, "$10=48");
+    assert(sys.report_mask == (SYS_REPORT_BUFFER | SYS_REPORT_LINE_NUMBER));
+    
+    size_t n;
+    const char *r = system_build_status_report(&sys, &n);
+    assert(strcmp(r, "<Run|Bf:16|Ln:1>") == 0 || PLANNER_BUFFER_SIZE != 16u);
+    assert(strstr(r, "MPos") == NULL && strstr(r, "F:") == NULL);
+    
+    /* With the protocol attached Bf: carries the free RX bytes too */
+    static protocol_t proto;
+    protocol_init(&proto, NULL, NULL, NULL, NULL);
+    system_attach_protocol(&sys, &proto);
+    assert(protocol_rx_write(&proto, (const uint8_t *)"G1 X1\n", 6) == 6);
+    char expect[SYS_STATUS_REPORT_MAX];
+    snprintf(expect, sizeof(expect), "<Run|Bf:%u,%u|Ln:1>",
+             (unsigned)PLANNER_BUFFER_SIZE, (unsigned)(PROTOCOL_RX_BUFFER_SIZE - 6u));
+    r = system_build_status_report(&sys, &n);
+    assert(strcmp(r, expect) == 0);
+    system_attach_protocol(&sys, NULL);
+    
+    /* Unknown bits and junk are rejected, mask unchanged */
+    uint32_t errors = sys.total_errors;
+    system_process_line(&sys, "$10=128");
+    system_process_line(&sys, "$10=1x");
+    system_process_line(&sys, "$10=");
+    assert(sys.total_errors == errors + 3);
+    assert(sys.report_mask == (SYS_REPORT_BUFFER | SYS_REPORT_LINE_NUMBER));
+    
+    system_process_line(&sys, "$10=1");
+    r = system_build_status_report(&sys, &n);
+    assert(strcmp(r, "<Run|MPos:0.000,0.000,0.000>") == 0);
+    
+    printf("  [PASSED]\n");
+}
+
+void test_laser_mode_setting() {
+    printf("Testing laser mode setting ($32)...\n");
+    
+    system_context_t sys;
+    system_init(&sys);
+    assert(!gcode_get_laser_mode(&sys.gcode));
+    
+    system_process_line(&sys, "$32=1");
+    assert(gcode_get_laser_mode(&sys.gcode));
+    
+    /* Settings survive a soft reset */
+    system_reset(&sys);
+    assert(gcode_get_laser_mode(&sys.gcode));
+    
+    uint32_t errors = sys.total_errors;
+    system_process_line(&sys, "$32=2");
+    system_process_line(&sys, "$32=");
+    assert(sys.total_errors == errors + 2);
+    assert(gcode_get_laser_mode(&sys.gcode));
+    
+    system_process_line(&sys, "$32=0");
+    assert(!gcode_get_laser_mode(&sys.gcode));
+    
+    printf("  [PASSED]\n");
+}
+
+void test_realtime_overrides() {
+    printf("Testing realtime override dispatch...\n");
+    
+    system_context_t sys;
+    system_init(&sys);
+    system_set_report_mask(&sys, SYS_REPORT_OVERRIDES);
+    
+    system_realtime_command(&sys, PROTO_RT_FEED_OVR_COARSE_PLUS);
+    system_realtime_command(&sys, PROTO_RT_FEED_OVR_FINE_MINUS);
+    system_realtime_command(&sys, PROTO_RT_RAPID_OVR_MEDIUM);
+    system_realtime_command(&sys, PROTO_RT_SPINDLE_OVR_COARSE_MINUS);
+    system_realtime_command(&sys, PROTO_RT_STATUS_QUERY);
+    assert(strcmp(sys.report, "<Idle|Ov:109,50,90>") == 0);
+    
+    /* Saturates at the limits */
+    for (int i = 0; i < 30; i++) {
+        system_realtime_command(&sys, PROTO_RT_FEED_OVR_COARSE_PLUS);
+        system_realtime_command(&sys, PROTO_RT_SPINDLE_OVR_COARSE_MINUS);
+    }
+    assert(sys.planner.feed_override == PLANNER_FEED_OVERRIDE_MAX);
+    assert(gcode_get_spindle_override(&sys.gcode) == GCODE_SPINDLE_OVERRIDE_MIN);
+    
+    /* Spindle output follows the override, programmed S is kept */
+    system_process_line(&sys, "M3 S1000");
+    assert(gcode_get_spindle_speed(&sys.gcode) == 1000.0f);
+    assert(gcode_get_spindle_output(&sys.gcode) == 100.0f);
+    
+    system_realtime_command(&sys, PROTO_RT_FEED_OVR_RESET);
+    system_realtime_command(&sys, PROTO_RT_RAPID_OVR_RESET);
+    assert(sys.planner.feed_override == 100 && sys.planner.rapid_override == 100);
+    
+    /* Soft reset restores every override */
+    system_realtime_command(&sys, PROTO_RT_FEED_OVR_COARSE_MINUS);
+    system_realtime_command(&sys, PROTO_RT_RESET);
+    assert(sys.planner.feed_override == 100);
+    assert(gcode_get_spindle_override(&sys.gcode) == GCODE_SPINDLE_OVERRIDE_DEFAULT);
+    
+    printf("  [PASSED]\n");
+}
+
+void test_spindle_override_running() {
+    printf("Testing spindle override reaches a running spindle...\n");
+    
+    system_context_t sys;
+    system_init(&sys);
+    stepper_context_t stepper;
+    stepper_init(&stepper, NULL);
+    stepper_attach_planner(&stepper, &sys.planner);
+    sys.gcode.spindle_spinup_ms = 0;
+    
+    /* M3 runs through its sync block: 500/1000 S */
+    system_process_line(&sys, "M3 S500");
+    assert(sys.last_error == 0);
+    stepper_update(&stepper);
+    assert(mock_spindle_dir == HAL_SPINDLE_CW && fabsf(mock_spindle_pwm - 0.5f) < 1e-6f);
+    
+    /* 0x9A / 0x9B change the output with no new block */
+    system_realtime_command(&sys, PROTO_RT_SPINDLE_OVR_COARSE_PLUS);
+    stepper_update(&stepper);
+    assert(mock_spindle_dir == HAL_SPINDLE_CW && fabsf(mock_spindle_pwm - 0.55f) < 1e-6f);
+    system_realtime_command(&sys, PROTO_RT_SPINDLE_OVR_COARSE_MINUS);
+    system_realtime_command(&sys, PROTO_RT_SPINDLE_OVR_COARSE_MINUS);
+    stepper_update(&stepper);
+    assert(mock_spindle_dir == HAL_SPINDLE_CW && fabsf(mock_spindle_pwm - 0.45f) < 1e-6f);
+    assert(gcode_get_spindle_output(&sys.gcode) == 450.0f);
+    
+    /* Soft reset restores 100% and stops the spindle */
+    stepper_reset(&stepper);
+    system_realtime_command(&sys, PROTO_RT_RESET);
+    stepper_update(&stepper);
+    assert(sys.planner.spindle_override == GCODE_SPINDLE_OVERRIDE_DEFAULT);
+    assert(mock_spindle_dir == HAL_SPINDLE_OFF && mock_spindle_pwm == 0.0f);
+    
+    printf("  [PASSED]\n");
+}
+
 void test_state_string_conversion() {
     printf("Testing state string conversion...\n");
     
@@ -275,6 +514,98 @@ void test_soft_limits() {
     printf("  [PASSED]\n");
 }
 
+void test_input_alarm_latch() {
+    printf("Testing interrupt-latched limit / e-stop alarms...\n");
+    
+    system_context_t sys;
+    system_init(&sys);
+    sys.inputs_irq = true;
+    
+    /* Hard limit trips outside RUNNING too (not while homing) */
+    hal_inputs_t in;
+    memset(&in, 0, sizeof(in));
+    assert(!system_inputs_isr(&sys, &in));
+    in.limit_y = true;
+    assert(system_inputs_isr(&sys, &in));
+    assert(sys.state == SYS_STATE_IDLE);  /* latched, not raised yet */
+    
+    /* First latched alarm wins */
+    in.estop = true;
+    assert(system_inputs_isr(&sys, &in));
+    system_check_inputs(&sys);
+    assert(sys.state == SYS_STATE_ALARM && sys.alarm == SYS_ALARM_HARD_LIMIT);
+    assert(sys.alarm_latched == SYS_ALARM_NONE);
+    
+    /* Bounce latched during the alarm is dropped by the clear */
+    assert(system_inputs_isr(&sys, &in));
+    assert(system_clear_alarm(&sys));
+    system_check_inputs(&sys);
+    assert(sys.state == SYS_STATE_IDLE);
+    
+    /* E-stop ignores the limit enable; limits respect it and homing */
+    system_set_limits_enabled(&sys, false);
+    in.estop = false;
+    assert(!system_inputs_isr(&sys, &in));
+    in.estop = true;
+    assert(system_inputs_isr(&sys, &in));
+    system_check_inputs(&sys);
+    assert(sys.alarm == SYS_ALARM_ESTOP);
+    
+    system_reset(&sys);
+    system_set_limits_enabled(&sys, true);
+    sys.state = SYS_STATE_HOMING;
+    in.estop = false;
+    assert(!system_inputs_isr(&sys, &in));
+    
+    printf("  [PASSED]\n");
+}
+
+void test_check_mode() {
+    printf("Testing check mode...\n");
+    
+    system_context_t sys;
+    system_init(&sys);
+    
+    /* Entered from idle only */
+    sys.state = SYS_STATE_HOLD;
+    assert(!system_set_state(&sys, SYS_STATE_CHECK));
+    sys.state = SYS_STATE_IDLE;
+    assert(system_set_state(&sys, SYS_STATE_CHECK));
+    assert(gcode_get_check_mode(&sys.gcode));
+    
+    /* Lines are validated and counted; nothing is queued or held */
+    system_process_line(&sys, "G90");
+    system_process_line(&sys, "G01 X10 Y20 F500");
+    system_process_line(&sys, "G02 X20 Y20 I5 J0");
+    system_process_line(&sys, "M03 S800");
+    system_process_line(&sys, "G04 P1");
+    assert(sys.total_lines_processed == 5 && sys.total_errors == 0);
+    system_process_line(&sys, "G999");
+    system_process_line(&sys, "G01 X1 Yabc");
+    assert(sys.total_lines_processed == 5 && sys.total_errors == 2);
+    assert(planner_is_empty(&sys.planner));
+    assert(!system_line_pending(&sys));
+    assert(sys.state == SYS_STATE_CHECK);
+    
+    float x, y;
+    gcode_get_position(&sys.gcode, &x, &y);
+    assert(x == 20.0f && y == 20.0f);
+    
+    /* Leaving drops the checked modal state */
+    assert(system_set_state(&sys, SYS_STATE_IDLE));
+    assert(!gcode_get_check_mode(&sys.gcode));
+    gcode_get_position(&sys.gcode, &x, &y);
+    assert(x == 0.0f && y == 0.0f);
+    assert(gcode_get_spindle_state(&sys.gcode) == GCODE_SPINDLE_OFF);
+    
+    /* An alarm ends check mode as well */
+    assert(system_set_state(&sys, SYS_STATE_CHECK));
+    system_trigger_alarm(&sys, SYS_ALARM_ESTOP);
+    assert(!gcode_get_check_mode(&sys.gcode));
+    
+    printf("  [PASSED]\n");
+}
+
 void test_is_idle() {
     printf("Testing system_is_idle...\n");
     
@@ -304,9 +635,16 @@ int main(void) {
     test_soft_reset();
     test_position_management();
     test_status_report();
+    test_status_report_format();
+    test_status_report_mask();
+    test_laser_mode_setting();
+    test_realtime_overrides();
+    test_spindle_override_running();
     test_state_string_conversion();
     test_homing();
     test_soft_limits();
+    test_input_alarm_latch();
+    test_check_mode();
     test_is_idle();
     
     printf("\n=== All tests passed! ===\n");